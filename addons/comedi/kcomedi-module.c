@@ -65,12 +65,141 @@ MODULE_LICENSE("GPL");
 
 #define KSPACE(adr)  ((unsigned long)adr > PAGE_OFFSET)
 
+/*
+ * Tasks waiting for blocks of scans, see rt_comedi_wait_scans, are given a
+ * slot here, so that the built in callback, knowing just the task, resumes
+ * them only once the whole block is available, or the acquisition has ended,
+ * rather than at each callback. Once a task has a slot it is never resumed
+ * by callbacks arriving while it is not waiting for scans, until it registers
+ * its callback anew. A slot holds also the block acquisition state, see
+ * rt_comedi_block_config, the callback time stamping each block as soon as
+ * it finds it complete. A slot is released by an exit handler when its task
+ * is deleted. Without CONFIG_RTAI_MALLOC, for which there are no exit
+ * handlers, a slot whose task is no more valid is taken over when needed.
+ */
+#define MAX_SCAN_WAITS  16
+#define SCANS_END       (COMEDI_CB_EOA | COMEDI_CB_ERROR | COMEDI_CB_OVERFLOW)
+#define BLOCK_STAMPS    16  // a power of 2
+
+static struct scan_wait {
+	RT_TASK *task;
+	XHDL *xhdl;           // the exit handler releasing the slot
+	void *dev;
+	unsigned int subdev;
+	unsigned int cbmask;  // callbacks since the last block read
+	long bytes;           // waited for, 0 if not waiting
+	long block_bytes;     // 0 if no block acquisition is configured
+	long sampsize;
+	unsigned long seq;    // next block to be read
+	unsigned long stamped;
+	RTIME stamps[BLOCK_STAMPS];
+} scan_waits[MAX_SCAN_WAITS];
+
+static inline struct scan_wait *find_scan_wait(RT_TASK *task)
+{
+	int i;
+	for (i = 0; i < MAX_SCAN_WAITS; i++) {
+		if (scan_waits[i].task == task) {
+			return &scan_waits[i];
+		}
+	}
+	return NULL;
+}
+
+static inline struct scan_wait *find_free_scan_wait(void)
+{
+	int i;
+	for (i = 0; i < MAX_SCAN_WAITS; i++) {
+		if (!scan_waits[i].task || scan_waits[i].task->magic != RT_TASK_MAGIC) {
+			return &scan_waits[i];
+		}
+	}
+	return NULL;
+}
+
+/* Exit handler, called by rt_task_delete with interrupts disabled. */
+static void scan_wait_exit(void *task, int unused)
+{
+	struct scan_wait *w;
+	if ((w = find_scan_wait(task))) {
+		// the scheduler frees the handler itself
+		w->xhdl = NULL;
+		w->task = NULL;
+	}
+}
+
+/* Called with interrupts disabled. */
+static void release_scan_wait(struct scan_wait *w)
+{
+#ifdef CONFIG_RTAI_MALLOC
+	XHDL **p;
+	if (w->xhdl && w->task->magic == RT_TASK_MAGIC) {
+		for (p = &w->task->ExitHook; *p; p = &(*p)->nxt) {
+			if (*p == w->xhdl) {
+				*p = w->xhdl->nxt;
+				rt_free(w->xhdl);
+				break;
+			}
+		}
+	}
+#endif
+	w->xhdl = NULL;
+	w->task = NULL;
+}
+
+/* Called with interrupts disabled, gives task a slot if it has none yet. */
+static struct scan_wait *get_scan_wait(RT_TASK *task)
+{
+	struct scan_wait *w;
+	if (!(w = find_scan_wait(task)) && (w = find_free_scan_wait())) {
+		// forget resumes left by callbacks preceding the first block wait
+		while (rt_task_suspend_if(task) < 0);
+		memset(w, 0, sizeof(*w));
+		w->task = task;
+#ifdef CONFIG_RTAI_MALLOC
+		w->xhdl = set_exit_handler(task, scan_wait_exit, task, 0);
+#endif
+	}
+	return w;
+}
+
+static inline void stamp_blocks(struct scan_wait *w)
+{
+	long avbs;
+	unsigned long complete;
+	RTIME now;
+	if ((avbs = comedi_get_buffer_contents(w->dev, w->subdev)) >= w->block_bytes) {
+		complete = w->seq + avbs/w->block_bytes;
+		now = rt_get_time();
+		while ((long)(complete - w->stamped) > 0) {
+			w->stamps[w->stamped++ & (BLOCK_STAMPS - 1)] = now;
+		}
+	}
+}
+
 static int rtai_comedi_callback(unsigned int, RT_TASK *) __attribute__ ((__unused__));
 static int rtai_comedi_callback(unsigned int val, RT_TASK *task)
 {
         if (task->magic == RT_TASK_MAGIC) {
-		task->resumsg = val;
+		struct scan_wait *w;
+		unsigned long flags;
+		flags = rt_global_save_flags_and_cli();
+		if ((w = find_scan_wait(task))) {
+			task->resumsg |= val;
+			w->cbmask |= val;
+			if (w->block_bytes) {
+				stamp_blocks(w);
+			}
+			if (!w->bytes || (!(val & SCANS_END) && comedi_get_buffer_contents(w->dev, w->subdev) < w->bytes)) {
+				rt_global_restore_flags(flags);
+				return 0;
+			}
+			w->bytes = 0;
+		} else {
+			task->resumsg = val;
+		}
 		rt_task_resume(task);
+		rt_global_restore_flags(flags);
 	}
 	return 0;
 }
@@ -111,6 +240,15 @@ RTAI_SYSCALL_MODE int rt_comedi_register_callback(void *dev, unsigned int subdev
 		task = rt_whoami();
 	}
 	((RT_TASK *)task)->resumsg = 0;
+	if (!KSPACE(callback)) {
+		struct scan_wait *w;
+		unsigned long flags;
+		flags = rt_global_save_flags_and_cli();
+		if ((w = find_scan_wait(task))) {
+			release_scan_wait(w);
+		}
+		rt_global_restore_flags(flags);
+	}
 	RTAI_COMEDI_LOCK(dev, subdev);
 	if (KSPACE(callback)) {
 		retval = comedi_register_callback(dev, subdev, mask, (void *)callback, task);
@@ -371,6 +509,249 @@ RTAI_SYSCALL_MODE long RT_comedi_command_data_wread(void *dev, unsigned int subd
 	return 0;
 }
 
+/*
+ * Zero copy reading of async commands: the COMEDI buffer is memory mapped by
+ * the reader, see rt_comedi_mmap, which gets spans of it to be read in place
+ * and then marks them as read.
+ */
+
+RTAI_SYSCALL_MODE long rt_comedi_get_buffer_size(void *dev, unsigned int subdev)
+{
+	return comedi_get_buffer_size(dev, subdev);
+}
+
+/*
+ * Spans and block samples are returned along with RTE_* errors, so they must
+ * stay below RTE_BASE, which limits them only with the legacy error values.
+ * Spans are just cut, to whole lsampl_t, the rest coming with the next one.
+ */
+#define MAX_SPAN  ((RTE_BASE - 1) & ~(long)(sizeof(lsampl_t) - 1))
+
+RTAI_SYSCALL_MODE long rt_comedi_buffer_span(void *dev, unsigned int subdev, long *offset)
+{
+	long size, avbs, ofst;
+	if ((size = comedi_get_buffer_size(dev, subdev)) <= 0) {
+		return RTE_OBJINV;
+	}
+	RTAI_COMEDI_LOCK(dev, subdev);
+	avbs = comedi_get_buffer_contents(dev, subdev);
+	ofst = comedi_get_buffer_offset(dev, subdev);
+	RTAI_COMEDI_UNLOCK(dev, subdev);
+	if (avbs < 0 || ofst < 0) {
+		return RTE_OBJINV;
+	}
+	if (avbs > size - ofst) {
+		avbs = size - ofst;
+	}
+	if (avbs > MAX_SPAN) {
+		avbs = MAX_SPAN;
+	}
+	if (KSPACE(offset) || RTAI_USE_STACK_ARGS) {
+		offset[0] = ofst;
+	} else {
+		rt_put_user(ofst, offset);
+	}
+	return avbs;
+}
+
+RTAI_SYSCALL_MODE long rt_comedi_buffer_mark_read(void *dev, unsigned int subdev, long nbytes)
+{
+	long retval;
+	RTAI_COMEDI_LOCK(dev, subdev);
+	retval = comedi_mark_buffer_read(dev, subdev, nbytes);
+	RTAI_COMEDI_UNLOCK(dev, subdev);
+	return retval;
+}
+
+static inline long __rt_comedi_wait_scans(void *dev, unsigned int subdev, long nscans, long scanlen, long *offset, RTIME until, int waitmode)
+{
+	RT_TASK *task = _rt_whoami();
+	struct scan_wait *w;
+	unsigned long flags;
+	long bytes, retval = 0;
+
+	if ((bytes = nscans*scanlen) <= 0 || bytes > comedi_get_buffer_size(dev, subdev)) {
+		return RTE_OBJINV;
+	}
+	flags = rt_global_save_flags_and_cli();
+	if (!(w = get_scan_wait(task))) {
+		rt_global_restore_flags(flags);
+		return RTE_PERM;
+	}
+	w->dev    = dev;
+	w->subdev = subdev;
+	if (comedi_get_buffer_contents(dev, subdev) < bytes) {
+		w->bytes = bytes;
+		task->resumsg = 0;
+		rt_global_restore_flags(flags);
+		retval = waitmode == WAITUNTIL ? rt_task_suspend_until(task, until) : rt_task_suspend(task);
+		flags = rt_global_save_flags_and_cli();
+		if (w->bytes) {
+			w->bytes = 0;
+		} else if (retval) {
+			// resumed by the callback just after a timeout, or an unblock
+			rt_task_suspend_if(task);
+			retval = 0;
+		}
+	}
+	rt_global_restore_flags(flags);
+	if (retval) {
+		return retval;
+	}
+	return rt_comedi_buffer_span(dev, subdev, offset);
+}
+
+RTAI_SYSCALL_MODE long rt_comedi_wait_scans(void *dev, unsigned int subdev, long nscans, long scanlen, long *offset)
+{
+	return __rt_comedi_wait_scans(dev, subdev, nscans, scanlen, offset, (RTIME)0, WAIT);
+}
+
+RTAI_SYSCALL_MODE long _rt_comedi_wait_scans_until(void *dev, unsigned int subdev, long nscans, long scanlen, long *offset, RTIME until)
+{
+	return __rt_comedi_wait_scans(dev, subdev, nscans, scanlen, offset, until, WAITUNTIL);
+}
+
+RTAI_SYSCALL_MODE long _rt_comedi_wait_scans_timed(void *dev, unsigned int subdev, long nscans, long scanlen, long *offset, RTIME delay)
+{
+	return _rt_comedi_wait_scans_until(dev, subdev, nscans, scanlen, offset, rt_get_time() + delay);
+}
+
+/*
+ * Block acquisition: whole blocks of nscans scans of nchans samples are read
+ * as lsampl_t, each one along with its sequence number, the time at which it
+ * was found complete, the callbacks arrived since the previous one and the
+ * number of blocks already complete behind it, i.e. how late the reader is.
+ */
+
+RTAI_SYSCALL_MODE long rt_comedi_block_config(void *dev, unsigned int subdev, long nchans, long nscans)
+{
+	RT_TASK *task = _rt_whoami();
+	struct scan_wait *w;
+	unsigned long flags;
+	long sampsize, block_bytes;
+
+	sampsize = comedi_get_subdevice_flags(dev, subdev) & SDF_LSAMPL ? sizeof(lsampl_t) : sizeof(sampl_t);
+	if (nchans*nscans >= RTE_BASE || (block_bytes = nchans*nscans*sampsize) <= 0 || block_bytes > comedi_get_buffer_size(dev, subdev)) {
+		return RTE_OBJINV;
+	}
+	flags = rt_global_save_flags_and_cli();
+	if (!(w = get_scan_wait(task))) {
+		rt_global_restore_flags(flags);
+		return RTE_PERM;
+	}
+	w->dev         = dev;
+	w->subdev      = subdev;
+	w->cbmask      = 0;
+	w->sampsize    = sampsize;
+	w->block_bytes = block_bytes;
+	w->seq = w->stamped = 0;
+	rt_global_restore_flags(flags);
+	return nchans*nscans;
+}
+
+#define BLOCK_CHUNK  64
+
+RTAI_SYSCALL_MODE long rt_comedi_block_read(void *dev, unsigned int subdev, RT_COMEDI_BLOCK *blkarg, lsampl_t *data)
+{
+	RT_TASK *task = _rt_whoami();
+	struct scan_wait *w;
+	RT_COMEDI_BLOCK blk;
+	lsampl_t chunk[BLOCK_CHUNK];
+	char *aibuf;
+	unsigned long flags;
+	long size, ofst, avbs, nsamples, i, k, n;
+
+	if (!(w = find_scan_wait(task)) || !w->block_bytes || w->dev != dev || w->subdev != subdev) {
+		return RTE_OBJINV;
+	}
+	if (comedi_map(dev, subdev, &aibuf) || (size = comedi_get_buffer_size(dev, subdev)) <= 0) {
+		return RTE_OBJINV;
+	}
+	RTAI_COMEDI_LOCK(dev, subdev);
+	flags = rt_global_save_flags_and_cli();
+	avbs = comedi_get_buffer_contents(dev, subdev);
+	blk.seq = w->seq;
+	blk.cbmask = w->cbmask;
+	w->cbmask = 0;
+	if (avbs < w->block_bytes) {
+		rt_global_restore_flags(flags);
+		RTAI_COMEDI_UNLOCK(dev, subdev);
+		blk.stamp = 0;
+		blk.overrun = 0;
+		nsamples = 0;
+		goto ret;
+	}
+	if ((long)(w->stamped - w->seq) <= 0) {
+		// the data arrived ahead of their callback
+		blk.stamp = rt_get_time();
+		w->stamped = w->seq + 1;
+	} else {
+		// 0 if its stamp has been overwritten, being the reader too late
+		blk.stamp = w->stamped - w->seq > BLOCK_STAMPS ? 0 : w->stamps[w->seq & (BLOCK_STAMPS - 1)];
+	}
+	blk.overrun = avbs/w->block_bytes - 1;
+	rt_global_restore_flags(flags);
+
+	ofst = comedi_get_buffer_offset(dev, subdev);
+	nsamples = w->block_bytes/w->sampsize;
+	for (i = 0; i < nsamples; i += n) {
+		n = nsamples - i > BLOCK_CHUNK ? BLOCK_CHUNK : nsamples - i;
+		for (k = 0; k < n; k++, ofst += w->sampsize) {
+			if (ofst >= size) {
+				ofst = 0;
+			}
+			chunk[k] = w->sampsize == sizeof(lsampl_t) ? *(lsampl_t *)(aibuf + ofst) : *(sampl_t *)(aibuf + ofst);
+		}
+		if (KSPACE(data) || RTAI_USE_STACK_ARGS) {
+			memcpy(data + i, chunk, n*sizeof(lsampl_t));
+		} else {
+			rt_copy_to_user(data + i, chunk, n*sizeof(lsampl_t));
+		}
+	}
+	// the callback must not see the block read before seq moves past it
+	flags = rt_global_save_flags_and_cli();
+	comedi_mark_buffer_read(dev, subdev, w->block_bytes);
+	w->seq++;
+	rt_global_restore_flags(flags);
+	RTAI_COMEDI_UNLOCK(dev, subdev);
+ret:
+	if (KSPACE(blkarg) || RTAI_USE_STACK_ARGS) {
+		blkarg[0] = blk;
+	} else {
+		rt_copy_to_user(blkarg, &blk, sizeof(blk));
+	}
+	return nsamples;
+}
+
+static inline long __rt_comedi_block_wread(void *dev, unsigned int subdev, RT_COMEDI_BLOCK *blk, lsampl_t *data, RTIME until, int waitmode)
+{
+	struct scan_wait *w;
+	long retval, ofst;
+
+	if (!(w = find_scan_wait(_rt_whoami())) || !w->block_bytes) {
+		return RTE_OBJINV;
+	}
+	if ((retval = __rt_comedi_wait_scans(dev, subdev, 1, w->block_bytes, &ofst, until, waitmode)) >= RTE_BASE) {
+		return retval;
+	}
+	return rt_comedi_block_read(dev, subdev, blk, data);
+}
+
+RTAI_SYSCALL_MODE long rt_comedi_block_wread(void *dev, unsigned int subdev, RT_COMEDI_BLOCK *blk, lsampl_t *data)
+{
+	return __rt_comedi_block_wread(dev, subdev, blk, data, (RTIME)0, WAIT);
+}
+
+RTAI_SYSCALL_MODE long _rt_comedi_block_wread_until(void *dev, unsigned int subdev, RT_COMEDI_BLOCK *blk, lsampl_t *data, RTIME until)
+{
+	return __rt_comedi_block_wread(dev, subdev, blk, data, until, WAITUNTIL);
+}
+
+RTAI_SYSCALL_MODE long _rt_comedi_block_wread_timed(void *dev, unsigned int subdev, RT_COMEDI_BLOCK *blk, lsampl_t *data, RTIME delay)
+{
+	return _rt_comedi_block_wread_until(dev, subdev, blk, data, rt_get_time() + delay);
+}
+
 RTAI_SYSCALL_MODE long rt_comedi_command_data_write(void *dev, unsigned int subdev, long nchans, lsampl_t *data)
 {
 	lsampl_t *aobuf;
@@ -771,6 +1152,17 @@ static struct rt_fun_entry rtai_comedi_fun[] = {
  ,[_RT_KCOMEDI_COMMAND]            = { 0, RT_comedi_command }
  ,[_RT_KCOMEDI_DO_INSN_LIST]       = { 0, RT_comedi_do_insnlist }
  ,[_RT_KCOMEDI_COMD_DATA_WREAD]    = { 0, RT_comedi_command_data_wread }
+ ,[_KCOMEDI_GET_BUFFER_SIZE]       = { 0, rt_comedi_get_buffer_size }
+ ,[_KCOMEDI_BUFFER_SPAN]           = { 0, rt_comedi_buffer_span }
+ ,[_KCOMEDI_BUFFER_MARK_READ]      = { 0, rt_comedi_buffer_mark_read }
+ ,[_KCOMEDI_WAIT_SCANS]            = { 1, rt_comedi_wait_scans }
+ ,[_KCOMEDI_WAIT_SCANS_UNTIL]      = { 1, _rt_comedi_wait_scans_until }
+ ,[_KCOMEDI_WAIT_SCANS_TIMED]      = { 1, _rt_comedi_wait_scans_timed }
+ ,[_KCOMEDI_BLOCK_CONFIG]          = { 0, rt_comedi_block_config }
+ ,[_KCOMEDI_BLOCK_READ]            = { 0, rt_comedi_block_read }
+ ,[_KCOMEDI_BLOCK_WREAD]           = { 1, rt_comedi_block_wread }
+ ,[_KCOMEDI_BLOCK_WREAD_UNTIL]     = { 1, _rt_comedi_block_wread_until }
+ ,[_KCOMEDI_BLOCK_WREAD_TIMED]     = { 1, _rt_comedi_block_wread_timed }
 };
 
 #ifdef CONFIG_RTAI_USE_LINUX_COMEDI
@@ -836,6 +1228,8 @@ int __rtai_comedi_init(void)
 
 void __rtai_comedi_exit(void)
 {
+	unsigned long flags;
+	int i;
 #ifdef CONFIG_RTAI_USE_LINUX_COMEDI
 	int irq;
 	for (irq = 0; irq < RTAI_NR_IRQS; irq++) {
@@ -847,6 +1241,14 @@ void __rtai_comedi_exit(void)
 	rt_comedi_release_irq = rt_release_irq;
 	rt_comedi_busy_sleep  = __udelay;
 #endif
+	// tasks may survive this module, not its exit handlers
+	flags = rt_global_save_flags_and_cli();
+	for (i = 0; i < MAX_SCAN_WAITS; i++) {
+		if (scan_waits[i].task) {
+			release_scan_wait(&scan_waits[i]);
+		}
+	}
+	rt_global_restore_flags(flags);
 	reset_rt_fun_ext_index(rtai_comedi_fun, FUN_COMEDI_LXRT_INDX);
 }
 
@@ -868,3 +1270,14 @@ EXPORT_SYMBOL(_rt_comedi_command_data_wread_timed);
 EXPORT_SYMBOL(rt_comedi_do_insnlist);
 EXPORT_SYMBOL(rt_comedi_trigger);
 EXPORT_SYMBOL(rt_comedi_command_data_write);
+EXPORT_SYMBOL(rt_comedi_get_buffer_size);
+EXPORT_SYMBOL(rt_comedi_buffer_span);
+EXPORT_SYMBOL(rt_comedi_buffer_mark_read);
+EXPORT_SYMBOL(rt_comedi_wait_scans);
+EXPORT_SYMBOL(_rt_comedi_wait_scans_until);
+EXPORT_SYMBOL(_rt_comedi_wait_scans_timed);
+EXPORT_SYMBOL(rt_comedi_block_config);
+EXPORT_SYMBOL(rt_comedi_block_read);
+EXPORT_SYMBOL(rt_comedi_block_wread);
+EXPORT_SYMBOL(_rt_comedi_block_wread_until);
+EXPORT_SYMBOL(_rt_comedi_block_wread_timed);
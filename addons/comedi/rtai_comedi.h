@@ -103,6 +103,21 @@ extern "C" {
 #define _RT_KCOMEDI_DO_INSN_LIST 	50
 #define _RT_KCOMEDI_COMD_DATA_WREAD 	51
 
+/* RTAI specific zero copy reading of async commands */
+#define _KCOMEDI_GET_BUFFER_SIZE	52
+#define _KCOMEDI_BUFFER_SPAN		53
+#define _KCOMEDI_BUFFER_MARK_READ	54
+#define _KCOMEDI_WAIT_SCANS		55
+#define _KCOMEDI_WAIT_SCANS_UNTIL	56
+#define _KCOMEDI_WAIT_SCANS_TIMED	57
+
+/* RTAI specific block acquisition */
+#define _KCOMEDI_BLOCK_CONFIG		58
+#define _KCOMEDI_BLOCK_READ		59
+#define _KCOMEDI_BLOCK_WREAD		60
+#define _KCOMEDI_BLOCK_WREAD_UNTIL	61
+#define _KCOMEDI_BLOCK_WREAD_TIMED	62
+
 #ifdef CONFIG_RTAI_USE_LINUX_COMEDI
 typedef unsigned int lsampl_t;
 typedef unsigned short sampl_t;
@@ -116,6 +131,14 @@ struct cmds_ofstlens { unsigned int cmd_chanlist_ofst, cmd_data_ofst, cmd_ofst,
 
 struct insns_ofstlens { unsigned int n_ofst, subdev_ofst, chanspec_ofst, insn_len, insns_ofst, data_ofsts, data_ofst; };
 
+/* What comes along with each block read by rt_comedi_block_(w)read. */
+typedef struct rt_comedi_block {
+	unsigned long seq;     // block number, from 0 at rt_comedi_block_config
+	RTIME stamp;           // when the block was found complete, 0 if unknown
+	unsigned int cbmask;   // callbacks arrived since the previous block
+	unsigned int overrun;  // blocks already complete behind this one
+} RT_COMEDI_BLOCK;
+
 #if 1
 #include <linux/comedi.h>
 #else // new way to be improved by using what configured for RTAI
@@ -172,9 +195,51 @@ RTAI_SYSCALL_MODE int rt_comedi_trigger(void *dev, unsigned int subdev);
 
 RTAI_SYSCALL_MODE long rt_comedi_command_data_write(void *dev, unsigned int subdev, long nchans, lsampl_t *data);
 
+RTAI_SYSCALL_MODE long rt_comedi_get_buffer_size(void *dev, unsigned int subdev);
+
+RTAI_SYSCALL_MODE long rt_comedi_buffer_span(void *dev, unsigned int subdev, long *offset);
+
+RTAI_SYSCALL_MODE long rt_comedi_buffer_mark_read(void *dev, unsigned int subdev, long nbytes);
+
+RTAI_SYSCALL_MODE long rt_comedi_wait_scans(void *dev, unsigned int subdev, long nscans, long scanlen, long *offset);
+
+RTAI_SYSCALL_MODE long _rt_comedi_wait_scans_until(void *dev, unsigned int subdev, long nscans, long scanlen, long *offset, RTIME until);
+static inline long rt_comedi_wait_scans_until(void *dev, unsigned int subdev, long nscans, long scanlen, long *offset, RTIME until)
+{
+	return _rt_comedi_wait_scans_until(dev, subdev, nscans, scanlen, offset, until);
+}
+
+RTAI_SYSCALL_MODE long _rt_comedi_wait_scans_timed(void *dev, unsigned int subdev, long nscans, long scanlen, long *offset, RTIME delay);
+static inline long rt_comedi_wait_scans_timed(void *dev, unsigned int subdev, long nscans, long scanlen, long *offset, RTIME delay)
+{
+	return _rt_comedi_wait_scans_timed(dev, subdev, nscans, scanlen, offset, delay);
+}
+
+RTAI_SYSCALL_MODE long rt_comedi_block_config(void *dev, unsigned int subdev, long nchans, long nscans);
+
+RTAI_SYSCALL_MODE long rt_comedi_block_read(void *dev, unsigned int subdev, RT_COMEDI_BLOCK *blk, lsampl_t *data);
+
+RTAI_SYSCALL_MODE long rt_comedi_block_wread(void *dev, unsigned int subdev, RT_COMEDI_BLOCK *blk, lsampl_t *data);
+
+RTAI_SYSCALL_MODE long _rt_comedi_block_wread_until(void *dev, unsigned int subdev, RT_COMEDI_BLOCK *blk, lsampl_t *data, RTIME until);
+static inline long rt_comedi_block_wread_until(void *dev, unsigned int subdev, RT_COMEDI_BLOCK *blk, lsampl_t *data, RTIME until)
+{
+	return _rt_comedi_block_wread_until(dev, subdev, blk, data, until);
+}
+
+RTAI_SYSCALL_MODE long _rt_comedi_block_wread_timed(void *dev, unsigned int subdev, RT_COMEDI_BLOCK *blk, lsampl_t *data, RTIME delay);
+static inline long rt_comedi_block_wread_timed(void *dev, unsigned int subdev, RT_COMEDI_BLOCK *blk, lsampl_t *data, RTIME delay)
+{
+	return _rt_comedi_block_wread_timed(dev, subdev, blk, data, delay);
+}
+
 #else  /* __KERNEL__ not defined */
 
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
 #include <asm/rtai_lxrt.h>
 #include <rtai_msg.h>
 #include <rtai_shm.h>
@@ -375,6 +440,99 @@ RTAI_PROTO(long, rt_comedi_command_data_write, (void *dev, unsigned int subdev,
 #endif
 }
 
+RTAI_PROTO(long, rt_comedi_get_buffer_size, (void *dev, unsigned int subdev))
+{
+	struct { void *dev; unsigned long subdev; } arg = { dev, subdev };
+	return rtai_lxrt(FUN_COMEDI_LXRT_INDX, COMEDI_LXRT_SIZARG, _KCOMEDI_GET_BUFFER_SIZE, &arg).i[LOW];
+}
+
+RTAI_PROTO(long, rt_comedi_buffer_span, (void *dev, unsigned int subdev, long *offset))
+{
+	struct { void *dev; unsigned long subdev; long *offset; } arg = { dev, subdev, offset };
+	return rtai_lxrt(FUN_COMEDI_LXRT_INDX, COMEDI_LXRT_SIZARG, _KCOMEDI_BUFFER_SPAN, &arg).i[LOW];
+}
+
+RTAI_PROTO(long, rt_comedi_buffer_mark_read, (void *dev, unsigned int subdev, long nbytes))
+{
+	struct { void *dev; unsigned long subdev; long nbytes; } arg = { dev, subdev, nbytes };
+	return rtai_lxrt(FUN_COMEDI_LXRT_INDX, COMEDI_LXRT_SIZARG, _KCOMEDI_BUFFER_MARK_READ, &arg).i[LOW];
+}
+
+RTAI_PROTO(long, rt_comedi_wait_scans, (void *dev, unsigned int subdev, long nscans, long scanlen, long *offset))
+{
+	struct { void *dev; unsigned long subdev; long nscans; long scanlen; long *offset; } arg = { dev, subdev, nscans, scanlen, offset };
+	return rtai_lxrt(FUN_COMEDI_LXRT_INDX, COMEDI_LXRT_SIZARG, _KCOMEDI_WAIT_SCANS, &arg).i[LOW];
+}
+
+RTAI_PROTO(long, rt_comedi_wait_scans_until, (void *dev, unsigned int subdev, long nscans, long scanlen, long *offset, RTIME until))
+{
+	struct { void *dev; unsigned long subdev; long nscans; long scanlen; long *offset; RTIME until; } arg = { dev, subdev, nscans, scanlen, offset, until };
+	return rtai_lxrt(FUN_COMEDI_LXRT_INDX, COMEDI_LXRT_SIZARG, _KCOMEDI_WAIT_SCANS_UNTIL, &arg).i[LOW];
+}
+
+RTAI_PROTO(long, rt_comedi_wait_scans_timed, (void *dev, unsigned int subdev, long nscans, long scanlen, long *offset, RTIME delay))
+{
+	struct { void *dev; unsigned long subdev; long nscans; long scanlen; long *offset; RTIME delay; } arg = { dev, subdev, nscans, scanlen, offset, delay };
+	return rtai_lxrt(FUN_COMEDI_LXRT_INDX, COMEDI_LXRT_SIZARG, _KCOMEDI_WAIT_SCANS_TIMED, &arg).i[LOW];
+}
+
+RTAI_PROTO(long, rt_comedi_block_config, (void *dev, unsigned int subdev, long nchans, long nscans))
+{
+	struct { void *dev; unsigned long subdev; long nchans; long nscans; } arg = { dev, subdev, nchans, nscans };
+	return rtai_lxrt(FUN_COMEDI_LXRT_INDX, COMEDI_LXRT_SIZARG, _KCOMEDI_BLOCK_CONFIG, &arg).i[LOW];
+}
+
+RTAI_PROTO(long, rt_comedi_block_read, (void *dev, unsigned int subdev, RT_COMEDI_BLOCK *blk, lsampl_t *data))
+{
+	struct { void *dev; unsigned long subdev; RT_COMEDI_BLOCK *blk; lsampl_t *data; } arg = { dev, subdev, blk, data };
+	return rtai_lxrt(FUN_COMEDI_LXRT_INDX, COMEDI_LXRT_SIZARG, _KCOMEDI_BLOCK_READ, &arg).i[LOW];
+}
+
+RTAI_PROTO(long, rt_comedi_block_wread, (void *dev, unsigned int subdev, RT_COMEDI_BLOCK *blk, lsampl_t *data))
+{
+	struct { void *dev; unsigned long subdev; RT_COMEDI_BLOCK *blk; lsampl_t *data; } arg = { dev, subdev, blk, data };
+	return rtai_lxrt(FUN_COMEDI_LXRT_INDX, COMEDI_LXRT_SIZARG, _KCOMEDI_BLOCK_WREAD, &arg).i[LOW];
+}
+
+RTAI_PROTO(long, rt_comedi_block_wread_until, (void *dev, unsigned int subdev, RT_COMEDI_BLOCK *blk, lsampl_t *data, RTIME until))
+{
+	struct { void *dev; unsigned long subdev; RT_COMEDI_BLOCK *blk; lsampl_t *data; RTIME until; } arg = { dev, subdev, blk, data, until };
+	return rtai_lxrt(FUN_COMEDI_LXRT_INDX, COMEDI_LXRT_SIZARG, _KCOMEDI_BLOCK_WREAD_UNTIL, &arg).i[LOW];
+}
+
+RTAI_PROTO(long, rt_comedi_block_wread_timed, (void *dev, unsigned int subdev, RT_COMEDI_BLOCK *blk, lsampl_t *data, RTIME delay))
+{
+	struct { void *dev; unsigned long subdev; RT_COMEDI_BLOCK *blk; lsampl_t *data; RTIME delay; } arg = { dev, subdev, blk, data, delay };
+	return rtai_lxrt(FUN_COMEDI_LXRT_INDX, COMEDI_LXRT_SIZARG, _KCOMEDI_BLOCK_WREAD_TIMED, &arg).i[LOW];
+}
+
+/*
+ * Map, read only, the buffer of the async command subdevice subdev of dev, 
+ * opened from filename, into the calling process. Its size is returned in 
+ * size. It must not be used in hard real time.
+ */
+RTAI_PROTO(void *, rt_comedi_mmap, (const char *filename, void *dev, unsigned int subdev, long *size))
+{
+	void *buf;
+	int fd;
+
+	if ((*size = rt_comedi_get_buffer_size(dev, subdev)) <= 0 || (fd = open(filename, O_RDONLY)) < 0) {
+		return NULL;
+	}
+#ifdef COMEDI_SETRSUBD
+	// useless if subdev is the default read subdevice, so a failure is harmless
+	ioctl(fd, COMEDI_SETRSUBD, subdev);
+#endif
+	buf = mmap(NULL, *size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	return buf != MAP_FAILED ? buf : NULL;
+}
+
+RTAI_PROTO(int, rt_comedi_munmap, (void *buf, long size))
+{
+	return munmap(buf, size);
+}
+
 RTAI_PROTO(int, comedi_data_write, (void *dev, unsigned int subdev, unsigned int chan, unsigned int range, unsigned int aref, lsampl_t data))
 {
 	struct { void *dev; unsigned long subdev; unsigned long chan; unsigned long range; unsigned long aref; unsigned long data; } arg = { dev, subdev, chan, range, aref, data };
@@ -58,6 +58,7 @@
 #define IIR_RX			0x04
 #define IIR_STAT		0x06
 #define IIR_MASK		0x07
+#define IIR_TIMEOUT		0x08
 
 #define RHR			0	/* Receive Holding Buffer */
 #define THR			0	/* Transmit Holding Buffer */
@@ -78,9 +79,7 @@ struct rt_16550_context {
 	rtdm_lock_t lock;		/* lock to protect context struct */
 
 	unsigned long base_addr;	/* hardware IO base address */
-#ifdef CONFIG_RTAI_16550A_ANY
 	int io_mode;			/* hardware IO-access mode */
-#endif
 	int tx_fifo;			/* cached global tx_fifo[<device>] */
 
 	int in_head;			/* RX ring buffer, head pointer */
@@ -142,33 +141,48 @@ MODULE_PARM_DESC(start_index, "First device instance number to be used");
 MODULE_LICENSE("GPL");
 MODULE_AUTHOR("jan.kiszka@web.de");
 
+#include "16550A_soft.h"
 #include "16550A_io.h"
 #include "16550A_pnp.h"
 #include "16550A_pci.h"
 
+/*
+ * Receive bursts: the first one is as long as the FIFO trigger level, that
+ * many bytes being known to be there when the IIR tells so, then LSR is
+ * polled once per byte, as long as data keep coming.
+ */
 static inline int rt_16550_rx_interrupt(struct rt_16550_context *ctx,
-					uint64_t * timestamp)
+					uint64_t * timestamp, int burst)
 {
 	unsigned long base = ctx->base_addr;
 	int mode = rt_16550_io_mode_from_ctx(ctx);
 	int rbytes = 0;
 	int lsr = 0;
-	int c;
+	int n, i;
 
 	do {
-		c = rt_16550_reg_in(mode, base, RHR);	/* read input char */
-
-		ctx->in_buf[ctx->in_tail] = c;
-		if (ctx->in_history)
-			ctx->in_history[ctx->in_tail] = *timestamp;
-		ctx->in_tail = (ctx->in_tail + 1) & (IN_BUFFER_SIZE - 1);
+		while (burst > 0) {
+			n = IN_BUFFER_SIZE - ctx->in_tail;
+			if (n > burst)
+				n = burst;
+			rt_16550_reg_in_rep(mode, base, RHR,
+					    &ctx->in_buf[ctx->in_tail], n);
+			if (ctx->in_history)
+				for (i = 0; i < n; i++)
+					ctx->in_history[ctx->in_tail + i] =
+					    *timestamp;
+			ctx->in_tail = (ctx->in_tail + n) & (IN_BUFFER_SIZE - 1);
+			ctx->in_npend += n;
+			rbytes += n;
+			burst -= n;
+		}
 
-		if (++ctx->in_npend > IN_BUFFER_SIZE) {
+		if (ctx->in_npend > IN_BUFFER_SIZE) {
 			lsr |= RTSER_SOFT_OVERRUN_ERR;
-			ctx->in_npend--;
+			ctx->in_npend = IN_BUFFER_SIZE;
 		}
 
-		rbytes++;
+		burst = 1;
 		lsr &= ~RTSER_LSR_DATA;
 		lsr |= (rt_16550_reg_in(mode, base, LSR) &
 			(RTSER_LSR_DATA | RTSER_LSR_OVERRUN_ERR |
@@ -194,23 +208,31 @@ static inline int rt_16550_rx_interrupt(struct rt_16550_context *ctx,
 
 static inline void rt_16550_tx_interrupt(struct rt_16550_context *ctx)
 {
-	int c;
+	int n;
 	int count;
 	unsigned long base = ctx->base_addr;
 	int mode = rt_16550_io_mode_from_ctx(ctx);
 
 /*	if (uart->modem & MSR_CTS)*/
 	{
-		for (count = ctx->tx_fifo;
-		     (count > 0) && (ctx->out_npend > 0);
-		     count--, ctx->out_npend--) {
-			c = ctx->out_buf[ctx->out_head++];
-			rt_16550_reg_out(mode, base, THR, c);
-			ctx->out_head &= (OUT_BUFFER_SIZE - 1);
+		count = (ctx->out_npend < ctx->tx_fifo) ?
+			ctx->out_npend : ctx->tx_fifo;
+		while (count > 0) {
+			n = OUT_BUFFER_SIZE - ctx->out_head;
+			if (n > count)
+				n = count;
+			rt_16550_reg_out_rep(mode, base, THR,
+					     &ctx->out_buf[ctx->out_head], n);
+			ctx->out_head = (ctx->out_head + n) &
+					(OUT_BUFFER_SIZE - 1);
+			ctx->out_npend -= n;
+			count -= n;
 		}
 	}
 }
 
+static const int rx_trigger[4] = { 1, 4, 8, 14 };
+
 static inline void rt_16550_stat_interrupt(struct rt_16550_context *ctx)
 {
 	unsigned long base = ctx->base_addr;
@@ -240,18 +262,21 @@ static int rt_16550_interrupt(rtdm_irq_t * irq_context)
 	rtdm_lock_get(&ctx->lock);
 
 	while (1) {
-		iir = rt_16550_reg_in(mode, base, IIR) & IIR_MASK;
+		iir = rt_16550_reg_in(mode, base, IIR);
 		if (testbits(iir, IIR_PIRQ))
 			break;
 
-		if (iir == IIR_RX) {
-			rbytes += rt_16550_rx_interrupt(ctx, &timestamp);
+		if ((iir & IIR_MASK) == IIR_RX) {
+			/* a timeout tells just that the FIFO is not empty */
+			rbytes += rt_16550_rx_interrupt(ctx, &timestamp,
+				testbits(iir, IIR_TIMEOUT) ? 1 :
+				rx_trigger[ctx->config.fifo_depth >> 6]);
 			events |= RTSER_EVENT_RXPEND;
-		} else if (iir == IIR_STAT)
+		} else if ((iir & IIR_MASK) == IIR_STAT)
 			rt_16550_stat_interrupt(ctx);
-		else if (iir == IIR_TX)
+		else if ((iir & IIR_MASK) == IIR_TX)
 			rt_16550_tx_interrupt(ctx);
-		else if (iir == IIR_MODEM) {
+		else if ((iir & IIR_MASK) == IIR_MODEM) {
 			modem = rt_16550_reg_in(mode, base, MSR);
 			if (modem & (modem << 4))
 				events |= RTSER_EVENT_MODEMHI;
@@ -300,6 +325,27 @@ static int rt_16550_interrupt(rtdm_irq_t * irq_context)
 	return ret;
 }
 
+/*
+ * A loopback device has no IRQ line, so the handler is run here, after any
+ * register write that may have raised an interrupt in the model. Rescheduling
+ * is held back till the handler has released ctx->lock, as it would be at the
+ * end of a real interrupt.
+ */
+static void rt_16550_soft_kick(struct rt_16550_context *ctx)
+{
+	rtdm_lockctx_t lock_ctx;
+
+	if (likely(rt_16550_io_mode_from_ctx(ctx) != MODE_SOFT))
+		return;
+
+	rt_sched_lock();
+	rtdm_lock_irqsave(lock_ctx);
+	if (rt_16550_soft_pending((struct uart_soft *)ctx->base_addr))
+		rt_16550_interrupt(&ctx->irq_handle);
+	rtdm_lock_irqrestore(lock_ctx);
+	rt_sched_unlock();
+}
+
 static int rt_16550_set_config(struct rt_16550_context *ctx,
 			       const struct rtser_config *config,
 			       uint64_t **in_history_ptr)
@@ -482,9 +528,14 @@ int rt_16550_open(struct rtdm_dev_context *context,
 
 	rt_16550_set_config(ctx, &default_config, &dummy);
 
-	err = rtdm_irq_request(&ctx->irq_handle, irq[dev_id],
-			       rt_16550_interrupt, irqtype[dev_id],
-			       context->device->proc_name, ctx);
+	if (rt_16550_io_mode_from_ctx(ctx) == MODE_SOFT) {
+		/* no IRQ line, see rt_16550_soft_kick */
+		ctx->irq_handle.cookie = ctx;
+		err = 0;
+	} else
+		err = rtdm_irq_request(&ctx->irq_handle, irq[dev_id],
+				       rt_16550_interrupt, irqtype[dev_id],
+				       context->device->proc_name, ctx);
 	if (err) {
 		/* reset DTR and RTS */
 		rt_16550_reg_out(rt_16550_io_mode_from_ctx(ctx), ctx->base_addr,
@@ -504,6 +555,8 @@ int rt_16550_open(struct rtdm_dev_context *context,
 
 	rtdm_lock_put_irqrestore(&ctx->lock, lock_ctx);
 
+	rt_16550_soft_kick(ctx);
+
 	return 0;
 }
 
@@ -537,7 +590,8 @@ int rt_16550_close(struct rtdm_dev_context *context,
 
 	rtdm_lock_put_irqrestore(&ctx->lock, lock_ctx);
 
-	rtdm_irq_free(&ctx->irq_handle);
+	if (mode != MODE_SOFT)
+		rtdm_irq_free(&ctx->irq_handle);
 
 	rt_16550_cleanup_ctx(ctx);
 
@@ -1051,6 +1105,8 @@ ssize_t rt_16550_write(struct rtdm_dev_context * context,
 					 ctx->ier_status);
 
 			rtdm_lock_put_irqrestore(&ctx->lock, lock_ctx);
+
+			rt_16550_soft_kick(ctx);
 			continue;
 		}
 
@@ -1130,7 +1186,8 @@ int __init rt_16550_init(void)
 			continue;
 
 		err = -EINVAL;
-		if (!irq[i] || !rt_16550_addr_param_valid(i))
+		if ((!irq[i] && !loopback[i]) ||
+		    !rt_16550_addr_param_valid(i))
 			goto cleanup_out;
 
 		dev = kmalloc(sizeof(struct rtdm_device), GFP_KERNEL);
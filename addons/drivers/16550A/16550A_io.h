@@ -20,7 +20,7 @@
 /* Manages the I/O access method of the driver. */
 
 
-typedef enum { MODE_PIO, MODE_MMIO } io_mode_t;
+typedef enum { MODE_PIO, MODE_MMIO, MODE_SOFT } io_mode_t;
 
 #if defined(CONFIG_RTAI_16550A_PIO) || \
     defined(CONFIG_RTAI_16550A_ANY)
@@ -45,7 +45,8 @@ extern void *mapped_io[]; /* dummy */
 
 static inline unsigned long rt_16550_addr_param(int dev_id)
 {
-	return io[dev_id];
+	return loopback[dev_id] ? (unsigned long)&soft_uart[dev_id] :
+				  io[dev_id];
 }
 
 static inline int rt_16550_addr_param_valid(int dev_id)
@@ -55,24 +56,19 @@ static inline int rt_16550_addr_param_valid(int dev_id)
 
 static inline unsigned long rt_16550_base_addr(int dev_id)
 {
-	return io[dev_id];
+	return loopback[dev_id] ? (unsigned long)&soft_uart[dev_id] :
+				  io[dev_id];
 }
 
 static inline io_mode_t rt_16550_io_mode(int dev_id)
 {
-	return MODE_PIO;
+	return loopback[dev_id] ? MODE_SOFT : MODE_PIO;
 }
 
 static inline io_mode_t
 rt_16550_io_mode_from_ctx(struct rt_16550_context *ctx)
 {
-	return MODE_PIO;
-}
-
-static inline void
-rt_16550_init_io_ctx(int dev_id, struct rt_16550_context *ctx)
-{
-	ctx->base_addr = io[dev_id];
+	return unlikely(ctx->io_mode == MODE_SOFT) ? MODE_SOFT : MODE_PIO;
 }
 
 #elif defined(CONFIG_RTAI_16550A_MMIO)
@@ -83,7 +79,8 @@ extern unsigned long io[]; /* dummy */
 
 static inline unsigned long rt_16550_addr_param(int dev_id)
 {
-	return mem[dev_id];
+	return loopback[dev_id] ? (unsigned long)&soft_uart[dev_id] :
+				  mem[dev_id];
 }
 
 static inline int rt_16550_addr_param_valid(int dev_id)
@@ -93,24 +90,19 @@ static inline int rt_16550_addr_param_valid(int dev_id)
 
 static inline unsigned long rt_16550_base_addr(int dev_id)
 {
-	return (unsigned long)mapped_io[dev_id];
+	return loopback[dev_id] ? (unsigned long)&soft_uart[dev_id] :
+				  (unsigned long)mapped_io[dev_id];
 }
 
 static inline io_mode_t rt_16550_io_mode(int dev_id)
 {
-	return MODE_MMIO;
+	return loopback[dev_id] ? MODE_SOFT : MODE_MMIO;
 }
 
 static inline io_mode_t
 rt_16550_io_mode_from_ctx(struct rt_16550_context *ctx)
 {
-	return MODE_MMIO;
-}
-
-static inline void
-rt_16550_init_io_ctx(int dev_id, struct rt_16550_context *ctx)
-{
-	ctx->base_addr = (unsigned long)mapped_io[dev_id];
+	return unlikely(ctx->io_mode == MODE_SOFT) ? MODE_SOFT : MODE_MMIO;
 }
 
 #elif defined(CONFIG_RTAI_16550A_ANY)
@@ -119,6 +111,8 @@ rt_16550_init_io_ctx(int dev_id, struct rt_16550_context *ctx)
 
 static inline unsigned long rt_16550_addr_param(int dev_id)
 {
+	if (loopback[dev_id])
+		return (unsigned long)&soft_uart[dev_id];
 	return (io[dev_id]) ? io[dev_id] : mem[dev_id];
 }
 
@@ -129,11 +123,15 @@ static inline int rt_16550_addr_param_valid(int dev_id)
 
 static inline unsigned long rt_16550_base_addr(int dev_id)
 {
+	if (loopback[dev_id])
+		return (unsigned long)&soft_uart[dev_id];
 	return (io[dev_id]) ? io[dev_id] : (unsigned long)mapped_io[dev_id];
 }
 
 static inline io_mode_t rt_16550_io_mode(int dev_id)
 {
+	if (loopback[dev_id])
+		return MODE_SOFT;
 	return (io[dev_id]) ? MODE_PIO : MODE_MMIO;
 }
 
@@ -143,28 +141,25 @@ rt_16550_io_mode_from_ctx(struct rt_16550_context *ctx)
 	return ctx->io_mode;
 }
 
+#else
+# error Unsupported I/O access method
+#endif
+
 static inline void
 rt_16550_init_io_ctx(int dev_id, struct rt_16550_context *ctx)
 {
-	if (io[dev_id]) {
-		ctx->base_addr = io[dev_id];
-		ctx->io_mode   = MODE_PIO;
-	} else {
-		ctx->base_addr = (unsigned long)mapped_io[dev_id];
-		ctx->io_mode   = MODE_MMIO;
-	}
+	ctx->base_addr = rt_16550_base_addr(dev_id);
+	ctx->io_mode   = rt_16550_io_mode(dev_id);
 }
 
-#else
-# error Unsupported I/O access method
-#endif
-
 static RT_16550_IO_INLINE u8
 rt_16550_reg_in(io_mode_t io_mode, unsigned long base, int off)
 {
 	switch (io_mode) {
 	case MODE_PIO:
 		return inb(base + off);
+	case MODE_SOFT:
+		return rt_16550_soft_in((struct uart_soft *)base, off);
 	default: /* MODE_MMIO */
 		return readb((void *)base + off);
 	}
@@ -180,6 +175,44 @@ rt_16550_reg_out(io_mode_t io_mode, unsigned long base, int off, u8 val)
 	case MODE_MMIO:
 		writeb(val, (void *)base + off);
 		break;
+	case MODE_SOFT:
+		rt_16550_soft_out((struct uart_soft *)base, off, val);
+		break;
+	}
+}
+
+/* Bursts of accesses to the same register, e.g. to drain the FIFOs. */
+static RT_16550_IO_INLINE void
+rt_16550_reg_in_rep(io_mode_t io_mode, unsigned long base, int off,
+		    void *buf, int n)
+{
+	switch (io_mode) {
+	case MODE_PIO:
+		insb(base + off, buf, n);
+		break;
+	case MODE_MMIO:
+		ioread8_rep((void *)base + off, buf, n);
+		break;
+	case MODE_SOFT:
+		rt_16550_soft_in_rep((struct uart_soft *)base, off, buf, n);
+		break;
+	}
+}
+
+static RT_16550_IO_INLINE void
+rt_16550_reg_out_rep(io_mode_t io_mode, unsigned long base, int off,
+		     const void *buf, int n)
+{
+	switch (io_mode) {
+	case MODE_PIO:
+		outsb(base + off, buf, n);
+		break;
+	case MODE_MMIO:
+		iowrite8_rep((void *)base + off, buf, n);
+		break;
+	case MODE_SOFT:
+		rt_16550_soft_out_rep((struct uart_soft *)base, off, buf, n);
+		break;
 	}
 }
 
@@ -195,6 +228,9 @@ static int rt_16550_init_io(int dev_id, char* name)
 		if (!mapped_io[dev_id])
 			return -EBUSY;
 		break;
+	case MODE_SOFT:
+		rt_16550_soft_reset(&soft_uart[dev_id]);
+		break;
 	}
 	return 0;
 }
@@ -208,5 +244,7 @@ static void rt_16550_release_io(int dev_id)
 	case MODE_MMIO:
 		iounmap(mapped_io[dev_id]);
 		break;
+	case MODE_SOFT:
+		break;
 	}
 }
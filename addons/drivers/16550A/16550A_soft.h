@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2026 The RTAI project
+ *
+ * RTAI is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * RTAI is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with RTAI; if not,see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Software loopback devices, on the UART model shared with the serial
+ * driver, see ../uart_soft.h. There is no IRQ line, so the interrupt handler
+ * is run by the driver itself, see rt_16550_soft_kick, whenever the model
+ * has an interrupt pending after a register write.
+ */
+
+#include "../uart_soft.h"
+
+static int loopback[MAX_DEVICES];
+static struct uart_soft soft_uart[MAX_DEVICES];
+
+compat_module_param_array(loopback, int, MAX_DEVICES, 0400);
+MODULE_PARM_DESC(loopback, "Software loopback devices, no UART needed "
+		 "(1 to use, instead of io/mem/irq)");
+
+static inline int rt_16550_soft_pending(struct uart_soft *s)
+{
+	return !testbits(uart_soft_iir(s), IIR_PIRQ);
+}
+
+static inline u8 rt_16550_soft_in(struct uart_soft *s, int off)
+{
+	return uart_soft_in(s, off);
+}
+
+static inline void rt_16550_soft_out(struct uart_soft *s, int off, u8 val)
+{
+	uart_soft_out(s, off, val);
+}
+
+static void rt_16550_soft_in_rep(struct uart_soft *s, int off,
+				 u8 *buf, int n)
+{
+	while (n-- > 0)
+		*buf++ = uart_soft_in(s, off);
+}
+
+static void rt_16550_soft_out_rep(struct uart_soft *s, int off,
+				  const u8 *buf, int n)
+{
+	while (n-- > 0)
+		uart_soft_out(s, off, *buf++);
+}
+
+static inline void rt_16550_soft_reset(struct uart_soft *s)
+{
+	memset(s, 0, sizeof(*s));
+}
@@ -28,6 +28,7 @@
 #define RT_SP_NO_HAND_SHAKE  0x00
 #define RT_SP_DSR_ON_TX      0x01
 #define RT_SP_HW_FLOW	     0x02
+#define RT_SP_POLLED	     0x04  // rt_spopen only, no UART interrupts
 
 #define RT_SP_PARITY_EVEN    0x18
 #define RT_SP_PARITY_NONE    0x00
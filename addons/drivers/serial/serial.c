@@ -40,8 +40,10 @@
 
 #include <rtai_lxrt.h>
 #include <rtai_sem.h>
+#include <rtai_registry.h>
 #include <rtai_serial.h>
 #include "serialP.h"
+#include "serial_soft.h"
 
 MODULE_AUTHOR("Paolo Mantegazza, Giuseppe Renoldi, Renato Castello.");
 MODULE_DESCRIPTION("RTAI real time serial ports driver with multiport support");
@@ -59,6 +61,9 @@ static int sptxdepth[CONFIG_SIZE] = { 0 };
 static int sptxdepth_size = CONFIG_SIZE; 
 RTAI_MODULE_PARM_ARRAY(sptxdepth, int, &sptxdepth_size, CONFIG_SIZE);
 
+static int sppollns = 100000;  // polling period of RT_SP_POLLED ports
+RTAI_MODULE_PARM(sppollns, int);
+
 struct rt_spct_t *spct;
 
 static int spcnt;	// number of available serial ports
@@ -73,8 +78,12 @@ static int max_opncnt;
 
 #define CHECK_SPINDX(indx)  do { if (indx >= spcnt) return -ENODEV; } while (0)
 
+// polled ports keep UART interrupts disabled, ier being just bookkeeping
+#define SET_IER(p)  sp_outb((p)->polled ? 0 : (p)->ier, (p)->base_adr + RT_SP_IER)
+
 
 static void mbx_init(struct rt_spmbx *mbx);
+static void rt_spsoft_kick(struct rt_spct_t *p);
 
 /*
  * rt_spclear_rx
@@ -101,10 +110,10 @@ RTAI_SYSCALL_MODE int rt_spclear_rx(unsigned int tty)
 		mbx_init(&(p = spct + tty)->ibuf);
 		chip_atomic_bgn(flags);
 		if (p->fifotrig) {
-			outb(inb(p->base_adr + RT_SP_FCR) | FCR_INPUT_FIFO_RESET, p->base_adr + RT_SP_FCR);
+			sp_outb(sp_inb(p->base_adr + RT_SP_FCR) | FCR_INPUT_FIFO_RESET, p->base_adr + RT_SP_FCR);
 		}
 		if (p->mode & RT_SP_HW_FLOW) {
-			outb(p->mcr |= MCR_RTS, p->base_adr + RT_SP_MCR);
+			sp_outb(p->mcr |= MCR_RTS, p->base_adr + RT_SP_MCR);
 		}
 		chip_atomic_end(flags);
 		clear_bit(0, &p->just_oner);
@@ -138,9 +147,10 @@ RTAI_SYSCALL_MODE int rt_spclear_tx(unsigned int tty)
 	if (!test_and_set_bit(0, &(p = spct + tty)->just_onew)) {
 		mbx_init(&(p = spct + tty)->obuf);
 		chip_atomic_bgn(flags);
-		outb(p->ier &= ~IER_ETBEI, p->base_adr | RT_SP_IER);
+		p->ier &= ~IER_ETBEI;
+		SET_IER(p);
 		if (p->fifotrig) {
-			outb(inb(p->base_adr + RT_SP_FCR) | FCR_OUTPUT_FIFO_RESET, p->base_adr + RT_SP_FCR);
+			sp_outb(sp_inb(p->base_adr + RT_SP_FCR) | FCR_OUTPUT_FIFO_RESET, p->base_adr + RT_SP_FCR);
 		}
 		chip_atomic_end(flags);
 		clear_bit(0, &p->just_onew);
@@ -176,7 +186,12 @@ RTAI_SYSCALL_MODE int rt_spset_mode(unsigned int tty, int mode)
 		return -EINVAL;
 	}
 	// Enable MODEM status interrupt if RT_SP_DSR_ON_TX or RT_SP_HW_FLOW mode
-	outb ((spct[tty].mode = mode) == RT_SP_NO_HAND_SHAKE ? (spct[tty].ier &= ~IER_EDSSI) : (spct[tty].ier |= IER_EDSSI), spct[tty].base_adr + RT_SP_IER);
+	if ((spct[tty].mode = mode) == RT_SP_NO_HAND_SHAKE) {
+		spct[tty].ier &= ~IER_EDSSI;
+	} else {
+		spct[tty].ier |= IER_EDSSI;
+	}
+	SET_IER(spct + tty);
 	return 0;
 }
 
@@ -208,7 +223,7 @@ RTAI_SYSCALL_MODE int rt_spset_fifotrig(unsigned int tty, int fifotrig)
 	if ((fifotrig & 0xC0) != fifotrig) {
 		return -EINVAL;
 	}
-	outb(spct[tty].fifotrig ? spct[tty].fifotrig | FCR_FIFO_ENABLE : 0, spct[tty].base_adr + RT_SP_FCR);
+	sp_outb(spct[tty].fifotrig ? spct[tty].fifotrig | FCR_FIFO_ENABLE : 0, spct[tty].base_adr + RT_SP_FCR);
 	return 0;
 }
 
@@ -239,7 +254,7 @@ RTAI_SYSCALL_MODE int rt_spset_mcr(unsigned int tty, int mask, int setbits)
 	if ((mask & (RT_SP_DSR_ON_TX|RT_SP_HW_FLOW)) != mask) {
 		return -EINVAL;
 	}
-	outb(setbits ? (spct[tty].mcr |= mask) : (spct[tty].mcr &= ~mask), spct[tty].base_adr + RT_SP_MCR);
+	sp_outb(setbits ? (spct[tty].mcr |= mask) : (spct[tty].mcr &= ~mask), spct[tty].base_adr + RT_SP_MCR);
 	return 0;
 }
 
@@ -264,7 +279,7 @@ RTAI_SYSCALL_MODE int rt_spset_mcr(unsigned int tty, int mask, int setbits)
 RTAI_SYSCALL_MODE int rt_spget_msr(unsigned int tty, int mask)
 {
 	CHECK_SPINDX(tty);
-	return inb(spct[tty].base_adr + RT_SP_MSR) & 0xF0 & mask;
+	return sp_inb(spct[tty].base_adr + RT_SP_MSR) & 0xF0 & mask;
 }
 
 
@@ -425,7 +440,9 @@ RTAI_SYSCALL_MODE int rt_spwrite(unsigned int tty, char *msg, int msg_size)
 			msg_size = mbxput(&p->obuf, &msg, msg_size);
 			// enable Transmitter Holding Register Empty to 
 			// start transmission if not running already
-			outb(p->ier |= IER_ETBEI, p->base_adr + RT_SP_IER);
+			p->ier |= IER_ETBEI;
+			SET_IER(p);
+			rt_spsoft_kick(p);
 		}
 		clear_bit(0, &p->just_onew);
 	}
@@ -464,7 +481,7 @@ RTAI_SYSCALL_MODE int rt_spread(unsigned int tty, char *msg, int msg_size)
 			// if RTS-CTS hardware flow control enabled and received
 			// buffer not full more than spbufhi threshold enable RTS
 			if ((p->mode & RT_SP_HW_FLOW) && p->ibuf.frbs > spbufhi) {
-				outb(p->mcr |= MCR_RTS, p->base_adr + RT_SP_MCR);
+				sp_outb(p->mcr |= MCR_RTS, p->base_adr + RT_SP_MCR);
 			}
 		}
 		clear_bit(0, &p->just_oner);
@@ -549,7 +566,9 @@ RTAI_SYSCALL_MODE int rt_spwrite_timed(unsigned int tty, char *msg, int msg_size
 				}
 			}
 			mbxput(&p->obuf, &msg, msg_size);
-			outb(p->ier |= IER_ETBEI, p->base_adr + RT_SP_IER);
+			p->ier |= IER_ETBEI;
+			SET_IER(p);
+			rt_spsoft_kick(p);
 			clear_bit(0, &p->just_onew);
 			return 0;
 		}
@@ -599,7 +618,7 @@ RTAI_SYSCALL_MODE int rt_spread_timed(unsigned int tty, char *msg, int msg_size,
 			}
 			mbxget(&p->ibuf, &msg, msg_size);
 			if ((p->mode & RT_SP_HW_FLOW) && p->ibuf.frbs > spbufhi) {
-				outb(p->mcr |= MCR_RTS, p->base_adr + RT_SP_MCR);
+				sp_outb(p->mcr |= MCR_RTS, p->base_adr + RT_SP_MCR);
 			}
 			clear_bit(0, &p->just_oner);
 			return 0;
@@ -680,12 +699,89 @@ static inline int rt_spset_irq(struct rt_spct_t *p, unsigned char ch)
 	return -ENOSPC;
 }
 
+struct rt_sptodo { unsigned char er, cb, txs, rxs; };
+
+static inline int rt_sptx_enabled(struct rt_spct_t *p, unsigned char msr)
+{
+	return (p->mode == RT_SP_NO_HAND_SHAKE) ||
+	       ((p->mode == RT_SP_DSR_ON_TX) && (MSR_DSR & msr)) ||
+	       ((p->mode == RT_SP_HW_FLOW) && (MSR_CTS & msr)) ||
+	       ((p->mode == (RT_SP_HW_FLOW|RT_SP_DSR_ON_TX)) && (MSR_CTS & msr) && (MSR_DSR & msr));
+}
+
+static inline void rt_spdone(struct rt_spct_t *p, int rxed, int txed, unsigned char error, struct rt_sptodo *todo)
+{
+	/* controls on buffer full and RTS clear on hardware flow control */
+	if (p->ibuf.frbs < spbufull) {
+		error = RT_SP_BUFFER_FULL;
+	}
+	if ((p->mode & RT_SP_HW_FLOW) && p->ibuf.frbs < spbuflow) {
+		sp_outb(p->mcr &= ~MCR_RTS, p->base_adr + RT_SP_MCR);
+	}
+
+	rxed = rxed && p->rxthrs && p->ibuf.avbs >= abs(p->rxthrs) ? p->rxthrs : 0;
+	txed = txed && p->txthrs && p->obuf.frbs >= abs(p->txthrs) ? p->txthrs : 0;
+	todo->er = p->error = error;
+	todo->cb = (rxed || txed);
+	todo->rxs = todo->txs = 0;
+	if (rxed < 0 && p->rxsem.count < 0) {
+		p->rxthrs = 0;
+		todo->rxs = 1;
+	}
+	if (txed < 0 && p->txsem.count < 0) {
+		p->txthrs = 0;
+		todo->txs = 1;
+	}
+}
+
+static inline void rt_spnotify(struct rt_spct_t *p, struct rt_sptodo *todo)
+{
+	int tsk;
+
+	if (todo->er) {
+		if (p->err_callback_fun) {
+			(p->err_callback_fun)(p->error = todo->er);
+		}
+		tsk = 1;
+	} else {
+		tsk = 0;
+	}
+	if (todo->cb) {
+		if (p->callback_fun) {
+			(p->callback_fun)(p->ibuf.avbs, p->obuf.frbs);
+		}
+		tsk |= 2;
+	}
+	if (todo->rxs && todo->txs) {
+		if (p->rxsem.queue.next->task->priority < p->txsem.queue.next->task->priority) {
+			rt_sem_signal(&p->rxsem);
+			rt_sem_signal(&p->txsem);
+		} else {
+			rt_sem_signal(&p->txsem);
+			rt_sem_signal(&p->rxsem);
+		}
+		return;
+	}
+	if (todo->rxs) {
+		rt_sem_signal(&p->rxsem);
+		return;
+	}
+	if (todo->txs) {
+		rt_sem_signal(&p->txsem);
+		return;
+	}
+	if (p->callback_task && tsk) {
+		p->call_usr = tsk;
+		rt_task_resume(p->callback_task);
+	}
+}
+
 /* Extended to support shared interrupts, by: Renato Castello <zx81@gmx.net>, */
 /* with a lot of rewrites by: Paolo Mantegazza <mantegazza@aero.polimi.it>    */
 
 static int rt_spisr(int irq, struct rt_spct_t *pp)
 {
-	struct { unsigned char er, cb, txs, rxs; } todo[max_opncnt];
+	struct rt_sptodo todo[max_opncnt];
 {
 	unsigned int base_adr;
 	int          data_to_tx;
@@ -701,7 +797,7 @@ static int rt_spisr(int irq, struct rt_spct_t *pp)
 		rxed = txed = 0;	
 		todo[i].txs = todo[i].rxs = todo[i].cb = error = 0;
 	
-		iir = inb(base_adr + RT_SP_IIR);	
+		iir = sp_inb(base_adr + RT_SP_IIR);	
 		do {
 		//rt_printk("rt_spisr irq=%d, iir=0x%02x\n",irq,iir);	
 			switch (iir & 0x0f) {
@@ -709,7 +805,7 @@ static int rt_spisr(int irq, struct rt_spct_t *pp)
 				   // Overrun Error or Parity Error or 
 				   // Framing Error or Break Interrupt
 				
-				if ((lsr = inb(base_adr + RT_SP_LSR)) & 0x1e) {
+				if ((lsr = sp_inb(base_adr + RT_SP_LSR)) & 0x1e) {
 					error &= ~0x1e;
 					error |= (lsr & 0x1e);
 				}	
@@ -720,10 +816,10 @@ static int rt_spisr(int irq, struct rt_spct_t *pp)
 				rxed = 1;
 				/* get available data from base_adr */
 				do {
-					if (rt_spset_irq(p, inb(base_adr + RT_SP_RXB))) {
+					if (rt_spset_irq(p, sp_inb(base_adr + RT_SP_RXB))) {
 						error |= RT_SP_BUFFER_OVF;
 					}
-					if ((lsr = inb(base_adr + RT_SP_LSR)) & 0x1e) {
+					if ((lsr = sp_inb(base_adr + RT_SP_LSR)) & 0x1e) {
 						error &= ~0x1e;
 						error |= (lsr & 0x1e);
 					}
@@ -736,63 +832,45 @@ static int rt_spisr(int irq, struct rt_spct_t *pp)
 				// buffer is full enough to stop removing RTS signal
 				if ((p->mode & RT_SP_HW_FLOW) && p->ibuf.frbs < spbuflow) {
 					// disable RTS	
-					outb(p->mcr &= ~MCR_RTS, p->base_adr + RT_SP_MCR);
+					sp_outb(p->mcr &= ~MCR_RTS, p->base_adr + RT_SP_MCR);
 				}
 				break;
 	
 				case 0x02: // Transmitter Holding Register Empty
 	
 				/* if possible, put data to base_adr */
-				msr = inb(base_adr + RT_SP_MSR);
-				if ( (p->mode == RT_SP_NO_HAND_SHAKE) || 
-					 ((p->mode == RT_SP_DSR_ON_TX) && (MSR_DSR & msr)) || 
-					 ((p->mode == RT_SP_HW_FLOW) && (MSR_CTS & msr)) ||
-					 ((p->mode == (RT_SP_HW_FLOW|RT_SP_DSR_ON_TX)) &&
-                                          (MSR_CTS & msr) && (MSR_DSR & msr)) ) {
+				msr = sp_inb(base_adr + RT_SP_MSR);
+				if (rt_sptx_enabled(p, msr)) {
 			    	// if there are data to transmit 
 					if (!(data_to_tx = rt_spget_irq(p, &data))) {
 						txed = 1;	
 						do {
 //							rt_printk("->%c] ",data);	
-							outb(data, base_adr + RT_SP_TXB);
+							sp_outb(data, base_adr + RT_SP_TXB);
 						} while ((--toFifo > 0) && !(data_to_tx = rt_spget_irq(p, &data)));
 					}
 					if (data_to_tx) {
 		            	/* no more data in output buffer, disable Transmitter
 			               Holding Register Empty Interrupt */
-						outb(p->ier &= ~IER_ETBEI, base_adr + RT_SP_IER);
+						sp_outb(p->ier &= ~IER_ETBEI, base_adr + RT_SP_IER);
 					}
 				}
 				break;
 	
 				case 0x00: // MODEM Status
-				msr = inb(base_adr + RT_SP_MSR);
+				msr = sp_inb(base_adr + RT_SP_MSR);
 				break;
 	
 				default:
 				break;
 			}
-		} while (!((iir = inb(base_adr + RT_SP_IIR)) & 1) );
-
-	    /* controls on buffer full and RTS clear on hardware flow control */
-		if (p->ibuf.frbs < spbufull) {
-			error = RT_SP_BUFFER_FULL;
-		}
-		if ((p->mode & RT_SP_HW_FLOW) && p->ibuf.frbs < spbuflow) {
-			outb(p->mcr &= ~MCR_RTS, p->base_adr + RT_SP_MCR);
-		}
+		} while (!((iir = sp_inb(base_adr + RT_SP_IIR)) & 1) );
 
-		rxed = rxed && p->rxthrs && p->ibuf.avbs >= abs(p->rxthrs) ? p->rxthrs : 0;
-		txed = txed && p->txthrs && p->obuf.frbs >= abs(p->txthrs) ? p->txthrs : 0;
-		todo[i].er = p->error = error;
-		todo[i].cb = (rxed || txed);
-		if (rxed < 0 && p->rxsem.count < 0) {
-			p->rxthrs = 0;
-			todo[i].rxs = 1;
-		}	
-		if (txed < 0 && p->txsem.count < 0) {
-			p->txthrs = 0;
-			todo[i].txs = 1;
+		if (p->polled) {
+			// its UART interrupts are disabled, see rt_sppoll
+			todo[i].er = todo[i].cb = 0;
+		} else {
+			rt_spdone(p, rxed, txed, error, &todo[i]);
 		}
 		rtai_sti();
 		if (!(p = p->next)) {
@@ -802,51 +880,99 @@ static int rt_spisr(int irq, struct rt_spct_t *pp)
 		rtai_cli();
 	}
 }	
-	ENABLE_SP(irq);
+	if (!SP_SOFT(pp->base_adr)) {
+		ENABLE_SP(irq);
+	}
 {
-	int tsk, i = 0;
+	int i = 0;
 	do {
-		if (todo[i].er) {
-			if (pp->err_callback_fun) {
-				(pp->err_callback_fun)(pp->error = todo[i].er);
-			}
-			tsk = 1;
-		} else {
-			tsk = 0;
+		rt_spnotify(pp, &todo[i++]);
+	} while ((pp = pp->next));
+}
+	return 0;
+}
+
+/*
+ * Software UART ports have no IRQ line, so that rt_spisr is called here, as
+ * the hardware would do, after writing to an interrupt mode port.
+ */
+static void rt_spsoft_kick(struct rt_spct_t *p)
+{
+	unsigned long flags;
+
+	if (unlikely(SP_SOFT(p->base_adr)) && !p->polled) {
+		rtai_save_flags_and_cli(flags);
+		if (!(uart_soft_iir(SPSOFT(p->base_adr)) & 1)) {
+			rt_spisr(p->irq, p);
 		}
-		if (todo[i].cb) {
-			if (pp->callback_fun) {
-				(pp->callback_fun)(pp->ibuf.avbs, pp->obuf.frbs);
-			}
-			tsk |= 2;
+		rtai_restore_flags(flags);
+	}
+}
+
+/*
+ * Polled ports have their UART interrupts disabled and are serviced here, at
+ * each period of the polling task of their port group, i.e. of the ports
+ * sharing the same irq, getting all that is in the rx FIFO and refilling the
+ * tx FIFO as a whole when it is empty. An error, or anything received or
+ * sent, is then dealt with as rt_spisr does.
+ */
+static void rt_sppoll_port(struct rt_spct_t *p, struct rt_sptodo *todo)
+{
+	unsigned long base_adr = p->base_adr;
+	unsigned char data, lsr, error = 0;
+	int rxed = 0, txed = 0, toFifo;
+
+	while ((lsr = sp_inb(base_adr + RT_SP_LSR)) & (LSR_DATA_READY | 0x1e)) {
+		if (lsr & 0x1e) {
+			error &= ~0x1e;
+			error |= (lsr & 0x1e);
 		}
-		if (todo[i].rxs && todo[i].txs) {
-			if (pp->rxsem.queue.next->task->priority < pp->txsem.queue.next->task->priority) {
-				rt_sem_signal(&pp->rxsem);
-				rt_sem_signal(&pp->txsem);
-			} else {
-				rt_sem_signal(&pp->txsem);
-				rt_sem_signal(&pp->rxsem);
-			}
-			goto again;
-                }
-		if (todo[i].rxs) {
-			rt_sem_signal(&pp->rxsem);
-			goto again;
+		if (!(lsr & LSR_DATA_READY)) {
+			break;
 		}
-		if (todo[i].txs) {
-			rt_sem_signal(&pp->txsem);
-			goto again;
+		rxed = 1;
+		if (rt_spset_irq(p, sp_inb(base_adr + RT_SP_RXB))) {
+			error |= RT_SP_BUFFER_OVF;
 		}
-		if (pp->callback_task && tsk) {
-			pp->call_usr = tsk;
-			rt_task_resume(pp->callback_task);
+	}
+
+	if (p->obuf.avbs && (lsr & LSR_THRE) && rt_sptx_enabled(p, sp_inb(base_adr + RT_SP_MSR))) {
+		for (toFifo = p->tx_fifo_depth; toFifo > 0 && !rt_spget_irq(p, &data); toFifo--) {
+			sp_outb(data, base_adr + RT_SP_TXB);
+			txed = 1;
 		}
-again:
-		i++;
-	} while ((pp = pp->next));
+	}
+
+	if (rxed || txed || error) {
+		rt_spdone(p, rxed, txed, error, todo);
+	} else {
+		todo->er = todo->cb = todo->rxs = todo->txs = 0;
+	}
 }
-	return 0;
+
+static void rt_sppoll(long indx)
+{
+	struct rt_sptodo todo;
+	struct rt_spct_t *p;
+	RTIME period, next;
+	int polled;
+
+	while (1) {
+		period = nano2count(sppollns);
+		next = rt_get_time();
+		do {
+			for (polled = 0, p = spct + indx; p; p = p->next) {
+				if (p->opened && p->polled) {
+					polled = 1;
+					rt_sppoll_port(p, &todo);
+					rt_spnotify(p, &todo);
+				}
+			}
+			rt_sleep_until(next += period);
+		} while (polled);
+		// resumed by rt_spopen
+		rt_task_suspend(NULL);
+	}
 }
 
 /*
@@ -873,6 +999,8 @@ again:
  * 	mode		RT_SP_NO_HAND_SHAKE
  * 			RT_SP_DSR_ON_TX
  * 			RT_SP_HW_FLOW
+ * 			ORed with RT_SP_POLLED to service the port by
+ * 			polling, at sppollns, rather than by interrupts
  *
  *      fifotrig	RT_SP_FIFO_DISABLE
  *      		RT_SP_FIFO_SIZE_1
@@ -896,7 +1024,7 @@ RTAI_SYSCALL_MODE int rt_spopen(unsigned int tty, unsigned int baud, unsigned in
 
 	CHECK_SPINDX(tty);
 	if ( baud < 50 || baud > 115200 ||
-	     (mode & 0x03) != mode ||
+	     (mode & (0x03 | RT_SP_POLLED)) != mode ||
 	     (parity & 0x38) != parity ||
 		 stopbits < 1 || stopbits > 2 ||
 		 numbits < 5 || numbits > 8 ||
@@ -905,42 +1033,49 @@ RTAI_SYSCALL_MODE int rt_spopen(unsigned int tty, unsigned int baud, unsigned in
 
 	if ((p = spct + tty)->opened)
 		return -EADDRINUSE;
+
+	if ((mode & RT_SP_POLLED) && !p->poll_task)
+		return -ENODEV;
 	
 	// disable interrupt
-	rt_disable_irq(p->irq);
+	if (!SP_SOFT(p->base_adr)) {
+		rt_disable_irq(p->irq);
+	}
 
 	// disable all UART interrupts
-	outb(0x00, (base_adr = p->base_adr) + RT_SP_IER);
+	sp_outb(0x00, (base_adr = p->base_adr) + RT_SP_IER);
 
 	// reset possible pending interrupts
-	inb(base_adr + RT_SP_IIR);
-	inb(base_adr + RT_SP_LSR);
-	inb(base_adr + RT_SP_RXB);
-	inb(base_adr + RT_SP_MSR);
+	sp_inb(base_adr + RT_SP_IIR);
+	sp_inb(base_adr + RT_SP_LSR);
+	sp_inb(base_adr + RT_SP_RXB);
+	sp_inb(base_adr + RT_SP_MSR);
 
 	// set Divisor Latch Access Bit (DLAB) for Baud Rate setting
-	outb(0x80, base_adr + RT_SP_LCR);
+	sp_outb(0x80, base_adr + RT_SP_LCR);
 	// set baud rate
-	outb((RT_SP_BASE_BAUD/baud) & 0xFF, base_adr + RT_SP_DLL);
-	outb((RT_SP_BASE_BAUD/baud) >> 8, base_adr + RT_SP_DLM);
+	sp_outb((RT_SP_BASE_BAUD/baud) & 0xFF, base_adr + RT_SP_DLL);
+	sp_outb((RT_SP_BASE_BAUD/baud) >> 8, base_adr + RT_SP_DLM);
 
 	// set numbits, stopbits and parity and reset DLAB 
-	outb((numbits - 5) | ((stopbits - 1) << 2) | (parity & 0x38), base_adr + RT_SP_LCR);
+	sp_outb((numbits - 5) | ((stopbits - 1) << 2) | (parity & 0x38), base_adr + RT_SP_LCR);
 
 	// DTR, RTS, OUT1 and OUT2 active
 	// and initialize p->mcr register
-	outb(p->mcr = MCR_DTR | MCR_RTS | MCR_OUT1 | MCR_OUT2, base_adr + RT_SP_MCR);
+	sp_outb(p->mcr = MCR_DTR | MCR_RTS | MCR_OUT1 | MCR_OUT2, base_adr + RT_SP_MCR);
 
 	// Enable MODEM status interrupt if RT_SP_DSR_ON_TX or RT_SP_HW_FLOW mode
-	// and initialize p->ier register
-	outb((p->mode = mode) == RT_SP_NO_HAND_SHAKE ? (p->ier = IER_ERBI | IER_ELSI) : (p->ier = IER_ERBI | IER_ELSI | IER_EDSSI), base_adr + RT_SP_IER);
+	// and initialize p->ier register, a polled port keeps them all disabled
+	p->polled = mode & RT_SP_POLLED;
+	p->ier = (p->mode = mode & ~RT_SP_POLLED) == RT_SP_NO_HAND_SHAKE ? IER_ERBI | IER_ELSI : IER_ERBI | IER_ELSI | IER_EDSSI;
+	SET_IER(p);
 
 	if (fifotrig >= 0) {
 		p->fifotrig = fifotrig;
 	}
 
 	// Enable fifo 
-	outb(FCR_FIFO_ENABLE | p->fifotrig, base_adr + RT_SP_FCR);
+	sp_outb(FCR_FIFO_ENABLE | p->fifotrig, base_adr + RT_SP_FCR);
 	// reset error 
 	p->error = 0;
 	// initialize received and transmit buffers
@@ -951,7 +1086,12 @@ RTAI_SYSCALL_MODE int rt_spopen(unsigned int tty, unsigned int baud, unsigned in
 	spct[tty].callback_task = 0;
 	p->opened = 1;
 	// enable interrupts
-	rt_enable_irq(p->irq);
+	if (!SP_SOFT(p->base_adr)) {
+		rt_enable_irq(p->irq);
+	}
+	if (p->polled) {
+		rt_task_resume(p->poll_task);
+	}
 	return 0;
 }
 
@@ -977,14 +1117,14 @@ RTAI_SYSCALL_MODE int rt_spclose(unsigned int tty)
 	// disable interrupt
 //	rt_disable_irq(spct[tty].irq);
 	// disable interrupt generation for UART
-	outb(0, base_adr + RT_SP_IER);
+	sp_outb(0, base_adr + RT_SP_IER);
 	// reset possible pending interrupts
-	inb(base_adr + RT_SP_IIR);
-	inb(base_adr + RT_SP_LSR);
-	inb(base_adr + RT_SP_RXB);
-	inb(base_adr + RT_SP_MSR);
+	sp_inb(base_adr + RT_SP_IIR);
+	sp_inb(base_adr + RT_SP_LSR);
+	sp_inb(base_adr + RT_SP_RXB);
+	sp_inb(base_adr + RT_SP_MSR);
 	// disable DTR, RTS
-	outb(spct[tty].mcr = MCR_OUT1 | MCR_OUT2, base_adr + RT_SP_MCR);
+	sp_outb(spct[tty].mcr = MCR_OUT1 | MCR_OUT2, base_adr + RT_SP_MCR);
 	spct[tty].opened = 0;
 	if (spct[tty].callback_task) {
 		RT_TASK *task = spct[tty].callback_task;
@@ -1237,12 +1377,14 @@ int __rtai_serial_init(void)
 				newirq = 0;
 			}
 		}
-		if (newirq) {
+		if (newirq && !SP_SOFT(sp_config[i].base_adr)) {
 			rt_disable_irq(sp_config[i].irq);
 			if (rt_request_irq(sp_config[i].irq, (void *)rt_spisr, (void *)(spct + i), 1)) {
 				printk("IRQ NOT AVAILABLE (TTY INDEX: %d).\n", i);
 				newirq = 0;
 			}
+		}
+		if (newirq) {
 		    
 			p = &spct[i];
 			do {
@@ -1256,8 +1398,10 @@ int __rtai_serial_init(void)
 					}
 					for (k = 0; k < spcnt; k++) {
 						if (spct[k].ibuf.bufadr) {
-					  		rt_release_irq(sp_config[k].irq);
-							release_region(sp_config[k].base_adr, 8);
+							if (!SP_SOFT(sp_config[k].base_adr)) {
+						  		rt_release_irq(sp_config[k].irq);
+								release_region(sp_config[k].base_adr, 8);
+							}
 							kfree(spct[k].ibuf.bufadr);
 						}
 					}
@@ -1269,14 +1413,16 @@ int __rtai_serial_init(void)
 			} while ((p = p->next));
 		}
 
-		if (request_region(sp_config[i].base_adr, 8, RTAI_SPDRV_NAME) == NULL) {
+		if (SP_SOFT(sp_config[i].base_adr)) {
+			memset(&spsoft[i], 0, sizeof(struct uart_soft));
+		} else if (request_region(sp_config[i].base_adr, 8, RTAI_SPDRV_NAME) == NULL) {
 			release_region(sp_config[i].base_adr, 8);
 			request_region(sp_config[i].base_adr, 8, RTAI_SPDRV_NAME);
 		}
 		spct[i].callback_task = 0;
 		spct[i].opened = 0;
 		// set base address for UART
-		spct[i].base_adr = sp_config[i].base_adr;
+		spct[i].base_adr = SP_SOFT(sp_config[i].base_adr) ? RT_SP_SOFT_PORT(i) : sp_config[i].base_adr;
 		// set irq 
 		spct[i].irq      = sp_config[i].irq;
 		// set default values for RX FIFO trigger level
@@ -1290,6 +1436,30 @@ int __rtai_serial_init(void)
 		rt_sem_init(&spct[i].rxsem, 0);
 	}
 	
+	// a polling task for each group of ports sharing the same irq,
+	// registered as SPPLnn, nn being the index of its first port
+	for (i = 0; i < spcnt; i++) {
+		for (k = 0; k < i && spct[k].irq != spct[i].irq; k++);
+		if (k < i) {
+			spct[i].poll_task = spct[k].poll_task;
+		} else if ((spct[i].poll_task = kmalloc(sizeof(RT_TASK), GFP_KERNEL))) {
+			char name[16];
+			if (rt_task_init(spct[i].poll_task, rt_sppoll, i, PAGE_SIZE, RT_SCHED_HIGHEST_PRIORITY, 0, 0)) {
+				kfree(spct[i].poll_task);
+				spct[i].poll_task = NULL;
+			} else {
+				sprintf(name, "SPPL%02d", i);
+				rt_register(nam2num(name), spct[i].poll_task, IS_TASK, 0);
+			}
+		}
+		if (!spct[i].poll_task) {
+			printk("NO POLLING TASK, RT_SP_POLLED NOT AVAILABLE (TTY INDEX: %d).\n", i);
+		}
+	}
+
+	if (sppollns <= 0) {
+		sppollns = 100000;
+	}
 	spbuflow = spbufsiz / 3;
 	spbufhi  = spbufsiz - spbuflow;
 	spbufull = spbufsiz / 10;
@@ -1308,6 +1478,15 @@ void __rtai_serial_exit(void)
 
 	reset_rt_fun_ext_index(rtai_spdrv_fun, FUN_EXT_RTAI_SP);
 
+	for (i = 0; i < spcnt; i++) {
+		int k;
+		for (k = 0; k < i && spct[k].irq != spct[i].irq; k++);
+		if (k == i && spct[i].poll_task) {
+			rt_drg_on_adr(spct[i].poll_task);
+			rt_task_delete(spct[i].poll_task);
+			kfree(spct[i].poll_task);
+		}
+	}
 	for (i = 0; i < spcnt; i++) {
 		if (spct[i].opened) {
 			rt_spclose(spcnt);
@@ -1315,8 +1494,10 @@ void __rtai_serial_exit(void)
 		if (spct[i].callback_task) {
 			rt_task_resume(spct[i].callback_task);
 		}
-  		rt_release_irq(spct[i].irq);
-		release_region(spct[i].base_adr, 8);
+		if (!SP_SOFT(spct[i].base_adr)) {
+	  		rt_release_irq(spct[i].irq);
+			release_region(spct[i].base_adr, 8);
+		}
 		kfree(spct[i].ibuf.bufadr);
 		rt_sem_delete(&spct[i].txsem);
 		rt_sem_delete(&spct[i].rxsem);
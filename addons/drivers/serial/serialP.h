@@ -113,6 +113,8 @@ struct rt_spct_t {
 	volatile unsigned long call_usr;
 	SEM txsem, rxsem;
 	struct rt_spct_t *next;
+	int polled;
+	RT_TASK *poll_task;
 };
 
 #endif /* RTAI_SPDRV_HW_H */
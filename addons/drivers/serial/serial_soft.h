@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2026 The RTAI project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Software UART ports, see ../uart_soft.h. A port is a software one when its
+ * base_adr, as given in spconfig, is RT_SP_SOFT_BASE or above, i.e. beyond
+ * the I/O space, its irq being then just a tag grouping ports, no IRQ line
+ * being ever requested for it. At init such a base_adr is replaced by
+ * RT_SP_SOFT_PORT(tty), so that the model of each port is found directly by
+ * its index. In interrupt mode rt_spisr is run by the driver itself, see
+ * rt_spsoft_kick, after any UART register write that may raise an interrupt.
+ */
+
+#ifndef RTAI_SPDRV_SOFT_H
+#define RTAI_SPDRV_SOFT_H
+
+#include "../uart_soft.h"
+
+#define RT_SP_SOFT_BASE  0x10000
+
+#define SP_SOFT(adr)  ((unsigned long)(adr) >= RT_SP_SOFT_BASE)
+
+#define RT_SP_SOFT_PORT(tty)  (RT_SP_SOFT_BASE + ((tty) << 3))
+
+static struct uart_soft spsoft[CONFIG_SIZE];
+
+#define SPSOFT(adr)  (&spsoft[((unsigned long)(adr) - RT_SP_SOFT_BASE) >> 3])
+
+static inline unsigned char sp_inb(unsigned long adr)
+{
+	if (unlikely(SP_SOFT(adr))) {
+		return uart_soft_in(SPSOFT(adr), adr & 7);
+	}
+	return inb(adr);
+}
+
+static inline void sp_outb(unsigned char val, unsigned long adr)
+{
+	if (unlikely(SP_SOFT(adr))) {
+		uart_soft_out(SPSOFT(adr), adr & 7, val);
+	} else {
+		outb(val, adr);
+	}
+}
+
+#endif /* RTAI_SPDRV_SOFT_H */
@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2026 The RTAI project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Software UART, a model of the 16550A registers wired in loopback: whatever
+ * is written to THR is received at once, as if the line took no time. It is
+ * shared by the serial and the 16550A drivers, to exercise and benchmark them
+ * on machines without any UART. Registers are addressed by their standard
+ * offsets, 0 to 7, and use the standard bits, so that it depends on neither
+ * driver. There is no IRQ line, each driver running its interrupt handler by
+ * itself when uart_soft_iir has an interrupt pending after a register write.
+ * Divisors, parity and so on are just stored, while MSR reflects MCR as in
+ * the UART loopback mode.
+ */
+
+#ifndef RTAI_UART_SOFT_H
+#define RTAI_UART_SOFT_H
+
+#define UART_SOFT_FIFO  64  // a power of 2, not below the drivers tx FIFO depth
+
+struct uart_soft {
+	unsigned char rxfifo[UART_SOFT_FIFO];
+	int rxhead, rxcnt;
+	int thre;  // THR empty interrupt not yet seen
+	unsigned char ier, lcr, mcr, fcr, scr, dll, dlm;
+	unsigned char lsr;  // errors, sticky until LSR is read
+};
+
+/* The IIR a read would return, without its side effects. */
+static inline unsigned char uart_soft_iir(struct uart_soft *s)
+{
+	static const int trig[4] = { 1, 4, 8, 14 };
+
+	if ((s->ier & 0x04) && s->lsr) {
+		return 0x06;
+	}
+	if ((s->ier & 0x01) && s->rxcnt > 0) {
+		return s->rxcnt >= trig[s->fcr >> 6] ? 0x04 : 0x0C;
+	}
+	if ((s->ier & 0x02) && s->thre) {
+		return 0x02;
+	}
+	return 0x01;
+}
+
+static inline unsigned char uart_soft_in(struct uart_soft *s, int reg)
+{
+	unsigned char val;
+
+	switch (reg) {
+		case 0:  // RXB
+			if (s->lcr & 0x80) {
+				return s->dll;
+			}
+			if (!s->rxcnt) {
+				return 0;
+			}
+			val = s->rxfifo[s->rxhead];
+			s->rxhead = (s->rxhead + 1) & (UART_SOFT_FIFO - 1);
+			s->rxcnt--;
+			return val;
+		case 1:  // IER
+			return s->lcr & 0x80 ? s->dlm : s->ier;
+		case 2:  // IIR
+			// reading the THRE interrupt id acknowledges it
+			if ((val = uart_soft_iir(s)) == 0x02) {
+				s->thre = 0;
+			}
+			return s->fcr & 0x01 ? val | 0xC0 : val;
+		case 3:  // LCR
+			return s->lcr;
+		case 4:  // MCR
+			return s->mcr;
+		case 5:  // LSR, THR and transmitter always empty
+			val = s->lsr | 0x60 | (s->rxcnt ? 0x01 : 0);
+			s->lsr = 0;
+			return val;
+		case 6:  // MSR, DTR->DSR, RTS->CTS, OUT1->RI, OUT2->DCD
+			return ((s->mcr & 0x01) ? 0x20 : 0) | ((s->mcr & 0x02) ? 0x10 : 0) |
+			       ((s->mcr & 0x04) ? 0x40 : 0) | ((s->mcr & 0x08) ? 0x80 : 0);
+		default:
+			return s->scr;
+	}
+}
+
+static inline void uart_soft_out(struct uart_soft *s, int reg, unsigned char val)
+{
+	switch (reg) {
+		case 0:  // TXB
+			if (s->lcr & 0x80) {
+				s->dll = val;
+				break;
+			}
+			if (s->rxcnt == UART_SOFT_FIFO) {
+				s->lsr |= 0x02;  // overrun
+			} else {
+				s->rxfifo[(s->rxhead + s->rxcnt++) & (UART_SOFT_FIFO - 1)] = val;
+			}
+			// sent at once, so THR is empty again
+			s->thre = 1;
+			break;
+		case 1:  // IER
+			if (s->lcr & 0x80) {
+				s->dlm = val;
+				break;
+			}
+			// enabling the THRE interrupt raises it, THR being empty
+			if ((val & 0x02) && !(s->ier & 0x02)) {
+				s->thre = 1;
+			}
+			s->ier = val & 0x0F;
+			break;
+		case 2:  // FCR
+			if (val & 0x02) {
+				s->rxcnt = 0;
+			}
+			s->fcr = val & 0xC1;
+			break;
+		case 3:  // LCR
+			s->lcr = val;
+			break;
+		case 4:  // MCR
+			s->mcr = val;
+			break;
+		case 5:  // LSR
+		case 6:  // MSR
+			break;
+		default:
+			s->scr = val;
+	}
+}
+
+#endif /* RTAI_UART_SOFT_H */
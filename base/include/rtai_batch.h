@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2026 The RTAI project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * BATCHED LXRT CALLS.
+ *
+ * A batch ring is a named shared memory area, allocated by the SHM module,
+ * holding a submission ring and a completion ring of the same power of 2
+ * size. A user space task queues LXRT requests on the submission ring, each
+ * one being the usual encoded request, as made by ENCODE_LXRT_REQ, plus a
+ * copy of the very same argument structure it would pass to rtai_lxrt, and
+ * then executes all of them with a single trap, LXRT_BATCH_SUBMIT. The
+ * kernel runs them in order, as if they were called one by one, posting the
+ * return value of each one, tagged with a user datum, on the completion
+ * ring. Any rt_fun_ext service can be queued, blocking ones included, but
+ * not the LXRT specific requests, like task or object creations, which fail
+ * with -ENOSYS. A submission ends early when the completion ring is full or
+ * when the task has to change its hard/soft real time state, so that the
+ * usual trap return path can do it, the not yet executed requests staying
+ * queued for the next submission. A ring must be used by a single task.
+ */
+
+#ifndef _RTAI_BATCH_H
+#define _RTAI_BATCH_H
+
+#include <rtai_shm.h>
+
+#define RT_BATCH_MAGIC  0x62a7c4e1
+#define RT_BATCH_ARGS   10  // at least RTAI_MAX_FUN_ARGS
+
+struct rt_batch_sqe {
+	unsigned int lxsrq;
+	unsigned int pad;
+	unsigned long user_data;
+	long args[RT_BATCH_ARGS];
+};
+
+struct rt_batch_cqe {
+	unsigned long user_data;
+	long long retval;
+};
+
+struct rt_batch_ring {
+	unsigned long name;
+	unsigned int magic;
+	unsigned int entries;
+	/* sq_tail and cq_head are moved by the task, sq_head and cq_tail by the kernel */
+	volatile unsigned int sq_head, sq_tail;
+	volatile unsigned int cq_head, cq_tail;
+};
+
+#define RT_BATCH_HDR_SIZE  ((sizeof(struct rt_batch_ring) + 63) & ~63)
+
+#define RT_BATCH_SIZE(entries) \
+	(RT_BATCH_HDR_SIZE + (entries)*(sizeof(struct rt_batch_sqe) + sizeof(struct rt_batch_cqe)))
+
+#define RT_BATCH_SQE(ring, i) \
+	((struct rt_batch_sqe *)((char *)(ring) + RT_BATCH_HDR_SIZE) + (i))
+
+#define RT_BATCH_CQE(ring, entries, i) \
+	((struct rt_batch_cqe *)RT_BATCH_SQE(ring, entries) + (i))
+
+#ifndef __KERNEL__
+
+#include <errno.h>
+#include <string.h>
+
+#if defined(__i386__) || defined(__x86_64__)
+#define rt_batch_wmb()  __asm__ __volatile__ ("" : : : "memory")
+#define rt_batch_rmb()  __asm__ __volatile__ ("" : : : "memory")
+#else
+#define rt_batch_wmb()  __sync_synchronize()
+#define rt_batch_rmb()  __sync_synchronize()
+#endif
+
+/**
+ * Create, or open, a batch ring.
+ *
+ * @internal
+ *
+ * entries is rounded up to a power of 2. Since it allocates shared memory it
+ * must not be used in hard real time.
+ *
+ * @returns the ring, NULL on failure.
+ *
+ */
+
+RTAI_PROTO(struct rt_batch_ring *, rt_batch_init, (unsigned long name, int entries))
+{
+	struct rt_batch_ring *ring;
+	unsigned int n;
+
+	if (entries <= 0) {
+		return NULL;
+	}
+	for (n = 1; n < (unsigned int)entries; n <<= 1);
+	if ((ring = (struct rt_batch_ring *)rt_shm_alloc(name, RT_BATCH_SIZE(n), USE_VMALLOC))) {
+		if (ring->magic != RT_BATCH_MAGIC) {
+			ring->name    = name;
+			ring->entries = n;
+			ring->sq_head = ring->sq_tail = 0;
+			ring->cq_head = ring->cq_tail = 0;
+			ring->magic   = RT_BATCH_MAGIC;
+		}
+	}
+	return ring;
+}
+
+RTAI_PROTO(int, rt_batch_delete, (struct rt_batch_ring *ring))
+{
+	return rt_shm_free(ring->name);
+}
+
+/**
+ * Queue an LXRT request on a batch ring.
+ *
+ * @internal
+ *
+ * arg and argsize are those that would be given to rtai_lxrt, whose
+ * srq and dynx are encoded in lxsrq. See also RT_BATCH_QUEUE.
+ *
+ * @returns 0 on success, -EAGAIN if the submission ring is full, -EINVAL if
+ * the arguments do not fit an entry.
+ *
+ */
+
+RTAI_PROTO(int, rt_batch_queue, (struct rt_batch_ring *ring, unsigned int lxsrq, void *arg, int argsize, unsigned long user_data))
+{
+	struct rt_batch_sqe *sqe;
+	unsigned int tail = ring->sq_tail;
+
+	if (argsize > (int)sizeof(sqe->args)) {
+		return -EINVAL;
+	}
+	if (tail - ring->sq_head >= ring->entries) {
+		return -EAGAIN;
+	}
+	sqe = RT_BATCH_SQE(ring, tail & (ring->entries - 1));
+	sqe->lxsrq = lxsrq;
+	sqe->user_data = user_data;
+	memcpy(sqe->args, arg, argsize);
+	rt_batch_wmb();
+	ring->sq_tail = tail + 1;
+	return 0;
+}
+
+#define RT_BATCH_QUEUE(ring, dynx, srq, arg, user_data) \
+	rt_batch_queue(ring, ENCODE_LXRT_REQ(dynx, srq, sizeof(arg)), &(arg), sizeof(arg), user_data)
+
+/**
+ * Execute all the queued requests of a batch ring with a single trap.
+ *
+ * @internal
+ *
+ * The submission is repeated as long as the kernel stops early for a
+ * hard/soft transition, while there is room for completions.
+ *
+ * @returns the number of executed requests, or a negative error if none
+ * could be executed.
+ *
+ */
+
+RTAI_PROTO(int, rt_batch_submit, (struct rt_batch_ring *ring))
+{
+	struct { unsigned long name; long max; } arg = { ring->name, 0 };
+	int ret, done = 0;
+
+	while (ring->sq_head != ring->sq_tail && ring->cq_tail - ring->cq_head < ring->entries) {
+		if ((ret = rtai_lxrt(BIDX, SIZARG, LXRT_BATCH_SUBMIT, &arg).i[LOW]) <= 0) {
+			return done ? done : ret;
+		}
+		done += ret;
+	}
+	return done;
+}
+
+/**
+ * Take the next completion of a batch ring.
+ *
+ * @internal
+ *
+ * @returns 1 and the completion in cqe, 0 if there is none.
+ *
+ */
+
+RTAI_PROTO(int, rt_batch_reap, (struct rt_batch_ring *ring, struct rt_batch_cqe *cqe))
+{
+	unsigned int head = ring->cq_head;
+
+	if (head == ring->cq_tail) {
+		return 0;
+	}
+	rt_batch_rmb();
+	*cqe = *RT_BATCH_CQE(ring, ring->entries, head & (ring->entries - 1));
+	ring->cq_head = head + 1;
+	return 1;
+}
+
+#endif /* !__KERNEL__ */
+
+#endif /* !_RTAI_BATCH_H */
@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2026 The RTAI project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * FAST MUTEXES.
+ *
+ * A fast mutex is a named shared memory area, allocated by the SHM module,
+ * whose first word holds the RTAI task owning the mutex, so that locking and
+ * unlocking a free mutex is just a compare and swap, from kernel or user
+ * space, without any LXRT call. It is paired with a kernel resource
+ * semaphore, for the contended cases only. The first task finding the mutex
+ * owned makes the kernel set the semaphore owner from the word, marking the
+ * word with RT_FMUTEX_WAITERS, and then blocks as usual, lending its priority
+ * to the owner. The word being writable by any user of the area, the kernel
+ * takes it just as a hint, checking that it names one of its tasks, and from
+ * then on keeps the owner by itself. Once marked the unlock cannot be done on the word, so the
+ * owner goes through the kernel, which hands the mutex over to the first
+ * waiter, updating the word, or frees both. The semaphore handle can be used
+ * with any semaphore or condition variable call, as the kernel is aware of
+ * the word. Recursive locks of RESEM_RECURS mutexes go through the kernel.
+ * The area name cannot be used for anything else.
+ */
+
+#ifndef _RTAI_FMUTEX_H
+#define _RTAI_FMUTEX_H
+
+#include <rtai_sem.h>
+#include <rtai_shm.h>
+
+#define RT_FMUTEX_WAITERS  1UL
+
+struct rt_fmutex {
+	/* owner RT_TASK | RT_FMUTEX_WAITERS, 0 when free */
+	volatile unsigned long owner;
+	unsigned long name;
+	SEM *sem;
+	int users;
+};
+
+#ifdef __KERNEL__
+
+#define RTAI_FMUTEX_PROTO(type, name, arglist)  static inline type name arglist
+
+#define rt_fmutex_self()            ((unsigned long)rt_whoami())
+#define rt_fmutex_cmpxchg(p, o, n)  cmpxchg(p, o, n)
+
+RTAI_SYSCALL_MODE SEM *rt_fmutex_bind(unsigned long name, int type);
+
+RTAI_SYSCALL_MODE int rt_fmutex_unbind(SEM *sem);
+
+#else /* !__KERNEL__ */
+
+#define RTAI_FMUTEX_PROTO  RTAI_PROTO
+
+#define rt_fmutex_self()            ((unsigned long)(rt_usp_self ? rt_usp_self : (rt_usp_self = rt_buddy())))
+#define rt_fmutex_cmpxchg(p, o, n)  __sync_val_compare_and_swap(p, o, n)
+
+RTAI_PROTO(SEM *, rt_fmutex_bind, (unsigned long name, int type))
+{
+	struct { unsigned long name; long type; } arg = { name, type };
+	return (SEM *)rtai_lxrt(BIDX, SIZARG, FMUTEX_BIND, &arg).v[LOW];
+}
+
+RTAI_PROTO(int, rt_fmutex_unbind, (SEM *sem))
+{
+	struct { SEM *sem; } arg = { sem };
+	return rtai_lxrt(BIDX, SIZARG, FMUTEX_UNBIND, &arg).i[LOW];
+}
+
+#endif /* __KERNEL__ */
+
+/**
+ * Create, or open, a fast mutex.
+ *
+ * @internal
+ *
+ * @param type is RESEM_BINSEM, RESEM_CHEKWT or RESEM_RECURS, as the value of
+ * a resource semaphore. It is used only by the first opener.
+ *
+ * @returns the mutex, 0 on failure.
+ *
+ */
+
+RTAI_FMUTEX_PROTO(struct rt_fmutex *, rt_fmutex_open, (unsigned long name, int type))
+{
+	struct rt_fmutex *fm;
+
+	if ((fm = (struct rt_fmutex *)rt_shm_alloc(name, sizeof(struct rt_fmutex), USE_VMALLOC))) {
+		if (!rt_fmutex_bind(name, type)) {
+			rt_shm_free(name);
+			return 0;
+		}
+	}
+	return fm;
+}
+
+/**
+ * Close a fast mutex, the last closing deletes it.
+ *
+ * @internal
+ *
+ */
+
+RTAI_FMUTEX_PROTO(void, rt_fmutex_close, (struct rt_fmutex *fm))
+{
+	unsigned long name = fm->name;
+	rt_fmutex_unbind(fm->sem);
+	rt_shm_free(name);
+}
+
+/**
+ * Lock a fast mutex, trapping into the kernel only if it is owned.
+ *
+ * @internal
+ *
+ * @returns as rt_sem_wait.
+ *
+ */
+
+RTAI_FMUTEX_PROTO(int, rt_fmutex_lock, (struct rt_fmutex *fm))
+{
+	unsigned long self = rt_fmutex_self();
+	if (self && !rt_fmutex_cmpxchg(&fm->owner, 0, self)) {
+		return 1;
+	}
+	return rt_sem_wait(fm->sem);
+}
+
+RTAI_FMUTEX_PROTO(int, rt_fmutex_trylock, (struct rt_fmutex *fm))
+{
+	unsigned long self = rt_fmutex_self(), owner;
+	if (self && !(owner = rt_fmutex_cmpxchg(&fm->owner, 0, self))) {
+		return 1;
+	}
+	return self && (owner & ~RT_FMUTEX_WAITERS) != self ? 0 : rt_sem_wait_if(fm->sem);
+}
+
+RTAI_FMUTEX_PROTO(int, rt_fmutex_timedlock, (struct rt_fmutex *fm, RTIME time))
+{
+	unsigned long self = rt_fmutex_self();
+	if (self && !rt_fmutex_cmpxchg(&fm->owner, 0, self)) {
+		return 1;
+	}
+	return rt_sem_wait_until(fm->sem, time);
+}
+
+/**
+ * Unlock a fast mutex, trapping into the kernel only if it has waiters.
+ *
+ * @internal
+ *
+ * @returns as rt_sem_signal.
+ *
+ */
+
+RTAI_FMUTEX_PROTO(int, rt_fmutex_unlock, (struct rt_fmutex *fm))
+{
+	unsigned long self = rt_fmutex_self();
+	if (self && rt_fmutex_cmpxchg(&fm->owner, self, 0) == self) {
+		return 0;
+	}
+	return rt_sem_signal(fm->sem);
+}
+
+#endif /* !_RTAI_FMUTEX_H */
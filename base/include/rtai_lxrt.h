@@ -313,7 +313,7 @@
 #define SCHED_UNLOCK		       210
 #define PEND_LINUX_IRQ		       211
 #define SET_LINUX_SYSCALL_MODE	       212
-/*#define RETURN_LINUX_SYSCALL         213 available */
+#define SET_NETRPC_WINDOW              213
 #define REQUEST_RTC                    214
 #define RELEASE_RTC                    215
 #define RT_GETTID                      216
@@ -336,7 +336,37 @@
 
 #define RT_USRQ_DISPATCHER	       230
 
-#define MAX_LXRT_FUN		       231
+// mail boxes in place access
+#define MBX_RESERVE		       231
+#define MBX_RESERVE_IF		       232
+#define MBX_COMMIT		       233
+#define MBX_PEEK		       234
+#define MBX_PEEK_IF		       235
+#define MBX_CONSUME		       236
+
+// vectored send/receive
+#define MBX_SEND_VEC		       237
+#define MBX_SEND_VEC_IF		       238
+#define MBX_SEND_VEC_UNTIL	       239
+#define MBX_SEND_VEC_TIMED	       240
+#define MBX_RECEIVE_VEC		       241
+#define MBX_RECEIVE_VEC_IF	       242
+#define MBX_RECEIVE_VEC_UNTIL	       243
+#define MBX_RECEIVE_VEC_TIMED	       244
+#define TBX_SEND_VEC		       245
+#define TBX_SEND_VEC_IF		       246
+#define TBX_SEND_VEC_UNTIL	       247
+#define TBX_SEND_VEC_TIMED	       248
+#define MQ_SEND_VEC		       249
+#define MQ_RECEIVE_VEC		       250
+#define MQ_TIMEDSEND_VEC	       251
+#define MQ_TIMEDRECEIVE_VEC	       252
+
+// fast mutexes
+#define FMUTEX_BIND		       253
+#define FMUTEX_UNBIND		       254
+
+#define MAX_LXRT_FUN		       255
 
 // not recovered yet 
 // Qblk's 
@@ -415,6 +445,7 @@
 #define LXRT_SPL_DELETE 	1030
 #define SCHED_LATENCIES   	1031
 #define GET_CPU_FREQ		1032
+#define LXRT_BATCH_SUBMIT	1033
 
 #define FORCE_SOFT 0x80000000
 
@@ -468,6 +499,8 @@ R ARG2 SZ .... .... .... .... .||| .... .... ....
 
 The low part of the unsigned long encodes also
 RT Switch .... .... .... .... .... .... .... ...|
+UDC       .... .... .... .... |... .... .... ....
+UDC PEER  .... .... .... ...| .... .... .... ....
 
 If SZ is zero sizeof(int) is copied by default, if LL bit is set sizeof(long long) is copied.
 */
@@ -483,6 +516,13 @@ If SZ is zero sizeof(int) is copied by default, if LL bit is set sizeof(long lon
 #define UR1(bf, sz)  ((((bf) & 0x7) << 3) | (((sz) & 0x7) <<  6))
 #define UR2(bf, sz)  ((((bf) & 0x7) << 9) | (((sz) & 0x7) << 12))
 
+// the function copies its ARG1 buffers by itself, so that they can be
+// passed directly from user space, see msg_mm in RT_TASK
+#define UDC       (1 << 15)
+// and, as its first argument is a task that is going to copy from/to them,
+// only if the latter shares the caller address space
+#define UDC_PEER  (1 << 16)
+
 #define	NEED_TO_RW(x)	((x) & 0xFFFFFFFE)
 
 #define NEED_TO_W(x)	((x) & (0x3F << 19))
@@ -589,6 +629,8 @@ struct apic_timer_setup_data;
 #define BIDX   0 // rt_fun_ext[0]
 #define SIZARG sizeof(arg)
 
+#include <rtai_timepage.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -644,6 +686,14 @@ static void hard_soft_toggler(int sig)
 
 #endif
 
+/*
+ * The RTAI task of the calling thread, cached for the user space fast paths
+ * that must know it without trapping into the kernel, e.g. fast mutexes.
+ * Defined weak, as rt_usp_time_page, so that all the objects of a process
+ * share it.
+ */
+__thread RT_TASK *rt_usp_self __attribute__ ((weak));
+
 RTAI_PROTO(RT_TASK *, rt_task_init_schmod, (unsigned long name, int priority, int stack_size, int max_msg_size, int policy, int cpus_allowed))
 {
         struct sched_param mysched;
@@ -660,8 +710,9 @@ RTAI_PROTO(RT_TASK *, rt_task_init_schmod, (unsigned long name, int priority, in
         }
 	rtai_iopl();
 	mlockall(MCL_CURRENT | MCL_FUTURE);
+	rt_time_page_open();
 
-	return (RT_TASK *)rtai_lxrt(BIDX, SIZARG, LXRT_TASK_INIT, &arg).v[LOW];
+	return rt_usp_self = (RT_TASK *)rtai_lxrt(BIDX, SIZARG, LXRT_TASK_INIT, &arg).v[LOW];
 }
 
 #define RT_THREAD_STACK_MIN  16*1024
@@ -877,6 +928,15 @@ RTAI_PROTO(RT_TASK *, rt_thread_init, (unsigned long name, int priority, int max
  * Note also that @a max_msg_size is for a buffer to be used to copy whatever
  * intertask message from user to kernel space, as intertask messages are not 
  * necessarily used immediately.
+ * Extended messages, i.e. those of rt_sendx, rt_rpcx, rt_receivex, rt_evdrpx, 
+ * rt_returnx and their variants, do not need it, being copied directly from/to
+ * the user buffers, always by the receiving and returning tasks and by the 
+ * sending ones whenever their partner belongs to the same process. The 
+ * exception is rt_sendx_if, whose message can be copied after it has returned, 
+ * so it goes through the buffer of the sending task, as any other message. So 
+ * @a max_msg_size can be sized for the other messages only, and to avoid any 
+ * real time reallocation it should be at least as large as the largest of 
+ * them.
  *
  * It is important to remark that the returned task pointers cannot be used
  * directly, they are for kernel space data, but just passed as arguments when
@@ -927,6 +987,9 @@ RTAI_PROTO(int, rt_thread_delete,(RT_TASK *task))
 {
 	struct { RT_TASK *task; } arg = { task };
 	rt_make_soft_real_time();
+	if (!task || task == rt_usp_self) {
+		rt_usp_self = NULL;
+	}
 	return rtai_lxrt(BIDX, SIZARG, LXRT_TASK_DELETE, &arg).i[LOW];
 }
 
@@ -1108,30 +1171,48 @@ RTAI_PROTO(void, rt_release_rtc, (void))
 RTAI_PROTO(RTIME, rt_get_time, (void))
 {
 	struct { unsigned long dummy; } arg;
+	RTIME t;
+	if (rt_time_page_get_time(&t)) {
+		return t;
+	}
 	return rtai_lxrt(BIDX, SIZARG, GET_TIME, &arg).rt;
 }
 
 RTAI_PROTO(RTIME, rt_get_real_time, (void))
 {
 	struct { unsigned long dummy; } arg;
+	RTIME t;
+	if (rt_time_page_get_real_time(&t)) {
+		return t;
+	}
 	return rtai_lxrt(BIDX, SIZARG, GET_REAL_TIME, &arg).rt;
 }
 
 RTAI_PROTO(RTIME, rt_get_real_time_ns, (void))
 {
 	struct { unsigned long dummy; } arg;
+	RTIME t;
+	if (rt_time_page_get_real_time_ns(&t)) {
+		return t;
+	}
 	return rtai_lxrt(BIDX, SIZARG, GET_REAL_TIME_NS, &arg).rt;
 }
 
 RTAI_PROTO(RTIME, count2nano, (RTIME count))
 {
 	struct { RTIME count; } arg = { count };
+	if (rt_time_page_count2nano(&count)) {
+		return count;
+	}
 	return rtai_lxrt(BIDX, SIZARG, COUNT2NANO, &arg).rt;
 }
 
 RTAI_PROTO(RTIME, nano2count, (RTIME nanos))
 {
 	struct { RTIME nanos; } arg = { nanos };
+	if (rt_time_page_nano2count(&nanos)) {
+		return nanos;
+	}
 	return rtai_lxrt(BIDX, SIZARG, NANO2COUNT, &arg).rt;
 }
 
@@ -1216,12 +1297,20 @@ RTAI_PROTO(int, rt_hard_timer_tick, (void))
 RTAI_PROTO(RTIME,rt_get_time_ns,(void))
 {
 	struct { unsigned long dummy; } arg;
+	RTIME t;
+	if (rt_time_page_get_time_ns(&t)) {
+		return t;
+	}
 	return rtai_lxrt(BIDX, SIZARG, GET_TIME_NS, &arg).rt;
 }
 
 RTAI_PROTO(RTIME,rt_get_cpu_time_ns,(void))
 {
 	struct { unsigned long dummy; } arg;
+	RTIME t;
+	if (rt_time_page_get_time_ns(&t)) {
+		return t;
+	}
 	return rtai_lxrt(BIDX, SIZARG, GET_CPU_TIME_NS, &arg).rt;
 }
 
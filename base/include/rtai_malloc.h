@@ -82,6 +82,37 @@ typedef struct rtextent {
 
 } rtextent_t;
 
+/*
+ * Per CPU magazines caching small blocks, by power of two size classes
+ * from RTHEAP_MINALLOCSZ up, in front of a heap (see rtheap_mags_init).
+ */
+
+#define RTHEAP_MAG_CLASSES  7
+#define RTHEAP_MAG_MAXSZ    (RTHEAP_MINALLOCSZ << (RTHEAP_MAG_CLASSES - 1))
+#define RTHEAP_MAG_BATCH    8
+#define RTHEAP_MAG_SIZE     (2*RTHEAP_MAG_BATCH)
+
+typedef struct rtheap_mag {
+    int count;
+    void *blocks[RTHEAP_MAG_SIZE];
+} rtheap_mag_t;
+
+typedef struct rtheap_mags {
+    rtheap_mag_t mag[RTHEAP_MAG_CLASSES];
+    unsigned long alloc_hits,
+		  alloc_misses,
+		  free_hits,
+		  free_misses;
+} ____cacheline_aligned rtheap_mags_t;
+
+struct rtheap_mags_stats {
+    unsigned long cached,	/* Bytes held by the magazines */
+		  alloc_hits,
+		  alloc_misses,
+		  free_hits,
+		  free_misses;
+};
+
 /* Creation flag */
 #define RTHEAP_EXTENDABLE 0x1
 
@@ -106,6 +137,8 @@ typedef struct rtheap {
 
     caddr_t buckets[RTHEAP_NBUCKETS];
 
+    rtheap_mags_t *mags;	/* Per CPU magazines, if any */
+
 } rtheap_t;
 
 #else /* __cplusplus */
@@ -146,6 +179,10 @@ void *rtheap_alloc(rtheap_t *heap, u_long size, int flags);
 
 int rtheap_free(rtheap_t *heap, void *block);
 
+int rtheap_mags_init(rtheap_t *heap);
+
+int rtheap_mags_stats(rtheap_t *heap, struct rtheap_mags_stats *stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -31,6 +31,12 @@
 struct rt_task_struct;
 struct rt_mailbox;
 
+/* A piece of a mailbox buffer, accessed in place. */
+struct rt_mbx_span {
+	void *adr;
+	int size;
+};
+
 #ifdef __KERNEL__
 
 #ifndef __cplusplus
@@ -39,8 +45,10 @@ typedef struct rt_mailbox {
 	int magic;
 	SEM sndsem, rcvsem;
 	struct rt_task_struct *waiting_task, *owndby;
+	struct rt_task_struct *rsvtask, *pektask;  // see rt_mbx_reserve/peek
 	char *bufadr;
 	int size, fbyte, lbyte, avbs, frbs;
+	int rsvsize, peksize;
 	spinlock_t lock;
 #ifdef CONFIG_RTAI_RT_POLL
 	struct rt_poll_ql poll_recv;
@@ -143,6 +151,82 @@ static inline struct rt_mailbox *rt_typed_named_mbx_init(const char *mbx_name, i
 RTAI_SYSCALL_MODE int rt_named_mbx_delete(struct rt_mailbox *mbx);
 
 #define rt_named_mbx_init(mbx_name, size)  rt_typed_named_mbx_init(mbx_name, size, FIFO_Q)
+
+RTAI_SYSCALL_MODE int _rt_mbx_reserve(struct rt_mailbox *mbx, int msg_size, struct rt_mbx_span *span, int space);
+static inline int rt_mbx_reserve(struct rt_mailbox *mbx, int msg_size, struct rt_mbx_span *span)
+{
+	return _rt_mbx_reserve(mbx, msg_size, span, 1);
+}
+
+RTAI_SYSCALL_MODE int _rt_mbx_reserve_if(struct rt_mailbox *mbx, int msg_size, struct rt_mbx_span *span, int space);
+static inline int rt_mbx_reserve_if(struct rt_mailbox *mbx, int msg_size, struct rt_mbx_span *span)
+{
+	return _rt_mbx_reserve_if(mbx, msg_size, span, 1);
+}
+
+RTAI_SYSCALL_MODE int rt_mbx_commit(struct rt_mailbox *mbx, int msg_size);
+
+RTAI_SYSCALL_MODE int _rt_mbx_peek(struct rt_mailbox *mbx, int msg_size, struct rt_mbx_span *span, int space);
+static inline int rt_mbx_peek(struct rt_mailbox *mbx, int msg_size, struct rt_mbx_span *span)
+{
+	return _rt_mbx_peek(mbx, msg_size, span, 1);
+}
+
+RTAI_SYSCALL_MODE int _rt_mbx_peek_if(struct rt_mailbox *mbx, int msg_size, struct rt_mbx_span *span, int space);
+static inline int rt_mbx_peek_if(struct rt_mailbox *mbx, int msg_size, struct rt_mbx_span *span)
+{
+	return _rt_mbx_peek_if(mbx, msg_size, span, 1);
+}
+
+RTAI_SYSCALL_MODE int rt_mbx_consume(struct rt_mailbox *mbx, int msg_size);
+
+RTAI_SYSCALL_MODE int _rt_mbx_send_vec(struct rt_mailbox *mbx, struct rt_msg_iov *iov, int nmsg, int space);
+static inline int rt_mbx_send_vec(struct rt_mailbox *mbx, struct rt_msg_iov *iov, int nmsg)
+{
+	return _rt_mbx_send_vec(mbx, iov, nmsg, 1);
+}
+
+RTAI_SYSCALL_MODE int _rt_mbx_send_vec_if(struct rt_mailbox *mbx, struct rt_msg_iov *iov, int nmsg, int space);
+static inline int rt_mbx_send_vec_if(struct rt_mailbox *mbx, struct rt_msg_iov *iov, int nmsg)
+{
+	return _rt_mbx_send_vec_if(mbx, iov, nmsg, 1);
+}
+
+RTAI_SYSCALL_MODE int _rt_mbx_send_vec_until(struct rt_mailbox *mbx, struct rt_msg_iov *iov, int nmsg, RTIME time, int space);
+static inline int rt_mbx_send_vec_until(struct rt_mailbox *mbx, struct rt_msg_iov *iov, int nmsg, RTIME time)
+{
+	return _rt_mbx_send_vec_until(mbx, iov, nmsg, time, 1);
+}
+
+RTAI_SYSCALL_MODE int _rt_mbx_send_vec_timed(struct rt_mailbox *mbx, struct rt_msg_iov *iov, int nmsg, RTIME delay, int space);
+static inline int rt_mbx_send_vec_timed(struct rt_mailbox *mbx, struct rt_msg_iov *iov, int nmsg, RTIME delay)
+{
+	return _rt_mbx_send_vec_timed(mbx, iov, nmsg, delay, 1);
+}
+
+RTAI_SYSCALL_MODE int _rt_mbx_receive_vec(struct rt_mailbox *mbx, struct rt_msg_iov *iov, int nmsg, int space);
+static inline int rt_mbx_receive_vec(struct rt_mailbox *mbx, struct rt_msg_iov *iov, int nmsg)
+{
+	return _rt_mbx_receive_vec(mbx, iov, nmsg, 1);
+}
+
+RTAI_SYSCALL_MODE int _rt_mbx_receive_vec_if(struct rt_mailbox *mbx, struct rt_msg_iov *iov, int nmsg, int space);
+static inline int rt_mbx_receive_vec_if(struct rt_mailbox *mbx, struct rt_msg_iov *iov, int nmsg)
+{
+	return _rt_mbx_receive_vec_if(mbx, iov, nmsg, 1);
+}
+
+RTAI_SYSCALL_MODE int _rt_mbx_receive_vec_until(struct rt_mailbox *mbx, struct rt_msg_iov *iov, int nmsg, RTIME time, int space);
+static inline int rt_mbx_receive_vec_until(struct rt_mailbox *mbx, struct rt_msg_iov *iov, int nmsg, RTIME time)
+{
+	return _rt_mbx_receive_vec_until(mbx, iov, nmsg, time, 1);
+}
+
+RTAI_SYSCALL_MODE int _rt_mbx_receive_vec_timed(struct rt_mailbox *mbx, struct rt_msg_iov *iov, int nmsg, RTIME delay, int space);
+static inline int rt_mbx_receive_vec_timed(struct rt_mailbox *mbx, struct rt_msg_iov *iov, int nmsg, RTIME delay)
+{
+	return _rt_mbx_receive_vec_timed(mbx, iov, nmsg, delay, 1);
+}
      
 #ifdef __cplusplus
 }
@@ -271,6 +355,95 @@ RTAI_PROTO(int, rt_mbx_receive_timed, (struct rt_mailbox *mbx, void *msg, int ms
 	return (int)rtai_lxrt(BIDX, SIZARG, MBX_RECEIVE_TIMED, &arg).i[LOW];
 }
 
+/*
+ * The in place calls need the global heap mapped in the calling process, see
+ * rt_global_heap_open, as mailboxes buffers are allocated on it.
+ */
+
+RTAI_PROTO(int, rt_mbx_reserve, (struct rt_mailbox *mbx, int msg_size, struct rt_mbx_span *span))
+{
+	struct { struct rt_mailbox *mbx; long msg_size; struct rt_mbx_span *span; long space; } arg = { mbx, msg_size, span, 0 };
+	return (int)rtai_lxrt(BIDX, SIZARG, MBX_RESERVE, &arg).i[LOW];
+}
+
+RTAI_PROTO(int, rt_mbx_reserve_if, (struct rt_mailbox *mbx, int msg_size, struct rt_mbx_span *span))
+{
+	struct { struct rt_mailbox *mbx; long msg_size; struct rt_mbx_span *span; long space; } arg = { mbx, msg_size, span, 0 };
+	return (int)rtai_lxrt(BIDX, SIZARG, MBX_RESERVE_IF, &arg).i[LOW];
+}
+
+RTAI_PROTO(int, rt_mbx_commit, (struct rt_mailbox *mbx, int msg_size))
+{
+	struct { struct rt_mailbox *mbx; long msg_size; } arg = { mbx, msg_size };
+	return (int)rtai_lxrt(BIDX, SIZARG, MBX_COMMIT, &arg).i[LOW];
+}
+
+RTAI_PROTO(int, rt_mbx_peek, (struct rt_mailbox *mbx, int msg_size, struct rt_mbx_span *span))
+{
+	struct { struct rt_mailbox *mbx; long msg_size; struct rt_mbx_span *span; long space; } arg = { mbx, msg_size, span, 0 };
+	return (int)rtai_lxrt(BIDX, SIZARG, MBX_PEEK, &arg).i[LOW];
+}
+
+RTAI_PROTO(int, rt_mbx_peek_if, (struct rt_mailbox *mbx, int msg_size, struct rt_mbx_span *span))
+{
+	struct { struct rt_mailbox *mbx; long msg_size; struct rt_mbx_span *span; long space; } arg = { mbx, msg_size, span, 0 };
+	return (int)rtai_lxrt(BIDX, SIZARG, MBX_PEEK_IF, &arg).i[LOW];
+}
+
+RTAI_PROTO(int, rt_mbx_consume, (struct rt_mailbox *mbx, int msg_size))
+{
+	struct { struct rt_mailbox *mbx; long msg_size; } arg = { mbx, msg_size };
+	return (int)rtai_lxrt(BIDX, SIZARG, MBX_CONSUME, &arg).i[LOW];
+}
+
+RTAI_PROTO(int, rt_mbx_send_vec, (struct rt_mailbox *mbx, struct rt_msg_iov *iov, int nmsg))
+{
+	struct { struct rt_mailbox *mbx; struct rt_msg_iov *iov; long nmsg; long space; } arg = { mbx, iov, nmsg, 0 };
+	return (int)rtai_lxrt(BIDX, SIZARG, MBX_SEND_VEC, &arg).i[LOW];
+}
+
+RTAI_PROTO(int, rt_mbx_send_vec_if, (struct rt_mailbox *mbx, struct rt_msg_iov *iov, int nmsg))
+{
+	struct { struct rt_mailbox *mbx; struct rt_msg_iov *iov; long nmsg; long space; } arg = { mbx, iov, nmsg, 0 };
+	return (int)rtai_lxrt(BIDX, SIZARG, MBX_SEND_VEC_IF, &arg).i[LOW];
+}
+
+RTAI_PROTO(int, rt_mbx_send_vec_until, (struct rt_mailbox *mbx, struct rt_msg_iov *iov, int nmsg, RTIME time))
+{
+	struct { struct rt_mailbox *mbx; struct rt_msg_iov *iov; long nmsg; RTIME time; long space; } arg = { mbx, iov, nmsg, time, 0 };
+	return (int)rtai_lxrt(BIDX, SIZARG, MBX_SEND_VEC_UNTIL, &arg).i[LOW];
+}
+
+RTAI_PROTO(int, rt_mbx_send_vec_timed, (struct rt_mailbox *mbx, struct rt_msg_iov *iov, int nmsg, RTIME delay))
+{
+	struct { struct rt_mailbox *mbx; struct rt_msg_iov *iov; long nmsg; RTIME delay; long space; } arg = { mbx, iov, nmsg, delay, 0 };
+	return (int)rtai_lxrt(BIDX, SIZARG, MBX_SEND_VEC_TIMED, &arg).i[LOW];
+}
+
+RTAI_PROTO(int, rt_mbx_receive_vec, (struct rt_mailbox *mbx, struct rt_msg_iov *iov, int nmsg))
+{
+	struct { struct rt_mailbox *mbx; struct rt_msg_iov *iov; long nmsg; long space; } arg = { mbx, iov, nmsg, 0 };
+	return (int)rtai_lxrt(BIDX, SIZARG, MBX_RECEIVE_VEC, &arg).i[LOW];
+}
+
+RTAI_PROTO(int, rt_mbx_receive_vec_if, (struct rt_mailbox *mbx, struct rt_msg_iov *iov, int nmsg))
+{
+	struct { struct rt_mailbox *mbx; struct rt_msg_iov *iov; long nmsg; long space; } arg = { mbx, iov, nmsg, 0 };
+	return (int)rtai_lxrt(BIDX, SIZARG, MBX_RECEIVE_VEC_IF, &arg).i[LOW];
+}
+
+RTAI_PROTO(int, rt_mbx_receive_vec_until, (struct rt_mailbox *mbx, struct rt_msg_iov *iov, int nmsg, RTIME time))
+{
+	struct { struct rt_mailbox *mbx; struct rt_msg_iov *iov; long nmsg; RTIME time; long space; } arg = { mbx, iov, nmsg, time, 0 };
+	return (int)rtai_lxrt(BIDX, SIZARG, MBX_RECEIVE_VEC_UNTIL, &arg).i[LOW];
+}
+
+RTAI_PROTO(int, rt_mbx_receive_vec_timed, (struct rt_mailbox *mbx, struct rt_msg_iov *iov, int nmsg, RTIME delay))
+{
+	struct { struct rt_mailbox *mbx; struct rt_msg_iov *iov; long nmsg; RTIME delay; long space; } arg = { mbx, iov, nmsg, delay, 0 };
+	return (int)rtai_lxrt(BIDX, SIZARG, MBX_RECEIVE_VEC_TIMED, &arg).i[LOW];
+}
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -84,6 +84,9 @@ typedef struct msg_hdr {
 
 #define MSG_HDR_SIZE	(sizeof(MSG_HDR))
 
+#define MQ_PRIO_LEVELS	(MQ_PRIO_MAX + 1)
+#define MQ_PRIO_WORDS	((MQ_PRIO_LEVELS + BITS_PER_LONG - 1)/BITS_PER_LONG)
+
 typedef struct queue_control {
     int nodind;
     void **nodes;
@@ -91,6 +94,9 @@ typedef struct queue_control {
     void *head;		/* Pointer to the element at the front of the queue */
     void *tail;		/* Pointer to the element at the back of the queue */
     MQ_ATTR attrs;	/* Queue attributes */
+    unsigned long prio_map[MQ_PRIO_WORDS];	/* Priorities having messages */
+    void *prio_head[MQ_PRIO_LEVELS];	/* FIFO of messages of each priority */
+    void *prio_tail[MQ_PRIO_LEVELS];
 } Q_CTRL;
 
 typedef struct msg {
@@ -117,6 +123,7 @@ typedef struct _pqueue_descr_struct {
     SEM emp_cond;		/* For blocking on empty queue */
     SEM full_cond;		/* For blocking on full queue */
     SEM mutex;			/* For synchronisation of queue */
+    unsigned long reg_name;	/* Registry name of q_name, 0 if not registered */
 } MSG_QUEUE;
 
 struct _pqueue_access_data {
@@ -188,6 +195,30 @@ static inline int mq_timedsend(mqd_t mq, const char *msg, size_t msglen, unsigne
 	return _mq_timedsend(mq, msg, msglen, msgprio, abstime, 1);
 }
 
+RTAI_SYSCALL_MODE int _mq_send_vec(mqd_t mq, struct rt_msg_iov *iov, int nmsg, int space);
+static inline int mq_send_vec(mqd_t mq, struct rt_msg_iov *iov, int nmsg)
+{
+	return _mq_send_vec(mq, iov, nmsg, 1);
+}
+
+RTAI_SYSCALL_MODE int _mq_receive_vec(mqd_t mq, struct rt_msg_iov *iov, int nmsg, int space);
+static inline int mq_receive_vec(mqd_t mq, struct rt_msg_iov *iov, int nmsg)
+{
+	return _mq_receive_vec(mq, iov, nmsg, 1);
+}
+
+RTAI_SYSCALL_MODE int _mq_timedsend_vec(mqd_t mq, struct rt_msg_iov *iov, int nmsg, const struct timespec *abstime, int space);
+static inline int mq_timedsend_vec(mqd_t mq, struct rt_msg_iov *iov, int nmsg, const struct timespec *abstime)
+{
+	return _mq_timedsend_vec(mq, iov, nmsg, abstime, 1);
+}
+
+RTAI_SYSCALL_MODE int _mq_timedreceive_vec(mqd_t mq, struct rt_msg_iov *iov, int nmsg, const struct timespec *abstime, int space);
+static inline int mq_timedreceive_vec(mqd_t mq, struct rt_msg_iov *iov, int nmsg, const struct timespec *abstime)
+{
+	return _mq_timedreceive_vec(mq, iov, nmsg, abstime, 1);
+}
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -327,6 +358,30 @@ RTAI_PROTO(int, mq_timedsend,(mqd_t mq, const char *msg, size_t msglen, unsigned
 	return rtai_lxrt(MQIDX, SIZARG, MQ_TIMEDSEND, &arg).i[LOW];
 }
 
+RTAI_PROTO(int, mq_send_vec,(mqd_t mq, struct rt_msg_iov *iov, int nmsg))
+{
+	struct { long mq; struct rt_msg_iov *iov; long nmsg; long space; } arg = { mq, iov, nmsg, 0 };
+	return rtai_lxrt(MQIDX, SIZARG, MQ_SEND_VEC, &arg).i[LOW];
+}
+
+RTAI_PROTO(int, mq_receive_vec,(mqd_t mq, struct rt_msg_iov *iov, int nmsg))
+{
+	struct { long mq; struct rt_msg_iov *iov; long nmsg; long space; } arg = { mq, iov, nmsg, 0 };
+	return rtai_lxrt(MQIDX, SIZARG, MQ_RECEIVE_VEC, &arg).i[LOW];
+}
+
+RTAI_PROTO(int, mq_timedsend_vec,(mqd_t mq, struct rt_msg_iov *iov, int nmsg, const struct timespec *abstime))
+{
+	struct { long mq; struct rt_msg_iov *iov; long nmsg; const struct timespec *abstime; long space; } arg = { mq, iov, nmsg, abstime, 0 };
+	return rtai_lxrt(MQIDX, SIZARG, MQ_TIMEDSEND_VEC, &arg).i[LOW];
+}
+
+RTAI_PROTO(int, mq_timedreceive_vec,(mqd_t mq, struct rt_msg_iov *iov, int nmsg, const struct timespec *abstime))
+{
+	struct { long mq; struct rt_msg_iov *iov; long nmsg; const struct timespec *abstime; long space; } arg = { mq, iov, nmsg, abstime, 0 };
+	return rtai_lxrt(MQIDX, SIZARG, MQ_TIMEDRECEIVE_VEC, &arg).i[LOW];
+}
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
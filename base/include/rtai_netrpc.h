@@ -37,6 +37,12 @@
 
 #define MAX_MSG_SIZE  1500
 
+/* max outstanding requests on a pipelined port, see rt_set_netrpc_window */
+#define NETRPC_MAX_WINDOW  32
+
+/* max fragments of a soft port request larger than MAX_MSG_SIZE */
+#define NETRPC_MAX_FRAGS  4096
+
 #define NET_RPC_EXT  0
 
 #define NETRPC_BASEPORT  5000
@@ -164,6 +170,8 @@ RTAI_SYSCALL_MODE long long _rt_net_rpc(long fun_ext_timed,
 
 RTAI_SYSCALL_MODE int rt_set_netrpc_timeout( int port, RTIME timeout);
 
+RTAI_SYSCALL_MODE int rt_set_netrpc_window(int port, int window);
+
 RTAI_SYSCALL_MODE int rt_send_req_rel_port(unsigned long node, 
 					   int port,
 					   unsigned long id,
@@ -193,6 +201,16 @@ int rt_get_net_rpc_ret(MBX *mbx,
 		       RTIME timeout,
 		       int type);
 
+int rt_get_net_rpc_ret_id(MBX *mbx,
+			  unsigned long *reqid,
+			  unsigned long long *retval,
+			  void *msg1,
+			  int *msglen1,
+			  void *msg2,
+			  int *msglen2,
+			  RTIME timeout,
+			  int type);
+
 static inline int rt_sync_net_rpc(unsigned long node, int port)
 {
 	if (node) {
@@ -814,6 +832,12 @@ static inline int rt_set_netrpc_timeout(int port, RTIME timeout)
 	return rtai_lxrt(NET_RPC_IDX, SIZARGS, SET_NETRPC_TIMEOUT, &args).i[LOW];
 }
 
+static inline int rt_set_netrpc_window(int port, int window)
+{
+	struct { long port; long window; } args = { port, window };
+	return rtai_lxrt(NET_RPC_IDX, SIZARGS, SET_NETRPC_WINDOW, &args).i[LOW];
+}
+
 static inline unsigned long ddn2nl(const char *ddn)
 {
 	struct { const char *ddn; } args = { ddn };
@@ -1510,9 +1534,9 @@ static inline int RT_mbx_receive_timed(unsigned long node, int port, MBX *mbx, v
 
 #include <stddef.h>
 
-static inline int rt_get_net_rpc_ret(MBX *mbx, unsigned long long *retval, void *msg1, int *msglen1, void *msg2, int *msglen2, RTIME timeout, int type)
+static inline int rt_get_net_rpc_ret_id(MBX *mbx, unsigned long *reqid, unsigned long long *retval, void *msg1, int *msglen1, void *msg2, int *msglen2, RTIME timeout, int type)
 {
-	struct reply_t { long long wsize, w2size, myport; unsigned long long retval; char msg[1], msg1[1]; };
+	struct reply_t { long long wsize, w2size, myport; unsigned long long retval, reqid; char msg[1], msg1[1]; };
 	struct reply_t reply;
 	int ret;
 
@@ -1531,10 +1555,14 @@ static inline int rt_get_net_rpc_ret(MBX *mbx, unsigned long long *retval, void
 			break;
 		case MBX_RECEIVE_TIMED:
 			ret = rt_mbx_receive_timed(mbx, &reply, offsetof(struct reply_t, msg), timeout);
+			break;
 		default:
 			ret = -1;
 	}
 	if (!ret) {
+		if (reqid) {
+			*reqid = (unsigned long)reply.reqid;
+		}
 		*retval = (unsigned long)reply.retval;
 		if (reply.wsize) {
 			char msg[reply.wsize];
@@ -1561,6 +1589,11 @@ static inline int rt_get_net_rpc_ret(MBX *mbx, unsigned long long *retval, void
 	return ret;
 }
 
+static inline int rt_get_net_rpc_ret(MBX *mbx, unsigned long long *retval, void *msg1, int *msglen1, void *msg2, int *msglen2, RTIME timeout, int type)
+{
+	return rt_get_net_rpc_ret_id(mbx, NULL, retval, msg1, msglen1, msg2, msglen2, timeout, type);
+}
+
 #endif /* CONFIG_RTAI_MBX */
 
 #endif /* __KERNEL__ */
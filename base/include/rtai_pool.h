@@ -0,0 +1,231 @@
+/*
+ * Copyright (C) 2026 The RTAI project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * FIXED SIZE OBJECTS POOLS.
+ *
+ * A pool is a named shared memory area, allocated by the SHM module, holding
+ * a header and count equally sized objects, so that it can be used from both
+ * kernel and user space. Free objects are linked by their indices in a LIFO,
+ * whose head carries a modification tag in its upper half, against ABA, so
+ * that allocating and freeing are O(1) lock free compare and swaps, usable
+ * from any context and on any CPU. As only indices are stored in the pool,
+ * any mapping of it works. The first long of a free object holds its link,
+ * so it is not preserved across a free/alloc.
+ */
+
+#ifndef _RTAI_POOL_H
+#define _RTAI_POOL_H
+
+#include <rtai_shm.h>
+
+#define RT_POOL_CACHE_BYTES  64
+
+#define RT_POOL_TAG_SHIFT    (4*sizeof(unsigned long))
+#define RT_POOL_INDEX_MASK   ((1UL << RT_POOL_TAG_SHIFT) - 1)
+#define RT_POOL_MAX_COUNT    (RT_POOL_INDEX_MASK - 1)
+
+struct rt_pool {
+	unsigned long name;
+	volatile unsigned long ready;
+	unsigned long objsize, count, offset;
+	/* tag << RT_POOL_TAG_SHIFT | (index of the first free object + 1) */
+	volatile unsigned long head __attribute__ ((aligned(RT_POOL_CACHE_BYTES)));
+};
+
+#define RT_POOL_OBJ(pool, index) \
+	((volatile unsigned long *)((char *)(pool) + (pool)->offset + (index)*(pool)->objsize))
+
+#ifdef __KERNEL__
+
+#define RTAI_POOL_PROTO(type, name, arglist)  static inline type name arglist
+
+#define rt_pool_wmb()              smp_wmb()
+#define rt_pool_rmb()              smp_rmb()
+#define rt_pool_relax()            cpu_relax()
+#define rt_pool_cmpxchg(p, o, n)   cmpxchg(p, o, n)
+
+#else
+
+#define RTAI_POOL_PROTO  RTAI_PROTO
+
+#if defined(__i386__) || defined(__x86_64__)
+#define rt_pool_rmb()              __asm__ __volatile__ ("" : : : "memory")
+#define rt_pool_wmb()              __asm__ __volatile__ ("" : : : "memory")
+#else
+#define rt_pool_rmb()              __sync_synchronize()
+#define rt_pool_wmb()              __sync_synchronize()
+#endif
+#define rt_pool_relax()            rt_pool_rmb()
+#define rt_pool_cmpxchg(p, o, n)   __sync_val_compare_and_swap(p, o, n)
+
+#endif
+
+/**
+ * Create, or open, a fixed size objects pool.
+ *
+ * @internal
+ *
+ * rt_pool_create allocates a named pool of count objects of objsize bytes,
+ * each aligned to align bytes, a power of 2 that is at least the size of a
+ * long. The first object is also cache line aligned, so using
+ * RT_POOL_CACHE_BYTES for align keeps each object on its own cache lines.
+ * As for any named shared memory only the first call allocates, the
+ * following ones, from kernel or user space, just map the pool and wait
+ * till its initialization has been published.
+ *
+ * @returns the pool handle, 0 on failure.
+ *
+ */
+
+RTAI_POOL_PROTO(void *, rt_pool_create, (unsigned long name, int objsize, int count, int align))
+{
+	struct rt_pool *pool;
+	unsigned long a, size, offset, i;
+
+	if (count <= 0 || (unsigned long)count > RT_POOL_MAX_COUNT) {
+		return 0;
+	}
+	for (a = sizeof(unsigned long); a < (unsigned long)align; a <<= 1);
+	size = ((objsize > (int)sizeof(unsigned long) ? objsize : sizeof(unsigned long)) + a - 1) & ~(a - 1);
+	if (a < RT_POOL_CACHE_BYTES) {
+		offset = (sizeof(struct rt_pool) + RT_POOL_CACHE_BYTES - 1) & ~(RT_POOL_CACHE_BYTES - 1);
+	} else {
+		offset = (sizeof(struct rt_pool) + a - 1) & ~(a - 1);
+	}
+	if ((pool = (struct rt_pool *)rt_shm_alloc(name, offset + count*size, USE_VMALLOC))) {
+		if (!rt_pool_cmpxchg(&pool->name, 0, name)) {
+			pool->objsize = size;
+			pool->count   = count;
+			pool->offset  = offset;
+			for (i = 0; i < count - 1; i++) {
+				*RT_POOL_OBJ(pool, i) = i + 2;
+			}
+			*RT_POOL_OBJ(pool, i) = 0;
+			pool->head = 1;
+			rt_pool_wmb();
+			pool->ready = name;
+		} else {
+			while (pool->ready != name) {
+				rt_pool_relax();
+			}
+			rt_pool_rmb();
+		}
+	}
+	return pool;
+}
+
+/**
+ * Delete a fixed size objects pool.
+ *
+ * @internal
+ *
+ * As for any named allocation only the last deletion really frees the pool,
+ * the others just unmap it.
+ *
+ * @returns the size of the freed pool, 0 on failure.
+ *
+ */
+
+RTAI_POOL_PROTO(int, rt_pool_delete, (unsigned long name))
+{
+	return rt_shm_free(name);
+}
+
+/**
+ * Allocate an object from a pool, in O(1), without locks.
+ *
+ * @internal
+ *
+ * @returns the object address, 0 if the pool is exhausted.
+ *
+ */
+
+RTAI_POOL_PROTO(void *, rt_pool_alloc, (void *pool))
+{
+	struct rt_pool *p = (struct rt_pool *)pool;
+	unsigned long head, index;
+
+	do {
+		head = p->head;
+		if (!(index = head & RT_POOL_INDEX_MASK)) {
+			return 0;
+		}
+	} while (rt_pool_cmpxchg(&p->head, head, ((head >> RT_POOL_TAG_SHIFT) + 1) << RT_POOL_TAG_SHIFT | *RT_POOL_OBJ(p, index - 1)) != head);
+	return (void *)RT_POOL_OBJ(p, index - 1);
+}
+
+/**
+ * Check if an object belongs to a pool.
+ *
+ * @internal
+ *
+ * @returns 1 if obj is an object of pool, 0 otherwise.
+ *
+ */
+
+RTAI_POOL_PROTO(int, rt_pool_owns, (void *pool, void *obj))
+{
+	struct rt_pool *p = (struct rt_pool *)pool;
+	unsigned long ofst;
+
+	ofst = (char *)obj - ((char *)p + p->offset);
+	return (char *)obj >= (char *)p + p->offset && ofst < p->count*p->objsize && !(ofst % p->objsize);
+}
+
+/**
+ * Return an object to its pool, in O(1), without locks.
+ *
+ * @internal
+ *
+ * @param obj must have been allocated from the same pool, possibly through
+ * another mapping of it.
+ *
+ */
+
+RTAI_POOL_PROTO(void, rt_pool_free, (void *pool, void *obj))
+{
+	struct rt_pool *p = (struct rt_pool *)pool;
+	unsigned long head, index;
+
+	index = ((char *)obj - ((char *)p + p->offset))/p->objsize;
+	do {
+		head = p->head;
+		*RT_POOL_OBJ(p, index) = head & RT_POOL_INDEX_MASK;
+	} while (rt_pool_cmpxchg(&p->head, head, ((head >> RT_POOL_TAG_SHIFT) + 1) << RT_POOL_TAG_SHIFT | (index + 1)) != head);
+}
+
+#ifdef __KERNEL__
+
+/*
+ * Named objects constructors (named tasks, semaphores, mailboxes and so on)
+ * draw their control blocks from the pool set for their registry type, if
+ * any and if its objects are large enough, from the global heap otherwise.
+ * A pool must be set before creating and cleared after deleting any object
+ * that may come from it.
+ */
+
+int rt_set_named_pool(int type, void *pool);
+
+void *rt_named_obj_alloc(int type, int size);
+
+void rt_named_obj_free(int type, void *obj);
+
+#endif /* __KERNEL__ */
+
+#endif /* !_RTAI_POOL_H */
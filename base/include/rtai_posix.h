@@ -1118,12 +1118,14 @@ struct task_struct;
 #define INC_VAL(s)     atomic_inc((atomic_t *)&(((void **)s)[1]))
 #define DEC_VAL(s)     atomic_dec_and_test((atomic_t *)&(((void **)s)[1]))
 #define TST_VAL(s)     (((void **)s)[1])
+#define FMX_ADR(s)     (((void **)s)[2])
 
 #define LINUX_SIGNAL  32
 #define LINUX_RT_SIGNAL  32
 
 #include <asm/rtai_atomic.h>
 #include <rtai_sem.h>
+#include <rtai_fmutex.h>
 #include <rtai_signal.h>
 #include <rtai_tasklets.h>
 
@@ -1384,10 +1386,27 @@ RTAI_PROTO(int, __wrap_sem_getvalue, (sem_t *sem, int *sval))
 #define RTAI_MUTEX_RECURSIVE  (1 << 2)
 #define RTAI_MUTEX_PSHARED    (1 << 3)
 
+/*
+ * Process private mutexes are fast mutexes, so that they are locked and
+ * unlocked without LXRT calls when not contended, see rtai_fmutex.h. Their
+ * address is kept after the semaphore, used as usual for anything else.
+ * Process shared ones are plain semaphores, as the fast mutex mapping
+ * differs in each process.
+ */
+
 RTAI_PROTO(int, __wrap_pthread_mutex_init, (pthread_mutex_t *mutex, const pthread_mutexattr_t *mutexattr))
 {
 	struct { unsigned long name; long value, type; unsigned long *handle; } arg = { rt_get_name(0), !mutexattr || (((long *)mutexattr)[0] & RTAI_MUTEX_DEFAULT) ? RESEM_BINSEM : (((long *)mutexattr)[0] & RTAI_MUTEX_ERRCHECK) ? RESEM_CHEKWT : RESEM_RECURS, RES_SEM, NULL };
 	SET_VAL(mutex) = 0;
+	if (!mutexattr || !(((long *)mutexattr)[0] & RTAI_MUTEX_PSHARED)) {
+		struct rt_fmutex *fm;
+		if (!(FMX_ADR(mutex) = fm = rt_fmutex_open(arg.name, arg.value))) {
+			return ENOMEM;
+		}
+		SET_ADR(mutex) = fm->sem;
+		return 0;
+	}
+	FMX_ADR(mutex) = NULL;
 	if (!(SET_ADR(mutex) = rtai_lxrt(BIDX, SIZARG, NAMED_SEM_INIT, &arg).v[LOW])) {
 		return ENOMEM;
 	}
@@ -1402,6 +1421,15 @@ RTAI_PROTO(int, __wrap_pthread_mutex_destroy, (pthread_mutex_t *mutex))
 		if (TST_VAL(mutex)) {
 			return EBUSY;
 		}
+		if (FMX_ADR(mutex)) {
+			struct rt_fmutex *fm = (struct rt_fmutex *)FMX_ADR(mutex);
+			if (fm->owner) {
+				return EBUSY;
+			}
+			SET_ADR(mutex) = FMX_ADR(mutex) = NULL;
+			rt_fmutex_close(fm);
+			return 0;
+		}
 		if ((count = rtai_lxrt(BIDX, SIZARG, SEM_WAIT_IF, &arg).i[LOW]) <= 0 || count > 1) {
 			if (count > 1 && count != RTE_DEADLOK) {
 				rtai_lxrt(BIDX, SIZARG, SEM_SIGNAL, &arg);
@@ -1420,7 +1448,11 @@ RTAI_PROTO(int, __wrap_pthread_mutex_lock, (pthread_mutex_t *mutex))
 	struct { void *mutex; } arg = { SET_ADR(mutex) };
 	if (arg.mutex) {
 		int retval;
-		while ((retval = rtai_lxrt(BIDX, SIZARG, SEM_WAIT, &arg).i[LOW]) == RTE_UNBLKD);
+		if (FMX_ADR(mutex)) {
+			while ((retval = rt_fmutex_lock((struct rt_fmutex *)FMX_ADR(mutex))) == RTE_UNBLKD);
+		} else {
+			while ((retval = rtai_lxrt(BIDX, SIZARG, SEM_WAIT, &arg).i[LOW]) == RTE_UNBLKD);
+		}
 		return abs(retval) < RTE_BASE ? 0 : EDEADLOCK;
 	}
 	return EINVAL;
@@ -1430,7 +1462,7 @@ RTAI_PROTO(int, __wrap_pthread_mutex_trylock, (pthread_mutex_t *mutex))
 {
 	struct { void *mutex; } arg = { SET_ADR(mutex) };
 	if (arg.mutex) {
-		if (rtai_lxrt(BIDX, SIZARG, SEM_WAIT_IF, &arg).i[LOW] <= 0) {
+		if ((FMX_ADR(mutex) ? rt_fmutex_trylock((struct rt_fmutex *)FMX_ADR(mutex)) : rtai_lxrt(BIDX, SIZARG, SEM_WAIT_IF, &arg).i[LOW]) <= 0) {
 			return EBUSY;
 		}
 		return 0;
@@ -1444,7 +1476,11 @@ RTAI_PROTO(int, __wrap_pthread_mutex_timedlock, (pthread_mutex_t *mutex, const s
 	struct { void *mutex; RTIME time; } arg = { SET_ADR(mutex), timespec2count(abstime) };
 	if (arg.mutex && abstime->tv_nsec >= 0 && abstime->tv_nsec < 1000000000) {
 		int retval;
-		while ((retval = rtai_lxrt(BIDX, SIZARG, SEM_WAIT_UNTIL, &arg).i[LOW]) == RTE_UNBLKD);
+		if (FMX_ADR(mutex)) {
+			while ((retval = rt_fmutex_timedlock((struct rt_fmutex *)FMX_ADR(mutex), arg.time)) == RTE_UNBLKD);
+		} else {
+			while ((retval = rtai_lxrt(BIDX, SIZARG, SEM_WAIT_UNTIL, &arg).i[LOW]) == RTE_UNBLKD);
+		}
 		if (abs(retval) < RTE_BASE) {
 			return 0;
 		}
@@ -1460,6 +1496,9 @@ RTAI_PROTO(int, __wrap_pthread_mutex_unlock, (pthread_mutex_t *mutex))
 {
 	struct { void *mutex; } arg = { SET_ADR(mutex) };
 	if (arg.mutex) {
+		if (FMX_ADR(mutex)) {
+			return rt_fmutex_unlock((struct rt_fmutex *)FMX_ADR(mutex)) == RTE_PERM ? EPERM : 0;
+		}
 		return rtai_lxrt(BIDX, SIZARG, SEM_SIGNAL, &arg).i[LOW] == RTE_PERM ? EPERM : 0;
 	}
 	return EINVAL;
@@ -37,11 +37,18 @@ struct rt_registry_entry {
 	struct task_struct *tsk; // Linux task owner of the resource
 	int type;		 // Type of resource
         unsigned short count;	 // Usage registry
-	unsigned short alink;
-	unsigned short nlink;
+	unsigned int alink;
+	unsigned int nlink;
 };
 
-#define MAX_SLOTS  CONFIG_RTAI_SCHED_LXRT_NUMSLOTS // Max number of registered objects
+struct rt_registry_stats {
+	int slots, used;
+	unsigned long lookups, lookup_probes, lookup_retries, lookup_max_probe;
+	unsigned long inserts, insert_probes, insert_max_probe;
+	unsigned long growths, growth_fails;
+};
+
+#define MAX_SLOTS  CONFIG_RTAI_SCHED_LXRT_NUMSLOTS // Initial number of registry slots, it grows if needed
 
 #define IS_TASK  0               // Used to identify registered resources
 #define IS_SEM   1
@@ -52,6 +59,7 @@ struct rt_registry_entry {
 #define IS_BIT   6
 #define IS_TBX   7
 #define IS_HPCK  8
+#define IS_MQ    9
 
 #ifdef __KERNEL__
 
@@ -88,6 +96,8 @@ int rt_get_type(unsigned long name);
 int rt_get_registry_slot(int slot, struct rt_registry_entry *entry);
 #endif /* CONFIG_PROC_FS */
 
+void rt_registry_stats(struct rt_registry_stats *stats);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
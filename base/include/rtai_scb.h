@@ -61,6 +61,29 @@ struct task_struct;
 
 #endif
 
+#ifdef __KERNEL__
+
+#define rt_scb_mb()               smp_mb()
+#define rt_scb_rmb()              smp_rmb()
+#define rt_scb_wmb()              smp_wmb()
+#define rt_scb_relax()            cpu_relax()
+#define rt_scb_cmpxchg(p, o, n)   cmpxchg(p, o, n)
+
+#else
+
+#define rt_scb_mb()               __sync_synchronize()
+#if defined(__i386__) || defined(__x86_64__)
+#define rt_scb_rmb()              __asm__ __volatile__ ("" : : : "memory")
+#define rt_scb_wmb()              __asm__ __volatile__ ("" : : : "memory")
+#else
+#define rt_scb_rmb()              __sync_synchronize()
+#define rt_scb_wmb()              __sync_synchronize()
+#endif
+#define rt_scb_relax()            rt_scb_rmb()
+#define rt_scb_cmpxchg(p, o, n)   __sync_val_compare_and_swap(p, o, n)
+
+#endif
+
 /**
  * Allocate and initialize a shared memory circular buffer.
  *
@@ -240,12 +263,15 @@ RTAI_SCB_PROTO(int, rt_scb_get, (void *scb, void *msg, int msg_size))
 	int size = SIZE, fbyte = FBYTE, lbyte = LBYTE;
 	if (msg_size > 0 && ((lbyte -= fbyte) >= 0 ? lbyte : size + lbyte) >= msg_size) {
 		int tocpy;
+		rt_scb_rmb();
 		if ((tocpy = size - fbyte) > msg_size) {
 			memcpy(msg, SCB + fbyte, msg_size);
+			rt_scb_mb();
 			FBYTE = fbyte + msg_size;
 		} else {
 			memcpy(msg, SCB + fbyte, tocpy);
 			memcpy(msg + tocpy, SCB, msg_size -= tocpy);
+			rt_scb_mb();
 			FBYTE = msg_size;
 		}
 		return 0;
@@ -298,12 +324,15 @@ RTAI_SCB_PROTO(int, rt_scb_put, (void *scb, void *msg, int msg_size))
 	int size = SIZE, fbyte = FBYTE, lbyte = LBYTE;
 	if (msg_size > 0 && ((fbyte -= lbyte) <= 0 ? size + fbyte : fbyte) > msg_size) {
 		int tocpy;
+		rt_scb_rmb();
 		if ((tocpy = size - lbyte) > msg_size) {
 			memcpy(SCB + lbyte, msg, msg_size);
+			rt_scb_wmb();
 			LBYTE = lbyte + msg_size;
 		} else {
 			memcpy(SCB + lbyte, msg, tocpy);
 			memcpy(SCB, msg + tocpy, msg_size -= tocpy);
+			rt_scb_wmb();
 			LBYTE = msg_size;
 		}
 		return 0;
@@ -329,4 +358,415 @@ RTAI_SCB_PROTO(int, rt_scb_ovrwr, (void *scb, void *msg, int msg_size))
 	return msg_size;
 }
 
+/*
+ * MULTIPLE PRODUCERS SCB.
+ *
+ * A variant of the above, allowing any number of producers and a single
+ * consumer, so that many hard real time tasks, on any CPU, can stream into
+ * a single logger without a mailbox. Its buffer is a sequence of messages,
+ * each preceded by a small header, rather than a plain bytes stream.
+ * Producers reserve the room for a message by advancing the write cursor
+ * with a compare and swap, fill it directly on the buffer and commit it by
+ * setting a flag in its header, after a write barrier. The consumer takes
+ * committed messages in place, stopping at the first one not committed yet,
+ * and releases them by zeroing their room and advancing the read cursor,
+ * after a full barrier. So a message must fit into half the buffer, and
+ * whatever is reserved must be committed, soon, as it holds all the messages
+ * that follow. The cursors are on different cache lines and run freely,
+ * the buffer size being a power of 2.
+ * The copying rt_mpscb_put/rt_mpscb_get are built on rt_mpscb_reserve/
+ * rt_mpscb_commit and rt_mpscb_peek/rt_mpscb_release.
+ */
+
+#define RT_MPSCB_CACHE_BYTES  64
+#define RT_MPSCB_ALIGN        8
+
+/* message header flags */
+#define RT_MPSCB_COMMITTED  1
+#define RT_MPSCB_PAD        2
+
+struct rt_mpscb_msg {
+	volatile unsigned int flags;
+	int size;
+};
+
+struct rt_mpscb {
+	unsigned long name;
+	volatile unsigned long ready;
+	unsigned long size;
+	volatile unsigned long head __attribute__ ((aligned(RT_MPSCB_CACHE_BYTES)));
+	volatile unsigned long tail __attribute__ ((aligned(RT_MPSCB_CACHE_BYTES)));
+	char data[0] __attribute__ ((aligned(RT_MPSCB_CACHE_BYTES)));
+};
+
+#define RT_MPSCB_SPAN(msg_size) \
+	(((msg_size) + sizeof(struct rt_mpscb_msg) + RT_MPSCB_ALIGN - 1) & ~(RT_MPSCB_ALIGN - 1))
+
+#define RT_MPSCB_MSG(scb, cursor) \
+	((struct rt_mpscb_msg *)((scb)->data + ((cursor) & ((scb)->size - 1))))
+
+
+/**
+ * Allocate and initialize a multiple producers shared memory circular buffer.
+ *
+ * @internal
+ *
+ * rt_mpscb_init is used to allocate and/or initialize a multiple producers
+ * shared memory circular buffer. Its arguments and the way the allocation is
+ * shared are the same as for rt_scb_init, the size being rounded up to a power
+ * of 2. When "suprt" is a memory area provided by the user, "size" is the
+ * whole area size, zeroed, and the buffer will be the largest power of 2
+ * fitting in it after the header, at least RT_MPSCB_CACHE_BYTES, smaller
+ * areas being refused.
+ * The initialization is done by the first caller, any other one waiting for
+ * it to be published.
+ *
+ * @returns a valid handle on succes, you must use it, 0 on failure.
+ *
+ */
+
+RTAI_SCB_PROTO(void *, rt_mpscb_init, (unsigned long name, int size, unsigned long suprt))
+{
+	struct rt_mpscb *scb;
+	unsigned long bufsize;
+	if (suprt > 1000) {
+		if (size < (int)(sizeof(struct rt_mpscb) + RT_MPSCB_CACHE_BYTES)) {
+			return 0;
+		}
+		for (bufsize = RT_MPSCB_CACHE_BYTES; 2*bufsize + sizeof(struct rt_mpscb) <= size; bufsize <<= 1);
+		scb = (struct rt_mpscb *)suprt;
+	} else {
+		for (bufsize = RT_MPSCB_CACHE_BYTES; bufsize < size; bufsize <<= 1);
+		scb = (struct rt_mpscb *)rt_shm_alloc(name, sizeof(struct rt_mpscb) + bufsize, suprt);
+	}
+	if (scb) {
+		if (!rt_scb_cmpxchg(&scb->name, 0, name)) {
+			scb->size = bufsize;
+			scb->head = scb->tail = 0;
+			memset(scb->data, 0, bufsize);
+			rt_scb_wmb();
+			scb->ready = name;
+		} else {
+			while (scb->ready != name) {
+				rt_scb_relax();
+			}
+			rt_scb_rmb();
+		}
+	}
+	return scb;
+}
+
+/**
+ * Reset a multiple producers shared memory circular buffer.
+ *
+ * @internal
+ *
+ * rt_mpscb_reset discards all the messages, it must not be used while any
+ * producer or the consumer is working on the buffer.
+ *
+ * @param scb is the handle returned when the buffer was initted.
+ *
+ */
+
+RTAI_SCB_PROTO(void, rt_mpscb_reset, (void *scb))
+{
+	memset(((struct rt_mpscb *)scb)->data, 0, ((struct rt_mpscb *)scb)->size);
+	rt_scb_wmb();
+	((struct rt_mpscb *)scb)->head = ((struct rt_mpscb *)scb)->tail = 0;
+}
+
+/**
+ * Free a multiple producers shared memory circular buffer.
+ *
+ * @internal
+ *
+ * Same as rt_scb_delete.
+ *
+ */
+
+RTAI_SCB_PROTO(int, rt_mpscb_delete, (unsigned long name))
+{
+	return rt_shm_free(name);
+}
+
+/**
+ * Get the number of bytes in use in a multiple producers shared memory
+ * circular buffer.
+ *
+ * @internal
+ *
+ * The count includes the headers, and the messages being written.
+ *
+ * @param scb is the handle returned when the buffer was initted.
+ *
+ * @returns the number of bytes in use.
+ *
+ */
+
+RTAI_SCB_PROTO(int, rt_mpscb_avbs, (void *scb))
+{
+	unsigned long tail = ((struct rt_mpscb *)scb)->tail;
+	rt_scb_rmb();
+	return ((struct rt_mpscb *)scb)->head - tail;
+}
+
+/**
+ * Get the number of free bytes in a multiple producers shared memory circular
+ * buffer.
+ *
+ * @internal
+ *
+ * @param scb is the handle returned when the buffer was initted.
+ *
+ * @returns the number of free bytes, headers room included.
+ *
+ */
+
+RTAI_SCB_PROTO(int, rt_mpscb_frbs, (void *scb))
+{
+	return ((struct rt_mpscb *)scb)->size - rt_mpscb_avbs(scb);
+}
+
+/**
+ * @brief Reserves the room for a message.
+ *
+ * rt_mpscb_reserve reserves @e msg_size contiguous bytes on the multiple
+ * producers shared memory circular buffer @e scb, for the caller to write
+ * a message directly on it. Any number of producers can reserve at the same
+ * time. It returns immediately and the caller is never blocked.
+ * The message will be seen by the consumer only after rt_mpscb_commit, which
+ * must always follow.
+ *
+ * @return On success the address at which the message is to be written, NULL
+ * if there is no room for it.
+ *
+ */
+
+RTAI_SCB_PROTO(void *, rt_mpscb_reserve, (void *scbp, int msg_size))
+{
+	struct rt_mpscb *scb = (struct rt_mpscb *)scbp;
+	struct rt_mpscb_msg *msg;
+	unsigned long size, head, tail, ofst, span, pad;
+	size = scb->size;
+	if (msg_size <= 0 || (span = RT_MPSCB_SPAN(msg_size)) > size/2) {
+		return NULL;
+	}
+	do {
+		tail = scb->tail;
+		rt_scb_rmb();
+		head = scb->head;
+		ofst = head & (size - 1);
+		pad = ofst + span > size ? size - ofst : 0;
+		if (head + pad + span - tail > size) {
+			return NULL;
+		}
+	} while (rt_scb_cmpxchg(&scb->head, head, head + pad + span) != head);
+	if (pad) {
+		msg = (struct rt_mpscb_msg *)(scb->data + ofst);
+		msg->size = pad - sizeof(struct rt_mpscb_msg);
+		rt_scb_wmb();
+		msg->flags = RT_MPSCB_COMMITTED | RT_MPSCB_PAD;
+		ofst = 0;
+	}
+	msg = (struct rt_mpscb_msg *)(scb->data + ofst);
+	msg->size = msg_size;
+	return msg + 1;
+}
+
+/**
+ * @brief Commits a reserved message.
+ *
+ * rt_mpscb_commit makes the message written at @e msg, as returned by
+ * rt_mpscb_reserve, available to the consumer.
+ *
+ */
+
+RTAI_SCB_PROTO(void, rt_mpscb_commit, (void *scb, void *msg))
+{
+	rt_scb_wmb();
+	((struct rt_mpscb_msg *)msg - 1)->flags = RT_MPSCB_COMMITTED;
+}
+
+/**
+ * @brief Releases the oldest message.
+ *
+ * rt_mpscb_release frees the room of the message returned by rt_mpscb_peek,
+ * which must not be used anymore afterward. Consumer only.
+ *
+ */
+
+RTAI_SCB_PROTO(void, rt_mpscb_release, (void *scbp))
+{
+	struct rt_mpscb *scb = (struct rt_mpscb *)scbp;
+	struct rt_mpscb_msg *msg;
+	unsigned long tail, span;
+	msg = RT_MPSCB_MSG(scb, tail = scb->tail);
+	span = RT_MPSCB_SPAN(msg->size);
+	memset(msg, 0, span);
+	rt_scb_mb();
+	scb->tail = tail + span;
+}
+
+/**
+ * @brief Peeks the oldest message.
+ *
+ * rt_mpscb_peek gives access in place to the oldest message on the multiple
+ * producers shared memory circular buffer @e scb, if it has been committed
+ * already. It returns immediately and the caller is never blocked.
+ * The message stays on the buffer till rt_mpscb_release. Consumer only.
+ *
+ * @param msg_size, if not NULL, gets the size of the message.
+ *
+ * @return On success the address of the message, NULL if there is none.
+ *
+ */
+
+RTAI_SCB_PROTO(void *, rt_mpscb_peek, (void *scbp, int *msg_size))
+{
+	struct rt_mpscb *scb = (struct rt_mpscb *)scbp;
+	struct rt_mpscb_msg *msg;
+	unsigned int flags;
+	while ((flags = (msg = RT_MPSCB_MSG(scb, scb->tail))->flags) & RT_MPSCB_COMMITTED) {
+		rt_scb_rmb();
+		if (!(flags & RT_MPSCB_PAD)) {
+			if (msg_size) {
+				*msg_size = msg->size;
+			}
+			return msg + 1;
+		}
+		rt_mpscb_release(scb);
+	}
+	return NULL;
+}
+
+/**
+ * @brief Puts (sends) a message, only if the whole message can be passed all
+ * at once.
+ *
+ * rt_mpscb_put copies the message @e msg of @e msg_size bytes to the multiple
+ * producers shared memory circular buffer @e scb. It returns immediately and
+ * the caller is never blocked.
+ *
+ * @return On success, i.e. message put, it returns 0, msg_size on failure.
+ *
+ */
+
+RTAI_SCB_PROTO(int, rt_mpscb_put, (void *scb, void *msg, int msg_size))
+{
+	void *buf;
+	if ((buf = rt_mpscb_reserve(scb, msg_size))) {
+		memcpy(buf, msg, msg_size);
+		rt_mpscb_commit(scb, buf);
+		return 0;
+	}
+	return msg_size;
+}
+
+/**
+ * @brief Gets (receives) a message.
+ *
+ * rt_mpscb_get copies the oldest message on the multiple producers shared
+ * memory circular buffer @e scb to @e msg, if it is not larger than
+ * @e msg_size. It returns immediately and the caller is never blocked.
+ * Consumer only.
+ *
+ * @return the size of the message got, 0 if there is none, minus its size
+ * if it does not fit into @e msg, in which case it is left on the buffer.
+ *
+ */
+
+RTAI_SCB_PROTO(int, rt_mpscb_get, (void *scb, void *msg, int msg_size))
+{
+	void *buf;
+	int size;
+	if ((buf = rt_mpscb_peek(scb, &size))) {
+		if (size > msg_size) {
+			return -size;
+		}
+		memcpy(msg, buf, size);
+		rt_mpscb_release(scb);
+		return size;
+	}
+	return 0;
+}
+
+/*
+ * STREAM SCB.
+ *
+ * A named SCB whose producer knows if a consumer is attached to it, so that
+ * a periodic producer, e.g. a sampling block of a hard real time controller,
+ * can stream into it, without any system call, just while a consumer on the
+ * same machine is reading it, using another way, e.g. a mailbox that can be
+ * read through netrpc, otherwise. An attaching consumer skips any leftover.
+ * When the buffer gets full, i.e. if its consumer stalls, or died without
+ * detaching, the producer can drop the message or go back to its other way. The stream
+ * header is on its own cache line, ahead of a plain SCB, so that the usual
+ * rt_scb_put/rt_scb_get can be used on the returned handle.
+ */
+
+#define RT_SSCB_HDRSIZ  RT_MPSCB_CACHE_BYTES
+
+#define RT_SSCB_READERS(scb)  (((volatile int *)((char *)(scb) - HDRSIZ - RT_SSCB_HDRSIZ))[0])
+
+/**
+ * Allocate, or map, a stream shared memory circular buffer.
+ *
+ * @internal
+ *
+ * rt_sscb_init allocates a named stream SCB of size bytes, or just maps it if
+ * it exists already, in which case size is not used.
+ *
+ * @returns a plain SCB handle on success, 0 on failure.
+ *
+ */
+
+RTAI_SCB_PROTO(void *, rt_sscb_init, (unsigned long name, int size))
+{
+	char *p;
+	if ((p = (char *)rt_shm_alloc(name, RT_SSCB_HDRSIZ + HDRSIZ + size + 1, USE_VMALLOC))) {
+		return rt_scb_init(name, HDRSIZ + size + 1, (unsigned long)(p + RT_SSCB_HDRSIZ));
+	}
+	return 0;
+}
+
+RTAI_SCB_PROTO(int, rt_sscb_delete, (unsigned long name))
+{
+	return rt_shm_free(name);
+}
+
+/**
+ * @brief Attaches the consumer of a stream SCB.
+ *
+ * rt_sscb_attach discards whatever is on the buffer and tells the producer
+ * to stream into it from now on. There can be just one consumer.
+ *
+ */
+
+RTAI_SCB_PROTO(void, rt_sscb_attach, (void *scb))
+{
+	FBYTE = LBYTE;
+	rt_scb_mb();
+	RT_SSCB_READERS(scb) = 1;
+}
+
+RTAI_SCB_PROTO(void, rt_sscb_detach, (void *scb))
+{
+	RT_SSCB_READERS(scb) = 0;
+}
+
+/**
+ * @brief Puts a message on a stream SCB, if anybody is reading it.
+ *
+ * rt_sscb_put is rt_scb_put for an attached consumer, failing at once when
+ * there is none, so that the producer can send the message its other way.
+ *
+ * @return 0 on success, msg_size if there is no consumer or room.
+ *
+ */
+
+RTAI_SCB_PROTO(int, rt_sscb_put, (void *scb, void *msg, int msg_size))
+{
+	return RT_SSCB_READERS(scb) ? rt_scb_put(scb, msg, msg_size) : msg_size;
+}
+
 #endif /* _RTAI_SCB_H */
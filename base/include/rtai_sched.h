@@ -131,6 +131,10 @@ typedef struct rb_node rb_node_t;
 typedef struct rb_root rb_root_t;
 #endif
 
+#ifdef CONFIG_RTAI_TIMED_LIST_WHEEL
+#include <rtai_twheel.h>
+#endif
+
 #define RT_TASK_MAGIC 0x9ad25f6f  // nam2num("rttask")
 
 #ifndef __cplusplus
@@ -148,6 +152,7 @@ struct mcb_t {
 	int sbytes;
 	void *rbuf;
 	int rbytes;
+	struct mm_struct *mm;  // if not NULL sbuf and rbuf are user space addresses
 };
 
 /*Exit handler functions are called like C++ destructors in rt_task_delete().*/
@@ -200,6 +205,7 @@ typedef struct rt_task_struct {
 	long long retval;
 	char *msg_buf[2];
 	long max_msg_size[2];
+	struct mm_struct *msg_mm;  // set while an UDC call uses user buffers
 	char task_name[RTAI_MAX_NAME_LENGTH];
 	void *system_data_ptr;
 	struct rt_task_struct *nextp, *prevp;
@@ -232,9 +238,14 @@ typedef struct rt_task_struct {
 
 	long scheduler;
 
-#ifdef CONFIG_RTAI_LONG_TIMED_LIST
+#if defined(CONFIG_RTAI_TIMED_LIST_WHEEL)
+	struct rt_twheel_node twn;
+#elif defined(CONFIG_RTAI_LONG_TIMED_LIST)
 	rb_root_t rbr;
 	rb_node_t rbn;
+#endif
+#ifdef CONFIG_RTAI_BITMAP_READY_LIST
+	int rlevel;
 #endif
 	struct rt_queue resq;
 	unsigned long resumsg;
@@ -253,34 +253,210 @@ do { \
 	hal_pend_uncond(wake_up_srq[0].srq, cpuid); \
 } while (0)
 
+#ifdef CONFIG_RTAI_BITMAP_READY_LIST
+
+/*
+ * PRIORITY BITMAP: the ready list stays the very same doubly linked list, 
+ * ordered by priority, that everybody else walks, but each per CPU list is 
+ * indexed by a two level bitmap of the priority levels having ready tasks, 
+ * along with the last task of each level. So the place where a task must 
+ * be inserted is found in constant time, rather than by scanning all the 
+ * higher priority ready tasks. Priorities beyond RT_READY_LIST_LEVELS - 2 
+ * share the last level, within which the linear scan is kept, while the 
+ * negative ones, temporarily assigned by rt_spv_RMS, are not mapped at all.
+ */
+
+#define RT_READY_LIST_LEVELS  256
+#define RT_READY_LIST_WORDS   ((RT_READY_LIST_LEVELS + BITS_PER_LONG - 1)/BITS_PER_LONG)
+
+struct rt_ready_map { 
+	unsigned long summary; 
+	unsigned long map[RT_READY_LIST_WORDS]; 
+	RT_TASK *tail[RT_READY_LIST_LEVELS]; 
+};
+
+extern struct rt_ready_map rt_smp_ready_map[];
+
+#ifdef CONFIG_SMP
+#define READY_MAP(task)  (&rt_smp_ready_map[(task)->runnable_on_cpus])
+#else
+#define READY_MAP(task)  (&rt_smp_ready_map[0])
+#endif
+
+static inline int ready_level(int priority)
+{
+	return priority < RT_READY_LIST_LEVELS - 1 ? priority : RT_READY_LIST_LEVELS - 1;
+}
+
+/* Highest priority, i.e. lowest index, level at or above "level". */
+static inline int ready_map_find(struct rt_ready_map *rmap, int level)
+{
+	unsigned long word, wrdidx;
+	if (level < 0) {
+		return -1;
+	}
+	wrdidx = level/BITS_PER_LONG;
+	if ((word = rmap->map[wrdidx] & (~0UL >> (BITS_PER_LONG - 1 - level%BITS_PER_LONG)))) {
+		return wrdidx*BITS_PER_LONG + __fls(word);
+	}
+	if ((word = rmap->summary & ((1UL << wrdidx) - 1))) {
+		wrdidx = __fls(word);
+		return wrdidx*BITS_PER_LONG + __fls(rmap->map[wrdidx]);
+	}
+	return -1;
+}
+
+static inline void ready_map_set(struct rt_ready_map *rmap, int level)
+{
+	__set_bit(level%BITS_PER_LONG, &rmap->map[level/BITS_PER_LONG]);
+	__set_bit(level/BITS_PER_LONG, &rmap->summary);
+}
+
+static inline void ready_map_clear(struct rt_ready_map *rmap, int level)
+{
+	if (!(rmap->map[level/BITS_PER_LONG] &= ~(1UL << (level%BITS_PER_LONG)))) {
+		__clear_bit(level/BITS_PER_LONG, &rmap->summary);
+	}
+}
+
+static inline RT_TASK *ready_list_start(RT_TASK *ready_task)
+{
+	struct rt_ready_map *rmap = READY_MAP(ready_task);
+	int level = ready_level(ready_task->priority);
+	level = ready_map_find(rmap, level < RT_READY_LIST_LEVELS - 1 ? level : level - 1);
+#ifdef CONFIG_SMP
+	return level >= 0 ? rmap->tail[level]->rnext : rt_smp_linux_task[ready_task->runnable_on_cpus].rnext;
+#else
+	return level >= 0 ? rmap->tail[level]->rnext : rt_smp_linux_task[0].rnext;
+#endif
+}
+
+static inline void ready_map_add(RT_TASK *ready_task)
+{
+	struct rt_ready_map *rmap = READY_MAP(ready_task);
+	int level;
+	if ((level = ready_task->rlevel = ready_level(ready_task->priority)) < 0) {
+		return;
+	}
+	if (!test_bit(level%BITS_PER_LONG, &rmap->map[level/BITS_PER_LONG])) {
+		rmap->tail[level] = ready_task;
+		ready_map_set(rmap, level);
+	} else if (rmap->tail[level] == ready_task->rprev) {
+		rmap->tail[level] = ready_task;
+	}
+}
+
+static inline void ready_map_del(RT_TASK *task)
+{
+	struct rt_ready_map *rmap = READY_MAP(task);
+	int level = task->rlevel;
+	if (rmap->tail[level] == task) {
+		if ((task->rprev)->rlevel == level) {
+			rmap->tail[level] = task->rprev;
+		} else {
+			ready_map_clear(rmap, level);
+		}
+	}
+	task->rlevel = -1;
+}
+
+#endif /* CONFIG_RTAI_BITMAP_READY_LIST */
+
+/*
+ * Whether a ready task, whose priority has just been changed in place, must
+ * be requeued. With the priority bitmap it must be also when it still fits 
+ * between its neighbours but its level changed, not to leave the tail of 
+ * its old level pointing to it. Soft tasks are not on the RTAI ready list.
+ */
+static inline int ready_task_misplaced(RT_TASK *task)
+{
+#ifdef CONFIG_RTAI_BITMAP_READY_LIST
+	if (task->is_hard && task->rlevel != ready_level(task->priority)) {
+		return 1;
+	}
+#endif
+	return (task->rprev)->priority > task->priority || (task->rnext)->priority < task->priority;
+}
+
+static inline void rem_ready_list(RT_TASK *task)
+{
+#ifdef CONFIG_RTAI_BITMAP_READY_LIST
+	if (task->rlevel >= 0) {
+		ready_map_del(task);
+	}
+#endif
+	(task->rprev)->rnext = task->rnext;
+	(task->rnext)->rprev = task->rprev;
+}
+
 static inline void enq_ready_task(RT_TASK *ready_task)
 {
 	RT_TASK *task;
 	if (ready_task->is_hard) {
+#ifdef CONFIG_RTAI_BITMAP_READY_LIST
+		task = ready_list_start(ready_task);
+#else
 #ifdef CONFIG_SMP
 		task = rt_smp_linux_task[ready_task->runnable_on_cpus].rnext;
 #else
 		task = rt_smp_linux_task[0].rnext;
+#endif
 #endif
 		while (ready_task->priority >= task->priority) {
 			if ((task = task->rnext)->priority < 0) break;
 		}
 		task->rprev = (ready_task->rprev = task->rprev)->rnext = ready_task;
 		ready_task->rnext = task;
+#ifdef CONFIG_RTAI_BITMAP_READY_LIST
+		ready_map_add(ready_task);
+#endif
 	} else {
 		ready_task->state |= RT_SCHED_SFTRDY;
 		NON_RTAI_TASK_RESUME(ready_task);
 	}
 }
 
+/* 
+ * Put a ready task after all the ready tasks having its same priority,
+ * returns 0 if there are none, i.e. nothing to yield to.
+ */
+static inline int yield_ready_task(RT_TASK *rt_current)
+{
+	RT_TASK *task;
+	task = rt_current->rnext;
+#ifdef CONFIG_RTAI_BITMAP_READY_LIST
+	if (rt_current->rlevel >= 0 && rt_current->rlevel < RT_READY_LIST_LEVELS - 1) {
+		if (task->priority != rt_current->priority) {
+			return 0;
+		}
+		task = READY_MAP(rt_current)->tail[rt_current->rlevel]->rnext;
+	}
+#endif
+	while (rt_current->priority == task->priority) {
+		task = task->rnext;
+	}
+	if (task != rt_current->rnext) {
+		(rt_current->rprev)->rnext = rt_current->rnext;
+		(rt_current->rnext)->rprev = rt_current->rprev;
+		task->rprev = (rt_current->rprev = task->rprev)->rnext = rt_current;
+		rt_current->rnext = task;
+#ifdef CONFIG_RTAI_BITMAP_READY_LIST
+		if (rt_current->rlevel >= 0 && READY_MAP(rt_current)->tail[rt_current->rlevel] == rt_current->rprev) {
+			READY_MAP(rt_current)->tail[rt_current->rlevel] = rt_current;
+		}
+#endif
+		return 1;
+	}
+	return 0;
+}
+
 static inline int renq_ready_task(RT_TASK *ready_task, int priority)
 {
 	int retval;
 	if ((retval = ready_task->priority != priority)) {
 		ready_task->priority = priority;
 		if (ready_task->state == RT_SCHED_READY) {
-			(ready_task->rprev)->rnext = ready_task->rnext;
-			(ready_task->rnext)->rprev = ready_task->rprev;
+			rem_ready_list(ready_task);
 			enq_ready_task(ready_task);
 		}
 	}
@@ -294,8 +470,7 @@ static inline void rem_ready_task(RT_TASK *task)
 			NON_RTAI_TASK_SUSPEND(task);
 		}
 //		task->unblocked = 0;
-		(task->rprev)->rnext = task->rnext;
-		(task->rnext)->rprev = task->rprev;
+		rem_ready_list(task);
 	}
 }
 
@@ -305,11 +480,10 @@ static inline void rem_ready_current(RT_TASK *rt_current)
 		NON_RTAI_TASK_SUSPEND(rt_current);
 	}
 //	rt_current->unblocked = 0;
-	(rt_current->rprev)->rnext = rt_current->rnext;
-	(rt_current->rnext)->rprev = rt_current->rprev;
+	rem_ready_list(rt_current);
 }
 
-#ifdef CONFIG_RTAI_LONG_TIMED_LIST
+#if defined(CONFIG_RTAI_LONG_TIMED_LIST) && !defined(CONFIG_RTAI_TIMED_LIST_WHEEL)
 
 /* BINARY TREE */
 static inline void enq_timed_task(RT_TASK *timed_task)
@@ -342,10 +516,10 @@ static inline void enq_timed_task(RT_TASK *timed_task)
 #define	rb_erase_task(task, cpuid) \
 	rb_erase(&(task)->rbn, &rt_smp_linux_task[cpuid].rbr);
 
-#else /* !CONFIG_RTAI_LONG_TIMED_LIST */
+#else /* !CONFIG_RTAI_LONG_TIMED_LIST || CONFIG_RTAI_TIMED_LIST_WHEEL */
 
 /* LINEAR */
-static inline void enq_timed_task(RT_TASK *timed_task)
+static inline void enq_near_timed_task(RT_TASK *timed_task)
 {
 	RT_TASK *task;
 #ifdef CONFIG_SMP
@@ -360,13 +534,67 @@ static inline void enq_timed_task(RT_TASK *timed_task)
 	timed_task->tnext = task;
 }
 
+#ifdef CONFIG_RTAI_TIMED_LIST_WHEEL
+
+/* TIMING WHEEL, in front of the LINEAR list, see rtai_twheel.h */
+extern struct rt_twheel rt_smp_twheel[];
+
+#ifdef CONFIG_SMP
+#define TWHEEL(task)  (&rt_smp_twheel[(task)->runnable_on_cpus])
+#else
+#define TWHEEL(task)  (&rt_smp_twheel[0])
+#endif
+
+static inline void enq_timed_task(RT_TASK *timed_task)
+{
+	if (rt_twheel_near(TWHEEL(timed_task), timed_task->resume_time)) {
+		enq_near_timed_task(timed_task);
+	} else {
+		timed_task->tprev = timed_task->tnext = timed_task;
+		rt_twheel_add(TWHEEL(timed_task), &timed_task->twn, timed_task->resume_time);
+	}
+}
+
+static inline void rem_far_timed_task(RT_TASK *task)
+{
+	if (rt_twheel_armed(&task->twn)) {
+		rt_twheel_del(TWHEEL(task), &task->twn);
+	}
+}
+
+static inline void merge_far_timed_tasks(int cpuid)
+{
+	struct rt_twheel_node list, *node;
+	list.next = list.prev = &list;
+#ifdef CONFIG_SMP
+	if (rt_twheel_expire(&rt_smp_twheel[cpuid], rt_time_h, &list)) {
+#else
+	if (rt_twheel_expire(&rt_smp_twheel[0], rt_time_h, &list)) {
+#endif
+		for (node = list.next; node != &list; node = node->next) {
+			enq_near_timed_task(container_of(node, RT_TASK, twn));
+		}
+	}
+}
+
+#else /* !CONFIG_RTAI_TIMED_LIST_WHEEL */
+
+#define enq_timed_task(timed_task)  enq_near_timed_task(timed_task)
+
+#define rem_far_timed_task(task)
+
+#define merge_far_timed_tasks(cpuid)
+
+#endif /* CONFIG_RTAI_TIMED_LIST_WHEEL */
+
 #define	rb_erase_task(task, cpuid)
 
-#endif /* !CONFIG_RTAI_LONG_TIMED_LIST */
+#endif /* !CONFIG_RTAI_LONG_TIMED_LIST || CONFIG_RTAI_TIMED_LIST_WHEEL */
 
 static inline void rem_timed_task(RT_TASK *task)
 {
 	if ((task->state & RT_SCHED_DELAYED)) {
+		rem_far_timed_task(task);
                 (task->tprev)->tnext = task->tnext;
                 (task->tnext)->tprev = task->tprev;
 #ifdef CONFIG_SMP
@@ -380,6 +608,7 @@ static inline void rem_timed_task(RT_TASK *task)
 static inline void wake_up_timed_tasks(int cpuid)
 {
 	RT_TASK *taskh, *task;
+	merge_far_timed_tasks(cpuid);
 #ifdef CONFIG_SMP
 	task = (taskh = &rt_smp_linux_task[cpuid])->tnext;
 #else
@@ -447,12 +676,11 @@ static inline unsigned long pass_prio(RT_TASK *to, RT_TASK *from)
         while (to && to->priority > from->priority) {
                 to->priority = from->priority;
 		if (to->state == RT_SCHED_READY) {
-			if ((to->rprev)->priority > to->priority || (to->rnext)->priority < to->priority) {
+			if (ready_task_misplaced(to)) {
 #ifdef CONFIG_SMP
 				rhead = rt_smp_linux_task[to->runnable_on_cpus].rnext;
 #endif
-				(to->rprev)->rnext = to->rnext;
-				(to->rnext)->rprev = to->rprev;
+				rem_ready_list(to);
 				enq_ready_task(to);
 #ifdef CONFIG_SMP
 				if (rhead != rt_smp_linux_task[to->runnable_on_cpus].rnext)  {
@@ -56,6 +56,7 @@ typedef struct rt_semaphore {
 	struct rt_task_struct *owndby;
 	int qtype;
 	struct rt_queue resq;
+	volatile unsigned long *fword; /* fast mutex word, see rtai_fmutex.h */
 #ifdef CONFIG_RTAI_RT_POLL
 	struct rt_poll_ql poll_wait_all;
 	struct rt_poll_ql poll_wait_one;
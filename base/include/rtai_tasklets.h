@@ -95,7 +95,9 @@ struct rt_tasklet_struct {
 	struct rt_task_struct *task;
 	struct rt_tasklet_struct *usptasklet;
 	int overrun;
-#ifdef  CONFIG_RTAI_LONG_TIMED_LIST
+#if defined(CONFIG_RTAI_TIMED_LIST_WHEEL)
+	struct rt_twheel_node twn;
+#elif defined(CONFIG_RTAI_LONG_TIMED_LIST)
 	rb_root_t rbr;
 	rb_node_t rbn;
 #endif
@@ -307,7 +309,9 @@ struct rt_tasklet_struct {
 	struct rt_task_struct *task;
 	struct rt_tasklet_struct *usptasklet;
 	int overrun;
-#ifdef  CONFIG_RTAI_LONG_TIMED_LIST
+#if defined(CONFIG_RTAI_TIMED_LIST_WHEEL)
+	struct { void *next, *prev; RTIME expires; int slot; } twn;
+#elif defined(CONFIG_RTAI_LONG_TIMED_LIST)
 	struct { void *rb_parent; int rb_color; void *rb_right, *rb_left; } rbn;
 	struct { void *rb_node; } rbr;
 #endif
@@ -41,6 +41,10 @@
 #define MSG_BROADCAST_UNTIL  TBX_BROADCAST_UNTIL
 #define MSG_BROADCAST_TIMED  TBX_BROADCAST_TIMED
 #define MSG_EVDRP            TBX_URGENT
+#define MSG_SEND_VEC         TBX_SEND_VEC
+#define MSG_SEND_VEC_IF      TBX_SEND_VEC_IF
+#define MSG_SEND_VEC_UNTIL   TBX_SEND_VEC_UNTIL
+#define MSG_SEND_VEC_TIMED   TBX_SEND_VEC_TIMED
 
 #define TBX  RT_MSGQ
 
@@ -61,12 +65,22 @@ typedef struct rt_msg {
 	char msg[1];
 } RT_MSG;
 
+/*
+ * Queued messages are kept on a FIFO per priority, the ones beyond the range
+ * of the buckets being kept ordered on the first or last one.
+ */
+#define RT_MSGQ_PRIOS  32
+
 typedef struct rt_msgq {
 	int nmsg;
 	int fastsize;
 	int slot;
 	void **slots;
 	void *firstmsg;
+	void *nomsg;
+	unsigned long prio_map;
+	RT_MSGH *prio_head[RT_MSGQ_PRIOS];
+	RT_MSGH *prio_tail[RT_MSGQ_PRIOS];
 	SEM receivers, senders;
 	SEM received, freslots;
 	SEM broadcast;
@@ -119,6 +133,30 @@ static inline int rt_msg_send_timed(RT_MSGQ *msgq, void *msg, int msg_size, int
 	return _rt_msg_send_timed(msgq, msg, msg_size, msgpri, delay, 1);
 }
 
+RTAI_SYSCALL_MODE int _rt_msg_send_vec(RT_MSGQ *msgq, struct rt_msg_iov *iov, int nmsg, int space);
+static inline int rt_msg_send_vec(RT_MSGQ *msgq, struct rt_msg_iov *iov, int nmsg)
+{
+	return _rt_msg_send_vec(msgq, iov, nmsg, 1);
+}
+
+RTAI_SYSCALL_MODE int _rt_msg_send_vec_if(RT_MSGQ *msgq, struct rt_msg_iov *iov, int nmsg, int space);
+static inline int rt_msg_send_vec_if(RT_MSGQ *msgq, struct rt_msg_iov *iov, int nmsg)
+{
+	return _rt_msg_send_vec_if(msgq, iov, nmsg, 1);
+}
+
+RTAI_SYSCALL_MODE int _rt_msg_send_vec_until(RT_MSGQ *msgq, struct rt_msg_iov *iov, int nmsg, RTIME until, int space);
+static inline int rt_msg_send_vec_until(RT_MSGQ *msgq, struct rt_msg_iov *iov, int nmsg, RTIME until)
+{
+	return _rt_msg_send_vec_until(msgq, iov, nmsg, until, 1);
+}
+
+RTAI_SYSCALL_MODE int _rt_msg_send_vec_timed(RT_MSGQ *msgq, struct rt_msg_iov *iov, int nmsg, RTIME delay, int space);
+static inline int rt_msg_send_vec_timed(RT_MSGQ *msgq, struct rt_msg_iov *iov, int nmsg, RTIME delay)
+{
+	return _rt_msg_send_vec_timed(msgq, iov, nmsg, delay, 1);
+}
+
 RTAI_SYSCALL_MODE int _rt_msg_receive(RT_MSGQ *msgq, void *msg, int msg_size, int *msgpri, int space);
 static inline int rt_msg_receive(RT_MSGQ *msgq, void *msg, int msg_size, int *msgpri)
 {
@@ -240,6 +278,30 @@ RTAI_PROTO(int, rt_msg_send_timed, (RT_MSGQ *msgq, void *msg, int msg_size, int
 	return rtai_lxrt(BIDX, SIZARG, MSG_SEND_TIMED, &arg).i[LOW];
 }
 
+RTAI_PROTO(int, rt_msg_send_vec, (RT_MSGQ *msgq, struct rt_msg_iov *iov, int nmsg))
+{
+	struct { RT_MSGQ *msgq; struct rt_msg_iov *iov; long nmsg; long space; } arg = { msgq, iov, nmsg, 0 };
+	return rtai_lxrt(BIDX, SIZARG, MSG_SEND_VEC, &arg).i[LOW];
+}
+
+RTAI_PROTO(int, rt_msg_send_vec_if, (RT_MSGQ *msgq, struct rt_msg_iov *iov, int nmsg))
+{
+	struct { RT_MSGQ *msgq; struct rt_msg_iov *iov; long nmsg; long space; } arg = { msgq, iov, nmsg, 0 };
+	return rtai_lxrt(BIDX, SIZARG, MSG_SEND_VEC_IF, &arg).i[LOW];
+}
+
+RTAI_PROTO(int, rt_msg_send_vec_until, (RT_MSGQ *msgq, struct rt_msg_iov *iov, int nmsg, RTIME until))
+{
+	struct { RT_MSGQ *msgq; struct rt_msg_iov *iov; long nmsg; RTIME until; long space; } arg = { msgq, iov, nmsg, until, 0 };
+	return rtai_lxrt(BIDX, SIZARG, MSG_SEND_VEC_UNTIL, &arg).i[LOW];
+}
+
+RTAI_PROTO(int, rt_msg_send_vec_timed, (RT_MSGQ *msgq, struct rt_msg_iov *iov, int nmsg, RTIME delay))
+{
+	struct { RT_MSGQ *msgq; struct rt_msg_iov *iov; long nmsg; RTIME delay; long space; } arg = { msgq, iov, nmsg, delay, 0 };
+	return rtai_lxrt(BIDX, SIZARG, MSG_SEND_VEC_TIMED, &arg).i[LOW];
+}
+
 RTAI_PROTO(int, rt_msg_receive, (RT_MSGQ *msgq, void *msg, int msg_size, int *msgprio))
 {
 	struct { RT_MSGQ *msgq; void *msg; long msg_size; int *msgprio; long space; } arg = { msgq, msg, msg_size, msgprio, 0 };
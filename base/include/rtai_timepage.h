@@ -0,0 +1,247 @@
+/*
+ * Copyright (C) 2026 The RTAI project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * SHARED TIME PAGE.
+ *
+ * The scheduler keeps on a named shared memory page, allocated by the SHM
+ * module and mapped read only to user space through /dev/rtai_shm, whatever
+ * is needed to convert the time stamp counter to RTAI times: its frequency,
+ * the per CPU offsets used to synchronize it, the boot epoch and the timing
+ * mode. The page is rewritten seqlock like, the sequence being odd while an
+ * update is in progress, so that LXRT user space can read the time with a
+ * plain rdtsc, without trapping into the kernel. Any user space helper falls
+ * back to the usual LXRT call if the page is not mapped.
+ */
+
+#ifndef _RTAI_TIMEPAGE_H
+#define _RTAI_TIMEPAGE_H
+
+#include <rtai_types.h>
+
+#define RT_TIME_PAGE_NAME   0xa955160b  // nam2num("RTTIMP")
+#define RT_TIME_PAGE_MAGIC  0x7e1a9a6e
+
+#define RT_TIME_PAGE_CPUS   CONFIG_RTAI_CPUS
+
+/* flags */
+#define RT_TIME_PAGE_TSC_OFST  1
+
+struct rt_time_page {
+	volatile unsigned int seq;
+	unsigned int magic;
+	unsigned int flags;
+	int oneshot;
+	RTIME clock_freq;
+	RTIME epoch_count;
+	RTIME epoch_ns;
+	int periodic_tick[RT_TIME_PAGE_CPUS];
+	RTIME tsc_ofst[RT_TIME_PAGE_CPUS];
+};
+
+#ifdef __KERNEL__
+
+void rt_set_time_page(struct rt_time_page *page);
+
+void rt_update_time_page(void);
+
+#else /* !__KERNEL__ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/ioctl.h>
+
+#if defined(__i386__) || defined(__x86_64__)
+
+#define RT_TIME_PAGE_USABLE
+
+#define rt_time_page_rmb()  __asm__ __volatile__ ("" : : : "memory")
+
+/* The CPU comes from the TSC_AUX register, set by Linux to node << 12 | cpu. */
+static inline RTIME rt_time_page_rdtsc(volatile struct rt_time_page *page)
+{
+	unsigned int lo, hi, aux;
+	if (page->flags & RT_TIME_PAGE_TSC_OFST) {
+		__asm__ __volatile__ ("rdtscp" : "=a" (lo), "=d" (hi), "=c" (aux));
+		return (((RTIME)hi << 32) | lo) + page->tsc_ofst[(aux & 0xFFF) % RT_TIME_PAGE_CPUS];
+	}
+	__asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+	return ((RTIME)hi << 32) | lo;
+}
+
+#endif
+
+/*
+ * Defined weak here, so that all the objects of a process share the same
+ * mapping, without the need of a library.
+ */
+volatile struct rt_time_page *rt_usp_time_page __attribute__ ((weak));
+
+/*
+ * Map the time page, it is done also by rt_task_init_schmod. Since it uses
+ * Linux calls it must not be used in hard real time. Returns the page, NULL
+ * if not available, in which case LXRT calls will be used to get the time.
+ */
+RTAI_PROTO(volatile struct rt_time_page *, rt_time_page_open, (void))
+{
+#ifdef RT_TIME_PAGE_USABLE
+	int hook, size;
+	void *adr;
+
+	if (rt_usp_time_page || (hook = open("/dev/rtai_shm", O_RDONLY)) <= 0) {
+		return rt_usp_time_page;
+	} else {
+		struct { unsigned long name; long arg, suprt; } arg = { RT_TIME_PAGE_NAME, 0, 0 };
+		if ((size = ioctl(hook, SHM_ALLOC, (unsigned long)(&arg))) >= (int)sizeof(struct rt_time_page)) {
+			if ((adr = mmap(NULL, size, PROT_READ, MAP_SHARED, hook, 0)) == MAP_FAILED) {
+				ioctl(hook, SHM_FREE, &arg.name);
+			} else if (((struct rt_time_page *)adr)->magic != RT_TIME_PAGE_MAGIC) {
+				munmap(adr, size);
+			} else {
+				rt_usp_time_page = (struct rt_time_page *)adr;
+			}
+		}
+		close(hook);
+	}
+#endif
+	return rt_usp_time_page;
+}
+
+RTAI_PROTO(void, rt_time_page_close, (void))
+{
+	volatile struct rt_time_page *page;
+	if ((page = rt_usp_time_page)) {
+		rt_usp_time_page = NULL;
+		munmap((void *)page, (sizeof(struct rt_time_page) + getpagesize() - 1) & ~(getpagesize() - 1));
+	}
+}
+
+/*
+ * As rtai_llimd, i.e. rounded to the nearest on i386, halves going down, and
+ * truncated on x86_64. The remainder times mult fits 63 bits, one of them
+ * being 10^9 and the other the clock frequency.
+ */
+static inline RTIME rt_time_page_llimd(RTIME ll, RTIME mult, RTIME div)
+{
+	RTIME q, r;
+	q = ll/div;
+	r = (ll - q*div)*mult;
+#ifdef __i386__
+	return q*mult + r/div + (2*(r%div) > div);
+#else
+	return q*mult + r/div;
+#endif
+}
+
+/*
+ * The following helpers return 1 and the asked value in *t when the time page
+ * is usable, 0 otherwise.
+ */
+
+#define RT_TIME_PAGE_READ(page, seq, read) \
+	do { \
+		while (((seq) = (page)->seq) & 1); \
+		rt_time_page_rmb(); \
+		read; \
+		rt_time_page_rmb(); \
+	} while ((seq) != (page)->seq)
+
+static inline int rt_time_page_get_time(RTIME *t)
+{
+#ifdef RT_TIME_PAGE_USABLE
+	volatile struct rt_time_page *page;
+	if ((page = rt_usp_time_page)) {
+		unsigned int seq;
+		RT_TIME_PAGE_READ(page, seq, *t = rt_time_page_rdtsc(page));
+		return 1;
+	}
+#endif
+	return 0;
+}
+
+static inline int rt_time_page_get_time_ns(RTIME *t)
+{
+#ifdef RT_TIME_PAGE_USABLE
+	volatile struct rt_time_page *page;
+	if ((page = rt_usp_time_page)) {
+		unsigned int seq;
+		RT_TIME_PAGE_READ(page, seq, *t = rt_time_page_llimd(rt_time_page_rdtsc(page), 1000000000, page->clock_freq));
+		return 1;
+	}
+#endif
+	return 0;
+}
+
+static inline int rt_time_page_get_real_time(RTIME *t)
+{
+#ifdef RT_TIME_PAGE_USABLE
+	volatile struct rt_time_page *page;
+	if ((page = rt_usp_time_page)) {
+		unsigned int seq;
+		RT_TIME_PAGE_READ(page, seq, *t = page->epoch_count + rt_time_page_rdtsc(page));
+		return 1;
+	}
+#endif
+	return 0;
+}
+
+static inline int rt_time_page_get_real_time_ns(RTIME *t)
+{
+#ifdef RT_TIME_PAGE_USABLE
+	volatile struct rt_time_page *page;
+	if ((page = rt_usp_time_page)) {
+		unsigned int seq;
+		RT_TIME_PAGE_READ(page, seq, *t = page->epoch_ns + rt_time_page_llimd(rt_time_page_rdtsc(page), 1000000000, page->clock_freq));
+		return 1;
+	}
+#endif
+	return 0;
+}
+
+static inline int rt_time_page_count2nano(RTIME *t)
+{
+#ifdef RT_TIME_PAGE_USABLE
+	volatile struct rt_time_page *page;
+	if ((page = rt_usp_time_page)) {
+		unsigned int seq;
+		RTIME count = *t;
+		RT_TIME_PAGE_READ(page, seq, *t = count >= 0 ? rt_time_page_llimd(count, 1000000000, page->clock_freq) : -rt_time_page_llimd(-count, 1000000000, page->clock_freq));
+		return 1;
+	}
+#endif
+	return 0;
+}
+
+static inline int rt_time_page_nano2count(RTIME *t)
+{
+#ifdef RT_TIME_PAGE_USABLE
+	volatile struct rt_time_page *page;
+	if ((page = rt_usp_time_page)) {
+		unsigned int seq;
+		RTIME nanos = *t;
+		RT_TIME_PAGE_READ(page, seq, *t = nanos >= 0 ? rt_time_page_llimd(nanos, page->clock_freq, 1000000000) : -rt_time_page_llimd(-nanos, page->clock_freq, 1000000000));
+		return 1;
+	}
+#endif
+	return 0;
+}
+
+#endif /* __KERNEL__ */
+
+#endif /* !_RTAI_TIMEPAGE_H */
@@ -0,0 +1,261 @@
+/*
+ * Copyright (C) 2026 The RTAI project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * HIERARCHICAL TIMING WHEEL, shared by the schedulers timed tasks lists and
+ * by the tasklets timers lists, when CONFIG_RTAI_TIMED_LIST_WHEEL is set.
+ *
+ * Timed objects expiring within the current or the next wheel slot are kept
+ * by their owners on their usual ordered lists, which remain short. All the
+ * others are parked unordered on the slot of the wheel level matching their
+ * distance in time, so that arming and cancelling them is O(1). Expired
+ * slots are moved in a single batch to a list given by the owner, which
+ * will then merge them into its ordered list. Higher levels are cascaded
+ * on the lower ones as time goes by.
+ * A slot lasts (1 << RT_TWHEEL_SHIFT) timer counts, which must be larger
+ * than any scheduling latency, as objects reach their owner list just one
+ * slot ahead of their expiration. Times beyond the wheel span are parked on
+ * the farthest slot and rearmed when it is cascaded.
+ */
+
+#ifndef _RTAI_TWHEEL_H
+#define _RTAI_TWHEEL_H
+
+#include <rtai.h>
+
+#define RT_TWHEEL_SHIFT   16
+#define RT_TWHEEL_BITS    5
+#define RT_TWHEEL_SLOTS   (1 << RT_TWHEEL_BITS)
+#define RT_TWHEEL_MASK    (RT_TWHEEL_SLOTS - 1)
+#define RT_TWHEEL_LEVELS  5
+
+/* A zeroed node is a valid not armed one, slot is 1 + the wheel slot index. */
+struct rt_twheel_node {
+	struct rt_twheel_node *next, *prev;
+	RTIME expires;
+	int slot;
+};
+
+struct rt_twheel {
+	RTIME base, next;
+	int count;
+	unsigned long map[RT_TWHEEL_LEVELS];
+	struct rt_twheel_node slot[RT_TWHEEL_LEVELS][RT_TWHEEL_SLOTS];
+};
+
+#ifdef __KERNEL__
+
+#define RT_TWHEEL_LIMIT  RTAI_TIME_LIMIT
+
+static inline void rt_twheel_node_init(struct rt_twheel_node *node)
+{
+	node->next = node->prev = node;
+	node->slot = 0;
+}
+
+static inline void rt_twheel_init(struct rt_twheel *wheel, RTIME now)
+{
+	int lvl, idx;
+	wheel->base  = (now >> RT_TWHEEL_SHIFT) + 1;
+	wheel->next  = RT_TWHEEL_LIMIT;
+	wheel->count = 0;
+	for (lvl = 0; lvl < RT_TWHEEL_LEVELS; lvl++) {
+		wheel->map[lvl] = 0;
+		for (idx = 0; idx < RT_TWHEEL_SLOTS; idx++) {
+			rt_twheel_node_init(&wheel->slot[lvl][idx]);
+		}
+	}
+}
+
+/* Expiring within the next slot, i.e. to be kept on the owner list. */
+static inline int rt_twheel_near(struct rt_twheel *wheel, RTIME expires)
+{
+	return (expires >> RT_TWHEEL_SHIFT) <= wheel->base;
+}
+
+static inline int rt_twheel_armed(struct rt_twheel_node *node)
+{
+	return node->slot > 0;
+}
+
+/*
+ * Time at which rt_twheel_expire must be called next, to have any parked
+ * object on its owner list one slot before it expires.
+ */
+static inline RTIME rt_twheel_next(struct rt_twheel *wheel)
+{
+	return wheel->next;
+}
+
+static inline void __rt_twheel_link(struct rt_twheel *wheel, struct rt_twheel_node *node, int lvl, int idx)
+{
+	struct rt_twheel_node *head;
+	head = &wheel->slot[lvl][idx];
+	node->next = head;
+	(node->prev = head->prev)->next = node;
+	head->prev = node;
+	node->slot = lvl*RT_TWHEEL_SLOTS + idx + 1;
+	wheel->map[lvl] |= (1UL << idx);
+}
+
+static inline RTIME __rt_twheel_park(struct rt_twheel *wheel, struct rt_twheel_node *node)
+{
+	RTIME unit, delta;
+	int lvl;
+	unit  = node->expires >> RT_TWHEEL_SHIFT;
+	delta = unit - wheel->base;
+	for (lvl = 0; lvl < RT_TWHEEL_LEVELS - 1 && delta >= (1LL << ((lvl + 1)*RT_TWHEEL_BITS)); lvl++);
+	if (delta >= (1LL << (RT_TWHEEL_LEVELS*RT_TWHEEL_BITS))) {
+		unit = wheel->base + (1LL << (RT_TWHEEL_LEVELS*RT_TWHEEL_BITS)) - 1;
+	}
+	__rt_twheel_link(wheel, node, lvl, (unit >> (lvl*RT_TWHEEL_BITS)) & RT_TWHEEL_MASK);
+	return lvl ? (unit >> (lvl*RT_TWHEEL_BITS)) << (lvl*RT_TWHEEL_BITS) : unit;
+}
+
+/* Park a not near object, see rt_twheel_near. O(1). */
+static inline void rt_twheel_add(struct rt_twheel *wheel, struct rt_twheel_node *node, RTIME expires)
+{
+	RTIME event;
+	node->expires = expires;
+	event = __rt_twheel_park(wheel, node);
+	wheel->count++;
+	if (((event - 1) << RT_TWHEEL_SHIFT) < wheel->next) {
+		wheel->next = (event - 1) << RT_TWHEEL_SHIFT;
+	}
+}
+
+/* Cancel a parked object. O(1). */
+static inline void rt_twheel_del(struct rt_twheel *wheel, struct rt_twheel_node *node)
+{
+	struct rt_twheel_node *head;
+	(node->prev)->next = node->next;
+	(node->next)->prev = node->prev;
+	head = &wheel->slot[0][0] + (node->slot - 1);
+	if (head->next == head) {
+		wheel->map[(node->slot - 1)/RT_TWHEEL_SLOTS] &= ~(1UL << ((node->slot - 1) & RT_TWHEEL_MASK));
+	}
+	rt_twheel_node_init(node);
+	wheel->count--;
+}
+
+/* Move a whole slot at the end of list, in one go. */
+static inline void __rt_twheel_splice(struct rt_twheel *wheel, int lvl, int idx, struct rt_twheel_node *list)
+{
+	struct rt_twheel_node *head, *node;
+	head = &wheel->slot[lvl][idx];
+	if (head->next != head) {
+		for (node = head->next; node != head; node = node->next) {
+			node->slot = 0;
+			wheel->count--;
+		}
+		(head->next)->prev = list->prev;
+		(list->prev)->next = head->next;
+		(head->prev)->next = list;
+		list->prev = head->prev;
+		head->next = head->prev = head;
+		wheel->map[lvl] &= ~(1UL << idx);
+	}
+}
+
+static inline void __rt_twheel_cascade(struct rt_twheel *wheel, struct rt_twheel_node *list)
+{
+	struct rt_twheel_node *head, *node, *next;
+	int lvl, idx;
+	for (lvl = 1; lvl < RT_TWHEEL_LEVELS; lvl++) {
+		idx = (wheel->base >> (lvl*RT_TWHEEL_BITS)) & RT_TWHEEL_MASK;
+		head = &wheel->slot[lvl][idx];
+		if ((node = head->next) != head) {
+			head->next = head->prev = head;
+			wheel->map[lvl] &= ~(1UL << idx);
+			do {
+				next = node->next;
+				if ((node->expires >> RT_TWHEEL_SHIFT) <= wheel->base) {
+					node->slot = 0;
+					node->next = list;
+					(node->prev = list->prev)->next = node;
+					list->prev = node;
+					wheel->count--;
+				} else {
+					__rt_twheel_park(wheel, node);
+				}
+			} while ((node = next) != head);
+		}
+		if (idx) {
+			break;
+		}
+	}
+}
+
+/* The first slot unit, after the base, at which something must be done. */
+static inline RTIME __rt_twheel_next_event(struct rt_twheel *wheel)
+{
+	RTIME event;
+	unsigned long map;
+	int lvl, ofst;
+	event = RT_TWHEEL_LIMIT;
+	if ((map = wheel->map[0])) {
+		if ((ofst = (wheel->base + 1) & RT_TWHEEL_MASK)) {
+			map = ((map >> ofst) | (map << (RT_TWHEEL_SLOTS - ofst))) & (~0UL >> (BITS_PER_LONG - RT_TWHEEL_SLOTS));
+		}
+		event = wheel->base + 1 + __ffs(map);
+	}
+	for (lvl = 1; lvl < RT_TWHEEL_LEVELS; lvl++) {
+		if (wheel->map[lvl]) {
+			if (((wheel->base | RT_TWHEEL_MASK) + 1) < event) {
+				event = (wheel->base | RT_TWHEEL_MASK) + 1;
+			}
+			break;
+		}
+	}
+	return event;
+}
+
+/*
+ * Advance the wheel up to now, moving all the objects that are about to
+ * expire at the end of list, as a batch. Empty slots are skipped, so the
+ * cost depends on the number of slots holding something, not on the time
+ * elapsed since the previous call, and calling it within the current slot
+ * costs nothing. Returns the number of moved objects.
+ */
+static inline int rt_twheel_expire(struct rt_twheel *wheel, RTIME now, struct rt_twheel_node *list)
+{
+	RTIME target, event;
+	int count;
+	if ((target = (now >> RT_TWHEEL_SHIFT) + 1) <= wheel->base) {
+		return 0;
+	}
+	count = wheel->count;
+	while (wheel->base < target) {
+		if ((event = __rt_twheel_next_event(wheel)) > target) {
+			wheel->base = target;
+			break;
+		}
+		wheel->base = event;
+		if (!(event & RT_TWHEEL_MASK)) {
+			__rt_twheel_cascade(wheel, list);
+		}
+		__rt_twheel_splice(wheel, 0, event & RT_TWHEEL_MASK, list);
+	}
+	event = __rt_twheel_next_event(wheel);
+	wheel->next = event < RT_TWHEEL_LIMIT ? (event - 1) << RT_TWHEEL_SHIFT : RT_TWHEEL_LIMIT;
+	return count - wheel->count;
+}
+
+#endif /* __KERNEL__ */
+
+#endif /* !_RTAI_TWHEEL_H */
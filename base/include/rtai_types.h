@@ -45,6 +45,16 @@ typedef long long RTIME;
 
 typedef int (*RT_TRAP_HANDLER)(int, int, struct pt_regs *,void *);
 
+/*
+ * A message of the vectored send/receive calls, the receive ones rewrite the
+ * actual size and priority of each received message, if meaningful.
+ */
+struct rt_msg_iov {
+	void *msg;
+	int size;
+	unsigned int prio;
+};
+
 struct rt_times {
 	int linux_tick;
 	int periodic_tick;
@@ -68,12 +68,15 @@ static void mbx_signal(MBX *mbx)
 	_mbx_signal(mbx, NULL);
 }
 
-static int mbx_wait(MBX *mbx, int *fravbs, RT_TASK *rt_current)
+#define mbx_wait(mbx, fravbs, rt_current) \
+	mbx_wait_bytes(mbx, fravbs, 1, rt_current)
+
+static int mbx_wait_bytes(MBX *mbx, int *fravbs, int bytes, RT_TASK *rt_current)
 {
 	unsigned long flags;
 
 	flags = rt_global_save_flags_and_cli();
-	if (!(*fravbs)) {
+	if (*fravbs < bytes) {
 		unsigned long retval;
 		rt_current->state |= RT_SCHED_MBXSUSP;
 		rem_ready_current(rt_current);
@@ -309,6 +312,8 @@ RTAI_SYSCALL_MODE int rt_typed_mbx_init(MBX *mbx, int size, int type)
 	mbx->magic = RT_MBX_MAGIC;
 	mbx->size = mbx->frbs = size;
 	mbx->owndby = mbx->waiting_task = NULL;
+	mbx->rsvtask = mbx->pektask = NULL;
+	mbx->rsvsize = mbx->peksize = 0;
 	mbx->fbyte = mbx->lbyte = mbx->avbs = 0;
         spin_lock_init(&(mbx->lock));
 #ifdef CONFIG_RTAI_RT_POLL
@@ -845,9 +850,659 @@ RTAI_SYSCALL_MODE int _rt_mbx_ovrwr_send(MBX *mbx, void *msg, int msg_size, int
 	return msg_size;
 }
 
+/* +++++++++++++++++++++++++ VECTORED MAIL BOXES ++++++++++++++++++++++++++ */
+
+#define MBX_VEC_WAIT   0
+#define MBX_VEC_IF     1
+#define MBX_VEC_UNTIL  2
+
+#define MBX_VEC_RET(count, retval) \
+	(CONFIG_RTAI_USE_NEWERR && !(count) ? retval : count)
+
+static inline void mbx_get_iov(struct rt_msg_iov *v, struct rt_msg_iov *iov, int space)
+{
+	if (space) {
+		*v = *iov;
+	} else {
+		rt_copy_from_user(v, iov, sizeof(struct rt_msg_iov));
+	}
+}
+
+static inline void mbx_put_iov(struct rt_msg_iov *v, struct rt_msg_iov *iov, int space)
+{
+	if (space) {
+		*iov = *v;
+	} else {
+		rt_copy_to_user(iov, v, sizeof(struct rt_msg_iov));
+	}
+}
+
+/*
+ * Copy as many whole messages as the free bytes allow, then make them all
+ * available with a single update of the counters. Returns how many messages
+ * have been put.
+ */
+static int mbxput_vec(MBX *mbx, struct rt_msg_iov *iov, int nmsg, int space)
+{
+	unsigned long flags;
+	struct rt_msg_iov v;
+	int i, lbyte, frbs, moved, tocpy;
+
+	lbyte = mbx->lbyte;
+	frbs  = mbx->frbs;
+	for (moved = i = 0; i < nmsg; i++) {
+		mbx_get_iov(&v, iov + i, space);
+		// invalid sizes are left to mbx_vec, to be reported
+		if (v.size < 0 || v.size > frbs - moved) {
+			break;
+		}
+		moved += v.size;
+		while (v.size > 0) {
+			if ((tocpy = mbx->size - lbyte) > v.size) {
+				tocpy = v.size;
+			}
+			if (space) {
+				memcpy(mbx->bufadr + lbyte, v.msg, tocpy);
+			} else {
+				rt_copy_from_user(mbx->bufadr + lbyte, v.msg, tocpy);
+			}
+			v.size -= tocpy;
+			v.msg  += tocpy;
+			lbyte = MOD_SIZE(lbyte + tocpy);
+		}
+	}
+	if (moved) {
+		flags = rt_spin_lock_irqsave(&(mbx->lock));
+		mbx->frbs -= moved;
+		mbx->avbs += moved;
+		rt_spin_unlock_irqrestore(flags, &(mbx->lock));
+		mbx->lbyte = lbyte;
+	}
+	return i;
+}
+
+static int mbxget_vec(MBX *mbx, struct rt_msg_iov *iov, int nmsg, int space)
+{
+	unsigned long flags;
+	struct rt_msg_iov v;
+	int i, fbyte, avbs, moved, tocpy;
+
+	fbyte = mbx->fbyte;
+	avbs  = mbx->avbs;
+	for (moved = i = 0; i < nmsg; i++) {
+		mbx_get_iov(&v, iov + i, space);
+		if (v.size < 0 || v.size > avbs - moved) {
+			break;
+		}
+		moved += v.size;
+		while (v.size > 0) {
+			if ((tocpy = mbx->size - fbyte) > v.size) {
+				tocpy = v.size;
+			}
+			if (space) {
+				memcpy(v.msg, mbx->bufadr + fbyte, tocpy);
+			} else {
+				rt_copy_to_user(v.msg, mbx->bufadr + fbyte, tocpy);
+			}
+			v.size -= tocpy;
+			v.msg  += tocpy;
+			fbyte = MOD_SIZE(fbyte + tocpy);
+		}
+	}
+	if (moved) {
+		flags = rt_spin_lock_irqsave(&(mbx->lock));
+		mbx->frbs += moved;
+		mbx->avbs -= moved;
+		rt_spin_unlock_irqrestore(flags, &(mbx->lock));
+		mbx->fbyte = fbyte;
+	}
+	return i;
+}
+
+static inline int mbx_vec_sem_wait(SEM *sem, int mode, RTIME time)
+{
+	switch (mode) {
+		case MBX_VEC_WAIT:
+			return rt_sem_wait(sem);
+		case MBX_VEC_IF:
+			return rt_sem_wait_if(sem) > 0 ? 0 : RTE_TIMOUT;
+	}
+	return rt_sem_wait_until(sem, time);
+}
+
+/*
+ * Common body of all the vectored sends and receives. The send/receive
+ * semaphore is taken once for the whole vector, and whatever fits in the
+ * buffer is moved at once, with a single signal to the other side. A message
+ * larger than what is free/available is moved piecewise, as rt_mbx_send/
+ * rt_mbx_receive do, unless the call must not block. If the wait for the
+ * rest of such a message fails, its iov element is updated to the part not
+ * moved, so that the caller knows what is left, and can resume from there.
+ * Messages can be up to the mailbox size, any other size is an error.
+ */
+static int mbx_vec(MBX *mbx, struct rt_msg_iov *iov, int nmsg, int mode, RTIME time, int send, int space)
+{
+	RT_TASK *rt_current = RT_CURRENT;
+	struct rt_msg_iov v;
+	SEM *sem;
+	int *fravbs, count, moved, retval, size;
+
+	CHK_MBX_MAGIC;
+	if (nmsg <= 0) {
+		return 0;
+	}
+	sem    = send ? &mbx->sndsem : &mbx->rcvsem;
+	fravbs = send ? &mbx->frbs   : &mbx->avbs;
+	if ((retval = mbx_vec_sem_wait(sem, mode, time)) > 1) {
+		return mode == MBX_VEC_IF ? 0 : MBX_VEC_RET(0, retval);
+	}
+	for (retval = count = 0; count < nmsg; count += moved) {
+		if ((moved = send ? mbxput_vec(mbx, iov + count, nmsg - count, space) : mbxget_vec(mbx, iov + count, nmsg - count, space))) {
+			mbx_signal(mbx);
+			continue;
+		}
+		mbx_get_iov(&v, iov + count, space);
+		if (v.size < 0 || v.size > mbx->size) {
+			retval = -EINVAL;
+			break;
+		}
+		if (mode == MBX_VEC_IF) {
+			break;
+		}
+		for (size = v.size; v.size; ) {
+			if ((retval = mode == MBX_VEC_WAIT ? mbx_wait(mbx, fravbs, rt_current) : mbx_wait_until(mbx, fravbs, time, rt_current))) {
+				if (v.size != size) {
+					mbx_put_iov(&v, iov + count, space);
+				}
+				goto out;
+			}
+			v.size = send ? mbxput(mbx, (char **)(&v.msg), v.size, space) : mbxget(mbx, (char **)(&v.msg), v.size, space);
+			mbx_signal(mbx);
+		}
+		moved = 1;
+	}
+out:
+	rt_sem_signal(sem);
+	if (count) {
+		rt_wakeup_pollers(send ? &mbx->poll_recv : &mbx->poll_send, 0);
+	}
+	return retval == -EINVAL && !count ? retval : MBX_VEC_RET(count, retval);
+}
+
+/**
+ * @brief Sends a vector of messages.
+ *
+ * rt_mbx_send_vec sends the @e nmsg messages described by @e iov to the
+ * mailbox @e mbx, as rt_mbx_send would do for each of them, but taking the
+ * mailbox just once. All the messages that fit in the mailbox buffer are
+ * copied and made available at once, with a single wake up of any waiting
+ * receiver. The caller will be blocked until all of the messages are sent
+ * or an error occurs.
+ *
+ * @param mbx is a pointer to a user allocated mailbox structure.
+ *
+ * @param iov is an array of @e nmsg messages, each one given by its address
+ * and size.
+ *
+ * @param nmsg is the number of messages to send.
+ *
+ * @return The number of whole messages sent. When nothing has been sent
+ * the new error scheme returns the error code, as rt_mbx_send does. A
+ * message of negative size, or larger than the mailbox, ends the vector,
+ * -EINVAL being returned if it is the first one. If a message has been sent
+ * in part only, its element of @e iov is updated to the part not sent.
+ */
+RTAI_SYSCALL_MODE int _rt_mbx_send_vec(MBX *mbx, struct rt_msg_iov *iov, int nmsg, int space)
+{
+	return mbx_vec(mbx, iov, nmsg, MBX_VEC_WAIT, 0, 1, space);
+}
+
+/**
+ * @brief Sends a vector of messages, only the ones that can be passed
+ * without blocking the calling task.
+ *
+ * rt_mbx_send_vec_if sends the leading messages of @e iov that fit in the
+ * mailbox buffer, as a whole. It returns immediately and the caller is
+ * never blocked.
+ *
+ * @return The number of messages sent, possibly 0.
+ */
+RTAI_SYSCALL_MODE int _rt_mbx_send_vec_if(MBX *mbx, struct rt_msg_iov *iov, int nmsg, int space)
+{
+	return mbx_vec(mbx, iov, nmsg, MBX_VEC_IF, 0, 1, space);
+}
+
+/**
+ * @brief Sends a vector of messages with absolute timeout.
+ *
+ * As rt_mbx_send_vec, but the caller is blocked at most till @e time.
+ *
+ * @return The number of whole messages sent before the timeout expired or
+ * an error occured.
+ */
+RTAI_SYSCALL_MODE int _rt_mbx_send_vec_until(MBX *mbx, struct rt_msg_iov *iov, int nmsg, RTIME time, int space)
+{
+	return mbx_vec(mbx, iov, nmsg, MBX_VEC_UNTIL, time, 1, space);
+}
+
+/**
+ * @brief Sends a vector of messages with relative timeout.
+ *
+ * As rt_mbx_send_vec_until, with a timeout relative to the current time.
+ */
+RTAI_SYSCALL_MODE int _rt_mbx_send_vec_timed(MBX *mbx, struct rt_msg_iov *iov, int nmsg, RTIME delay, int space)
+{
+	return mbx_vec(mbx, iov, nmsg, MBX_VEC_UNTIL, get_time() + delay, 1, space);
+}
+
+/**
+ * @brief Receives a vector of messages.
+ *
+ * rt_mbx_receive_vec receives @e nmsg messages, of the sizes given in
+ * @e iov, from the mailbox @e mbx, as rt_mbx_receive would do for each of
+ * them, but taking the mailbox just once. All the messages already available
+ * are copied and freed at once, with a single wake up of any waiting sender.
+ * The caller will be blocked until all of the messages are received or an
+ * error occurs.
+ *
+ * @param mbx is a pointer to a user allocated mailbox structure.
+ *
+ * @param iov is an array of @e nmsg buffers, each one given by its address
+ * and the size of the message to be received on it.
+ *
+ * @param nmsg is the number of messages to receive.
+ *
+ * @return The number of whole messages received. When nothing has been
+ * received the new error scheme returns the error code, as rt_mbx_receive
+ * does. Sizes are checked, and partially received messages reported in
+ * @e iov, as for rt_mbx_send_vec.
+ */
+RTAI_SYSCALL_MODE int _rt_mbx_receive_vec(MBX *mbx, struct rt_msg_iov *iov, int nmsg, int space)
+{
+	return mbx_vec(mbx, iov, nmsg, MBX_VEC_WAIT, 0, 0, space);
+}
+
+/**
+ * @brief Receives a vector of messages, only the ones that can be passed
+ * without blocking the calling task.
+ *
+ * rt_mbx_receive_vec_if receives the leading messages of @e iov that are
+ * wholly available. It returns immediately and the caller is never blocked.
+ *
+ * @return The number of messages received, possibly 0.
+ */
+RTAI_SYSCALL_MODE int _rt_mbx_receive_vec_if(MBX *mbx, struct rt_msg_iov *iov, int nmsg, int space)
+{
+	return mbx_vec(mbx, iov, nmsg, MBX_VEC_IF, 0, 0, space);
+}
+
+/**
+ * @brief Receives a vector of messages with absolute timeout.
+ *
+ * As rt_mbx_receive_vec, but the caller is blocked at most till @e time.
+ *
+ * @return The number of whole messages received before the timeout expired
+ * or an error occured.
+ */
+RTAI_SYSCALL_MODE int _rt_mbx_receive_vec_until(MBX *mbx, struct rt_msg_iov *iov, int nmsg, RTIME time, int space)
+{
+	return mbx_vec(mbx, iov, nmsg, MBX_VEC_UNTIL, time, 0, space);
+}
+
+/**
+ * @brief Receives a vector of messages with relative timeout.
+ *
+ * As rt_mbx_receive_vec_until, with a timeout relative to the current time.
+ */
+RTAI_SYSCALL_MODE int _rt_mbx_receive_vec_timed(MBX *mbx, struct rt_msg_iov *iov, int nmsg, RTIME delay, int space)
+{
+	return mbx_vec(mbx, iov, nmsg, MBX_VEC_UNTIL, get_time() + delay, 0, space);
+}
+
+/* ++++++++++++++++++++++++ ZERO COPY MAIL BOXES +++++++++++++++++++++++++++ */
+
+extern void *rtai_global_heap_adr;
+extern int   rtai_global_heap_size;
+
+#define GLOBAL  0  // the global heap slot of RT_TASK heap[], as in shm.c
+
+/* The calling task, also when a soft one in user space. */
+static inline RT_TASK *mbx_caller(void)
+{
+	RT_TASK *task;
+
+	return (task = _rt_whoami())->is_hard ? task : rtai_tskext_t(current, TSKEXT0);
+}
+
+/*
+ * The mailbox buffer, as seen by the caller. Mailboxes buffers are allocated
+ * on the global heap, which user space can map by rt_global_heap_open, if RTAI
+ * malloc uses vmalloc. So the kernel address is translated into the mapping
+ * of the calling process, NULL if it has none.
+ */
+static char *mbx_bufadr(MBX *mbx, int space)
+{
+	RT_TASK *task;
+
+	if (space) {
+		return mbx->bufadr;
+	}
+	if (!(task = mbx_caller())) {
+		return NULL;
+	}
+	if (!task->heap[GLOBAL].uadr || mbx->bufadr < (char *)rtai_global_heap_adr || mbx->bufadr + mbx->size > (char *)rtai_global_heap_adr + rtai_global_heap_size) {
+		return NULL;
+	}
+	return task->heap[GLOBAL].uadr + (mbx->bufadr - (char *)task->heap[GLOBAL].kadr);
+}
+
+static void mbx_spans(MBX *mbx, char *bufadr, int byte, int msg_size, struct rt_mbx_span *span, int space)
+{
+	struct rt_mbx_span spans[2];
+
+	spans[0].adr = bufadr + byte;
+	if ((spans[0].size = mbx->size - byte) >= msg_size) {
+		spans[0].size = msg_size;
+		spans[1].adr  = NULL;
+		spans[1].size = 0;
+	} else {
+		spans[1].adr  = bufadr;
+		spans[1].size = msg_size - spans[0].size;
+	}
+	if (space) {
+		memcpy(span, spans, sizeof(spans));
+	} else {
+		rt_copy_to_user(span, spans, sizeof(spans));
+	}
+}
+
+/**
+ * @brief Reserves room in place for a message.
+ *
+ * rt_mbx_reserve reserves @e msg_size bytes of the buffer of the mailbox
+ * @e mbx, for the caller to write a message directly on it. The caller will
+ * be blocked until there is room for the whole message or an error occurs.
+ * The room is returned as two spans, the second one being used only when the
+ * room wraps around the end of the buffer. No other task can send to the
+ * mailbox till the reservation is committed, by rt_mbx_commit, which must
+ * always follow.
+ * From user space the spans are within the global heap mapping, so the
+ * calling process must have opened it, by rt_global_heap_open.
+ *
+ * @param mbx is a pointer to a user allocated mailbox structure.
+ *
+ * @param msg_size is the size of the message, it cannot exceed half the
+ * mailbox size.
+ *
+ * @param span is an array of two spans, filled with the address and size of
+ * the reserved room.
+ *
+ * @return On success, 0 is returned.
+ * On failure a value is returned as described below:
+ * - the number of bytes not reserved: an error is occured
+ *   in the queueing of all sending tasks.
+ * - @b EINVAL: mbx points to an invalid mailbox or the message is too large.
+ * - @b EFAULT: the mailbox buffer is not mapped in the calling process.
+ */
+RTAI_SYSCALL_MODE int _rt_mbx_reserve(MBX *mbx, int msg_size, struct rt_mbx_span *span, int space)
+{
+	RT_TASK *rt_current = RT_CURRENT;
+	char *bufadr;
+	int retval;
+
+	CHK_MBX_MAGIC;
+	if (msg_size <= 0 || msg_size > mbx->size/2) {
+		return -EINVAL;
+	}
+	if (!(bufadr = mbx_bufadr(mbx, space))) {
+		return -EFAULT;
+	}
+	if ((retval = rt_sem_wait(&mbx->sndsem)) > 1) {
+		return MBX_RET(msg_size, retval);
+	}
+	while (mbx->frbs < msg_size) {
+		if ((retval = mbx_wait_bytes(mbx, &mbx->frbs, msg_size, rt_current))) {
+			rt_sem_signal(&mbx->sndsem);
+			return MBX_RET(msg_size, retval);
+		}
+	}
+	mbx->rsvtask = mbx_caller();
+	mbx->rsvsize = msg_size;
+	mbx_spans(mbx, bufadr, mbx->lbyte, msg_size, span, space);
+	return 0;
+}
+
+/**
+ * @brief Reserves room in place for a message, only if it can be done
+ * without blocking the calling task.
+ *
+ * rt_mbx_reserve_if is like rt_mbx_reserve but returns immediately, without
+ * reserving anything, if there is no room for the whole message.
+ *
+ * @return On success, 0 is returned. If there is no room @e msg_size is
+ * returned, a negative value on failure, as for rt_mbx_reserve.
+ */
+RTAI_SYSCALL_MODE int _rt_mbx_reserve_if(MBX *mbx, int msg_size, struct rt_mbx_span *span, int space)
+{
+	unsigned long flags;
+	RT_TASK *rt_current = RT_CURRENT;
+	char *bufadr;
+
+	CHK_MBX_MAGIC;
+	if (msg_size <= 0 || msg_size > mbx->size/2) {
+		return -EINVAL;
+	}
+	if (!(bufadr = mbx_bufadr(mbx, space))) {
+		return -EFAULT;
+	}
+	flags = rt_global_save_flags_and_cli();
+	if (mbx->sndsem.count > 0 && msg_size <= mbx->frbs) {
+		mbx->sndsem.count = 0;
+		if (mbx->sndsem.type > 0) {
+			mbx->sndsem.owndby = rt_current;
+			enqueue_resqel(&mbx->sndsem.resq, rt_current);
+		}
+		mbx->rsvtask = mbx_caller();
+		mbx->rsvsize = msg_size;
+		rt_global_restore_flags(flags);
+		mbx_spans(mbx, bufadr, mbx->lbyte, msg_size, span, space);
+		return 0;
+	}
+	rt_global_restore_flags(flags);
+	return msg_size;
+}
+
+/**
+ * @brief Commits a message written in place.
+ *
+ * rt_mbx_commit makes the first @e msg_size bytes reserved by a previous
+ * rt_mbx_reserve(_if) available to receivers, and ends the reservation.
+ * Committing 0 bytes just cancels it.
+ *
+ * @param mbx is a pointer to a user allocated mailbox structure.
+ *
+ * @param msg_size is the size of the message written.
+ *
+ * @return On success, 0 is returned. On failure a negative value is
+ * returned as described below:
+ * - @b EINVAL: mbx points to an invalid mailbox or @e msg_size exceeds the
+ *   reserved room, in which case nothing is committed, but the reservation
+ *   is ended anyhow.
+ * - @b EPERM: the caller is not the task holding the reservation, which is
+ *   left untouched.
+ */
+RTAI_SYSCALL_MODE int rt_mbx_commit(MBX *mbx, int msg_size)
+{
+	unsigned long flags;
+	int retval = 0;
+
+	CHK_MBX_MAGIC;
+	if (!mbx->rsvtask || mbx->rsvtask != mbx_caller()) {
+		return -EPERM;
+	}
+	if (msg_size > 0 && msg_size <= mbx->rsvsize) {
+		flags = rt_spin_lock_irqsave(&(mbx->lock));
+		mbx->frbs -= msg_size;
+		mbx->avbs += msg_size;
+		rt_spin_unlock_irqrestore(flags, &(mbx->lock));
+		mbx->lbyte = MOD_SIZE(mbx->lbyte + msg_size);
+		mbx_signal(mbx);
+	} else if (msg_size) {
+		retval = -EINVAL;
+	}
+	mbx->rsvtask = NULL;
+	mbx->rsvsize = 0;
+	rt_sem_signal(&mbx->sndsem);
+	if (msg_size > 0 && !retval) {
+		rt_wakeup_pollers(&mbx->poll_recv, 0);
+	}
+	return retval;
+}
+
+/**
+ * @brief Peeks a message in place.
+ *
+ * rt_mbx_peek gives access in place to the first @e msg_size bytes available
+ * in the mailbox @e mbx. The caller will be blocked until they are all there
+ * or an error occurs. They are returned as two spans, as for rt_mbx_reserve,
+ * and stay in the mailbox till rt_mbx_consume, which must always follow, as
+ * no other task can receive from the mailbox till then.
+ * From user space the calling process must have opened the global heap, by
+ * rt_global_heap_open.
+ *
+ * @param mbx is a pointer to a user allocated mailbox structure.
+ *
+ * @param msg_size is the size of the message, it cannot exceed half the
+ * mailbox size.
+ *
+ * @param span is an array of two spans, filled with the address and size of
+ * the message.
+ *
+ * @return On success, 0 is returned.
+ * On failure a value is returned as described below:
+ * - the number of bytes not available: an error is occured
+ *   in the queueing of all receiving tasks.
+ * - @b EINVAL: mbx points to an invalid mailbox or the message is too large.
+ * - @b EFAULT: the mailbox buffer is not mapped in the calling process.
+ */
+RTAI_SYSCALL_MODE int _rt_mbx_peek(MBX *mbx, int msg_size, struct rt_mbx_span *span, int space)
+{
+	RT_TASK *rt_current = RT_CURRENT;
+	char *bufadr;
+	int retval;
+
+	CHK_MBX_MAGIC;
+	if (msg_size <= 0 || msg_size > mbx->size/2) {
+		return -EINVAL;
+	}
+	if (!(bufadr = mbx_bufadr(mbx, space))) {
+		return -EFAULT;
+	}
+	if ((retval = rt_sem_wait(&mbx->rcvsem)) > 1) {
+		return MBX_RET(msg_size, retval);
+	}
+	while (mbx->avbs < msg_size) {
+		if ((retval = mbx_wait_bytes(mbx, &mbx->avbs, msg_size, rt_current))) {
+			rt_sem_signal(&mbx->rcvsem);
+			return MBX_RET(msg_size, retval);
+		}
+	}
+	mbx->pektask = mbx_caller();
+	mbx->peksize = msg_size;
+	mbx_spans(mbx, bufadr, mbx->fbyte, msg_size, span, space);
+	return 0;
+}
+
+/**
+ * @brief Peeks a message in place, only if the whole message is available.
+ *
+ * rt_mbx_peek_if is like rt_mbx_peek but returns immediately, without
+ * peeking anything, if the whole message is not available.
+ *
+ * @return On success, 0 is returned. If the message is not available
+ * @e msg_size is returned, a negative value on failure, as for rt_mbx_peek.
+ */
+RTAI_SYSCALL_MODE int _rt_mbx_peek_if(MBX *mbx, int msg_size, struct rt_mbx_span *span, int space)
+{
+	unsigned long flags;
+	RT_TASK *rt_current = RT_CURRENT;
+	char *bufadr;
+
+	CHK_MBX_MAGIC;
+	if (msg_size <= 0 || msg_size > mbx->size/2) {
+		return -EINVAL;
+	}
+	if (!(bufadr = mbx_bufadr(mbx, space))) {
+		return -EFAULT;
+	}
+	flags = rt_global_save_flags_and_cli();
+	if (mbx->rcvsem.count > 0 && msg_size <= mbx->avbs) {
+		mbx->rcvsem.count = 0;
+		if (mbx->rcvsem.type > 0) {
+			mbx->rcvsem.owndby = rt_current;
+			enqueue_resqel(&mbx->rcvsem.resq, rt_current);
+		}
+		mbx->pektask = mbx_caller();
+		mbx->peksize = msg_size;
+		rt_global_restore_flags(flags);
+		mbx_spans(mbx, bufadr, mbx->fbyte, msg_size, span, space);
+		return 0;
+	}
+	rt_global_restore_flags(flags);
+	return msg_size;
+}
+
+/**
+ * @brief Consumes a message peeked in place.
+ *
+ * rt_mbx_consume frees the first @e msg_size bytes peeked by a previous
+ * rt_mbx_peek(_if), and ends the peeking. Consuming 0 bytes leaves the whole
+ * message in the mailbox.
+ *
+ * @param mbx is a pointer to a user allocated mailbox structure.
+ *
+ * @param msg_size is the number of bytes consumed.
+ *
+ * @return On success, 0 is returned. On failure a negative value is
+ * returned as described below:
+ * - @b EINVAL: mbx points to an invalid mailbox or @e msg_size exceeds the
+ *   peeked bytes, in which case nothing is consumed, but the peeking is
+ *   ended anyhow.
+ * - @b EPERM: the caller is not the task that peeked, the peeking being
+ *   left untouched.
+ */
+RTAI_SYSCALL_MODE int rt_mbx_consume(MBX *mbx, int msg_size)
+{
+	unsigned long flags;
+	int retval = 0;
+
+	CHK_MBX_MAGIC;
+	if (!mbx->pektask || mbx->pektask != mbx_caller()) {
+		return -EPERM;
+	}
+	if (msg_size > 0 && msg_size <= mbx->peksize) {
+		flags = rt_spin_lock_irqsave(&(mbx->lock));
+		mbx->frbs += msg_size;
+		mbx->avbs -= msg_size;
+		rt_spin_unlock_irqrestore(flags, &(mbx->lock));
+		mbx->fbyte = MOD_SIZE(mbx->fbyte + msg_size);
+		mbx_signal(mbx);
+	} else if (msg_size) {
+		retval = -EINVAL;
+	}
+	mbx->pektask = NULL;
+	mbx->peksize = 0;
+	rt_sem_signal(&mbx->rcvsem);
+	if (msg_size > 0 && !retval) {
+		rt_wakeup_pollers(&mbx->poll_send, 0);
+	}
+	return retval;
+}
+
 /* ++++++++++++++++++++++++++ NAMED MAIL BOXES ++++++++++++++++++++++++++++++ */
 
 #include <rtai_registry.h>
+#include <rtai_pool.h>
 
 
 /**
@@ -879,14 +1534,16 @@ RTAI_SYSCALL_MODE MBX *_rt_typed_named_mbx_init(unsigned long mbx_name, int size
 	if ((mbx = rt_get_adr_cnt(mbx_name))) {
 		return mbx;
 	}
-	if ((mbx = rt_malloc(sizeof(MBX)))) {
+	if ((mbx = rt_named_obj_alloc(IS_MBX, sizeof(MBX)))) {
 		rt_typed_mbx_init(mbx, size, qtype);
 		if (rt_register(mbx_name, mbx, IS_MBX, 0)) {
 			return mbx;
 		}
 		rt_mbx_delete(mbx);
 	}
-	rt_free(mbx);
+	if (mbx) {
+		rt_named_obj_free(IS_MBX, mbx);
+	}
 	return (MBX *)0;
 }
 
@@ -916,7 +1573,7 @@ RTAI_SYSCALL_MODE int rt_named_mbx_delete(MBX *mbx)
 	int ret;
 	if (!(ret = rt_drg_on_adr_cnt(mbx))) {
 		if (!rt_mbx_delete(mbx)) {
-			rt_free(mbx);
+			rt_named_obj_free(IS_MBX, mbx);
 			return 0;
 		} else {
 			return -EFAULT;
@@ -945,6 +1602,20 @@ struct rt_native_fun_entry rt_mbx_entries[] = {
 	{ { 1, _rt_mbx_receive_timed }, 	MBX_RECEIVE_TIMED },
 	{ { 0, _rt_typed_named_mbx_init },  	NAMED_MBX_INIT },
 	{ { 0, rt_named_mbx_delete },		NAMED_MBX_DELETE },
+	{ { 1, _rt_mbx_reserve },		MBX_RESERVE },
+	{ { 1, _rt_mbx_reserve_if },		MBX_RESERVE_IF },
+	{ { 1, rt_mbx_commit },			MBX_COMMIT },
+	{ { 1, _rt_mbx_peek },			MBX_PEEK },
+	{ { 1, _rt_mbx_peek_if },		MBX_PEEK_IF },
+	{ { 1, rt_mbx_consume },		MBX_CONSUME },
+	{ { 1, _rt_mbx_send_vec },		MBX_SEND_VEC },
+	{ { 1, _rt_mbx_send_vec_if },		MBX_SEND_VEC_IF },
+	{ { 1, _rt_mbx_send_vec_until },	MBX_SEND_VEC_UNTIL },
+	{ { 1, _rt_mbx_send_vec_timed },	MBX_SEND_VEC_TIMED },
+	{ { 1, _rt_mbx_receive_vec },		MBX_RECEIVE_VEC },
+	{ { 1, _rt_mbx_receive_vec_if },	MBX_RECEIVE_VEC_IF },
+	{ { 1, _rt_mbx_receive_vec_until },	MBX_RECEIVE_VEC_UNTIL },
+	{ { 1, _rt_mbx_receive_vec_timed },	MBX_RECEIVE_VEC_TIMED },
 	{ { 0, 0 },  		      	       	000 }
 };
 
@@ -993,4 +1664,18 @@ EXPORT_SYMBOL(_rt_mbx_receive_timed);
 EXPORT_SYMBOL(_rt_mbx_ovrwr_send);
 EXPORT_SYMBOL(_rt_typed_named_mbx_init);
 EXPORT_SYMBOL(rt_named_mbx_delete);
+EXPORT_SYMBOL(_rt_mbx_reserve);
+EXPORT_SYMBOL(_rt_mbx_reserve_if);
+EXPORT_SYMBOL(rt_mbx_commit);
+EXPORT_SYMBOL(_rt_mbx_peek);
+EXPORT_SYMBOL(_rt_mbx_peek_if);
+EXPORT_SYMBOL(rt_mbx_consume);
+EXPORT_SYMBOL(_rt_mbx_send_vec);
+EXPORT_SYMBOL(_rt_mbx_send_vec_if);
+EXPORT_SYMBOL(_rt_mbx_send_vec_until);
+EXPORT_SYMBOL(_rt_mbx_send_vec_timed);
+EXPORT_SYMBOL(_rt_mbx_receive_vec);
+EXPORT_SYMBOL(_rt_mbx_receive_vec_if);
+EXPORT_SYMBOL(_rt_mbx_receive_vec_until);
+EXPORT_SYMBOL(_rt_mbx_receive_vec_timed);
 #endif /* CONFIG_KBUILD */
@@ -120,14 +120,58 @@ static mq_mutex_t pqueue_mutex;
 //      LOCAL FUNCTIONS
 ///////////////////////////////////////////////////////////////////////////////
 
+//Queue names are arbitrary strings, so they are registered by a hash beyond
+//any nam2num name, always verifying the name of what is found. Queues that
+//could not be registered, because of a hash collision or a full registry,
+//are looked for by a linear scan, done only if there is any of them.
+
+static int unregistered_pqueues = 0;
+
+static unsigned long name_to_reg_name(const char *name)
+{
+	unsigned long hash = 5381;
+	while (*name) {
+		hash = hash*33 + (unsigned char)*name++;
+	}
+	return MAX_NAM2NUM + 1 + hash%(0xFFFFFFFFUL - MAX_NAM2NUM - 1);
+}
+
+static void register_queue(MSG_QUEUE *q)
+{
+	q->reg_name = name_to_reg_name(q->q_name);
+	if (!rt_register(q->reg_name, q, IS_MQ, 0)) {
+		q->reg_name = 0;
+		unregistered_pqueues++;
+	}
+}
+
+//To be called once, when the queue name is cleared.
+static void unregister_queue(MSG_QUEUE *q)
+{
+	if (q->reg_name) {
+		rt_drg_on_name(q->reg_name);
+		q->reg_name = 0;
+	} else if (unregistered_pqueues > 0) {
+		unregistered_pqueues--;
+	}
+}
+
 static int name_to_id(char *name)
 {
+	MSG_QUEUE *q;
 	int ind;
-	for (ind = 0; ind < MAX_PQUEUES; ind++) {
-		if (rt_pqueue_descr[ind].q_name[0] && !strcmp(rt_pqueue_descr[ind].q_name, name)) {
-			return ind;
+
+	q = rt_get_adr(name_to_reg_name(name));
+	if (q >= rt_pqueue_descr && q < rt_pqueue_descr + MAX_PQUEUES && !strcmp(q->q_name, name)) {
+		return q - rt_pqueue_descr;
+	}
+	if (unregistered_pqueues) {
+		for (ind = 0; ind < MAX_PQUEUES; ind++) {
+			if (rt_pqueue_descr[ind].q_name[0] && !rt_pqueue_descr[ind].reg_name && !strcmp(rt_pqueue_descr[ind].q_name, name)) {
+				return ind;
+			}
 		}
-	} 
+	}
 	return ERROR;
 }
 
@@ -159,41 +203,66 @@ static inline int freenode(void *node, Q_CTRL *queue)
 }
 
 
+//Messages are kept on a FIFO per priority level, indexed by a bitmap of the
+//levels in use, so that both queueing and dequeueing are O(1), whatever the
+//number of queued messages. The head of the queue is always the oldest message
+//of the highest priority, and the tail the newest of the lowest one.
+
+static inline int highest_prio(Q_CTRL *q)
+{
+	int i;
+	for (i = MQ_PRIO_WORDS - 1; i >= 0; i--) {
+		if (q->prio_map[i]) {
+			return i*BITS_PER_LONG + __fls(q->prio_map[i]);
+		}
+	}
+	return -1;
+}
+
+static inline int lowest_prio(Q_CTRL *q)
+{
+	int i;
+	for (i = 0; i < MQ_PRIO_WORDS; i++) {
+		if (q->prio_map[i]) {
+			return i*BITS_PER_LONG + __ffs(q->prio_map[i]);
+		}
+	}
+	return -1;
+}
+
 static void insert_message(Q_CTRL *q, MSG_HDR *this_msg)
 {
-//This function finds the appropriate point in a priority queue to
-//insert the supplied message. It preserves FIFO order within each
-//priority levela and can therefore be used for FIFO queuing policies
-//simply by making the priority equal to the supplied message priority
+	uint prio = this_msg->priority;
 
-	MSG_HDR *prev, *insertpt;
+	this_msg->next = NULL;
+	if (q->prio_head[prio]) {
+		((MSG_HDR *)q->prio_tail[prio])->next = this_msg;
+	} else {
+		q->prio_head[prio] = this_msg;
+		__set_bit(prio%BITS_PER_LONG, &q->prio_map[prio/BITS_PER_LONG]);
+	}
+	q->prio_tail[prio] = this_msg;
+	q->head = q->prio_head[highest_prio(q)];
+	q->tail = q->prio_tail[lowest_prio(q)];
+}
 
-//Do a quick check in case the message at the back of the queue has
-//a higher priority than this one, in which case this one can just
-//go at the back of the queue. 
-//Remember that Posix priorities increase from 0 to (at least) 32
+//Dequeue the message at the head of the queue, which must not be empty.
+static MQMSG *remove_message(Q_CTRL *q)
+{
+	MSG_HDR *this_msg;
+	int prio;
 
-	if (((MSG_HDR *)q->tail)->priority >= this_msg->priority) {
-		((MSG_HDR*)q->tail)->next = this_msg;
-		q->tail = this_msg;
+	this_msg = q->prio_head[prio = highest_prio(q)];
+	if (!(q->prio_head[prio] = this_msg->next)) {
+		__clear_bit(prio%BITS_PER_LONG, &q->prio_map[prio/BITS_PER_LONG]);
+	}
+	if ((prio = highest_prio(q)) >= 0) {
+		q->head = q->prio_head[prio];
+		q->tail = q->prio_tail[lowest_prio(q)];
 	} else {
-		prev = insertpt = q->head;
-//POSIX queues preserve FIFO ordering of messages within
-//a particular priority level
-		while (insertpt->priority >= this_msg->priority) {
-		        prev = insertpt;
-		        insertpt = insertpt->next; 
-		}
-//We've now found a message (or messages) of equal or lower
-//priority than the one we're trying to put onto the queue
- 		if (insertpt == q->head) {
-			this_msg->next = q->head;
-			q->head = this_msg;
-		} else {
-			this_msg->next = prev->next;
-			prev->next = this_msg;
-		}   
+		q->head = q->tail = q->nodes[0];
 	}
+	return (MQMSG *)this_msg;
 }
 
 #undef mqueues
@@ -263,11 +332,17 @@ static inline void initialise_queue(Q_CTRL *q)
 		((MSG_HDR *)msg_ptr)->next = NULL;
 		msg_ptr += msg_size;
 	}
+	memset(q->prio_map, 0, sizeof(q->prio_map));
+	memset(q->prio_head, 0, sizeof(q->prio_head));
+	memset(q->prio_tail, 0, sizeof(q->prio_tail));
 }
 
 
 static void delete_queue(int q_index)
 {
+	if (rt_pqueue_descr[q_index].q_name[0]) {
+		unregister_queue(&rt_pqueue_descr[q_index]);
+	}
 	rt_free(rt_pqueue_descr[q_index].data.base);
 
 	rt_pqueue_descr[q_index].owner = NULL;
@@ -445,6 +520,7 @@ RTAI_SYSCALL_MODE mqd_t _mq_open(char *mq_name, int oflags, mode_t permissions,
     				rt_pqueue_descr[q_index].owner = this_task;
 		    		rt_pqueue_descr[q_index].open_count = 0;
 				strcpy(rt_pqueue_descr[q_index].q_name, mq_name);
+				register_queue(&rt_pqueue_descr[q_index]);
 				rt_pqueue_descr[q_index].q_id = q_index + 1;
 				rt_pqueue_descr[q_index].marked_for_deletion = FALSE;
 				rt_pqueue_descr[q_index].data.head = 
@@ -521,7 +597,7 @@ RTAI_SYSCALL_MODE size_t _mq_receive(mqd_t mq, char *msg_buffer, size_t buflen,
 			return -EAGAIN;
 		}
 	}
-    	msg_ptr = q->data.head;
+    	msg_ptr = remove_message(&q->data);
         if (msg_ptr->hdr.size <= buflen) {
 		size = msg_ptr->hdr.size;
 		if (space) {
@@ -538,13 +614,9 @@ RTAI_SYSCALL_MODE size_t _mq_receive(mqd_t mq, char *msg_buffer, size_t buflen,
 	} else {
 		size = ERROR;
 	}
-	q->data.head = msg_ptr->hdr.next;
 	msg_ptr->hdr.size = 0;
     	msg_ptr->hdr.next = NULL;
     	freenode(msg_ptr, &q->data);
-	if(q->data.head == NULL) {
-		q->data.head = q->data.tail = q->data.nodes[0];
-	}
 	mq_cond_signal(&q->full_cond);
 	mq_mutex_unlock(&q->mutex);
 	return size;
@@ -584,7 +656,7 @@ RTAI_SYSCALL_MODE size_t _mq_timedreceive(mqd_t mq, char *msg_buffer, size_t buf
 			return -EAGAIN;
 		}
 	}
-	msg_ptr = q->data.head;
+	msg_ptr = remove_message(&q->data);
 	if (msg_ptr->hdr.size <= buflen) {
 		size = msg_ptr->hdr.size;
 		if (space) {
@@ -601,13 +673,9 @@ RTAI_SYSCALL_MODE size_t _mq_timedreceive(mqd_t mq, char *msg_buffer, size_t buf
 	} else {
 		size = ERROR;
 	}
-	q->data.head = msg_ptr->hdr.next;
 	msg_ptr->hdr.size = 0;
 	msg_ptr->hdr.next = NULL;
     	freenode(msg_ptr, &q->data);
-	if(q->data.head == NULL) {
-		q->data.head = q->data.tail = q->data.nodes[0];
-	}
 	mq_cond_signal(&q->full_cond);
 	mq_mutex_unlock(&q->mutex);
 	return size;
@@ -734,6 +802,182 @@ RTAI_SYSCALL_MODE int _mq_timedsend(mqd_t mq, const char *msg, size_t msglen, un
 }
 EXPORT_SYMBOL(_mq_timedsend);
 
+///////////////////////////////////////////////////////////////////////////////
+//      VECTORED SEND/RECEIVE
+///////////////////////////////////////////////////////////////////////////////
+
+//Signal n events to a condition in one go, as n mq_cond_signal would do,
+//unless someone is waiting on it, in which case each of them is woken up.
+static void mq_cond_signal_n(mq_cond_t *cond, int n)
+{
+	unsigned long flags;
+
+	flags = rt_global_save_flags_and_cli();
+	if (cond->count >= 0) {
+		cond->count += n;
+		rt_global_restore_flags(flags);
+		return;
+	}
+	rt_global_restore_flags(flags);
+	while (n-- > 0) {
+		mq_cond_signal(cond);
+	}
+}
+
+static void mq_vec_signal(MSG_QUEUE *q, mqd_t mq, int moved, int send, mq_bool_t q_was_empty)
+{
+	if (!moved) {
+		return;
+	}
+	if (!send) {
+		mq_cond_signal_n(&q->full_cond, moved);
+		return;
+	}
+	mq_cond_signal_n(&q->emp_cond, moved);
+	if (q_was_empty && q->notify.task != NULL) {
+		rt_trigger_signal((MAXSIGNALS + mq), q->notify.task);
+		q->notify.task = NULL;
+	}
+}
+
+//Common body of the vectored calls. The queue mutex is taken once and all
+//the messages that can be moved are, before signalling the other side just
+//once. A blocking queue waits for room/messages till all of the vector has
+//been moved, a non blocking one moves what it can. Returns the number of
+//messages moved, or the error that prevented moving the first one.
+static int mq_vec(mqd_t mq, struct rt_msg_iov *iov, int nmsg, const struct timespec *abstime, int send, int space)
+{
+	int q_index = mq - 1, count, moved, ret;
+	MSG_QUEUE *q;
+	MSG_HDR *this_msg;
+	MQMSG *msg_ptr;
+	struct rt_msg_iov v;
+	struct timespec time;
+	mq_bool_t blocking, q_was_empty;
+	RTIME t = 0;
+
+	if (q_index < 0 || q_index >= MAX_PQUEUES) {
+		return -EBADF;
+	}
+	q = &rt_pqueue_descr[q_index];
+	if (can_access(q, send ? FOR_WRITE : FOR_READ) == FALSE) {
+		return -EINVAL;
+	}
+	if (nmsg <= 0) {
+		return 0;
+	}
+	if (abstime) {
+		if (!space) {
+			rt_copy_from_user(&time, abstime, sizeof(struct timespec));
+			abstime = &time;
+		}
+		t = timespec2count(abstime);
+	}
+	if ((blocking = is_blocking(q))) {
+		if ((ret = abs(abstime ? rt_sem_wait_until(&q->mutex, t) : rt_sem_wait(&q->mutex))) >= RTE_LOWERR) {
+			return ret == RTE_TIMOUT ? -ETIMEDOUT : -EBADF;
+		}
+	} else if (mq_mutex_trylock(&q->mutex) <= 0) {
+		return -EAGAIN;
+	}
+	q_was_empty = is_empty(&q->data);
+	for (ret = count = moved = 0; count < nmsg; count++, moved++) {
+		while (send ? is_full(&q->data) : is_empty(&q->data)) {
+			if (!blocking) {
+				ret = -EAGAIN;
+				goto out;
+			}
+			mq_vec_signal(q, mq, moved, send, q_was_empty);
+			moved = 0;
+			mq_mutex_unlock(&q->mutex);
+			if ((ret = abs(abstime ? rt_sem_wait_until(send ? &q->full_cond : &q->emp_cond, t) : rt_sem_wait(send ? &q->full_cond : &q->emp_cond))) >= RTE_LOWERR) {
+				ret = ret == RTE_TIMOUT ? -ETIMEDOUT : -EBADF;
+				return count ? count : ret;
+			}
+			if ((ret = abs(abstime ? rt_sem_wait_until(&q->mutex, t) : rt_sem_wait(&q->mutex))) >= RTE_LOWERR) {
+				mq_cond_signal(send ? &q->full_cond : &q->emp_cond);
+				ret = ret == RTE_TIMOUT ? -ETIMEDOUT : -EBADF;
+				return count ? count : ret;
+			}
+			q_was_empty = is_empty(&q->data);
+		}
+		if (space) {
+			v = iov[count];
+		} else {
+			rt_copy_from_user(&v, iov + count, sizeof(struct rt_msg_iov));
+		}
+		if (send) {
+			if (v.prio > MQ_PRIO_MAX) {
+				ret = -EINVAL;
+				goto out;
+			}
+			if (v.size < 0) {
+				ret = -EINVAL;
+				goto out;
+			}
+			if (v.size > q->data.attrs.mq_msgsize) {
+				ret = -EMSGSIZE;
+				goto out;
+			}
+			this_msg = getnode(&q->data);
+			this_msg->size = v.size;
+			this_msg->priority = v.prio;
+			if (space) {
+				memcpy(&((MQMSG *)this_msg)->data, v.msg, v.size);
+			} else {
+				rt_copy_from_user(&((MQMSG *)this_msg)->data, v.msg, v.size);
+			}
+			insert_message(&q->data, this_msg);
+		} else {
+			if (v.size < q->data.attrs.mq_msgsize) {
+				ret = -EMSGSIZE;
+				goto out;
+			}
+			msg_ptr = remove_message(&q->data);
+			v.size = msg_ptr->hdr.size;
+			v.prio = msg_ptr->hdr.priority;
+			if (space) {
+				memcpy(v.msg, &msg_ptr->data, v.size);
+				iov[count] = v;
+			} else {
+				rt_copy_to_user(v.msg, &msg_ptr->data, v.size);
+				rt_copy_to_user(iov + count, &v, sizeof(struct rt_msg_iov));
+			}
+			msg_ptr->hdr.size = 0;
+			msg_ptr->hdr.next = NULL;
+			freenode(msg_ptr, &q->data);
+		}
+	}
+out:
+	mq_vec_signal(q, mq, moved, send, q_was_empty);
+	mq_mutex_unlock(&q->mutex);
+	return count ? count : ret;
+}
+
+RTAI_SYSCALL_MODE int _mq_send_vec(mqd_t mq, struct rt_msg_iov *iov, int nmsg, int space)
+{
+	return mq_vec(mq, iov, nmsg, NULL, 1, space);
+}
+EXPORT_SYMBOL(_mq_send_vec);
+
+RTAI_SYSCALL_MODE int _mq_receive_vec(mqd_t mq, struct rt_msg_iov *iov, int nmsg, int space)
+{
+	return mq_vec(mq, iov, nmsg, NULL, 0, space);
+}
+EXPORT_SYMBOL(_mq_receive_vec);
+
+RTAI_SYSCALL_MODE int _mq_timedsend_vec(mqd_t mq, struct rt_msg_iov *iov, int nmsg, const struct timespec *abstime, int space)
+{
+	return mq_vec(mq, iov, nmsg, abstime, 1, space);
+}
+EXPORT_SYMBOL(_mq_timedsend_vec);
+
+RTAI_SYSCALL_MODE int _mq_timedreceive_vec(mqd_t mq, struct rt_msg_iov *iov, int nmsg, const struct timespec *abstime, int space)
+{
+	return mq_vec(mq, iov, nmsg, abstime, 0, space);
+}
+EXPORT_SYMBOL(_mq_timedreceive_vec);
+
 RTAI_SYSCALL_MODE int mq_close(mqd_t mq)
 {
 	int q_index = mq - 1;
@@ -896,6 +1140,7 @@ RTAI_SYSCALL_MODE int mq_unlink(char *mq_name)
 	}
 	mq_mutex_lock(&rt_pqueue_descr[q_index].mutex);
 	if (rt_pqueue_descr[q_index].open_count > 0) {
+		unregister_queue(&rt_pqueue_descr[q_index]);
 		strcpy(rt_pqueue_descr[q_index].q_name, "\0");
 		rt_pqueue_descr[q_index].marked_for_deletion = TRUE;
 		rtn = rt_pqueue_descr[q_index].open_count;
@@ -983,6 +1228,10 @@ struct rt_native_fun_entry rt_pqueue_entries[] = {
         { { 1, _mq_timedreceive },		  	MQ_TIMEDRECEIVE },
         { { 1, _mq_timedsend }, 	       		MQ_TIMEDSEND },
         { { 1,	mq_reg_usp_notifier }, 	       		MQ_REG_USP_NOTIFIER },
+        { { 1, _mq_send_vec },				MQ_SEND_VEC },
+        { { 1, _mq_receive_vec },			MQ_RECEIVE_VEC },
+        { { 1, _mq_timedsend_vec },			MQ_TIMEDSEND_VEC },
+        { { 1, _mq_timedreceive_vec },			MQ_TIMEDRECEIVE_VEC },
 	{ { 0, 0 },  		      	       		000 }
 };
 
@@ -992,6 +1241,7 @@ extern void reset_rt_fun_entries(struct rt_native_fun_entry *entry);
 int __rtai_mq_init(void) 
 {
 	num_pqueues = 0;
+	unregistered_pqueues = 0;
 	mq_mutex_init(&pqueue_mutex, NULL);
 #ifdef CONFIG_PROC_FS
 	pqueue_proc_register();
@@ -1003,6 +1253,12 @@ int __rtai_mq_init(void)
 
 void __rtai_mq_exit(void) 
 {
+	int q_index;
+	for (q_index = 0; q_index < MAX_PQUEUES; q_index++) {
+		if (rt_pqueue_descr[q_index].reg_name) {
+			unregister_queue(&rt_pqueue_descr[q_index]);
+		}
+	}
 	mq_mutex_destroy(&pqueue_mutex);
 	reset_rt_fun_entries(rt_pqueue_entries);
 #ifdef CONFIG_PROC_FS
@@ -1119,12 +1119,42 @@ COPYRIGHT (C) 2003  Pierre Cloutier  (pcloutier@poseidoncontrols.com)
                     Paolo Mantegazza (mantegazza@aero.polimi.it)
 +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
 
+/*
+ * Extended messages buffers can be user space ones, see UDC in rtai_lxrt.h,
+ * those of the current task if it has its msg_mm set, those of an mcb if
+ * it has its mm set, in which case the sender has already verified that the
+ * receiver, i.e. the current task, shares that mm. Copies between two user
+ * buffers go through a small bounce on the stack.
+ */
+static void msg_copy(void *dst, struct mm_struct *dmm, void *src, struct mm_struct *smm, int size)
+{
+	char buf[256];
+	int n;
+
+	if (!smm && !dmm) {
+		memcpy(dst, src, size);
+	} else if (!dmm) {
+		rt_copy_from_user(dst, src, size);
+	} else if (!smm) {
+		rt_copy_to_user(dst, src, size);
+	} else {
+		for (; size > 0; size -= n) {
+			n = size < (int)sizeof(buf) ? size : (int)sizeof(buf);
+			rt_copy_from_user(buf, src, n);
+			rt_copy_to_user(dst, buf, n);
+			src = (char *)src + n;
+			dst = (char *)dst + n;
+		}
+	}
+}
+
 #define SET_RPC_MCB() \
 	do { \
 		mcb.sbuf   = smsg; \
 		mcb.sbytes = ssize; \
 		mcb.rbuf   = rmsg; \
 		mcb.rbytes = rsize; \
+		mcb.mm     = RT_CURRENT->msg_mm; \
 	} while (0)
 
 /**
@@ -1341,6 +1371,7 @@ RTAI_SYSCALL_MODE RT_TASK *rt_rpcx_timed(RT_TASK *task, void *smsg, void *rmsg,
 		mcb.sbytes = size; \
 		mcb.rbuf   = NULL; \
 		mcb.rbytes = SEND_RCV_BYTES; \
+		mcb.mm     = RT_CURRENT->msg_mm; \
 	} while (0)
 
 /**
@@ -1432,6 +1463,7 @@ RTAI_SYSCALL_MODE RT_TASK *rt_sendx_if(RT_TASK *task, void *msg, int size)
 	      (!task->msg_queue.task || task->msg_queue.task == rt_current)) {
 		task->mcb.sbuf = msg;
 		task->mcb.sbytes = size;
+		task->mcb.mm = rt_current->msg_mm;
 		task->msg = (unsigned long)&task->mcb;
 		task->msg_queue.task = rt_current;
 		task->ret_queue.task = NULL;
@@ -1608,7 +1640,7 @@ RTAI_SYSCALL_MODE RT_TASK *rt_returnx(RT_TASK *task, void *msg, int size)
 			size = mcb->rbytes;
 		}
 		if (msg && size > 0) {
-			memcpy(mcb->rbuf, msg, size);
+			msg_copy(mcb->rbuf, mcb->mm, msg, rt_current->msg_mm, size);
 		}
 		_rt_return(0UL);
 	} else {
@@ -1621,7 +1653,7 @@ RTAI_SYSCALL_MODE RT_TASK *rt_returnx(RT_TASK *task, void *msg, int size)
 #define DO_RCV_MSG() \
 	do { \
 		if (msg && (*len = size <= mcb->sbytes ? size : mcb->sbytes)) { \
-			memcpy(msg, mcb->sbuf, *len); \
+			msg_copy(msg, RT_CURRENT->msg_mm, mcb->sbuf, mcb->mm, *len); \
 		} \
 		if ((unsigned long)task > RTE_HIGERR && !mcb->rbuf && mcb->rbytes == SEND_RCV_BYTES) { \
 			rt_return(task, 0UL); \
@@ -2196,20 +2228,20 @@ struct rt_native_fun_entry rt_msg_entries[] = {
 	{ { UW1(3, 0), rt_rpc_timed },			RPC_TIMED },
 	{ { 0, rt_isrpc }, 		 		ISRPC },
 	{ { 1, rt_return },				RETURNMSG },
-	{ { UR1(2, 4) | UW1(3, 5), rt_rpcx },		RPCX },
-	{ { UR1(2, 4) | UW1(3, 5), rt_rpcx_if },	RPCX_IF },
-	{ { UR1(2, 4) | UW1(3, 5), rt_rpcx_until },	RPCX_UNTIL },
-	{ { UR1(2, 4) | UW1(3, 5), rt_rpcx_timed }, 	RPCX_TIMED },
-	{ { UR1(2, 3), rt_sendx },			SENDX },
+	{ { UR1(2, 4) | UW1(3, 5) | UDC | UDC_PEER, rt_rpcx },		RPCX },
+	{ { UR1(2, 4) | UW1(3, 5) | UDC | UDC_PEER, rt_rpcx_if },	RPCX_IF },
+	{ { UR1(2, 4) | UW1(3, 5) | UDC | UDC_PEER, rt_rpcx_until },	RPCX_UNTIL },
+	{ { UR1(2, 4) | UW1(3, 5) | UDC | UDC_PEER, rt_rpcx_timed }, 	RPCX_TIMED },
+	{ { UR1(2, 3) | UDC | UDC_PEER, rt_sendx },			SENDX },
 	{ { UR1(2, 3), rt_sendx_if },			SENDX_IF },
-	{ { UR1(2, 3), rt_sendx_until },		SENDX_UNTIL },
-	{ { UR1(2, 3), rt_sendx_timed },		SENDX_TIMED },
-	{ { UR1(2, 3), rt_returnx },			RETURNX },
-	{ { UW1(2, 3) | UW2(4, 0), rt_evdrpx },		EVDRPX },
-	{ { UW1(2, 3) | UW2(4, 0), rt_receivex },	RECEIVEX },
-	{ { UW1(2, 3) | UW2(4, 0), rt_receivex_if },	RECEIVEX_IF },
-	{ { UW1(2, 3) | UW2(4, 0), rt_receivex_until }, RECEIVEX_UNTIL },
-	{ { UW1(2, 3) | UW2(4, 0), rt_receivex_timed },	RECEIVEX_TIMED },
+	{ { UR1(2, 3) | UDC | UDC_PEER, rt_sendx_until },		SENDX_UNTIL },
+	{ { UR1(2, 3) | UDC | UDC_PEER, rt_sendx_timed },		SENDX_TIMED },
+	{ { UR1(2, 3) | UDC, rt_returnx },			RETURNX },
+	{ { UW1(2, 3) | UW2(4, 0) | UDC, rt_evdrpx },		EVDRPX },
+	{ { UW1(2, 3) | UW2(4, 0) | UDC, rt_receivex },	RECEIVEX },
+	{ { UW1(2, 3) | UW2(4, 0) | UDC, rt_receivex_if },	RECEIVEX_IF },
+	{ { UW1(2, 3) | UW2(4, 0) | UDC, rt_receivex_until }, RECEIVEX_UNTIL },
+	{ { UW1(2, 3) | UW2(4, 0) | UDC, rt_receivex_timed },	RECEIVEX_TIMED },
 	{ { UR1(2, 3), rt_proxy_attach },         	PROXY_ATTACH },
 	{ { 1, rt_proxy_detach },                 	PROXY_DETACH },
 	{ { 1, rt_trigger },                      	PROXY_TRIGGER },
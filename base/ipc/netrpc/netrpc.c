@@ -24,6 +24,8 @@
 #include <linux/unistd.h>
 #include <linux/delay.h>
 #include <linux/sched.h>
+#include <linux/slab.h>
+#include <linux/vmalloc.h>
 
 #include <asm/uaccess.h>
 
@@ -36,6 +38,13 @@
 #include <rtai_sem.h>
 #include <rtai_mbx.h>
 
+#if defined(CONFIG_RTAI_SHM) && (!defined(CONFIG_RTAI_NETRPC_BUILTIN) || defined(CONFIG_RTAI_SHM_BUILTIN))
+#include <rtai_shm.h>
+#define NETRPC_LOCAL_PORTS  1
+#else
+#define NETRPC_LOCAL_PORTS  0
+#endif
+
 MODULE_LICENSE("GPL");
 
 // Simple check to verify if memcpy is used between kernel and user space.
@@ -103,6 +112,13 @@ static inline void check_kuadr(char *id, void *adr1, void *adr2)
 
 #define NETRPC_STACK_SIZE  6000
 
+#define NETRPC_RECV_DEPTH  4
+#define NETRPC_MMSG_BATCH  16
+#define NETRPC_LO_DEPTH    (2*NETRPC_MAX_WINDOW)  // a power of 2
+#define NETRPC_FRAG_BURST  16
+#define NETRPC_FRAG_TMOUT  20000000  // ns
+#define NETRPC_FRAG_TRIES  50
+
 static unsigned long MaxStubs = MAX_STUBS;
 RTAI_MODULE_PARM(MaxStubs, ulong);
 static int MaxStubsMone;
@@ -110,6 +126,18 @@ static int MaxStubsMone;
 static unsigned long MaxSocks = MAX_SOCKS;
 RTAI_MODULE_PARM(MaxSocks, ulong);
 
+static int RecvThreads = 0;  // 0: one per online CPU
+RTAI_MODULE_PARM(RecvThreads, int);
+
+static int RecvDepth = NETRPC_RECV_DEPTH;
+RTAI_MODULE_PARM(RecvDepth, int);
+
+static int LocalPorts = NETRPC_LOCAL_PORTS;
+RTAI_MODULE_PARM(LocalPorts, int);
+
+static int FragBurst = NETRPC_FRAG_BURST;
+RTAI_MODULE_PARM(FragBurst, int);
+
 static int StackSize = NETRPC_STACK_SIZE;
 RTAI_MODULE_PARM(StackSize, int);
 
@@ -129,7 +157,9 @@ extern struct rt_fun_entry *rt_fun_ext[];
 static unsigned long this_node[2];
 
 #define PRTSRVNAME  0xFFFFFFFF
-struct portslot_t { struct portslot_t *p; long task; int indx, place, socket[2], hard; unsigned long long owner; SEM sem; void *msg; struct sockaddr_in addr; MBX *mbx; unsigned long name;  RTIME timeout; int recovered; };
+/* Buffers of a client port, off the RT stack, see frag_request and pipe_replies. */
+struct port_msgs { char frag[MAX_MSG_SIZE], pipe[MAX_MSG_SIZE]; unsigned char tosend[NETRPC_MAX_FRAGS/8]; };
+struct portslot_t { struct portslot_t *p; long task; int indx, place, socket[2], hard; unsigned long long owner; SEM sem; void *msg; struct sockaddr_in addr; MBX *mbx; unsigned long name;  RTIME timeout; int recovered; int window, draining; unsigned long reqid, sync_reqid; volatile unsigned long reqids[NETRPC_MAX_WINDOW]; atomic_t pipe_calls; struct lo_pair *lo; struct lo_ring *volatile lo_in, *volatile lo_out, *lo_peeked; struct portslot_t *volatile lo_peer; atomic_t lo_busy; unsigned long long fragid; unsigned char *volatile fragmap; volatile int fragstat; struct frag_buf *frag; struct port_msgs *msgs; };
 static DEFINE_SPINLOCK(portslot_lock);
 static volatile int portslotsp;
 
@@ -138,6 +168,7 @@ static volatile int stubssp = 1;
 
 
 static struct portslot_t *portslot;
+static struct port_msgs *port_msgs;
 static struct sockaddr_in SPRT_ADDR;
 struct recovery_msg { int hard, priority; unsigned long long owner; struct sockaddr addr; };
 static struct { int in, out; struct recovery_msg *msg; } recovery;
@@ -235,9 +266,9 @@ void set_netrpc_encoding(void *encode_fun, void *decode_fun, void *ext)
 
 struct req_rel_msg { long long op, port, priority, hard; unsigned long long owner, name, rem_node, chkspare;};
 
-struct par_t { long long mach, priority, base_priority, argsize, rsize, fun_ext_timed, type; unsigned long long owner, partypes; long a[1]; };
+struct par_t { long long mach, priority, base_priority, argsize, rsize, fun_ext_timed, type; unsigned long long owner, partypes, reqid; long a[1]; };
 
-struct reply_t { long long wsize, w2size, myport; unsigned long long retval; char msg[1], msg1[1]; };
+struct reply_t { long long wsize, w2size, myport; unsigned long long retval, reqid; char msg[1], msg1[1]; };
 
 static inline int argconv(void *ain, void *aout, int send_mach, int argsize, unsigned int partypes)
 {
@@ -298,6 +329,253 @@ static inline int argconv(void *ain, void *aout, int send_mach, int argsize, uns
 #undef recv_mach
 }
 
+static void pipe_replies(struct portslot_t *p);
+
+static void frag_free(struct portslot_t *p);
+
+/*
+ * Ports to this node. The soft stub serving a port requested from this
+ * node gets a pair of rings, on a named shared memory area, requests being
+ * queued on the first one by the port and replies on the second one by the
+ * stub. Once both have been attached to them calls do not go through Linux
+ * sockets, the send and receive threads anymore, the peer being woken up
+ * directly. Each ring has a single producer and a single consumer, so they
+ * are lock free. Port requests and releases keep using the port server, as
+ * for any other node, and a port goes back to sockets if its stub is busy
+ * with another local port already. Hard ports are never local.
+ * Rings are used only between lo_enter and lo_leave, so that lo_free can wait
+ * for their users to be out before freeing them.
+ */
+struct lo_msg { long len; char msg[MAX_MSG_SIZE]; };
+
+struct lo_ring { volatile unsigned int in, out; struct lo_msg slot[NETRPC_LO_DEPTH]; };
+
+struct lo_pair { struct lo_ring req, rep; };
+
+static inline unsigned long lo_name(int stub)
+{
+	char name[8];
+	sprintf(name, "NRL%03d", stub);
+	return nam2num(name);
+}
+
+static inline int lo_node(unsigned long node)
+{
+	return node == this_node[0] || (ntohl(node) >> 24) == 127;
+}
+
+static inline void lo_resume(struct portslot_t *p)
+{
+	if (p->window > 1) {
+		pipe_replies(p);
+	} else {
+		rt_sem_signal(&p->sem);
+	}
+}
+
+static inline struct lo_ring *lo_enter(struct portslot_t *p, struct lo_ring *volatile *ringp)
+{
+	struct lo_ring *ring;
+	atomic_inc(&p->lo_busy);
+	smp_mb();
+	if (!(ring = *ringp)) {
+		atomic_dec(&p->lo_busy);
+	}
+	return ring;
+}
+
+static inline void lo_leave(struct portslot_t *p)
+{
+	smp_mb();
+	atomic_dec(&p->lo_busy);
+}
+
+static int lo_put(struct portslot_t *p, const void *msg, int msglen)
+{
+	struct portslot_t *peer;
+	struct lo_ring *ring;
+	struct lo_msg *slot;
+
+	if (!(ring = lo_enter(p, &p->lo_out))) {
+		return -1;
+	}
+	if (!(peer = p->lo_peer) || ring->in - ring->out >= NETRPC_LO_DEPTH) {
+		lo_leave(p);
+		return -1;
+	}
+	if (msglen > MAX_MSG_SIZE) {
+		msglen = MAX_MSG_SIZE;
+	}
+	slot = ring->slot + (ring->in & (NETRPC_LO_DEPTH - 1));
+	memcpy(slot->msg, msg, slot->len = msglen);
+	smp_wmb();
+	ring->in++;
+	lo_resume(peer);
+	lo_leave(p);
+	return msglen;
+}
+
+/*
+ * Wrappers of the soft sockets functions, using the rings of local ports.
+ * A message taken in place by port_recv_peek comes from the ring if *from
+ * is NULL, and it must be given back accordingly to port_recv_done, or to
+ * port_recv_leave to keep it there, the ring being in use till then.
+ */
+static inline int port_sendto(struct portslot_t *p, const void *msg, int msglen, struct sockaddr *to)
+{
+	if (p->lo_peer) {
+		return lo_put(p, msg, msglen);
+	}
+	return soft_rt_sendto(p->socket[0], msg, msglen, 0, to, sizeof(struct sockaddr));
+}
+
+static inline int port_recv_peek(struct portslot_t *p, void **msg, struct sockaddr **from)
+{
+	struct lo_ring *ring;
+	if ((ring = lo_enter(p, &p->lo_in))) {
+		if (ring->out != ring->in) {
+			smp_rmb();
+			*msg = ring->slot[ring->out & (NETRPC_LO_DEPTH - 1)].msg;
+			*from = NULL;
+			p->lo_peeked = ring;
+			return ring->slot[ring->out & (NETRPC_LO_DEPTH - 1)].len;
+		}
+		lo_leave(p);
+	}
+	return soft_rt_recv_peek(p->socket[0], msg, from);
+}
+
+static inline void port_recv_done(struct portslot_t *p, struct sockaddr *from)
+{
+	if (!from) {
+		smp_mb();
+		p->lo_peeked->out++;
+		lo_leave(p);
+	} else {
+		soft_rt_recv_done(p->socket[0]);
+	}
+}
+
+static inline void port_recv_leave(struct portslot_t *p, struct sockaddr *from)
+{
+	if (!from) {
+		lo_leave(p);
+	}
+}
+
+static inline int port_recvfrom(struct portslot_t *p, void *msg, int msglen, struct sockaddr *from, long *fromlen)
+{
+	struct lo_ring *ring;
+	struct lo_msg *slot;
+	if ((ring = lo_enter(p, &p->lo_in))) {
+		if (ring->out != ring->in) {
+			smp_rmb();
+			slot = ring->slot + (ring->out & (NETRPC_LO_DEPTH - 1));
+			if (msglen > slot->len) {
+				msglen = slot->len;
+			}
+			memcpy(msg, slot->msg, msglen);
+			smp_mb();
+			ring->out++;
+			lo_leave(p);
+			return msglen;
+		}
+		lo_leave(p);
+	}
+	return soft_rt_recvfrom(p->socket[0], msg, msglen, 0, from, fromlen);
+}
+
+#if NETRPC_LOCAL_PORTS
+
+/* Called by the port server, i.e. from Linux, when it creates a soft stub. */
+static void lo_alloc(struct portslot_t *stub, struct sockaddr *from)
+{
+	if (LocalPorts && !stub->lo && lo_node(((struct sockaddr_in *)from)->sin_addr.s_addr)) {
+		if ((stub->lo = rt_shm_alloc(lo_name(stub->indx), sizeof(struct lo_pair), USE_VMALLOC))) {
+			stub->lo_in  = &stub->lo->req;
+			stub->lo_out = &stub->lo->rep;
+		}
+	}
+}
+
+/*
+ * Called from Linux, once the stub task has been deleted, while its port can
+ * still be using the rings, or attaching to them. The stub is made its own
+ * peer, so that no port can attach anymore, and the rings are freed when
+ * both have left them.
+ */
+static void lo_free(struct portslot_t *stub)
+{
+	struct portslot_t *port;
+	if (stub->lo) {
+		if ((port = xchg(&stub->lo_peer, stub)) == stub) {
+			port = NULL;
+		}
+		if (port) {
+			while (atomic_read(&port->lo_busy)) {
+				msleep(1);
+			}
+			port->lo_peer = NULL;
+			port->lo_in = port->lo_out = NULL;
+		}
+		stub->lo_in = stub->lo_out = NULL;
+		smp_mb();
+		while ((port && atomic_read(&port->lo_busy)) || atomic_read(&stub->lo_busy)) {
+			msleep(1);
+		}
+		rt_shm_free(lo_name(stub->indx));
+		stub->lo = NULL;
+		smp_wmb();
+		stub->lo_peer = NULL;
+	}
+}
+
+/*
+ * Called by the port owner once it has got its stub. Replies left on the
+ * ring by a previous port are discarded, requests are not, as it happens
+ * with sockets.
+ */
+static void lo_attach(struct portslot_t *port, unsigned long node, int stub)
+{
+	struct portslot_t *stubp;
+
+	if (!LocalPorts || !lo_node(node) || stub <= 0 || stub >= MaxStubs) {
+		return;
+	}
+	stubp = portslot + stub;
+	// busy, so that lo_free waits for the attach to be complete
+	atomic_inc(&port->lo_busy);
+	smp_mb();
+	if (stubp->lo && !stubp->hard && stubp->owner == port->owner && !cmpxchg(&stubp->lo_peer, NULL, port)) {
+		stubp->lo->rep.out = stubp->lo->rep.in;
+		port->lo_in  = &stubp->lo->rep;
+		port->lo_out = &stubp->lo->req;
+		smp_wmb();
+		port->lo_peer = stubp;
+	}
+	lo_leave(port);
+}
+
+static void lo_detach(struct portslot_t *port)
+{
+	struct portslot_t *stub;
+	if ((stub = port->lo_peer)) {
+		port->lo_peer = NULL;
+		port->lo_in = port->lo_out = NULL;
+		// not if lo_free has made the stub its own peer already
+		cmpxchg(&stub->lo_peer, port, NULL);
+	}
+}
+
+#else
+
+#define lo_alloc(stub, from)
+#define lo_free(stub)
+#define lo_attach(port, node, stub)
+#define lo_detach(port)
+
+#endif
+
 static void net_resume_task(int sock, struct portslot_t *p)
 {
 	int all_ok;
@@ -310,20 +588,26 @@ static void net_resume_task(int sock, struct portslot_t *p)
 		}
 	}
 	if (all_ok) {
+		if (p->window > 1 && !my->is_hard) {
+			pipe_replies(p);
+			return;
+		}
 		rt_sem_signal(&p->sem);
 	} else {
 		long i;
 		unsigned long flags;
 		struct par_t *par;
 		char msg[MAX_MSG_SIZE];
-		struct sockaddr *addr;
+		struct sockaddr *addr, *from;
 		par = (void *)msg;
 		addr = (struct sockaddr*)&p->addr;
 		
 		if (my->is_hard) {
 			while (hard_rt_recvfrom(p->socket[1], msg, MAX_MSG_SIZE, 0, addr, (void *)&i) == -EAGAIN);
+		} else if (soft_rt_recv_peek(p->socket[0], (void **)&par, &from) > 0) {
+			*addr = *from;
 		} else {
-			soft_rt_recvfrom(p->socket[0], msg, MAX_MSG_SIZE, 0, addr, &i);
+			return;
 		}
 		
 		flags = rt_spin_lock_irqsave(&recovery_lock);
@@ -333,6 +617,9 @@ static void net_resume_task(int sock, struct portslot_t *p)
 		recovery.msg[recovery.in].hard = my->is_hard;
 		recovery.in = (recovery.in + 1) & MaxStubsMone;
 		rt_spin_unlock_irqrestore(flags, &recovery_lock);
+		if (!my->is_hard) {
+			soft_rt_recv_done(p->socket[0]);
+		}
 		rt_sem_signal(&portslot[0].sem);
 	}
 }
@@ -452,6 +739,8 @@ static inline int gvb_stub(int slot, unsigned long long owner)
 					soft_kthread_delete(task);
 				}
 				kfree(task);
+				lo_free(portslot + slot - BASEPORT);
+				frag_free(portslot + slot - BASEPORT);
 			} else {
 				slot = !portslot[slot].owner ? slot + BASEPORT : -ENXIO;
 				rt_spin_unlock_irqrestore(flags, &stub_lock);
@@ -479,100 +768,490 @@ static inline int find_stub(unsigned long long owner)
 	return p->owner != owner ? 0 : p->indx;
 }
 
-static void soft_stub_fun(struct portslot_t *portslotp)
+/*
+ * Fragmentation of soft ports requests larger than MAX_MSG_SIZE, e.g. a
+ * remote RT_mbx_send of a large message. The request is sent as a stream of
+ * fragments, each carrying its sequence number, in bursts of FragBurst, the
+ * last fragment of each burst asking the stub for the status of all the
+ * fragments up to it. The status is a bitmap of the missing ones, which are
+ * then sent again, along with the next burst, so that just lost fragments
+ * are retransmitted. A burst whose status does not come back in time is
+ * sent again. The stub sends a last status as soon as it has the whole
+ * request, before serving it, so that the port can go on as for any other
+ * call. The stub reassembles the request in its own buffer, except for the
+ * message of a mailbox send, written directly in the mailbox, reserved in
+ * place when the first fragment arrives, if it has room for it.
+ * Fragments and statuses are told from requests and replies by a negative
+ * first field, which is "mach" for the former and "wsize" for the latter.
+ */
+#define NETRPC_FRAG    -1
+#define NETRPC_STATUS  -2
+
+struct frag_t { long long mach, seq, nfrags, total, ack; unsigned long long owner, fragid; char data[1]; };
+
+#define FRAG_DATA  (MAX_MSG_SIZE - offsetof(struct frag_t, data))
+
+struct frag_buf { unsigned long long fragid, done; int nfrags, total, count, size, body; char *buf; MBX *mbx; struct rt_mbx_span span[2]; unsigned char map[NETRPC_MAX_FRAGS/8]; };
+
+#define FRAG_BIT(map, k)      ((map)[(k)/8] & (1 << ((k) & 7)))
+#define FRAG_SET_BIT(map, k)  ((map)[(k)/8] |= (1 << ((k) & 7)))
+#define FRAG_CLR_BIT(map, k)  ((map)[(k)/8] &= ~(1 << ((k) & 7)))
+
+static inline int frag_next(unsigned char *map, int k, int nfrags)
+{
+	for (; k < nfrags && !FRAG_BIT(map, k); k++);
+	return k;
+}
+
+static void frag_send(struct portslot_t *portslotp, char *msg, unsigned long long fragid, int seq, int nfrags, int ack, void *hdr, int hdrsize, void *rbuf, int total, int space)
+{
+	struct frag_t *frag;
+	int ofst, len, size;
+
+	frag = (void *)msg;
+	frag->seq    = seq;
+	frag->nfrags = nfrags;
+	frag->total  = total;
+	frag->ack    = ack;
+	frag->owner  = portslotp->owner;
+	frag->fragid = fragid;
+	ofst = seq*FRAG_DATA;
+	len  = total - ofst < FRAG_DATA ? total - ofst : FRAG_DATA;
+	if (ofst < hdrsize) {
+		size = hdrsize - ofst < len ? hdrsize - ofst : len;
+		memcpy(frag->data, (char *)hdr + ofst, size);
+	} else {
+		size = 0;
+	}
+	if (len > size) {
+		if (space) {
+			memcpy(frag->data + size, (char *)rbuf + ofst + size - hdrsize, len - size);
+		} else {
+			rt_copy_from_user(frag->data + size, (char *)rbuf + ofst + size - hdrsize, len - size);
+		}
+	}
+	len += offsetof(struct frag_t, data);
+	if (encode) {
+		len = encode(portslotp, msg, len, RPC_REQ);
+	}
+	frag->mach = NETRPC_FRAG;
+	port_sendto(portslotp, msg, len, (struct sockaddr *)&portslotp->addr);
+}
+
+/*
+ * Take a status of the fragments being sent by the port owner, if it is
+ * about them, marking those to be sent again. Called by frag_request or by
+ * pipe_replies, as statuses arrive along with the replies of the window.
+ */
+static int frag_take(struct portslot_t *portslotp, struct frag_t *stat)
+{
+	unsigned char *map;
+	int k;
+
+	if (!(map = portslotp->fragmap) || stat->fragid != portslotp->fragid) {
+		return 0;
+	}
+	if (stat->ack) {
+		portslotp->fragstat = 2;
+		return 1;
+	}
+	for (k = 0; k <= stat->seq && k < NETRPC_MAX_FRAGS; k++) {
+		if (FRAG_BIT((unsigned char *)stat->data, k)) {
+			FRAG_SET_BIT(map, k);
+		} else {
+			FRAG_CLR_BIT(map, k);
+		}
+	}
+	if (!portslotp->fragstat) {
+		portslotp->fragstat = 1;
+	}
+	return 1;
+}
+
+/*
+ * Send a request of hdrsize bytes at hdr, followed by rsize bytes at rbuf,
+ * by fragments. It returns when the stub has got all of them, 0, or on
+ * timeout, RTE_NETIMOUT.
+ */
+static int frag_request(struct portslot_t *portslotp, void *hdr, int hdrsize, void *rbuf, int rsize, int space)
+{
+	char *msg;
+	unsigned char *tosend;
+	struct sockaddr addr;
+	unsigned long long fragid;
+	int nfrags, total, tries, n, k, next;
+	long i;
+
+	msg    = portslotp->msgs->frag;
+	tosend = portslotp->msgs->tosend;
+	total  = hdrsize + rsize;
+	nfrags = (total + FRAG_DATA - 1)/FRAG_DATA;
+	memset(tosend, 0xFF, (nfrags + 7)/8);
+	portslotp->fragid = fragid = rtai_rdtsc();
+	portslotp->fragstat = 0;
+	portslotp->sem.count = 0;
+	portslotp->fragmap = tosend;
+	for (tries = 0; tries <= NETRPC_FRAG_TRIES; ) {
+		k = frag_next(tosend, 0, nfrags);
+		for (n = 0; k < nfrags && n < FragBurst; n++) {
+			next = frag_next(tosend, k + 1, nfrags);
+			frag_send(portslotp, msg, fragid, k, nfrags, next >= nfrags || n == FragBurst - 1, hdr, hdrsize, rbuf, total, space);
+			k = next;
+		}
+		portslotp->fragstat = 0;
+		while (!portslotp->fragstat && rt_sem_wait_timed(&portslotp->sem, nano2count(NETRPC_FRAG_TMOUT)) < RTE_LOWERR) {
+			if (portslotp->window > 1) {
+				pipe_replies(portslotp);
+				continue;
+			}
+			while ((n = port_recvfrom(portslotp, msg, MAX_MSG_SIZE, &addr, &i)) > 0) {
+				if (decode) {
+					decode(portslotp, msg, n, RPC_RCV);
+				}
+				if (((struct frag_t *)msg)->mach == NETRPC_STATUS) {
+					frag_take(portslotp, (void *)msg);
+				}
+			}
+		}
+		if (portslotp->fragstat == 2) {
+			portslotp->fragmap = NULL;
+			portslotp->sem.count = 0;
+			return 0;
+		}
+		tries = portslotp->fragstat ? 0 : tries + 1;
+	}
+	portslotp->fragmap = NULL;
+	frag_send(portslotp, msg, fragid, 0, 0, 0, hdr, 0, rbuf, 0, 1);
+	return RTE_NETIMOUT;
+}
+
+/* Forget a request that could not be sent, as if it had never been made. */
+static void frag_abort(struct portslot_t *portslotp, long port, unsigned long reqid)
+{
+	int i;
+
+	if (port > 0) {
+		portslotp->sync_reqid = 0;
+	} else if (portslotp->window > 1) {
+		for (i = 0; i < portslotp->window; i++) {
+			if (portslotp->reqids[i] == reqid) {
+				portslotp->reqids[i] = 0;
+			}
+		}
+	} else {
+		portslotp->task = 1;
+	}
+}
+
+static inline long long frag_mbx_call(struct portslot_t *portslotp, int fun, long arg0, long arg1, long arg2, long arg3)
+{
+	long a[4] = { arg0, arg1, arg2, arg3 };
+	return soft_rt_genfun_call((RT_TASK *)portslotp->task, rt_net_rpc_fun_ext[NET_RPC_EXT][fun].fun, a, sizeof(a));
+}
+
+static void frag_cancel(struct portslot_t *portslotp, struct frag_buf *fb)
+{
+	if (fb->mbx) {
+		frag_mbx_call(portslotp, MBX_COMMIT, (long)fb->mbx, 0, 0, 0);
+		fb->mbx = NULL;
+	}
+	fb->fragid = 0;
+}
+
+static void frag_status(struct portslot_t *portslotp, struct frag_buf *fb, struct frag_t *frag, int complete, struct sockaddr *addr)
 {
 	char msg[MAX_MSG_SIZE];
-	struct sockaddr *addr;
+	struct frag_t *stat;
+	int k, n, len;
+
+	stat = (void *)msg;
+	stat->mach   = NETRPC_STATUS;
+	stat->seq    = complete ? frag->nfrags - 1 : frag->seq;
+	stat->nfrags = frag->nfrags;
+	stat->ack    = complete;
+	stat->owner  = frag->owner;
+	stat->fragid = frag->fragid;
+	n = complete ? 0 : frag->seq + 1;
+	memset(stat->data, 0, (n + 7)/8);
+	for (stat->total = k = 0; k < n; k++) {
+		if (!FRAG_BIT(fb->map, k)) {
+			FRAG_SET_BIT((unsigned char *)stat->data, k);
+			stat->total++;
+		}
+	}
+	len = offsetof(struct frag_t, data) + (n + 7)/8;
+	port_sendto(portslotp, msg, encode ? encode(portslotp, msg, len, RPC_RTR) : len, addr);
+}
+
+static void frag_place(struct frag_buf *fb, int ofst, char *data, int len)
+{
+	int size, k;
+
+	if (fb->mbx && ofst + len > fb->body) {
+		if (ofst < fb->body) {
+			memcpy(fb->buf + ofst, data, size = fb->body - ofst);
+			ofst += size;
+			data += size;
+			len  -= size;
+		}
+		for (ofst -= fb->body, k = 0; len > 0 && k < 2; k++) {
+			if (ofst < fb->span[k].size) {
+				size = fb->span[k].size - ofst < len ? fb->span[k].size - ofst : len;
+				memcpy((char *)fb->span[k].adr + ofst, data, size);
+				data += size;
+				len  -= size;
+				ofst  = 0;
+			} else {
+				ofst -= fb->span[k].size;
+			}
+		}
+	} else {
+		memcpy(fb->buf + ofst, data, len);
+	}
+}
+
+/*
+ * The first fragment of a mailbox send tells where its message will be, if
+ * there is room for it in the mailbox and no other fragment has come before.
+ */
+static void frag_direct(struct portslot_t *portslotp, struct frag_buf *fb, struct frag_t *frag)
+{
+	struct par_t *par;
+	long *a;
+
+	par = (void *)frag->data;
+	if (fb->count || par->mach != sizeof(long) || EXT(par->fun_ext_timed) != NET_RPC_EXT || (FUN(par->fun_ext_timed) != MBX_SEND && FUN(par->fun_ext_timed) != MBX_SEND_IF)) {
+		return;
+	}
+	fb->body = sizeof(struct par_t) - sizeof(long) + par->argsize;
+	a = par->a;
+	if (fb->body > FRAG_DATA || a[2] != frag->total - fb->body || a[2] <= 0) {
+		return;
+	}
+	if (!frag_mbx_call(portslotp, MBX_RESERVE_IF, a[0], a[2], (long)fb->span, 1)) {
+		fb->mbx = (MBX *)a[0];
+	}
+}
+
+/*
+ * Take a fragment, returning the whole request when it is complete, NULL
+ * otherwise, or when it has been completed directly in a mailbox.
+ */
+static struct par_t *frag_recv(struct portslot_t *portslotp, struct frag_t *frag, int len, struct sockaddr *addr)
+{
+	struct frag_buf *fb;
+	int ofst;
+
+	if (!(fb = portslotp->frag)) {
+		if (!(fb = portslotp->frag = kzalloc(sizeof(struct frag_buf), GFP_KERNEL))) {
+			return NULL;
+		}
+	}
+	if (frag->mach != NETRPC_FRAG || frag->owner != portslotp->owner) {
+		return NULL;
+	}
+	if (!frag->nfrags) {
+		if (frag->fragid == fb->fragid) {
+			frag_cancel(portslotp, fb);
+		}
+		return NULL;
+	}
+	if (frag->fragid == fb->done) {
+		frag_status(portslotp, fb, frag, 1, addr);
+		return NULL;
+	}
+	if (frag->nfrags < 0 || frag->nfrags > NETRPC_MAX_FRAGS || frag->seq < 0 || frag->seq >= frag->nfrags || frag->total <= 0 || frag->total > NETRPC_MAX_FRAGS*FRAG_DATA || frag->nfrags != (frag->total + FRAG_DATA - 1)/FRAG_DATA) {
+		return NULL;
+	}
+	if (frag->fragid == fb->fragid) {
+		if (frag->nfrags != fb->nfrags || frag->total != fb->total) {
+			return NULL;
+		}
+	} else {
+		frag_cancel(portslotp, fb);
+		if (frag->total > fb->size) {
+			vfree(fb->buf);
+			if (!(fb->buf = vmalloc(frag->total))) {
+				fb->size = 0;
+				return NULL;
+			}
+			fb->size = frag->total;
+		}
+		fb->fragid = frag->fragid;
+		fb->nfrags = frag->nfrags;
+		fb->total  = frag->total;
+		fb->count  = 0;
+		memset(fb->map, 0, sizeof(fb->map));
+	}
+	if (!FRAG_BIT(fb->map, frag->seq)) {
+		if ((ofst = frag->seq*FRAG_DATA) >= fb->total) {
+			return NULL;
+		}
+		if (len - (int)offsetof(struct frag_t, data) < (fb->total - ofst < FRAG_DATA ? fb->total - ofst : FRAG_DATA)) {
+			return NULL;
+		}
+		if (!frag->seq) {
+			frag_direct(portslotp, fb, frag);
+		}
+		frag_place(fb, ofst, frag->data, fb->total - ofst < FRAG_DATA ? fb->total - ofst : FRAG_DATA);
+		FRAG_SET_BIT(fb->map, frag->seq);
+		fb->count++;
+	}
+	if (fb->count == fb->nfrags) {
+		frag_status(portslotp, fb, frag, 1, addr);
+		fb->done   = fb->fragid;
+		fb->fragid = 0;
+		if (fb->mbx) {
+			struct reply_t arg = { 0, 0, 0, 0, ((struct par_t *)fb->buf)->reqid };
+			frag_mbx_call(portslotp, MBX_COMMIT, (long)fb->mbx, fb->total - fb->body, 0, 0);
+			fb->mbx = NULL;
+			port_sendto(portslotp, &arg, encode ? encode(portslotp, &arg, sizeof(struct reply_t), RPC_RTR) : sizeof(struct reply_t), addr);
+			return NULL;
+		}
+		return (struct par_t *)fb->buf;
+	}
+	if (frag->ack) {
+		frag_status(portslotp, fb, frag, 0, addr);
+	}
+	return NULL;
+}
+
+static void frag_free(struct portslot_t *portslotp)
+{
+	struct frag_buf *fb;
+	if ((fb = portslotp->frag)) {
+		if (fb->mbx) {
+			((int (*)(MBX *, int))rt_net_rpc_fun_ext[NET_RPC_EXT][MBX_COMMIT].fun)(fb->mbx, 0);
+		}
+		vfree(fb->buf);
+		kfree(fb);
+		portslotp->frag = NULL;
+	}
+}
+
+/*
+ * Requests are served in place, from the socket or local port ring slot,
+ * arguments coming from a machine with the same word size being used there
+ * too, without any argconv copy. Fragmented requests are served from their
+ * reassembly buffer, see frag_recv.
+ */
+static void soft_stub_fun(struct portslot_t *portslotp)
+{
+	struct sockaddr *addr, *from;
 	RT_TASK *task;
 	SEM *sem;
         struct par_t *par;
 	long wsize, w2size, sock;
 	long *ain;
 	long type;
+	int whole;
 
 	addr = (struct sockaddr *)&portslotp->addr;
 	sock = portslotp->socket[0];
 	sem  = &portslotp->sem;
-	ain = (par = (void *)msg)->a;
 	task = (RT_TASK *)portslotp->task;
 	sprintf(current->comm, "SFTSTB:%ld", sock);
 	
 recvrys:
 
 	while (soft_rt_fun_call(task, rt_sem_wait, sem) < RTE_LOWERR) {
-		wsize = soft_rt_recvfrom(sock, msg, MAX_MSG_SIZE, 0, addr, &w2size);
-		if (decode) {
-			decode(portslotp, msg, wsize, RPC_SRV);
-		}
-		if (portslotp->owner != par->owner)	{
-			unsigned long flags;
-			
-			flags = rt_spin_lock_irqsave(&recovery_lock);
-			recovery.msg[recovery.in].priority = par->priority;
-			recovery.msg[recovery.in].owner = par->owner;
-			recovery.msg[recovery.in].addr = *addr;
-			recovery.msg[recovery.in].hard = 0;
-			recovery.in = (recovery.in + 1) & MaxStubsMone;
-			rt_spin_unlock_irqrestore(flags, &recovery_lock);
-			rt_sem_signal(&portslot[0].sem);
-		} else {
-			int argsize; 
-			long a[par->argsize/sizeof(long) + 1];
-			if(par->priority >= 0 && par->priority < RT_SCHED_LINUX_PRIORITY) {
-				if ((wsize = par->priority) < task->priority) {
-					task->priority = wsize;
-					rtai_set_linux_task_priority(task->lnxtsk, task->lnxtsk->policy, wsize >= MAX_LINUX_RTPRIO ? MIN_LINUX_RTPRIO : MAX_LINUX_RTPRIO - wsize);
-				}
-				task->base_priority = par->base_priority;
+		while ((wsize = port_recv_peek(portslotp, (void **)&par, &from)) > 0) {
+			if (from) {
+				*addr = *from;
 			}
-			argsize = argconv(ain, a, par->mach, par->argsize, par->partypes);
-			type = par->type;
-			if (par->rsize) {
-				a[USP_RBF1(type) - 1] = (long)((char *)ain + par->argsize);
-			}
-			if (NEED_TO_W(type)) {
-				wsize = USP_WSZ1(type);
-				wsize = wsize ? a[wsize - 1] : par->mach; //sizeof(long);
-			} else {
-				wsize = 0;
+			if (decode) {
+				decode(portslotp, par, wsize, RPC_SRV);
 			}
-			if (NEED_TO_W2ND(type)) {
-				w2size = USP_WSZ2(type);
-				w2size = w2size ? a[w2size - 1] : par->mach; //sizeof(long);
-			} else {
-				w2size = 0;
+			if ((whole = par->mach < 0)) {
+				par = frag_recv(portslotp, (void *)par, wsize, addr);
+				port_recv_done(portslotp, from);
+				if (!par) {
+					continue;
+				}
+			} else if (portslotp->frag && portslotp->frag->fragid) {
+				frag_cancel(portslotp, portslotp->frag);
 			}
-			do {
-				struct msg_t { struct reply_t arg; char bufspace[wsize + w2size]; } arg;
-				arg.arg.myport = 0;
-				if (wsize > 0) {
-					arg.arg.wsize = wsize;
-					a[USP_WBF1(type) - 1] = (long)arg.arg.msg;
-					if ((USP_WBF1(type) - 1) == (USP_RBF1(type) - 1) && wsize == par->rsize) {
-						check_kuadr("soft_stub_fun", arg.arg.msg, (char *)ain + par->argsize);
-						memcpy(arg.arg.msg, (char *)ain + par->argsize, wsize);
-						a[USP_RBF1(type) - 1] = (long)(arg.arg.msg);
+			ain = par->a;
+			if (portslotp->owner != par->owner)	{
+				unsigned long flags;
+			
+				flags = rt_spin_lock_irqsave(&recovery_lock);
+				recovery.msg[recovery.in].priority = par->priority;
+				recovery.msg[recovery.in].owner = par->owner;
+				recovery.msg[recovery.in].addr = *addr;
+				recovery.msg[recovery.in].hard = 0;
+				recovery.in = (recovery.in + 1) & MaxStubsMone;
+				rt_spin_unlock_irqrestore(flags, &recovery_lock);
+				rt_sem_signal(&portslot[0].sem);
+			} else {
+				int argsize; 
+				long abuf[par->mach == sizeof(long) ? 1 : par->argsize/sizeof(long) + 1], *a;
+				if(par->priority >= 0 && par->priority < RT_SCHED_LINUX_PRIORITY) {
+					if ((wsize = par->priority) < task->priority) {
+						task->priority = wsize;
+						rtai_set_linux_task_priority(task->lnxtsk, task->lnxtsk->policy, wsize >= MAX_LINUX_RTPRIO ? MIN_LINUX_RTPRIO : MAX_LINUX_RTPRIO - wsize);
 					}
+					task->base_priority = par->base_priority;
+				}
+				if (par->mach == sizeof(long)) {
+					a = ain;
+					argsize = par->argsize;
 				} else {
-					arg.arg.wsize = 0;
+					a = abuf;
+					argsize = argconv(ain, a, par->mach, par->argsize, par->partypes);
 				}
-				if (w2size > 0) {
-					arg.arg.w2size = w2size;
-					a[USP_WBF2(type) - 1] = (long)(arg.arg.msg + arg.arg.wsize);
+				type = par->type;
+				if (par->rsize) {
+					a[USP_RBF1(type) - 1] = (long)((char *)ain + par->argsize);
+				}
+				if (NEED_TO_W(type)) {
+					wsize = USP_WSZ1(type);
+					wsize = wsize ? a[wsize - 1] : par->mach; //sizeof(long);
 				} else {
-					arg.arg.w2size = 0;
+					wsize = 0;
+				}
+				if (NEED_TO_W2ND(type)) {
+					w2size = USP_WSZ2(type);
+					w2size = w2size ? a[w2size - 1] : par->mach; //sizeof(long);
+				} else {
+					w2size = 0;
 				}
+				do {
+					struct msg_t { struct reply_t arg; char bufspace[wsize + w2size]; } arg;
+					arg.arg.myport = 0;
+					arg.arg.reqid = par->reqid;
+					if (wsize > 0) {
+						arg.arg.wsize = wsize;
+						a[USP_WBF1(type) - 1] = (long)arg.arg.msg;
+						if ((USP_WBF1(type) - 1) == (USP_RBF1(type) - 1) && wsize == par->rsize) {
+							check_kuadr("soft_stub_fun", arg.arg.msg, (char *)ain + par->argsize);
+							memcpy(arg.arg.msg, (char *)ain + par->argsize, wsize);
+							a[USP_RBF1(type) - 1] = (long)(arg.arg.msg);
+						}
+					} else {
+						arg.arg.wsize = 0;
+					}
+					if (w2size > 0) {
+						arg.arg.w2size = w2size;
+						a[USP_WBF2(type) - 1] = (long)(arg.arg.msg + arg.arg.wsize);
+					} else {
+						arg.arg.w2size = 0;
+					}
 #ifndef NETRPC_ALIGN_RTIME
-				if ((wsize = TIMED(par->fun_ext_timed) - 1) >= 0) {
+					if ((wsize = TIMED(par->fun_ext_timed) - 1) >= 0) {
 #else
-				if ((wsize = TIMED(par->fun_ext_timed)) > 0) {
-					wsize += (NETRPC_ALIGN_RTIME(wsize) - 1);
+					if ((wsize = TIMED(par->fun_ext_timed)) > 0) {
+						wsize += (NETRPC_ALIGN_RTIME(wsize) - 1);
 #endif
-					*((long long *)(a + wsize)) = nano2count(*((long long *)(a + wsize)));
-				}
-				arg.arg.retval = soft_rt_genfun_call(task, rt_net_rpc_fun_ext[EXT(par->fun_ext_timed)][FUN(par->fun_ext_timed)].fun, a, argsize);
-				soft_rt_sendto(sock, &arg, encode ? encode(portslotp, &arg, sizeof(struct msg_t), RPC_RTR) : sizeof(struct msg_t), 0, addr, ADRSZ);
-			} while (0);
+						*((long long *)(a + wsize)) = nano2count(*((long long *)(a + wsize)));
+					}
+					arg.arg.retval = soft_rt_genfun_call(task, rt_net_rpc_fun_ext[EXT(par->fun_ext_timed)][FUN(par->fun_ext_timed)].fun, a, argsize);
+					port_sendto(portslotp, &arg, encode ? encode(portslotp, &arg, sizeof(struct msg_t), RPC_RTR) : sizeof(struct msg_t), addr);
+				} while (0);
+			}
+			if (!whole) {
+				port_recv_done(portslotp, from);
+			}
 		}
 	}
 	if (portslotp->recovered) {
@@ -580,7 +1259,8 @@ recvrys:
 		portslotp->recovered = 0;
 		arg.myport = sock + BASEPORT;
 		arg.retval = portslotp->owner;
-		soft_rt_sendto(sock, &arg, encode ? encode(portslotp, &arg, sizeof(struct reply_t), RPC_RTR) : sizeof(struct reply_t), 0, addr, ADRSZ);
+		arg.reqid = 0;
+		port_sendto(portslotp, &arg, encode ? encode(portslotp, &arg, sizeof(struct reply_t), RPC_RTR) : sizeof(struct reply_t), addr);
 		goto recvrys;
 	}
 }
@@ -652,6 +1332,7 @@ recvryh:
 			do {
 				struct msg_t { struct reply_t arg; char bufspace[wsize + w2size]; } arg;
 				arg.arg.myport = 0;
+				arg.arg.reqid = par->reqid;
 				if (wsize > 0) {
 					arg.arg.wsize = wsize;
 					if ((USP_WBF1(type) - 1) == (USP_RBF1(type) - 1) && wsize == par->rsize) {
@@ -687,6 +1368,7 @@ recvryh:
 		portslotp->recovered = 0;
 		arg.myport = sock + BASEPORT;
 		arg.retval = portslotp->owner;
+		arg.reqid = 0;
 		hard_rt_sendto(sock, &arg, encode ? encode(portslotp, &arg, sizeof(struct reply_t), RPC_RTR) : sizeof(struct reply_t), 0, addr, ADRSZ);
 		goto recvryh;
 	}
@@ -748,6 +1430,8 @@ static void port_server_fun(RT_TASK *port_server)
 				portslot[msg.port].hard = MSG_HARD;
 			} else {
 				portslot[msg.port].hard = MSG_SOFT;
+				soft_rt_socket_affinity(portslot[msg.port].socket[0], task->runnable_on_cpus);
+				lo_alloc(portslot + msg.port, addr);
 			}
 			portslot[msg.port].sem.count = 0;
 			portslot[msg.port].sem.queue.prev = portslot[msg.port].sem.queue.next = &portslot[msg.port].sem.queue;
@@ -788,6 +1472,7 @@ RTAI_SYSCALL_MODE int rt_send_req_rel_port(unsigned long node, int op, unsigned
 	portslotp->addr.sin_addr.s_addr = node;
 	task = _rt_whoami();
 	if (op) {
+		lo_detach(portslot + op);
 		msg.op = ntohs(portslot[op].addr.sin_port);
 		id = portslot[op].name;
 		hard = portslot[op].hard;
@@ -818,11 +1503,13 @@ RTAI_SYSCALL_MODE int rt_send_req_rel_port(unsigned long node, int op, unsigned
 		if (msg.port > 0) {
 			if (op) {
 				portslot[op].task = 0;
+				portslot[op].window = 1;
 				gvb_portslot(portslot + op);
 				gvb_portslot(portslotp);
 				return op;
 			} else {
 				check_portslot(node, msg.port, &portslotp);
+				soft_rt_socket_affinity(portslotp->socket[0], task->runnable_on_cpus);
 				portslotp->sem.count = 0;
 				portslotp->sem.queue.prev = portslotp->sem.queue.next = &portslotp->sem.queue;
 				portslotp->hard = msg.hard;
@@ -832,6 +1519,9 @@ RTAI_SYSCALL_MODE int rt_send_req_rel_port(unsigned long node, int op, unsigned
 				portslotp->mbx  = mbx;
 				portslotp->recovered = 1;
 				portslotp->addr.sin_addr.s_addr = msg.rem_node;	
+				if (!msg.hard) {
+					lo_attach(portslotp, node, msg.port - BASEPORT);
+				}
 				if (msg.chkspare == 4) {
 					return (portslotp->indx << PORT_SHF);
 				} else {
@@ -869,10 +1559,15 @@ RTAI_SYSCALL_MODE int rt_rel_stub(unsigned long long owner)
 	}
 }
 
+static inline int pipe_outstanding(struct portslot_t *portslotp);
+
 RTAI_SYSCALL_MODE int rt_waiting_return(unsigned long node, int port)
 {
 	struct portslot_t *portslotp;
 	portslotp = portslot + (abs(port) >> PORT_SHF);
+	if (portslotp->window > 1) {
+		return pipe_outstanding(portslotp);
+	}
 	return portslotp->task < 0 && !portslotp->sem.count;
 }
 
@@ -945,6 +1640,140 @@ static void mbx_send_if(MBX *mbx, void *msg, int msg_size)
 	rt_global_restore_flags(flags);
 }
 
+/*
+ * Pipelined ports, see rt_set_netrpc_window. Requests are tagged with an id,
+ * echoed by the stub in its reply and kept in the port table till the reply
+ * arrives. Replies to asynchronous calls are put in the port mailbox by the
+ * receiver, as soon as they arrive, replies to synchronous calls are left to
+ * their caller, unmatched replies, i.e. of timed out calls, are dropped.
+ * Only the port owner inserts ids in the table, the receivers only clear
+ * them.
+ */
+
+static inline int pipe_outstanding(struct portslot_t *portslotp)
+{
+	int i, n;
+	for (n = i = 0; i < portslotp->window; i++) {
+		if (portslotp->reqids[i]) {
+			n++;
+		}
+	}
+	return n;
+}
+
+static inline unsigned long pipe_new_reqid(struct portslot_t *portslotp)
+{
+	if (!++portslotp->reqid) {
+		portslotp->reqid = 1;
+	}
+	return portslotp->reqid;
+}
+
+static inline unsigned long pipe_insert(struct portslot_t *portslotp)
+{
+	int i;
+	for (i = 0; i < portslotp->window; i++) {
+		if (!portslotp->reqids[i]) {
+			return portslotp->reqids[i] = pipe_new_reqid(portslotp);
+		}
+	}
+	return 0;
+}
+
+/*
+ * It can be called by the receiver and the port owner at the same time,
+ * the first one in does the job, for all the others too.
+ */
+static void pipe_replies(struct portslot_t *portslotp)
+{
+	char *msg = portslotp->msgs->pipe;
+	struct reply_t *reply;
+	struct sockaddr *from;
+	unsigned long reqid;
+	int calls, rsize, i;
+
+	if (atomic_inc_return(&portslotp->pipe_calls) != 1) {
+		return;
+	}
+	do {
+		calls = atomic_read(&portslotp->pipe_calls);
+		while ((rsize = port_recv_peek(portslotp, (void **)&reply, &from)) > 0) {
+			if (decode) {
+				memcpy(msg, reply, rsize);
+				decode(portslotp, reply = (void *)msg, rsize, RPC_RCV);
+			}
+			if (reply->wsize < 0) {
+				if (frag_take(portslotp, (void *)reply)) {
+					rt_sem_signal(&portslotp->sem);
+				}
+				port_recv_done(portslotp, from);
+				continue;
+			}
+			reqid = reply->reqid;
+			if (reply->myport || (reqid && reqid == portslotp->sync_reqid)) {
+				port_recv_leave(portslotp, from);
+				rt_sem_signal(&portslotp->sem);
+				break;
+			}
+			for (i = 0; reqid && i < portslotp->window; i++) {
+				if (portslotp->reqids[i] == reqid) {
+					mbx_send_if(portslotp->mbx, reply, offsetof(struct reply_t, msg) + reply->wsize + reply->w2size);
+					portslotp->reqids[i] = 0;
+					break;
+				}
+			}
+			port_recv_done(portslotp, from);
+			if (portslotp->draining && !pipe_outstanding(portslotp)) {
+				portslotp->draining = 0;
+				rt_sem_signal(&portslotp->sem);
+			}
+		}
+	} while (atomic_sub_return(calls, &portslotp->pipe_calls) > 0);
+}
+
+/* Wait for the replies of all the outstanding requests of a pipelined port. */
+static int pipe_drain(struct portslot_t *portslotp)
+{
+	portslotp->sem.count = 0;
+	portslotp->draining = 1;
+	pipe_replies(portslotp);
+	while (pipe_outstanding(portslotp)) {
+		if (portslotp->timeout) {
+			if (rt_sem_wait_timed(&portslotp->sem, portslotp->timeout) == RTE_TIMOUT) {
+				portslotp->draining = 0;
+				return RTE_NETIMOUT;
+			}
+		} else {
+			rt_sem_wait(&portslotp->sem);
+		}
+	}
+	portslotp->draining = 0;
+	return 1;
+}
+
+/*
+ * Allow up to window outstanding requests on a soft client port. With
+ * a window larger than 1 asynchronous calls, i.e. those using -port, return
+ * the id of their request, 0 if the window is full, and their replies can
+ * be collected from the port mailbox with rt_get_net_rpc_ret_id. A window
+ * equal to 1, the default, gives back the usual single request ports.
+ */
+RTAI_SYSCALL_MODE int rt_set_netrpc_window(int port, int window)
+{
+	struct portslot_t *portslotp;
+
+	port = abs(port) >> PORT_SHF;
+	if (port < MaxStubs || port >= MaxSocks || window < 1 || window > NETRPC_MAX_WINDOW || (portslotp = portslot + port)->hard) {
+		return -EINVAL;
+	}
+	if (portslotp->window > 1 ? pipe_outstanding(portslotp) : portslotp->task < 0) {
+		return -EBUSY;
+	}
+	memset((void *)portslotp->reqids, 0, sizeof(portslotp->reqids));
+	portslotp->window = window;
+	return 0;
+}
+
 #define RETURN_ERR(err) \
 	do { \
 		union { long long ll; long l; } retval; \
@@ -958,10 +1787,18 @@ RTAI_SYSCALL_MODE long long _rt_net_rpc(long fun_ext_timed, long type, void *arg
 	struct reply_t *reply;
 	long rsize, port;
 	struct portslot_t *portslotp;
+	unsigned long reqid = 0;
+	int fragmented;
 
 	if ((port = PORT(fun_ext_timed)) > 0) {
 		port >>= PORT_SHF;
-		if ((portslotp = portslot + port)->task < 0) {
+		if ((portslotp = portslot + port)->window > 1) {
+			if (FUN(fun_ext_timed) == SYNC_NET_RPC) {
+				RETURN_ERR(pipe_drain(portslotp));
+			}
+			portslotp->sem.count = 0;
+			portslotp->sync_reqid = reqid = pipe_new_reqid(portslotp);
+		} else if (portslotp->task < 0) {
 			long i;
 			struct sockaddr addr;
 			
@@ -971,7 +1808,7 @@ RTAI_SYSCALL_MODE long long _rt_net_rpc(long fun_ext_timed, long type, void *arg
 			} else {
 				rt_sem_wait(&portslotp->sem);
 			}
-			if ((rsize = portslotp->hard ? hard_rt_recvfrom(portslotp->socket[1], msg, MAX_MSG_SIZE, 0, &addr, (void *)&i) : soft_rt_recvfrom(portslotp->socket[0], msg, MAX_MSG_SIZE, 0, &addr, &i))) {
+			if ((rsize = portslotp->hard ? hard_rt_recvfrom(portslotp->socket[1], msg, MAX_MSG_SIZE, 0, &addr, (void *)&i) : port_recvfrom(portslotp, msg, MAX_MSG_SIZE, &addr, &i))) {
 				if (decode) {
 					rsize = decode(portslotp, msg, rsize, RPC_RCV);
 				}
@@ -993,14 +1830,22 @@ RTAI_SYSCALL_MODE long long _rt_net_rpc(long fun_ext_timed, long type, void *arg
 		portslotp->msg = msg;
 	} else {
 		port = -(abs(port) >> PORT_SHF);
-		if ((portslotp = portslot - port)->task < 0) {
+		if ((portslotp = portslot - port)->window > 1) {
+			if (FUN(fun_ext_timed) == SYNC_NET_RPC) {
+				RETURN_ERR(1);
+			}
+			pipe_replies(portslotp);
+			if (!(reqid = pipe_insert(portslotp))) {
+				return 0;
+			}
+		} else if (portslotp->task < 0) {
 			if (!rt_sem_wait_if(&portslotp->sem)) {
 				return 0;
 			} else {
 				long i;
 				struct sockaddr addr;
 				
-				if ((rsize = portslotp->hard ? hard_rt_recvfrom(portslotp->socket[1], msg, MAX_MSG_SIZE, 0, &addr, (void *)&i) : soft_rt_recvfrom(portslotp->socket[0], msg, MAX_MSG_SIZE, 0, &addr, &i))) {
+				if ((rsize = portslotp->hard ? hard_rt_recvfrom(portslotp->socket[1], msg, MAX_MSG_SIZE, 0, &addr, (void *)&i) : port_recvfrom(portslotp, msg, MAX_MSG_SIZE, &addr, &i))) {
 					if (decode) {
 						rsize = decode(portslotp, msg, rsize, RPC_RCV);
 					}
@@ -1039,6 +1884,12 @@ RTAI_SYSCALL_MODE long long _rt_net_rpc(long fun_ext_timed, long type, void *arg
 	} else {
 		rsize = 0;
 	}
+	if ((fragmented = sizeof(struct par_t) - sizeof(long) + argsize + rsize > MAX_MSG_SIZE)) {
+		if (portslotp->hard || sizeof(struct par_t) - sizeof(long) + argsize + rsize > NETRPC_MAX_FRAGS*FRAG_DATA) {
+			frag_abort(portslotp, port, reqid);
+			RETURN_ERR(-EMSGSIZE);
+		}
+	}
 	do {
 		struct par_t *arg;
 		RT_TASK *task;
@@ -1052,12 +1903,27 @@ RTAI_SYSCALL_MODE long long _rt_net_rpc(long fun_ext_timed, long type, void *arg
 		arg->type = type;
 		arg->owner = portslotp->owner;
 		arg->partypes = partypes;
+		arg->reqid = reqid;
 		if (space) {
 			check_kuadr("1 _rt_net_rpc", arg->a, args);
 			memcpy(arg->a, args, argsize);
 		} else {
 			rt_copy_from_user(arg->a, args, argsize);
 		}
+		if (fragmented) {
+			void *rbuf;
+			if (space) {
+				rbuf = (void *)((long *)args + USP_RBF1(type) - 1)[0];
+			} else {
+				rt_get_user(rbuf, &((long *)args + USP_RBF1(type) - 1)[0]);
+			}
+			arg->mach = sizeof(long);
+			if (frag_request(portslotp, msg, sizeof(struct par_t) - sizeof(long) + argsize, rbuf, rsize, space)) {
+				frag_abort(portslotp, port, reqid);
+				RETURN_ERR(-RTE_NETIMOUT);
+			}
+			break;
+		}
 		if (rsize > 0) {
 			if (space) {
 				check_kuadr("2 _rt_net_rpc", (char *)arg->a + argsize, (void *)((long *)args + USP_RBF1(type) - 1)[0]);
@@ -1076,21 +1942,33 @@ RTAI_SYSCALL_MODE long long _rt_net_rpc(long fun_ext_timed, long type, void *arg
 		if (portslotp->hard) {
 			hard_rt_sendto(portslotp->socket[1], msg, rsize, 0, (struct sockaddr *)&portslotp->addr, ADRSZ);
 		} else  {
-			soft_rt_sendto(portslotp->socket[0], msg, rsize, 0, (struct sockaddr *)&portslotp->addr, ADRSZ);
+			port_sendto(portslotp, msg, rsize, (struct sockaddr *)&portslotp->addr);
 		}
 	} while (0);
 	if (port > 0) {
 		struct sockaddr addr;
 
-		if (portslotp->timeout) {
-			if(rt_sem_wait_timed(&portslotp->sem,portslotp->timeout) == RTE_TIMOUT)
-				RETURN_ERR(-RTE_NETIMOUT);
-		} else {
-			rt_sem_wait(&portslotp->sem);
-		}
-		rsize = portslotp->hard ? hard_rt_recvfrom(portslotp->socket[1], msg, MAX_MSG_SIZE, 0, &addr, (void *)&port) : soft_rt_recvfrom(portslotp->socket[0], msg, MAX_MSG_SIZE, 0, &addr, &port);
-		if (decode) {
-			decode(portslotp, portslotp->msg, rsize, RPC_RCV);
+		rsize = 0;
+		do {
+			if (rsize <= 0) {
+				if (portslotp->timeout) {
+					if(rt_sem_wait_timed(&portslotp->sem,portslotp->timeout) == RTE_TIMOUT) {
+						portslotp->sync_reqid = 0;
+						RETURN_ERR(-RTE_NETIMOUT);
+					}
+				} else {
+					rt_sem_wait(&portslotp->sem);
+				}
+			}
+			rsize = portslotp->hard ? hard_rt_recvfrom(portslotp->socket[1], msg, MAX_MSG_SIZE, 0, &addr, (void *)&port) : port_recvfrom(portslotp, msg, MAX_MSG_SIZE, &addr, &port);
+			if (decode) {
+				decode(portslotp, portslotp->msg, rsize, RPC_RCV);
+			}
+		// late statuses of a fragmented request are not replies
+		} while (fragmented && (rsize <= 0 || ((struct reply_t *)msg)->wsize < 0));
+		if (reqid) {
+			portslotp->sync_reqid = 0;
+			pipe_replies(portslotp);
 		}
 		if((reply = (void *)msg)->myport) {
 			if (reply->myport < 0) {
@@ -1126,10 +2004,13 @@ RTAI_SYSCALL_MODE long long _rt_net_rpc(long fun_ext_timed, long type, void *arg
 			return reply->retval;
 		}
 	}
+	if (reqid) {
+		RETURN_ERR(reqid);
+	}
 	return 0;
 }
 
-int rt_get_net_rpc_ret(MBX *mbx, unsigned long long *retval, void *msg1, int *msglen1, void *msg2, int *msglen2, RTIME timeout, int type)
+int rt_get_net_rpc_ret_id(MBX *mbx, unsigned long *reqid, unsigned long long *retval, void *msg1, int *msglen1, void *msg2, int *msglen2, RTIME timeout, int type)
 {
 	struct reply_t reply;
 	int ret;
@@ -1137,6 +2018,9 @@ int rt_get_net_rpc_ret(MBX *mbx, unsigned long long *retval, void *msg1, int *ms
 	if ((ret = ((int (*)(MBX *, ...))rt_net_rpc_fun_ext[NET_RPC_EXT][type].fun)(mbx, &reply, offsetof(struct reply_t, msg), timeout))) {
 		return ret;
 	}
+	if (reqid) {
+		*reqid = reply.reqid;
+	}
 	*retval = reply.retval;
 	if (reply.wsize) {
 		if (*msglen1 > reply.wsize) {
@@ -1157,6 +2041,11 @@ int rt_get_net_rpc_ret(MBX *mbx, unsigned long long *retval, void *msg1, int *ms
 	return 0;
 }
 
+int rt_get_net_rpc_ret(MBX *mbx, unsigned long long *retval, void *msg1, int *msglen1, void *msg2, int *msglen2, RTIME timeout, int type)
+{
+	return rt_get_net_rpc_ret_id(mbx, NULL, retval, msg1, msglen1, msg2, msglen2, timeout, type);
+}
+
 RTAI_SYSCALL_MODE unsigned long ddn2nl(const char *ddn)
 {
 	int p, n, c;
@@ -1180,7 +2069,7 @@ RTAI_SYSCALL_MODE unsigned long ddn2nl(const char *ddn)
 }
 
 static void send_thread(void);
-static void recv_thread(void);
+static void recv_thread(long k);
 
 RTAI_SYSCALL_MODE unsigned long rt_set_this_node(const char *ddn, unsigned long node, int hard)
 {
@@ -1213,6 +2102,7 @@ EXPORT_SYMBOL(rt_poll_netrpc);
 struct rt_native_fun_entry rt_netrpc_entries[] = {
 	{ { 1, _rt_net_rpc           },  NETRPC },
 	{ { 0, rt_set_netrpc_timeout },	 SET_NETRPC_TIMEOUT },
+	{ { 0, rt_set_netrpc_window  },	 SET_NETRPC_WINDOW },
 	{ { 1, rt_send_req_rel_port  },	 SEND_REQ_REL_PORT },
 	{ { 0, ddn2nl                },	 DDN2NL },
 	{ { 0, rt_set_this_node      },	 SET_THIS_NODE },
@@ -1240,6 +2130,8 @@ void mod_timer_hdlr(void)
 
 static struct sock_t *socks;
 
+static int RecvDepthMone;
+
 int soft_rt_socket(int domain, int type, int protocol)
 {
 	int i;
@@ -1274,8 +2166,15 @@ int soft_rt_socket_callback(int sock, int (*func)(int sock, void *arg), void *ar
 	return -1;
 }
 
+/*
+ * Datagrams to be sent are copied in the slots of the sysrq ring, so that
+ * a port can queue more of them before the send thread gets them. A slot
+ * is made valid by setting its sock, after its content has been written.
+ */
+struct sock_smsg { volatile int sock; int len; struct sockaddr addr; char msg[MAX_MSG_SIZE]; };
+
 static int MaxSockSrq;
-static struct { int in, out, *sockindx; } sysrq;
+static struct { int in, out; struct sock_smsg *smsg; } sysrq;
 static DEFINE_SPINLOCK(sysrq_lock);
 
 static SEM mtx;
@@ -1283,41 +2182,112 @@ static SEM mtx;
 int soft_rt_sendto(int sock, const void *msg, int msglen, unsigned int sflags, struct sockaddr *to, int tolen)
 {
 	unsigned long flags;
+	struct sock_smsg *smsg;
 	if (sock >= 0 && sock < MaxSocks) {
 		if (msglen > MAX_MSG_SIZE) {
 			msglen = MAX_MSG_SIZE;
 		}
-		memcpy(socks[sock].msg, msg, socks[sock].tosend = msglen);
-		memcpy(&socks[sock].addr, to, tolen);
 		flags = rt_spin_lock_irqsave(&sysrq_lock);
-		sysrq.sockindx[sysrq.in] = sock;
+		if (((sysrq.in + 1) & MaxSockSrq) == sysrq.out) {
+			rt_spin_unlock_irqrestore(flags, &sysrq_lock);
+			return -1;
+		}
+		smsg = sysrq.smsg + sysrq.in;
 	        sysrq.in = (sysrq.in + 1) & MaxSockSrq;
 		rt_spin_unlock_irqrestore(flags, &sysrq_lock);
+		memcpy(smsg->msg, msg, smsg->len = msglen);
+		memcpy(&smsg->addr, to, tolen);
+		smp_wmb();
+		smsg->sock = sock;
 		rt_sem_signal(&mtx);
 		return msglen;
 	}
 	return -1;
 }
 
+/*
+ * Received datagrams are consumed in arrival order from the socket ring,
+ * 0 being returned when it is empty.
+ */
 int soft_rt_recvfrom(int sock, void *msg, int msglen, unsigned int flags, struct sockaddr *from, long *fromlen)
 {
+	struct sock_rmsg *rmsg;
 	if (sock >= 0 && sock < MaxSocks) {
-		if (msglen > socks[sock].recvd) {
-			msglen = socks[sock].recvd;
+		if (socks[sock].rout == socks[sock].rin) {
+			return 0;
 		}
-		memcpy(msg, socks[sock].msg, msglen);
+		smp_rmb();
+		rmsg = socks[sock].rmsg + (socks[sock].rout & RecvDepthMone);
+		if (msglen > rmsg->len) {
+			msglen = rmsg->len;
+		}
+		memcpy(msg, rmsg->msg, msglen);
 		if (from && fromlen) {
-			memcpy(from, &socks[sock].addr, socks[sock].addrlen);
-			*fromlen = socks[sock].addrlen;
+			memcpy(from, &rmsg->addr, rmsg->addrlen);
+			*fromlen = rmsg->addrlen;
 		}
+		smp_mb();
+		socks[sock].rout++;
 		return msglen;
 	}
 	return -1;
 }
 
+/*
+ * In place consumption of the oldest received datagram: soft_rt_recv_peek
+ * returns its length and where it and its sender address are, without any
+ * copy, soft_rt_recv_done releases it afterward.
+ */
+int soft_rt_recv_peek(int sock, void **msg, struct sockaddr **from)
+{
+	struct sock_rmsg *rmsg;
+	if (sock >= 0 && sock < MaxSocks) {
+		if (socks[sock].rout == socks[sock].rin) {
+			return 0;
+		}
+		smp_rmb();
+		rmsg = socks[sock].rmsg + (socks[sock].rout & RecvDepthMone);
+		*msg = rmsg->msg;
+		if (from) {
+			*from = &rmsg->addr;
+		}
+		return rmsg->len;
+	}
+	return -1;
+}
+
+void soft_rt_recv_done(int sock)
+{
+	if (sock >= 0 && sock < MaxSocks && socks[sock].rout != socks[sock].rin) {
+		smp_mb();
+		socks[sock].rout++;
+	}
+}
+
+static int nrcvrs;
+static volatile unsigned long shard_gen;
+
+/*
+ * Receivers are pinned one per CPU, a socket is better served by the one
+ * on the CPU of the task consuming its datagrams, so that the callback
+ * wakes it up locally. The move is seen by the receivers after their
+ * current poll, till then the previous receiver goes on serving it.
+ */
+int soft_rt_socket_affinity(int sock, int cpu)
+{
+	if (sock >= 0 && sock < MaxSocks && cpu >= 0) {
+		socks[sock].rcvr = cpu % nrcvrs;
+		smp_wmb();
+		shard_gen++;
+		return 0;
+	}
+	return -1;
+}
+
 #include <linux/unistd.h>
 #include <linux/poll.h>
 #include <linux/net.h>
+#include <linux/vmalloc.h>
 
 #define SYSCALL_BGN() \
 	do { int retval; mm_segment_t svdfs = get_fs(); set_fs(KERNEL_DS)
@@ -1377,6 +2347,24 @@ static inline int krecvfrom(int fd, void *ubuf, size_t len, unsigned flags, stru
 	return ksocketcall(SYS_RECVFROM, &args);
 }
 
+#if defined(SYS_RECVMMSG) && defined(SYS_SENDMMSG)
+
+#define KMMSG_SYSCALLS
+
+static inline int ksendmmsg(int fd, struct mmsghdr *mmsg, unsigned vlen, unsigned flags)
+{
+	struct { int fd; struct mmsghdr *mmsg; unsigned vlen; unsigned flags; } args = { fd, mmsg, vlen, flags };
+	return ksocketcall(SYS_SENDMMSG, &args);
+}
+
+static inline int krecvmmsg(int fd, struct mmsghdr *mmsg, unsigned vlen, unsigned flags, struct timespec *timeout)
+{
+	struct { int fd; struct mmsghdr *mmsg; unsigned vlen; unsigned flags; struct timespec *timeout; } args = { fd, mmsg, vlen, flags, timeout };
+	return ksocketcall(SYS_RECVMMSG, &args);
+}
+
+#endif
+
 #else  // 64 bits
 
 //static _syscall3(int, socket, int, family, int, type, int, protocol)
@@ -1415,8 +2403,58 @@ static inline int krecvfrom(int fd, void *ubuf, size_t len, unsigned flags, stru
 	SYSCALL_END();
 }
 
+#if defined(__NR_recvmmsg) && defined(__NR_sendmmsg)
+
+#define KMMSG_SYSCALLS
+
+//static _syscall4(int, sendmmsg, int, fd, struct mmsghdr *, mmsg, unsigned, vlen, unsigned, flags)
+static inline int ksendmmsg(int fd, struct mmsghdr *mmsg, unsigned vlen, unsigned flags)
+{
+	SYSCALL_BGN();
+	retval = ((int (*)(int, struct mmsghdr *, unsigned, unsigned))sys_call_table[__NR_sendmmsg])(fd, mmsg, vlen, flags);
+	SYSCALL_END();
+}
+
+//static _syscall5(int, recvmmsg, int, fd, struct mmsghdr *, mmsg, unsigned, vlen, unsigned, flags, struct timespec *, timeout)
+static inline int krecvmmsg(int fd, struct mmsghdr *mmsg, unsigned vlen, unsigned flags, struct timespec *timeout)
+{
+	SYSCALL_BGN();
+	retval = ((int (*)(int, struct mmsghdr *, unsigned, unsigned, struct timespec *))sys_call_table[__NR_recvmmsg])(fd, mmsg, vlen, flags, timeout);
+	SYSCALL_END();
+}
+
+#endif
+
 #endif  // 32 or 64 bits
 
+#ifndef KMMSG_SYSCALLS  // no multiple messages calls, one by one then
+
+static inline int ksendmmsg(int fd, struct mmsghdr *mmsg, unsigned vlen, unsigned flags)
+{
+	int i, len;
+	for (i = 0; i < vlen; i++) {
+		if ((len = ksendto(fd, mmsg[i].msg_hdr.msg_iov->iov_base, mmsg[i].msg_hdr.msg_iov->iov_len, flags, mmsg[i].msg_hdr.msg_name, mmsg[i].msg_hdr.msg_namelen)) < 0) {
+			return i ? i : len;
+		}
+		mmsg[i].msg_len = len;
+	}
+	return i;
+}
+
+static inline int krecvmmsg(int fd, struct mmsghdr *mmsg, unsigned vlen, unsigned flags, struct timespec *timeout)
+{
+	int i, len;
+	for (i = 0; i < vlen; i++) {
+		if ((len = krecvfrom(fd, mmsg[i].msg_hdr.msg_iov->iov_base, mmsg[i].msg_hdr.msg_iov->iov_len, flags, mmsg[i].msg_hdr.msg_name, &mmsg[i].msg_hdr.msg_namelen)) < 0) {
+			return i ? i : len;
+		}
+		mmsg[i].msg_len = len;
+	}
+	return i;
+}
+
+#endif
+
 static inline int ksend(int fd, void *buff, size_t len, unsigned flags)
 {
         return ksendto(fd, buff, len, flags, NULL, 0);
@@ -1429,27 +2467,67 @@ static inline int krecv(int fd, void *ubuf, size_t size, unsigned flags)
 
 static unsigned long end_softrtnet;
 
-static RT_TASK *send_task, *recv_task;
+static RT_TASK *send_task;
+
+/*
+ * Sysrq slots queued in a row for the same socket are sent by a single
+ * ksendmmsg, up to NETRPC_MMSG_BATCH of them.
+ */
+static struct mmsghdr send_mmsg[NETRPC_MMSG_BATCH];
+static struct iovec send_iov[NETRPC_MMSG_BATCH];
 
 static void send_thread(void)
 {
-	int i;
+	struct sock_smsg *smsg;
+	int sock, out, n;
 
 	sigfillset(&current->blocked);
 	send_task = rt_thread_init(nam2num("SNDSRV"), 95, 0, SCHED_FIFO, 0xF);
 	while (!end_softrtnet) {
 		soft_rt_fun_call(send_task, rt_sem_wait, &mtx);
-		while (sysrq.out != sysrq.in) {
-			i = sysrq.sockindx[sysrq.out];
-			ksendto(socks[i].sock, socks[i].msg, socks[i].tosend, MSG_DONTWAIT, &socks[i].addr, ADRSZ);
-			sysrq.out = (sysrq.out + 1) & MaxSockSrq;
+		while (sysrq.out != sysrq.in && (sock = sysrq.smsg[sysrq.out].sock) >= 0) {
+			out = sysrq.out;
+			n = 0;
+			do {
+				smp_rmb();
+				smsg = sysrq.smsg + out;
+				send_iov[n].iov_base = smsg->msg;
+				send_iov[n].iov_len  = smsg->len;
+				send_mmsg[n].msg_hdr.msg_name    = &smsg->addr;
+				send_mmsg[n].msg_hdr.msg_namelen = ADRSZ;
+				send_mmsg[n].msg_hdr.msg_iov     = &send_iov[n];
+				send_mmsg[n].msg_hdr.msg_iovlen  = 1;
+				out = (out + 1) & MaxSockSrq;
+			} while (++n < NETRPC_MMSG_BATCH && out != sysrq.in && sysrq.smsg[out].sock == sock);
+			ksendmmsg(socks[sock].sock, send_mmsg, n, MSG_DONTWAIT);
+			do {
+				sysrq.smsg[sysrq.out].sock = -1;
+				smp_wmb();
+				sysrq.out = (sysrq.out + 1) & MaxSockSrq;
+			} while (--n);
 		}
 	}
 	rt_thread_delete(send_task);
 	set_bit(1, &end_softrtnet);
 }
 
-static struct pollfd *pollv;
+/*
+ * There is a receiver per CPU, each one polling just the sockets sharded
+ * to it, see soft_rt_socket_affinity.
+ */
+struct rcvr_t {
+	RT_TASK *task;
+	unsigned long gen;
+	int npoll, *sockv, *cblist;
+	struct pollfd *pollv;
+	struct mmsghdr mmsg[NETRPC_MMSG_BATCH];
+	struct iovec iov[NETRPC_MMSG_BATCH];
+	char drop[MAX_MSG_SIZE];
+};
+
+static struct rcvr_t *rcvrs;
+static atomic_t rcvrs_up;
+static volatile int socks_up;
 
 static void do_all_callbacks(int *cblist)
 {
@@ -1461,57 +2539,152 @@ static void do_all_callbacks(int *cblist)
 	return;
 }
 
-static void recv_thread(void)
+static void shard_socks(struct rcvr_t *rcvr, int k)
 {
-	int i, nevents;
+	int i;
+	rcvr->gen = shard_gen;
+	smp_rmb();
+	for (rcvr->npoll = i = 0; i < MaxSocks; i++) {
+		if (socks[i].rcvr == k) {
+			rcvr->sockv[rcvr->npoll]         = i;
+			rcvr->pollv[rcvr->npoll].fd      = socks[i].sock;
+			rcvr->pollv[rcvr->npoll].events  = POLLIN;
+			rcvr->pollv[rcvr->npoll].revents = 0;
+			rcvr->npoll++;
+		}
+	}
+}
 
-	for (i = 0; i < MaxSocks; i++) {
-		int k;
-		SPRT_ADDR.sin_port = htons(BASEPORT + i);
-		if ((socks[i].sock = ksocket(AF_INET, SOCK_DGRAM, 0)) < 0 || (k = kbind(socks[i].sock, (struct sockaddr *)&SPRT_ADDR, ADRSZ)) < 0) {
-			kfree(socks);
-			kfree(pollv);
-			kfree(sysrq.sockindx);
-			printk("SOFT RTNet: unable to set up Linux support sockets.\n");
-			return;
+/*
+ * Receive, by a single krecvmmsg, as many datagrams as there are free slots
+ * in the socket ring, up to NETRPC_MMSG_BATCH. With the ring full the first
+ * pending datagram is dropped, as Linux does on socket buffers overflows.
+ */
+static int recv_sock(struct rcvr_t *rcvr, int i)
+{
+	struct sock_t *sock;
+	struct sock_rmsg *rmsg;
+	int k, n;
+
+	sock = socks + i;
+	if ((n = RecvDepth - (sock->rin - sock->rout)) <= 0) {
+		krecv(sock->sock, rcvr->drop, MAX_MSG_SIZE, MSG_DONTWAIT);
+		sock->drops++;
+		return 0;
+	}
+	if (n > NETRPC_MMSG_BATCH) {
+		n = NETRPC_MMSG_BATCH;
+	}
+	for (k = 0; k < n; k++) {
+		rmsg = sock->rmsg + ((sock->rin + k) & RecvDepthMone);
+		rcvr->iov[k].iov_base = rmsg->msg;
+		rcvr->iov[k].iov_len  = MAX_MSG_SIZE;
+		rcvr->mmsg[k].msg_hdr.msg_name    = &rmsg->addr;
+		rcvr->mmsg[k].msg_hdr.msg_namelen = ADRSZ;
+		rcvr->mmsg[k].msg_hdr.msg_iov     = &rcvr->iov[k];
+		rcvr->mmsg[k].msg_hdr.msg_iovlen  = 1;
+	}
+	if ((n = krecvmmsg(sock->sock, rcvr->mmsg, n, MSG_DONTWAIT, NULL)) <= 0) {
+		return 0;
+	}
+	for (k = 0; k < n; k++) {
+		rmsg = sock->rmsg + ((sock->rin + k) & RecvDepthMone);
+		rmsg->len     = rcvr->mmsg[k].msg_len;
+		rmsg->addrlen = rcvr->mmsg[k].msg_hdr.msg_namelen;
+	}
+	smp_wmb();
+	sock->rin += n;
+	return n;
+}
+
+static void recv_thread(long k)
+{
+	struct rcvr_t *rcvr;
+	char name[8];
+	int i, j, n, nevents;
+
+	rcvr = rcvrs + k;
+	if (!k) {
+		for (i = 0; i < MaxSocks; i++) {
+			SPRT_ADDR.sin_port = htons(BASEPORT + i);
+			if ((socks[i].sock = ksocket(AF_INET, SOCK_DGRAM, 0)) < 0 || kbind(socks[i].sock, (struct sockaddr *)&SPRT_ADDR, ADRSZ) < 0) {
+				for (; i >= 0; i--) {
+					if (socks[i].sock >= 0) {
+						kclose(socks[i].sock);
+					}
+				}
+				printk("SOFT RTNet: unable to set up Linux support sockets.\n");
+				return;
+			}
+			socks[i].rcvr = i % nrcvrs;
+		}
+		socks_up = 1;
+	} else {
+		while (!socks_up) {
+			if (end_softrtnet) {
+				return;
+			}
+			msleep(1000/NETRPC_DELAY_FREQ);
 		}
-		socks[i].addrlen = ADRSZ;
-		pollv[i].fd      = socks[i].sock;
-		pollv[i].events  = POLLIN;
-		pollv[i].revents = 0;
 	}
 	sigfillset(&current->blocked);
-	recv_task = rt_thread_init(nam2num("RCVSRV"), 95, 0, SCHED_FIFO, 0xF);
+	if (k) {
+		sprintf(name, "RCVS%02d", (int)k);
+	} else {
+		strcpy(name, "RCVSRV");
+	}
+	rcvr->task = rt_thread_init(nam2num(name), 95, 0, SCHED_FIFO, 1 << k);
+	rcvr->gen = ~shard_gen;
+	atomic_inc(&rcvrs_up);
 	while (!end_softrtnet) {
-		if ((nevents = kpoll(pollv, MaxSocks, NETRPC_POLL_TMOUT)) > 0) {
-			int k = 1, cblist[nevents + 1];
-			cblist[0] = nevents;
-			i = -1;
-			do {
-				while (!pollv[++i].revents);
-				if ((socks[i].recvd = krecvfrom(socks[i].sock, socks[i].msg, MAX_MSG_SIZE, MSG_DONTWAIT, &socks[i].addr, &socks[i].addrlen)) > 0) {
-					cblist[k++] = i; // socks[i].callback(i, socks[i].arg);
+		if (rcvr->gen != shard_gen) {
+			shard_socks(rcvr, k);
+		}
+		if ((nevents = kpoll(rcvr->pollv, rcvr->npoll, NETRPC_POLL_TMOUT)) > 0) {
+			rcvr->cblist[0] = 0;
+			for (j = 0; nevents > 0 && j < rcvr->npoll; j++) {
+				if (rcvr->pollv[j].revents) {
+					nevents--;
+					i = rcvr->sockv[j];
+					if (!test_and_set_bit(0, &socks[i].busy)) {
+						n = recv_sock(rcvr, i);
+						clear_bit(0, &socks[i].busy);
+						while (n-- > 0) {
+							rcvr->cblist[++rcvr->cblist[0]] = i;
+						}
+					}
 				}
-			} while (--nevents);
-			do_all_callbacks(cblist);
+			}
+			do_all_callbacks(rcvr->cblist);
 		}
 	}
-	for (i = 0; i < MaxSocks; i++) {
-		kclose(socks[i].sock);
+	rt_thread_delete(rcvr->task);
+	if (atomic_dec_and_test(&rcvrs_up)) {
+		for (i = 0; i < MaxSocks; i++) {
+			kclose(socks[i].sock);
+		}
+		set_bit(2, &end_softrtnet);
 	}
-	rt_thread_delete(recv_task);
-	set_bit(2, &end_softrtnet);
 	return;
 }
 
+/*
+ * srqarg: 0 runs the first receiver, 1 the sender, 2 returns the number of
+ * receivers, 2 + k runs the k-th receiver, k > 0.
+ */
 static long long user_softrtnet_hdlr(unsigned long srqarg)
 {
 	if (!srqarg) {
 		printk("SOFT RECV_THREAD LAUNCHED FROM USER SPACE SUPPORT.\n");
-		recv_thread();
+		recv_thread(0);
 	} else if (srqarg == 1) {
 		printk("SOFT SEND_THREAD LAUNCHED FROM USER SPACE SUPPORT.\n");
 		send_thread();
+	} else if (srqarg == 2) {
+		return nrcvrs;
+	} else if (srqarg - 2 < nrcvrs) {
+		printk("SOFT RECV_THREAD %lu LAUNCHED FROM USER SPACE SUPPORT.\n", srqarg - 2);
+		recv_thread(srqarg - 2);
 	}
 	return 0;
 }
@@ -1527,21 +2700,56 @@ static long long user_softrtnet_hdlr(unsigned long srqarg)
 static int init_softrtnet(void)
 {
 	int i;
+	char *p;
+	struct sock_rmsg *rmsg;
+
 	for (i = 8*sizeof(unsigned long) - 1; !test_bit(i, &MaxSocks); i--);
-	MaxSockSrq = ((1 << i) != MaxSocks ? 1 << (i + 1) : MaxSocks) - 1;
-	if (!(sysrq.sockindx = (int *)kmalloc((MaxSockSrq + 1)*sizeof(int), GFP_KERNEL))) {
+	MaxSockSrq = 2*((1 << i) != MaxSocks ? 1 << (i + 1) : MaxSocks) - 1;
+	for (RecvDepthMone = 1; RecvDepthMone < RecvDepth; RecvDepthMone <<= 1);
+	RecvDepth = RecvDepthMone--;
+	if ((nrcvrs = RecvThreads) <= 0 || nrcvrs > num_online_cpus()) {
+		nrcvrs = num_online_cpus();
+	}
+	if (nrcvrs > RTAI_NR_CPUS) {
+		nrcvrs = RTAI_NR_CPUS;
+	}
+	if (nrcvrs > MaxSocks) {
+		nrcvrs = MaxSocks;
+	}
+	if (!(sysrq.smsg = (struct sock_smsg *)vmalloc((MaxSockSrq + 1)*sizeof(struct sock_smsg)))) {
 		printk("SOFT RTNet INIT: no memory available for socket queus.\n");
-		goto ret4;
+		goto ret5;
+	}
+	for (i = 0; i <= MaxSockSrq; i++) {
+		sysrq.smsg[i].sock = -1;
 	}
 	if (!(socks = (struct sock_t *)kmalloc(MaxSocks*sizeof(struct sock_t), GFP_KERNEL))) {
 		printk("SOFT RTNet INIT: no memory available for socks.\n");
+		goto ret4;
+	}
+	if (!(rmsg = (struct sock_rmsg *)vmalloc(MaxSocks*RecvDepth*sizeof(struct sock_rmsg)))) {
+		printk("SOFT RTNet INIT: no memory available for receive rings.\n");
 		goto ret3;
 	}
-	if (!(pollv = (struct pollfd *)kmalloc(MaxSocks*sizeof(struct pollfd), GFP_KERNEL))) {
+	if (!(rcvrs = (struct rcvr_t *)vmalloc(nrcvrs*(sizeof(struct rcvr_t) + MaxSocks*(sizeof(struct pollfd) + sizeof(int)) + (MaxSocks*RecvDepth + 1)*sizeof(int))))) {
 		printk("SOFT RTNet INIT: no memory available for polling.\n");
 		goto ret2;
 	}
 	memset(socks, 0, MaxSocks*sizeof(struct sock_t));
+	for (i = 0; i < MaxSocks; i++) {
+		socks[i].sock = -1;
+		socks[i].rmsg = rmsg + i*RecvDepth;
+	}
+	memset(rcvrs, 0, nrcvrs*sizeof(struct rcvr_t));
+	for (p = (char *)(rcvrs + nrcvrs), i = 0; i < nrcvrs; i++) {
+		rcvrs[i].pollv  = (struct pollfd *)p;
+		p += MaxSocks*sizeof(struct pollfd);
+		rcvrs[i].sockv  = (int *)p;
+		p += MaxSocks*sizeof(int);
+		rcvrs[i].cblist = (int *)p;
+		p += (MaxSocks*RecvDepth + 1)*sizeof(int);
+	}
+	atomic_set(&rcvrs_up, 0);
 	rt_typed_sem_init(&mtx, 0, BIN_SEM | FIFO_Q);
 	if (SOFTRTNET_USER_SUPPORT) {
 		char env0[] = RTAI_INSTALL_DIR"/bin";
@@ -1556,26 +2764,34 @@ static int init_softrtnet(void)
 		printk("SOFT RTNet USERMODE HELPER OK.\n");
 	} else {
 		rt_thread_create((void *)send_thread, NULL, NULL);
-		rt_thread_create((void *)recv_thread, NULL, NULL);
+		for (i = 0; i < nrcvrs; i++) {
+			rt_thread_create((void *)recv_thread, (void *)(long)i, NULL);
+		}
 	}
-	for (i = 0; i < 2*NETRPC_DELAY_FREQ && (!send_task || !recv_task); i++) {
+	for (i = 0; i < 2*NETRPC_DELAY_FREQ && (!send_task || atomic_read(&rcvrs_up) < nrcvrs); i++) {
 		msleep(1000/NETRPC_DELAY_FREQ);
 	}
-	if (!recv_task || !send_task) {
+	if (!send_task || atomic_read(&rcvrs_up) < nrcvrs) {
 		printk("SOFT RTNet INIT: send-receive soft server set up failed.\n");
 		goto ret1;
 	}
+	printk("SOFT RTNet: %d receivers, %d deep receive rings.\n", nrcvrs, RecvDepth);
 	return 0;
-ret1:	rt_sem_delete(&mtx);
-ret2:	kfree(pollv);
+ret1:	end_softrtnet = 1;
+	rt_sem_signal(&mtx);
+	msleep(2*NETRPC_POLL_TMOUT);
+	rt_sem_delete(&mtx);
+	vfree(rcvrs);
+ret2:	vfree(rmsg);
 ret3:	kfree(socks);
-ret4:	kfree(sysrq.sockindx);
-	return -1;
+ret4:	vfree(sysrq.smsg);
+ret5:	return -1;
 }
 
 static void cleanup_softrtnet(void)
 {
 	int i;
+	unsigned long drops;
 	end_softrtnet = 1;
 	rt_sem_signal(&mtx);
 	for (i = 0; i < 2*NETRPC_DELAY_FREQ && end_softrtnet < 7; i++) {
@@ -1584,9 +2800,16 @@ static void cleanup_softrtnet(void)
 	if (end_softrtnet < 7) {
 		printk("SOFT RTNet CLEANUP: send-receive soft server did not end.\n");
 	}
-	kfree(sysrq.sockindx);
+	for (drops = i = 0; i < MaxSocks; i++) {
+		drops += socks[i].drops;
+	}
+	if (drops) {
+		printk("SOFT RTNet CLEANUP: %lu datagrams dropped on full receive rings.\n", drops);
+	}
+	vfree(sysrq.smsg);
+	vfree(socks[0].rmsg);
 	kfree(socks);
-	kfree(pollv);
+	vfree(rcvrs);
 	rt_sem_delete(&mtx);
 }
 
@@ -1616,6 +2839,9 @@ int __rtai_netrpc_init(void)
 		return -1;
 	}
 	MaxStubsMone = MaxStubs - 1;
+	if (FragBurst < 1) {
+		FragBurst = 1;
+	}
 	if (!(recovery.msg = (struct recovery_msg *)kmalloc((MaxStubs)*sizeof(struct recovery_msg), GFP_KERNEL))) {
 		printk("NETRPC INIT: no memory for recovery.msg.\n");
 		goto ret2;
@@ -1626,6 +2852,11 @@ int __rtai_netrpc_init(void)
 		printk("NETRPC INIT: no memory for portslot.\n");
 		goto ret1;
 	}
+	if (!(port_msgs = kmalloc((MaxSocks - MaxStubs)*sizeof(struct port_msgs), GFP_KERNEL))) {
+		printk("NETRPC INIT: no memory for port messages.\n");
+		kfree(portslot);
+		goto ret1;
+	}
 	if (!ThisSoftNode) {
 		ThisSoftNode = ThisNode;
 	}
@@ -1650,6 +2881,18 @@ int __rtai_netrpc_init(void)
 		rt_typed_sem_init(&portslot[i].sem, 0, BIN_SEM | FIFO_Q);
 		portslot[i].task = 0;
 		portslot[i].timeout = 0;
+		portslot[i].window = 1;
+		portslot[i].draining = 0;
+		portslot[i].reqid = portslot[i].sync_reqid = 0;
+		memset((void *)portslot[i].reqids, 0, sizeof(portslot[i].reqids));
+		atomic_set(&portslot[i].pipe_calls, 0);
+		portslot[i].lo = NULL;
+		portslot[i].lo_in = portslot[i].lo_out = NULL;
+		portslot[i].lo_peer = NULL;
+		atomic_set(&portslot[i].lo_busy, 0);
+		portslot[i].fragmap = NULL;
+		portslot[i].frag = NULL;
+		portslot[i].msgs = i < MaxStubs ? NULL : port_msgs + i - MaxStubs;
 	}
 	SPRT_ADDR.sin_port = htons(BASEPORT);
 	portslotsp = MaxStubs;
@@ -1658,6 +2901,7 @@ int __rtai_netrpc_init(void)
 	portslot[0].owner = OWNER(this_node[0], (unsigned long)port_server);
 	port_server = kmalloc(sizeof(RT_TASK) + 3*sizeof(struct fun_args), GFP_KERNEL);
 	soft_kthread_init(port_server, (long)port_server_fun, (long)port_server, RT_SCHED_LOWEST_PRIORITY);
+	soft_rt_socket_affinity(portslot[0].socket[0], port_server->runnable_on_cpus);
 	portslot[0].task = (long)port_server;
 	rt_task_resume(port_server);
 	rt_typed_sem_init(&timer_sem, 0, BIN_SEM | FIFO_Q);
@@ -1688,12 +2932,15 @@ void __rtai_netrpc_exit(void)
 				kfree((RT_TASK *)portslot[i].task);
 			}
 		}
+		lo_free(portslot + i);
+		frag_free(portslot + i);
 	}
 	for (i = 0; i < MaxSocks; i++) {
 		rt_sem_delete(&portslot[i].sem);
 		soft_rt_close(portslot[i].socket[0]);
 		hard_rt_close(portslot[i].socket[1]);
 	}
+	kfree(port_msgs);
 	kfree(portslot);
 	kfree(recovery.msg);
 	cleanup_softrtnet();
@@ -1715,6 +2962,8 @@ EXPORT_SYMBOL(_rt_net_rpc);
 EXPORT_SYMBOL(rt_get_net_rpc_ret);
 EXPORT_SYMBOL(rt_set_this_node);
 EXPORT_SYMBOL(rt_set_netrpc_timeout);
+EXPORT_SYMBOL(rt_set_netrpc_window);
+EXPORT_SYMBOL(rt_get_net_rpc_ret_id);
 
 
 #ifdef SOFT_RTNET
@@ -1724,6 +2973,9 @@ EXPORT_SYMBOL(soft_rt_bind);
 EXPORT_SYMBOL(soft_rt_socket_callback);
 EXPORT_SYMBOL(soft_rt_sendto);
 EXPORT_SYMBOL(soft_rt_recvfrom);
+EXPORT_SYMBOL(soft_rt_recv_peek);
+EXPORT_SYMBOL(soft_rt_recv_done);
+EXPORT_SYMBOL(soft_rt_socket_affinity);
 EXPORT_SYMBOL(ddn2nl);
 #endif /* SOFT_RTNET */
 
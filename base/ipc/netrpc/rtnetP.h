@@ -47,14 +47,31 @@ int soft_rt_socket_callback(int s,
 			    int (*func)(int s, void *arg),
 			    void *arg);
 
+int soft_rt_socket_affinity(int s,
+			    int cpu);
+
+int soft_rt_recv_peek(int s,
+		      void **buf,
+		      struct sockaddr **from);
+
+void soft_rt_recv_done(int s);
+
+/* a datagram received by the soft receivers, waiting to be consumed */
+struct sock_rmsg {
+	int len, addrlen;
+	struct sockaddr addr;
+	char msg[MAX_MSG_SIZE];
+};
+
 struct sock_t { 
 	int sock, opnd; 
-	int tosend, recvd; 
-	struct sockaddr addr; 
-	int addrlen; 
+	int rcvr;
+	unsigned long busy;
+	volatile unsigned int rin, rout;
+	unsigned long drops;
 	int (*callback)(int sock, void *arg); 
 	void *arg; 
-	char msg[MAX_MSG_SIZE]; 
+	struct sock_rmsg *rmsg;
 };
 
 #ifdef COMPILE_ANYHOW
@@ -18,6 +18,7 @@ License along with this library; if not, see <http://www.gnu.org/licenses/>.
 
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <pthread.h>
 
 #include <asm/rtai_srq.h>
@@ -32,10 +33,22 @@ void *send_fun(void *arg)
 	return NULL;
 }
 
+struct recv_arg { int srq, rcvr; };
+
+void *recv_fun(void *arg)
+{
+	struct recv_arg *recv = arg;
+	fprintf(strm, "USER SPACE RECV TASK %d BEGINS AND GOES TO KERNEL.\n", recv->rcvr); fflush(strm);
+	rtai_srq(recv->srq, 2 + recv->rcvr);
+	fprintf(strm, "USER SPACE RECV TASK %d ENDS.\n", recv->rcvr); fflush(strm);
+	return NULL;
+}
+
 int main(int argc, char **argv)
 {
-	int srq;
-	pthread_t send_thread;
+	int srq, nrcvrs, i;
+	pthread_t send_thread, *recv_thread;
+	struct recv_arg *recv_arg;
 	strm = fopen(argv[1], "w+");
 	fprintf(strm, "USER SPACE RECV TASK BEGINS AND OPENS SRQ.\n"); fflush(strm);
 	srq = rtai_open_srq(0xbadface1);
@@ -45,9 +58,22 @@ int main(int argc, char **argv)
 	}
 	fprintf(strm, "USER SPACE RECV TASK GOT SRQ %d AND CREATES USER SPACE SEND TASK.\n", srq); fflush(strm);
 	pthread_create(&send_thread, NULL, send_fun, &srq);
+	nrcvrs = rtai_srq(srq, 2);
+	recv_thread = calloc(nrcvrs, sizeof(pthread_t));
+	recv_arg = calloc(nrcvrs, sizeof(struct recv_arg));
+	for (i = 1; i < nrcvrs; i++) {
+		recv_arg[i].srq = srq;
+		recv_arg[i].rcvr = i;
+		pthread_create(&recv_thread[i], NULL, recv_fun, &recv_arg[i]);
+	}
 	fprintf(strm, "USER SPACE RECV TASK GOES TO KERNEL.\n"); fflush(strm);
 	rtai_srq(srq, 0);
 	pthread_join(send_thread, NULL);
+	for (i = 1; i < nrcvrs; i++) {
+		pthread_join(recv_thread[i], NULL);
+	}
+	free(recv_thread);
+	free(recv_arg);
 	fprintf(strm, "USER SPACE RECV TASK ENDS.\n"); fflush(strm);
 	fclose(strm);
 	return 0;
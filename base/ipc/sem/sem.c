@@ -37,6 +37,7 @@
 #include <rtai_schedcore.h>
 #include <rtai_prinher.h>
 #include <rtai_sem.h>
+#include <rtai_fmutex.h>
 #include <rtai_rwl.h>
 #include <rtai_spl.h>
 
@@ -62,6 +63,9 @@ do { \
 		} \
 		enqueue_blocked(task, &sem->queue, PRIO_Q); \
 		enqueue_resqel(&sem->resq, sem->owndby = rt_current); \
+		if (sem->fword) { \
+			*sem->fword = (unsigned long)rt_current | RT_FMUTEX_WAITERS; \
+		} \
 		rt_global_restore_flags(flags); \
 		return 1; \
 	} \
@@ -105,6 +109,64 @@ do { \
 #define CHECK_SEM_MAGIC(sem) \
 do { if (sem->magic != RT_SEM_MAGIC) return RTE_OBJINV; } while (0)
 
+/*
+ * Fast mutexes support, see rtai_fmutex.h, to be used with the global lock
+ * held. The word is marked whenever the semaphore has an owner, so that it
+ * cannot change outside of here, but for the free to owned and back compare
+ * and swaps of the uncontended locks and unlocks.
+ */
+
+/*
+ * The task an unmarked word names as owner. The word is in user space, so it
+ * is just a hint, looked up among the scheduler tasks and never dereferenced
+ * before being found there. Once the word is marked the semaphore owner is
+ * the one kept here, by the kernel.
+ */
+static RT_TASK *fmutex_owner(unsigned long word)
+{
+	RT_TASK *task;
+	int cpuid;
+
+	for (cpuid = 0; cpuid < RTAI_NR_CPUS; cpuid++) {
+		for (task = rt_smp_linux_task[cpuid].next; task; task = task->next) {
+			if ((unsigned long)task == word) {
+				return task->magic == RT_TASK_MAGIC ? task : NULL;
+			}
+		}
+	}
+	return NULL;
+}
+
+/* Take the word if free, else mark it and give the semaphore to its owner. */
+static inline int fmutex_take(SEM *sem, RT_TASK *rt_current)
+{
+	unsigned long word;
+	RT_TASK *owner;
+
+	while (1) {
+		if (!(word = *sem->fword)) {
+			if (!cmpxchg(sem->fword, 0UL, (unsigned long)rt_current)) {
+				return 1;
+			}
+		} else if (word & RT_FMUTEX_WAITERS) {
+			return 0;
+		} else if (!(owner = fmutex_owner(word))) {
+			return RTE_OBJINV;
+		} else if (cmpxchg(sem->fword, word, word | RT_FMUTEX_WAITERS) == word) {
+			sem->count = 0;
+			enqueue_resqel(&sem->resq, sem->owndby = owner);
+			return 0;
+		}
+	}
+}
+
+/* Set the word for the semaphore owner to be, i.e. its first waiter. */
+static inline void fmutex_pass(SEM *sem)
+{
+	RT_TASK *task = (sem->queue.next)->task;
+	*sem->fword = task ? (unsigned long)task | RT_FMUTEX_WAITERS : 0UL;
+}
+
 /* +++++++++++++++++++++ ALL SEMAPHORES TYPES SUPPORT +++++++++++++++++++++++ */
 
 /**
@@ -186,6 +248,7 @@ RTAI_SYSCALL_MODE void rt_typed_sem_init(SEM *sem, int value, int type)
 	sem->queue.prev = &(sem->queue);
 	sem->queue.next = &(sem->queue);
 	sem->queue.task = sem->owndby = NULL;
+	sem->fword = NULL;
 
 	sem->resq.prev = sem->resq.next = &sem->resq;
 	sem->resq.task = (void *)&sem->queue;
@@ -344,6 +407,15 @@ RTAI_SYSCALL_MODE int rt_sem_signal(SEM *sem)
 
 	flags = rt_global_save_flags_and_cli();
 	if (sem->type) {
+		if (sem->fword && !(*sem->fword & RT_FMUTEX_WAITERS)) {
+			if (*sem->fword != (unsigned long)RT_CURRENT) {
+				rt_global_restore_flags(flags);
+				return RTE_PERM;
+			}
+			*sem->fword = 0UL;
+			rt_global_restore_flags(flags);
+			return 0;
+		}
 		if (sem->restype && (!sem->owndby || sem->owndby != RT_CURRENT)) {
 			rt_global_restore_flags(flags);
 			return RTE_PERM;
@@ -353,6 +425,9 @@ RTAI_SYSCALL_MODE int rt_sem_signal(SEM *sem)
 			rt_global_restore_flags(flags);
 			return 0;
 		}
+		if (sem->fword) {
+			fmutex_pass(sem);
+		}
 		if (++sem->count > 1) {
 			sem->count = 1;
 		}
@@ -511,6 +586,10 @@ RTAI_SYSCALL_MODE int rt_sem_wait(SEM *sem)
 
 	flags = rt_global_save_flags_and_cli();
 	rt_current = RT_CURRENT;
+	if (sem->fword && (count = fmutex_take(sem, rt_current))) {
+		rt_global_restore_flags(flags);
+		return count;
+	}
 	if ((count = sem->count) <= 0) {
 		void *retp;
 		unsigned long schedmap;
@@ -594,6 +673,15 @@ RTAI_SYSCALL_MODE int rt_sem_wait_if(SEM *sem)
 	CHECK_SEM_MAGIC(sem);
 
 	flags = rt_global_save_flags_and_cli();
+	if (sem->fword) {
+		RT_TASK *rt_current = RT_CURRENT;
+		if ((*sem->fword & ~RT_FMUTEX_WAITERS) != (unsigned long)rt_current) {
+			count = !cmpxchg(sem->fword, 0UL, (unsigned long)rt_current);
+			rt_global_restore_flags(flags);
+			return count;
+		}
+		fmutex_take(sem, rt_current);
+	}
 	if ((count = sem->count) <= 0) {
 		UBI_MAIOR_MINOR_CESSAT_WAIT_IF(sem);
 		if (sem->restype && sem->owndby == RT_CURRENT) {
@@ -662,6 +750,10 @@ RTAI_SYSCALL_MODE int rt_sem_wait_until(SEM *sem, RTIME time)
 
 	flags = rt_global_save_flags_and_cli();
 	ASSIGN_RT_CURRENT;
+	if (sem->fword && (count = fmutex_take(sem, rt_current))) {
+		rt_global_restore_flags(flags);
+		return count;
+	}
 	if ((count = sem->count) <= 0) {
 		void *retp;
 		rt_current->blocked_on = &sem->queue;
@@ -892,6 +984,9 @@ RTAI_SYSCALL_MODE int rt_cond_wait(CND *cnd, SEM *mtx)
 
 	flags = rt_global_save_flags_and_cli();
 	rt_current = RT_CURRENT;
+	if (mtx->fword && *mtx->fword == (unsigned long)rt_current) {
+		fmutex_take(mtx, rt_current);
+	}
 	if (mtx->owndby != rt_current) {
 		rt_global_restore_flags(flags);
 		return RTE_PERM;
@@ -899,6 +994,9 @@ RTAI_SYSCALL_MODE int rt_cond_wait(CND *cnd, SEM *mtx)
 	rt_current->state |= RT_SCHED_SEMAPHORE;
 	rem_ready_current(rt_current);
 	enqueue_blocked(rt_current, &cnd->queue, cnd->qtype);
+	if (mtx->fword) {
+		fmutex_pass(mtx);
+	}
 	type = rt_cndmtx_signal(mtx, rt_current);
 	if (likely((retp = rt_current->blocked_on) != RTP_OBJREM)) { 
 		if (unlikely(retp != NULL)) {
@@ -955,6 +1053,9 @@ RTAI_SYSCALL_MODE int rt_cond_wait_until(CND *cnd, SEM *mtx, RTIME time)
 
 	flags = rt_global_save_flags_and_cli();
 	ASSIGN_RT_CURRENT;
+	if (mtx->fword && *mtx->fword == (unsigned long)rt_current) {
+		fmutex_take(mtx, rt_current);
+	}
 	if (mtx->owndby != rt_current) {
 		rt_global_restore_flags(flags);
 		return RTE_PERM;
@@ -964,6 +1065,9 @@ RTAI_SYSCALL_MODE int rt_cond_wait_until(CND *cnd, SEM *mtx, RTIME time)
 		rem_ready_current(rt_current);
 		enqueue_blocked(rt_current, &cnd->queue, cnd->qtype);
 		enq_timed_task(rt_current);
+		if (mtx->fword) {
+			fmutex_pass(mtx);
+		}
 		type = rt_cndmtx_signal(mtx, rt_current);
 		if (unlikely((retp = rt_current->blocked_on) == RTP_OBJREM)) { 
                         retval = RTE_OBJREM;
@@ -1565,6 +1669,7 @@ RTAI_SYSCALL_MODE int rt_spl_unlock(SPL *spl)
 /* ++++++ NAMED SEMAPHORES, BARRIER, COND VARIABLES, RWLOCKS, SPINLOCKS +++++ */
 
 #include <rtai_registry.h>
+#include <rtai_pool.h>
 
 /**
  * @anchor _rt_typed_named_sem_init
@@ -1621,14 +1726,16 @@ RTAI_SYSCALL_MODE SEM *_rt_typed_named_sem_init(unsigned long sem_name, int valu
 		}
 		return sem;
 	}
-	if ((sem = rt_malloc(sizeof(SEM)))) {
+	if ((sem = rt_named_obj_alloc(IS_SEM, sizeof(SEM)))) {
 		rt_typed_sem_init(sem, value, type);
 		if (rt_register(sem_name, sem, IS_SEM, 0)) {
 			return sem;
 		}
 		rt_sem_delete(sem);
 	}
-	rt_free(sem);
+	if (sem) {
+		rt_named_obj_free(IS_SEM, sem);
+	}
 	return (SEM *)0;
 }
 
@@ -1658,7 +1765,7 @@ RTAI_SYSCALL_MODE int rt_named_sem_delete(SEM *sem)
 	int ret;
 	if (!(ret = rt_drg_on_adr_cnt(sem))) {
 		if (!rt_sem_delete(sem)) {
-			rt_free(sem);
+			rt_named_obj_free(IS_SEM, sem);
 			return 0;
 		} else {
 			return RTE_OBJINV;
@@ -1703,14 +1810,16 @@ RTAI_SYSCALL_MODE RWL *_rt_named_rwl_init(unsigned long rwl_name)
 	if ((rwl = rt_get_adr_cnt(rwl_name))) {
 		return rwl;
 	}
-	if ((rwl = rt_malloc(sizeof(RWL)))) {
+	if ((rwl = rt_named_obj_alloc(IS_RWL, sizeof(RWL)))) {
 		rt_rwl_init(rwl);
 		if (rt_register(rwl_name, rwl, IS_RWL, 0)) {
 			return rwl;
 		}
 		rt_rwl_delete(rwl);
 	}
-	rt_free(rwl);
+	if (rwl) {
+		rt_named_obj_free(IS_RWL, rwl);
+	}
 	return (RWL *)0;
 }
 
@@ -1739,7 +1848,7 @@ RTAI_SYSCALL_MODE int rt_named_rwl_delete(RWL *rwl)
 	int ret;
 	if (!(ret = rt_drg_on_adr_cnt(rwl))) {
 		if (!rt_rwl_delete(rwl)) {
-			rt_free(rwl);
+			rt_named_obj_free(IS_RWL, rwl);
 			return 0;
 		} else {
 			return RTE_OBJINV;
@@ -1783,14 +1892,16 @@ RTAI_SYSCALL_MODE SPL *_rt_named_spl_init(unsigned long spl_name)
 	if ((spl = rt_get_adr_cnt(spl_name))) {
 		return spl;
 	}
-	if ((spl = rt_malloc(sizeof(SPL)))) {
+	if ((spl = rt_named_obj_alloc(IS_SPL, sizeof(SPL)))) {
 		rt_spl_init(spl);
 		if (rt_register(spl_name, spl, IS_SPL, 0)) {
 			return spl;
 		}
 		rt_spl_delete(spl);
 	}
-	rt_free(spl);
+	if (spl) {
+		rt_named_obj_free(IS_SPL, spl);
+	}
 	return (SPL *)0;
 }
 
@@ -1818,7 +1929,7 @@ RTAI_SYSCALL_MODE int rt_named_spl_delete(SPL *spl)
 	int ret;
 	if (!(ret = rt_drg_on_adr_cnt(spl))) {
 		rt_spl_delete(spl);
-		rt_free(spl);
+		rt_named_obj_free(IS_SPL, spl);
 		return 0;
 	}
 	return ret;
@@ -2128,6 +2239,85 @@ EXPORT_SYMBOL(_rt_poll);
 
 /* +++++++++++++++++++++++++++ END POLLING SERVICE ++++++++++++++++++++++++++ */
 
+/* ++++++++++++++++++++++++++++ FAST MUTEXES ++++++++++++++++++++++++++++++++ */
+
+/**
+ * @anchor rt_fmutex_bind
+ * @brief Pair a fast mutex word with a kernel semaphore.
+ *
+ * rt_fmutex_bind is called by rt_fmutex_open, after the named shared memory
+ * holding the mutex has been allocated. The first call creates the resource
+ * semaphore used when the mutex is contended, the following ones just count
+ * the users.
+ *
+ * @param name is the name of the shared memory holding the mutex.
+ *
+ * @param type is the resource semaphore value, i.e. RESEM_BINSEM,
+ * RESEM_CHEKWT or RESEM_RECURS.
+ *
+ * @return the semaphore, 0 on failure.
+ */
+RTAI_SYSCALL_MODE SEM *rt_fmutex_bind(unsigned long name, int type)
+{
+	struct rt_fmutex *fm;
+	unsigned long flags;
+	SEM *sem;
+
+	if (!(fm = rt_get_adr(name)) || abs(rt_get_type(name)) < (int)sizeof(struct rt_fmutex)) {
+		return NULL;
+	}
+	if (!(sem = rt_malloc(sizeof(SEM)))) {
+		return NULL;
+	}
+	rt_typed_sem_init(sem, type, RES_SEM);
+	sem->fword = &fm->owner;
+	flags = rt_global_save_flags_and_cli();
+	if (!fm->sem) {
+		fm->name = name;
+		fm->sem  = sem;
+		sem = NULL;
+	}
+	fm->users++;
+	rt_global_restore_flags(flags);
+	if (sem) {
+		rt_free(sem);
+	}
+	return fm->sem;
+}
+
+/**
+ * @anchor rt_fmutex_unbind
+ * @brief Release a fast mutex semaphore.
+ *
+ * The last user deletes the semaphore.
+ *
+ * @return the number of remaining users, RTE_OBJINV if @a sem is not a
+ * fast mutex semaphore.
+ */
+RTAI_SYSCALL_MODE int rt_fmutex_unbind(SEM *sem)
+{
+	struct rt_fmutex *fm;
+	unsigned long flags;
+	int users;
+
+	CHECK_SEM_MAGIC(sem);
+	if (!sem->fword) {
+		return RTE_OBJINV;
+	}
+	fm = (struct rt_fmutex *)sem->fword;  // the word is the first field
+	flags = rt_global_save_flags_and_cli();
+	if ((users = --fm->users) <= 0) {
+		fm->sem = NULL;
+	}
+	rt_global_restore_flags(flags);
+	if (users > 0) {
+		return users;
+	}
+	rt_sem_delete(sem);
+	rt_free(sem);
+	return 0;
+}
+
 /* +++++ SEMAPHORES, BARRIER, COND VARIABLES, RWLOCKS, SPINLOCKS ENTRIES ++++ */
 
 struct rt_native_fun_entry rt_sem_entries[] = {
@@ -2168,6 +2358,8 @@ struct rt_native_fun_entry rt_sem_entries[] = {
 	{ { 1, rt_spl_lock_if },           SPL_LOCK_IF },
 	{ { 1, rt_spl_lock_timed },        SPL_LOCK_TIMED },
 	{ { 1, rt_spl_unlock },            SPL_UNLOCK },
+	{ { 0, rt_fmutex_bind },           FMUTEX_BIND },
+	{ { 0, rt_fmutex_unbind },         FMUTEX_UNBIND },
 #ifdef CONFIG_RTAI_RT_POLL
 	{ { 1, _rt_poll }, 	           SEM_RT_POLL },
 #endif
@@ -2243,3 +2435,5 @@ EXPORT_SYMBOL(rt_spl_lock_timed);
 EXPORT_SYMBOL(rt_spl_unlock);
 EXPORT_SYMBOL(_rt_named_spl_init);
 EXPORT_SYMBOL(rt_named_spl_delete);
+EXPORT_SYMBOL(rt_fmutex_bind);
+EXPORT_SYMBOL(rt_fmutex_unbind);
@@ -41,6 +41,7 @@
 #include <rtai_trace.h>
 #include <rtai_schedcore.h>
 #include <rtai_registry.h>
+#include <rtai_timepage.h>
 #include "rtai_shm.h"
 
 MODULE_LICENSE("GPL");
@@ -265,6 +266,12 @@ static int rtai_shm_f_mmap(struct file *file, struct vm_area_struct *vma)
 	unsigned long name;
 	int size;
 	if (!vma->vm_ops) {
+		if ((unsigned long)rtai_tskext(current, TSKEXT1) == RT_TIME_PAGE_NAME) {
+			if (vma->vm_flags & VM_WRITE) {
+				return -EPERM;
+			}
+			vma->vm_flags &= ~VM_MAYWRITE;
+		}
 		vma->vm_ops = &rtai_shm_vm_ops;
 		vma->vm_flags |= VM_LOCKED;
 		name = (unsigned long)(vma->vm_private_data = rtai_tskext(current, TSKEXT1));
@@ -723,6 +730,7 @@ int __rtai_shm_init (void)
 	printk("***** WARNING: GLOBAL HEAP NEITHER SHARABLE NOR USABLE FROM USER SPACE (use the vmalloc option for RTAI malloc) *****\n");
 #endif
 #endif
+	rt_set_time_page(rt_shm_alloc(RT_TIME_PAGE_NAME, sizeof(struct rt_time_page), USE_VMALLOC));
 	return set_rt_fun_entries(rt_shm_entries);
 }
 
@@ -735,6 +743,8 @@ void __rtai_shm_exit (void)
 #ifdef CONFIG_RTAI_MALLOC_VMALLOC
 	rt_drg_on_name_cnt(GLOBAL_HEAP_ID);
 #endif
+	rt_set_time_page(NULL);
+	rt_shm_free(RT_TIME_PAGE_NAME);
 	for (slot = 1; slot <= max_slots; slot++) {
 		if (rt_get_registry_slot(slot, &entry)) {
 			if (abs(entry.type) >= PAGE_SIZE) {
@@ -27,21 +27,66 @@
 #include <rtai_registry.h>
 #include <rtai_schedcore.h>
 #include <rtai_tbx.h>
+#include <rtai_pool.h>
 
 MODULE_LICENSE("GPL");
 
-static inline void enq_msg(RT_MSGQ *q, RT_MSGH *msg)
+/*
+ * Messages are queued on the FIFO of their priority bucket, the map of the
+ * non empty buckets giving the first message in O(1), lower priority values
+ * being served first. Priorities are not bounded, so the first and last
+ * buckets collect all those beyond the range and are kept ordered, which is
+ * still O(1) for messages sent at the same priority.
+ */
+
+static inline int msg_bucket(int priority)
 {
-	RT_MSGH *prev, *next;
+	return priority <= 0 ? 0 : (priority >= RT_MSGQ_PRIOS - 1 ? RT_MSGQ_PRIOS - 1 : priority);
+}
 
-	for (prev = next = q->firstmsg; msg->priority >= next->priority; prev = next, next = next->next);
-	if (next == prev) {
-		msg->next = next;
-		q->firstmsg = msg;
+static inline void enq_msg(RT_MSGQ *q, RT_MSGH *msg)
+{
+	RT_MSGH *prev;
+	int b;
+
+	msg->next = NULL;
+	if (!q->prio_head[b = msg_bucket(msg->priority)]) {
+		q->prio_head[b] = q->prio_tail[b] = msg;
+		q->prio_map |= (1UL << b);
+	} else if (q->prio_tail[b]->priority <= msg->priority) {
+		q->prio_tail[b]->next = msg;
+		q->prio_tail[b] = msg;
+	} else if (q->prio_head[b]->priority > msg->priority) {
+		msg->next = q->prio_head[b];
+		q->prio_head[b] = msg;
 	} else {
+		for (prev = q->prio_head[b]; ((RT_MSGH *)prev->next)->priority <= msg->priority; prev = prev->next);
 		msg->next = prev->next;
 		prev->next = msg;
 	}
+	q->firstmsg = q->prio_head[__ffs(q->prio_map)];
+}
+
+/*
+ * Dequeue a given message, usually the first one, which is then O(1). Any
+ * other is possible only for broadcasts overtaken by a more urgent send.
+ */
+static inline void deq_msg(RT_MSGQ *q, RT_MSGH *msg)
+{
+	RT_MSGH *prev;
+	int b;
+
+	if (q->prio_head[b = msg_bucket(msg->priority)] == msg) {
+		if (!(q->prio_head[b] = msg->next)) {
+			q->prio_map &= ~(1UL << b);
+		}
+	} else {
+		for (prev = q->prio_head[b]; prev->next != msg; prev = prev->next);
+		if (!(prev->next = msg->next)) {
+			q->prio_tail[b] = prev;
+		}
+	}
+	q->firstmsg = q->prio_map ? q->prio_head[__ffs(q->prio_map)] : q->nomsg;
 }
 
 RTAI_SYSCALL_MODE int rt_msgq_init(RT_MSGQ *mq, int nmsg, int msg_size)
@@ -61,7 +106,11 @@ RTAI_SYSCALL_MODE int rt_msgq_init(RT_MSGQ *mq, int nmsg, int msg_size)
 		((RT_MSGH *)p)->priority = 0;
 		p += (msg_size + RT_MSGH_SIZE);
 	}
-        ((RT_MSGH *)(mq->firstmsg = p))->priority = (0xFFFFFFFF/2);
+        ((RT_MSGH *)(mq->firstmsg = mq->nomsg = p))->priority = (0xFFFFFFFF/2);
+	mq->prio_map = 0;
+	for (i = 0; i < RT_MSGQ_PRIOS; i++) {
+		mq->prio_head[i] = mq->prio_tail[i] = NULL;
+	}
 	rt_typed_sem_init(&mq->receivers, 1, RES_SEM);
 	rt_typed_sem_init(&mq->senders, 1, RES_SEM);
 	rt_typed_sem_init(&mq->received, 0, CNT_SEM);
@@ -86,14 +135,16 @@ RTAI_SYSCALL_MODE RT_MSGQ *_rt_named_msgq_init(unsigned long msgq_name, int nmsg
 	if ((msgq = rt_get_adr_cnt(msgq_name))) {
 		return msgq;
 	}
-	if ((msgq = rt_malloc(sizeof(RT_MSGQ)))) {
+	if ((msgq = rt_named_obj_alloc(IS_MBX, sizeof(RT_MSGQ)))) {
 		rt_msgq_init(msgq, nmsg, msg_size);
 		if (rt_register(msgq_name, msgq, IS_MBX, 0)) {
 			return msgq;
 		}
 		rt_msgq_delete(msgq);
 	}
-	rt_free(msgq);
+	if (msgq) {
+		rt_named_obj_free(IS_MBX, msgq);
+	}
 	return NULL;
 }
 
@@ -102,7 +153,7 @@ RTAI_SYSCALL_MODE int rt_named_msgq_delete(RT_MSGQ *msgq)
 	int ret;
 	if (!(ret = rt_drg_on_adr_cnt(msgq))) {
 		if (!rt_msgq_delete(msgq)) {
-			rt_free(msgq);
+			rt_named_obj_free(IS_MBX, msgq);
 			return 0;
 		} else {
 			return -EFAULT;
@@ -193,6 +244,169 @@ RTAI_SYSCALL_MODE int _rt_msg_send_timed(RT_MSGQ *mq, void *msg, int msg_size, i
 	return _rt_msg_send_until(mq, msg, msg_size, msgpri, get_time() + delay, space);
 }
 
+#define TBX_VEC_WAIT   0
+#define TBX_VEC_IF     1
+#define TBX_VEC_UNTIL  2
+
+#define TBX_VEC_BATCH  16
+
+static inline int tbx_vec_sem_wait(SEM *sem, int mode, RTIME until)
+{
+	switch (mode) {
+		case TBX_VEC_WAIT:
+			return rt_sem_wait(sem);
+		case TBX_VEC_IF:
+			return rt_sem_wait_if(sem) > 0 ? 0 : RTE_TIMOUT;
+	}
+	return rt_sem_wait_until(sem, until);
+}
+
+/* Take up to n more events from a counting semaphore, without blocking. */
+static int tbx_sem_take(SEM *sem, int n)
+{
+	unsigned long flags;
+	int count;
+
+	flags = rt_global_save_flags_and_cli();
+	if ((count = sem->count) > n) {
+		count = n;
+	}
+	if (count > 0) {
+		sem->count -= count;
+	} else {
+		count = 0;
+	}
+	rt_global_restore_flags(flags);
+	return count;
+}
+
+/* Signal n events to a counting semaphore, in one go if nobody waits. */
+static void tbx_sem_give(SEM *sem, int n)
+{
+	unsigned long flags;
+
+	flags = rt_global_save_flags_and_cli();
+	if (sem->count >= 0) {
+		sem->count += n;
+		rt_global_restore_flags(flags);
+		return;
+	}
+	rt_global_restore_flags(flags);
+	while (n-- > 0) {
+		rt_sem_signal(sem);
+	}
+}
+
+/*
+ * Send a batch of nmsg messages, for which the senders semaphore and nmsg
+ * free slots are already owned. Slots are taken and messages queued with
+ * a single hold of the queue lock each, and receivers are signalled once.
+ * Returns how many messages have been sent, less than nmsg only if a message
+ * has a negative size or a large one could not be allocated, as told by err.
+ */
+static int _send_vec(RT_MSGQ *mq, struct rt_msg_iov *iov, int nmsg, int space, int *err)
+{
+	unsigned long flags;
+	RT_MSG *msg_ptr[TBX_VEC_BATCH];
+	struct rt_msg_iov v;
+	void *p;
+	int i, sent;
+
+	flags = rt_spin_lock_irqsave(&mq->lock);
+	for (i = 0; i < nmsg; i++) {
+		msg_ptr[i] = mq->slots[mq->slot++];
+	}
+	rt_spin_unlock_irqrestore(flags, &mq->lock);
+	for (sent = 0; sent < nmsg; sent++) {
+		if (space) {
+			v = iov[sent];
+		} else {
+			rt_copy_from_user(&v, iov + sent, sizeof(struct rt_msg_iov));
+		}
+		if (v.size < 0) {
+			*err = -EINVAL;
+			break;
+		}
+		if (v.size > mq->fastsize) {
+			if (!(p = rt_malloc(v.size))) {
+				*err = -ENOMEM;
+				break;
+			}
+		} else {
+			p = NULL;
+		}
+		msg_ptr[sent]->hdr.size = v.size;
+		msg_ptr[sent]->hdr.priority = v.prio;
+		msg_ptr[sent]->hdr.malloc = p;
+		msg_ptr[sent]->hdr.broadcast = 0;
+		if (space) {
+			memcpy(p ? p : msg_ptr[sent]->msg, v.msg, v.size);
+		} else {
+			rt_copy_from_user(p ? p : msg_ptr[sent]->msg, v.msg, v.size);
+		}
+	}
+	flags = rt_spin_lock_irqsave(&mq->lock);
+	for (i = 0; i < sent; i++) {
+		enq_msg(mq, &msg_ptr[i]->hdr);
+	}
+	for (i = nmsg; --i >= sent; ) {
+		mq->slots[--mq->slot] = msg_ptr[i];
+	}
+	rt_spin_unlock_irqrestore(flags, &mq->lock);
+	if (sent < nmsg) {
+		tbx_sem_give(&mq->freslots, nmsg - sent);
+	}
+	tbx_sem_give(&mq->received, sent);
+	return sent;
+}
+
+static int _rt_msg_send_vec_mode(RT_MSGQ *mq, struct rt_msg_iov *iov, int nmsg, int mode, RTIME until, int space)
+{
+	int sent, batch, done, retval;
+
+	if (nmsg <= 0) {
+		return 0;
+	}
+	if ((retval = tbx_vec_sem_wait(&mq->senders, mode, until)) >= RTE_LOWERR) {
+		return mode == TBX_VEC_IF ? 0 : TBX_RET(0, retval);
+	}
+	for (sent = 0; sent < nmsg; sent += done) {
+		if ((retval = tbx_vec_sem_wait(&mq->freslots, mode, until)) >= RTE_LOWERR) {
+			break;
+		}
+		batch = 1 + tbx_sem_take(&mq->freslots, min(nmsg - sent, TBX_VEC_BATCH) - 1);
+		if ((done = _send_vec(mq, iov + sent, batch, space, &retval)) < batch) {
+			sent += done;
+			break;
+		}
+	}
+	rt_sem_signal(&mq->senders);
+	if (!sent && retval == -EINVAL) {
+		return retval;
+	}
+	return sent || mode == TBX_VEC_IF ? sent : TBX_RET(0, retval);
+}
+
+RTAI_SYSCALL_MODE int _rt_msg_send_vec(RT_MSGQ *mq, struct rt_msg_iov *iov, int nmsg, int space)
+{
+	return _rt_msg_send_vec_mode(mq, iov, nmsg, TBX_VEC_WAIT, 0, space);
+}
+
+RTAI_SYSCALL_MODE int _rt_msg_send_vec_if(RT_MSGQ *mq, struct rt_msg_iov *iov, int nmsg, int space)
+{
+	return _rt_msg_send_vec_mode(mq, iov, nmsg, TBX_VEC_IF, 0, space);
+}
+
+RTAI_SYSCALL_MODE int _rt_msg_send_vec_until(RT_MSGQ *mq, struct rt_msg_iov *iov, int nmsg, RTIME until, int space)
+{
+	return _rt_msg_send_vec_mode(mq, iov, nmsg, TBX_VEC_UNTIL, until, space);
+}
+
+RTAI_SYSCALL_MODE int _rt_msg_send_vec_timed(RT_MSGQ *mq, struct rt_msg_iov *iov, int nmsg, RTIME delay, int space)
+{
+	return _rt_msg_send_vec_mode(mq, iov, nmsg, TBX_VEC_UNTIL, get_time() + delay, space);
+}
+
 static int _receive(RT_MSGQ *mq, void *msg, int msg_size, int *msgpri, int space)
 {
 	int size;
@@ -224,7 +438,7 @@ static int _receive(RT_MSGQ *mq, void *msg, int msg_size, int *msgpri, int space
 	} else {
 		unsigned long flags;
 relslot:	flags = rt_spin_lock_irqsave(&mq->lock);
-		mq->firstmsg = msg_ptr->hdr.next;
+		deq_msg(mq, &msg_ptr->hdr);
 		mq->slots[--mq->slot] = msg_ptr;
 		rt_spin_unlock_irqrestore(flags, &mq->lock);
 		rt_sem_signal(&mq->freslots);
@@ -412,6 +626,10 @@ struct rt_native_fun_entry rt_msg_queue_entries[] = {
         { { 1, _rt_msg_broadcast_until },	MSG_BROADCAST_UNTIL },
         { { 1, _rt_msg_broadcast_timed }, 	MSG_BROADCAST_TIMED },
         { { 1, _rt_msg_evdrp }, 		MSG_EVDRP },
+        { { 1, _rt_msg_send_vec },		MSG_SEND_VEC },
+        { { 1, _rt_msg_send_vec_if },		MSG_SEND_VEC_IF },
+        { { 1, _rt_msg_send_vec_until },	MSG_SEND_VEC_UNTIL },
+        { { 1, _rt_msg_send_vec_timed },	MSG_SEND_VEC_TIMED },
 	{ { 0, 0 },  		      		000 }
 };
 
@@ -453,4 +671,8 @@ EXPORT_SYMBOL(_rt_msg_broadcast_if);
 EXPORT_SYMBOL(_rt_msg_broadcast_until);
 EXPORT_SYMBOL(_rt_msg_broadcast_timed);
 EXPORT_SYMBOL(_rt_msg_evdrp);
+EXPORT_SYMBOL(_rt_msg_send_vec);
+EXPORT_SYMBOL(_rt_msg_send_vec_if);
+EXPORT_SYMBOL(_rt_msg_send_vec_until);
+EXPORT_SYMBOL(_rt_msg_send_vec_timed);
 #endif /* CONFIG_KBUILD */
@@ -90,6 +90,156 @@ static void free_extent(void *p, u_long size, int suprt)
 	}
 }
 
+/*
+ * PER CPU MAGAZINES.
+ *
+ * When enabled on a heap, blocks up to RTHEAP_MAG_MAXSZ are cached per CPU
+ * by power of two size classes, so that most allocations and releases get
+ * along with just the local hard interrupts disabled, without touching the
+ * heap lock. An empty magazine is refilled, and a full one halved, by
+ * RTHEAP_MAG_BATCH blocks under a single hold of the heap lock, so both the
+ * fast and the slow paths are bounded in time. A released block goes to the
+ * class its usable size can serve, so that blocks allocated out of the
+ * magazines, or larger than asked for, are recycled too. Cached blocks are
+ * still accounted as used by the heap.
+ */
+
+static void *heap_alloc(rtheap_t *heap, u_long size, int mode);
+static int heap_free(rtheap_t *heap, void *block);
+static u_long heap_block_size(rtheap_t *heap, void *block);
+
+int rtai_heap_magazines = 1;
+RTAI_MODULE_PARM(rtai_heap_magazines, int);
+
+/* Class of the smallest blocks able to satisfy an allocation of size. */
+static inline int mag_alloc_class(u_long size)
+{
+	if (size <= RTHEAP_MINALLOCSZ) {
+		return 0;
+	}
+	return size <= RTHEAP_MAG_MAXSZ ? fls(size - 1) - RTHEAP_MINLOG2 : -1;
+}
+
+/* Class of the largest blocks a block of usable size can stand for. */
+static inline int mag_free_class(u_long size)
+{
+	if (size < RTHEAP_MINALLOCSZ || size >= 2*RTHEAP_MAG_MAXSZ) {
+		return -1;
+	}
+	return fls(size) - 1 - RTHEAP_MINLOG2;
+}
+
+int rtheap_mags_init(rtheap_t *heap)
+{
+	if (!heap->mags) {
+		if (!(heap->mags = kmalloc(RTAI_NR_CPUS*sizeof(rtheap_mags_t), GFP_KERNEL))) {
+			return RTHEAP_NOMEM;
+		}
+		memset(heap->mags, 0, RTAI_NR_CPUS*sizeof(rtheap_mags_t));
+	}
+	return 0;
+}
+
+/* Returns 1 if the heap has magazines, 0 otherwise. */
+int rtheap_mags_stats(rtheap_t *heap, struct rtheap_mags_stats *stats)
+{
+	rtheap_mags_t *mags;
+	int cpuid, class;
+
+	memset(stats, 0, sizeof(*stats));
+	if (!heap->mags) {
+		return 0;
+	}
+	for (cpuid = 0; cpuid < RTAI_NR_CPUS; cpuid++) {
+		mags = heap->mags + cpuid;
+		for (class = 0; class < RTHEAP_MAG_CLASSES; class++) {
+			stats->cached += (u_long)mags->mag[class].count*(RTHEAP_MINALLOCSZ << class);
+		}
+		stats->alloc_hits   += mags->alloc_hits;
+		stats->alloc_misses += mags->alloc_misses;
+		stats->free_hits    += mags->free_hits;
+		stats->free_misses  += mags->free_misses;
+	}
+	return 1;
+}
+
+/* Cached blocks belong to the heap extents, so they just go with them. */
+static void rtheap_mags_release(rtheap_t *heap)
+{
+	if (heap->mags) {
+		kfree(heap->mags);
+		heap->mags = NULL;
+	}
+}
+
+void *rtheap_alloc(rtheap_t *heap, u_long size, int mode)
+{
+	unsigned long flags;
+	void *block;
+	int class;
+
+	if (!size) {
+		return NULL;
+	}
+	if (heap->mags && (class = mag_alloc_class(size)) >= 0) {
+		rtheap_mags_t *mags;
+		rtheap_mag_t *mag;
+		rtai_save_flags_and_cli(flags);
+		mags = heap->mags + rtai_cpuid();
+		mag = &mags->mag[class];
+		if (mag->count > 0) {
+			mags->alloc_hits++;
+		} else {
+			mags->alloc_misses++;
+			rt_spin_lock(&heap->lock);
+			while (mag->count < RTHEAP_MAG_BATCH && (block = heap_alloc(heap, RTHEAP_MINALLOCSZ << class, mode))) {
+				mag->blocks[mag->count++] = block;
+			}
+			rt_spin_unlock(&heap->lock);
+		}
+		block = mag->count > 0 ? mag->blocks[--mag->count] : NULL;
+		rtai_restore_flags(flags);
+		return block;
+	}
+	flags = rt_spin_lock_irqsave(&heap->lock);
+	block = heap_alloc(heap, size, mode);
+	rt_spin_unlock_irqrestore(flags, &heap->lock);
+	return block;
+}
+
+int rtheap_free(rtheap_t *heap, void *block)
+{
+	unsigned long flags;
+	int class, i, retval;
+
+	if (heap->mags && block && (class = mag_free_class(heap_block_size(heap, block))) >= 0) {
+		rtheap_mags_t *mags;
+		rtheap_mag_t *mag;
+		rtai_save_flags_and_cli(flags);
+		mags = heap->mags + rtai_cpuid();
+		mag = &mags->mag[class];
+		if (mag->count < RTHEAP_MAG_SIZE) {
+			mags->free_hits++;
+		} else {
+			mags->free_misses++;
+			rt_spin_lock(&heap->lock);
+			for (i = 0; i < RTHEAP_MAG_BATCH; i++) {
+				heap_free(heap, mag->blocks[i]);
+			}
+			rt_spin_unlock(&heap->lock);
+			memmove(mag->blocks, mag->blocks + RTHEAP_MAG_BATCH, (RTHEAP_MAG_SIZE - RTHEAP_MAG_BATCH)*sizeof(void *));
+			mag->count -= RTHEAP_MAG_BATCH;
+		}
+		mag->blocks[mag->count++] = block;
+		rtai_restore_flags(flags);
+		return 0;
+	}
+	flags = rt_spin_lock_irqsave(&heap->lock);
+	retval = heap_free(heap, block);
+	rt_spin_unlock_irqrestore(flags, &heap->lock);
+	return retval;
+}
+
 #ifndef CONFIG_RTAI_USE_TLSF
 #define CONFIG_RTAI_USE_TLSF 0
 #endif
@@ -113,6 +263,7 @@ int rtheap_init(rtheap_t *heap, void *heapaddr, u_long heapsize, u_long pagesize
 
 	INIT_LIST_HEAD(&heap->extents);
 	spin_lock_init(&heap->lock);
+	heap->mags = NULL;
 
 	heap->extentsize = heapsize;
 	if (!heapaddr && suprt) {
@@ -149,37 +300,31 @@ int rtheap_init(rtheap_t *heap, void *heapaddr, u_long heapsize, u_long pagesize
 void rtheap_destroy(rtheap_t *heap, int suprt)
 {
 	struct list_head *holder, *nholder;
+	rtheap_mags_release(heap);
 	list_for_each_safe(holder, nholder, &heap->extents) {
 		free_extent(list_entry(holder, rtextent_t, link), heap->extentsize, suprt);
 	}
 }
 
-void *rtheap_alloc(rtheap_t *heap, u_long size, int mode)
+/* Both to be called with the heap lock held. */
+
+static void *heap_alloc(rtheap_t *heap, u_long size, int mode)
 {
 	void *adr = NULL;
 	struct list_head *holder;
-	unsigned long flags;
-
-	if (!size) {
-		return NULL;
-	}
 
-	flags = rt_spin_lock_irqsave(&heap->lock);
 	list_for_each(holder, &heap->extents) {
 		if ((adr = malloc_ex(size, list_entry(holder, rtextent_t, link)->membase)) != NULL) {
 			break;
 		}
 	}
-	rt_spin_unlock_irqrestore(flags, &heap->lock);
 	return adr;
 }
 
-int rtheap_free(rtheap_t *heap, void *block)
+static int heap_free(rtheap_t *heap, void *block)
 {
-	unsigned long flags;
 	struct list_head *holder;
 
-	flags = rt_spin_lock_irqsave(&heap->lock);
 	list_for_each(holder, &heap->extents) {
 		rtextent_t *extent;
 		extent = list_entry(holder, rtextent_t, link);
@@ -188,7 +333,6 @@ int rtheap_free(rtheap_t *heap, void *block)
 			break;
 		}
 	}
-	rt_spin_unlock_irqrestore(flags, &heap->lock);
 	return 0;
 }
 
@@ -773,6 +917,21 @@ void free_ex(void *ptr, void *mem_pool)
     tmp_b->prev_hdr = b;
 }
 
+/* Usable size of an allocated block. */
+static u_long heap_block_size(rtheap_t *heap, void *block)
+{
+	struct list_head *holder;
+
+	list_for_each(holder, &heap->extents) {
+		rtextent_t *extent;
+		extent = list_entry(holder, rtextent_t, link);
+		if ((caddr_t)block < extent->memlim && (caddr_t)block >= extent->membase) {
+			return ((bhdr_t *)((char *)block - BHDR_OVERHEAD))->size & BLOCK_SIZE;
+		}
+	}
+	return 0;
+}
+
 unsigned long tlsf_get_used_size(rtheap_t *heap) {
 #if TLSF_STATISTIC
         struct list_head *holder;
@@ -971,6 +1130,7 @@ int rtheap_init (rtheap_t *heap, void *heapaddr, u_long heapsize, u_long pagesiz
 	heap->ubytes     = 0;
 	INIT_LIST_HEAD(&heap->extents);
 	spin_lock_init(&heap->lock);
+	heap->mags = NULL;
 
 	for (n = 0; n < RTHEAP_NBUCKETS; n++) {
 		heap->buckets[n] = NULL;
@@ -1017,6 +1177,8 @@ void rtheap_destroy (rtheap_t *heap, int suprt)
 {
 	struct list_head *holder, *nholder;
 
+	rtheap_mags_release(heap);
+
 	list_for_each_safe(holder, nholder, &heap->extents) {
 		free_extent(list_entry(holder, rtextent_t, link), heap->extentsize, suprt);
 	}
@@ -1160,10 +1322,10 @@ splitpage:
  * time (see rtheap_init()).
  */
 
-void *rtheap_alloc (rtheap_t *heap, u_long size, int mode)
+static void *heap_alloc (rtheap_t *heap, u_long size, int mode)
 
 {
-    u_long bsize, flags;
+    u_long bsize;
     caddr_t block;
     int log2size;
 
@@ -1202,8 +1364,6 @@ void *rtheap_alloc (rtheap_t *heap, u_long size, int mode)
 	     bsize < size; bsize <<= 1, log2size++)
 	    ; /* Loop */
 
-	flags = rt_spin_lock_irqsave(&heap->lock);
-
 	block = heap->buckets[log2size - RTHEAP_MINLOG2];
 
 	if (block == NULL)
@@ -1222,8 +1382,6 @@ void *rtheap_alloc (rtheap_t *heap, u_long size, int mode)
         if (size > heap->maxcont)
             return NULL;
 
-	flags = rt_spin_lock_irqsave(&heap->lock);
-
 	/* Directly request a free page range. */
 	block = get_free_range(heap,size,0,mode);
 
@@ -1233,8 +1391,6 @@ void *rtheap_alloc (rtheap_t *heap, u_long size, int mode)
 
 release_and_exit:
 
-    rt_spin_unlock_irqrestore(flags,&heap->lock);
-
     return block;
 }
 
@@ -1260,17 +1416,15 @@ release_and_exit:
  * context
  */
 
-int rtheap_free (rtheap_t *heap, void *block)
+static int heap_free (rtheap_t *heap, void *block)
 
 {
-    u_long pagenum, pagecont, boffset, bsize, flags;
+    u_long pagenum, pagecont, boffset, bsize;
     caddr_t freepage, lastpage, nextpage, tailpage;
     rtextent_t *extent = NULL;
     struct list_head *holder;
     int log2size, npages;
 
-    flags = rt_spin_lock_irqsave(&heap->lock);
-
     /* Find the extent from which the returned block is
        originating. If the heap is non-extendable, then a single
        extent is scanned at most. */
@@ -1298,7 +1452,6 @@ int rtheap_free (rtheap_t *heap, void *block)
 
 unlock_and_fail:
 
-	    rt_spin_unlock_irqrestore(flags,&heap->lock);
 	    return RTHEAP_PARAM;
 
 	case RTHEAP_PLIST:
@@ -1358,7 +1511,29 @@ unlock_and_fail:
 
     heap->ubytes -= bsize;
 
-    rt_spin_unlock_irqrestore(flags,&heap->lock);
+    return 0;
+}
+
+/* Usable size of an allocated bucketed block, 0 for page ranges. */
+
+static u_long heap_block_size (rtheap_t *heap, void *block)
+
+{
+    rtextent_t *extent;
+    struct list_head *holder;
+    int log2size;
+
+    list_for_each(holder,&heap->extents) {
+
+        extent = list_entry(holder,rtextent_t,link);
+
+	if ((caddr_t)block >= extent->membase &&
+	    (caddr_t)block < extent->memlim)
+	    {
+	    log2size = extent->pagemap[((caddr_t)block - extent->membase) >> heap->pageshift];
+	    return log2size >= RTHEAP_MINLOG2 ? (1 << log2size) : 0;
+	    }
+    }
 
     return 0;
 }
@@ -1412,6 +1587,9 @@ int __rtai_heap_init (void)
 		return 1;
 	}
 	rtai_global_heap_adr = rtai_global_heap.extents.next;
+	if (rtai_heap_magazines && rtheap_mags_init(&rtai_global_heap)) {
+		printk(KERN_INFO "RTAI[malloc]: no memory for the global heap magazines, going without them.\n");
+	}
 	printk(KERN_INFO "RTAI[malloc]: global heap size = %d bytes, <%s>.\n", rtai_global_heap_size, CONFIG_RTAI_USE_TLSF ? "TLSF" : "BSD");
 	return 0;
 }
@@ -1436,6 +1614,8 @@ EXPORT_SYMBOL(rtheap_init);
 EXPORT_SYMBOL(rtheap_destroy);
 EXPORT_SYMBOL(rtheap_alloc);
 EXPORT_SYMBOL(rtheap_free);
+EXPORT_SYMBOL(rtheap_mags_init);
+EXPORT_SYMBOL(rtheap_mags_stats);
 EXPORT_SYMBOL(rtai_global_heap);
 EXPORT_SYMBOL(rtai_global_heap_adr);
 EXPORT_SYMBOL(rtai_global_heap_size);
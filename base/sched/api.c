@@ -32,6 +32,8 @@
 #include <rtai_schedcore.h>
 #include <rtai_prinher.h>
 #include <rtai_registry.h>
+#include <rtai_timepage.h>
+#include <rtai_pool.h>
 
 /* ++++++++++++++++++++++++ COMMON FUNCTIONALITIES ++++++++++++++++++++++++++ */
 
@@ -221,10 +223,9 @@ RTAI_SYSCALL_MODE int rt_change_prio(RT_TASK *task, int priority)
 		do {
 			task->priority = priority;
 			if (task->state == RT_SCHED_READY) {
-				if ((task->rprev)->priority > task->priority || (task->rnext)->priority < task->priority) {
+				if (ready_task_misplaced(task)) {
 					rhead = rt_smp_linux_task[task->runnable_on_cpus].rnext;
-					(task->rprev)->rnext = task->rnext;
-					(task->rnext)->rprev = task->rprev;
+					rem_ready_list(task);
 					enq_ready_task(task);
 					if (rhead != rt_smp_linux_task[task->runnable_on_cpus].rnext) {
 #ifdef CONFIG_SMP
@@ -306,21 +307,13 @@ RT_TASK *rt_whoami(void)
  */
 void rt_task_yield(void)
 {
-	RT_TASK *rt_current, *task;
+	RT_TASK *rt_current;
 	unsigned long flags;
 
 	flags = rt_global_save_flags_and_cli();
 	rt_current = RT_CURRENT;
 	if (rt_smp_linux_task[rt_current->runnable_on_cpus].rnext == rt_current) {
-		task = rt_current->rnext;
-		while (rt_current->priority == task->priority) {
-			task = task->rnext;
-		}
-		if (task != rt_current->rnext) {
-			(rt_current->rprev)->rnext = rt_current->rnext;
-			(rt_current->rnext)->rprev = rt_current->rprev;
-			task->rprev = (rt_current->rprev = task->rprev)->rnext = rt_current;
-			rt_current->rnext = task;
+		if (yield_ready_task(rt_current)) {
 			rt_schedule();
 		}
 	} else {
@@ -674,6 +667,54 @@ void rt_get_boot_epoch(void)
 	int use;
 	_rt_get_boot_epoch(boot_epoch.time[use = 1 - boot_epoch.touse]);
 	boot_epoch.touse = use;
+	rt_update_time_page();
+}
+
+/* +++++++++++++++++++++++++++++ SHARED TIME PAGE +++++++++++++++++++++++++++ */
+
+static struct rt_time_page *rt_time_page;
+static DEFINE_SPINLOCK(rt_time_page_lock);
+
+void rt_update_time_page(void)
+{
+	struct rt_time_page *page;
+	unsigned long flags;
+	int cpuid;
+
+	flags = rt_spin_lock_irqsave(&rt_time_page_lock);
+	if ((page = rt_time_page)) {
+		page->seq++;
+		wmb();
+		page->magic       = RT_TIME_PAGE_MAGIC;
+		page->oneshot     = 1;
+		page->clock_freq  = rtai_tunables.clock_freq;
+		page->epoch_count = boot_epoch.time[boot_epoch.touse][0];
+		page->epoch_ns    = boot_epoch.time[boot_epoch.touse][1];
+		for (cpuid = 0; cpuid < RTAI_NR_CPUS && cpuid < RT_TIME_PAGE_CPUS; cpuid++) {
+			page->periodic_tick[cpuid] = rt_smp_times[cpuid].periodic_tick;
+#if defined(CONFIG_SMP) && defined(CONFIG_RTAI_DIAG_TSC_SYNC) && defined(CONFIG_RTAI_TUNE_TSC_SYNC)
+#ifdef __i386__
+			page->tsc_ofst[cpuid] = -rtai_tsc_ofst[cpuid];
+#else
+			page->tsc_ofst[cpuid] = rtai_tsc_ofst[cpuid];
+#endif
+			page->flags |= RT_TIME_PAGE_TSC_OFST;
+#endif
+		}
+		wmb();
+		page->seq++;
+	}
+	rt_spin_unlock_irqrestore(flags, &rt_time_page_lock);
+}
+
+void rt_set_time_page(struct rt_time_page *page)
+{
+	unsigned long flags;
+
+	flags = rt_spin_lock_irqsave(&rt_time_page_lock);
+	rt_time_page = page;
+	rt_spin_unlock_irqrestore(flags, &rt_time_page_lock);
+	rt_update_time_page();
 }
 
 void rt_gettimeorig(RTIME time_orig[])
@@ -887,7 +928,11 @@ RTAI_SYSCALL_MODE int rt_set_resume_time(RT_TASK *task, RTIME new_resume_time)
 
 	flags = rt_global_save_flags_and_cli();
 	if (task->state & RT_SCHED_DELAYED) {
+#ifdef CONFIG_RTAI_TIMED_LIST_WHEEL
+		if (((task->resume_time = new_resume_time) - (task->tnext)->resume_time) > 0 || rt_twheel_armed(&task->twn)) {
+#else
 		if (((task->resume_time = new_resume_time) - (task->tnext)->resume_time) > 0) {
+#endif
 			rem_timed_task(task);
 			enq_timed_task(task);
 			rt_global_restore_flags(flags);
@@ -1160,6 +1205,43 @@ int rt_renq_current(RT_TASK *rt_current, int priority)
 	return renq_ready_task(rt_current, priority);
 }
 
+/* +++++++++++++++++++++++++ NAMED OBJECTS POOLS ++++++++++++++++++++++++++++ */
+
+#define MAX_NAMED_POOLS  16
+
+static void *named_pool[MAX_NAMED_POOLS];
+
+int rt_set_named_pool(int type, void *pool)
+{
+	if (type < 0 || type >= MAX_NAMED_POOLS) {
+		return -EINVAL;
+	}
+	named_pool[type] = pool;
+	return 0;
+}
+
+void *rt_named_obj_alloc(int type, int size)
+{
+	struct rt_pool *pool;
+	void *obj;
+
+	if ((unsigned)type < MAX_NAMED_POOLS && (pool = named_pool[type]) && pool->objsize >= size && (obj = rt_pool_alloc(pool))) {
+		return obj;
+	}
+	return rt_malloc(size);
+}
+
+void rt_named_obj_free(int type, void *obj)
+{
+	void *pool;
+
+	if ((unsigned)type < MAX_NAMED_POOLS && (pool = named_pool[type]) && rt_pool_owns(pool, obj)) {
+		rt_pool_free(pool, obj);
+	} else {
+		rt_free(obj);
+	}
+}
+
 /* ++++++++++++++++++++++++ NAMED TASK INIT/DELETE ++++++++++++++++++++++++++ */
 
 RTAI_SYSCALL_MODE RT_TASK *rt_named_task_init(const char *task_name, void (*thread)(long), long data, int stack_size, int prio, int uses_fpu, void(*signal)(void))
@@ -1170,13 +1252,15 @@ RTAI_SYSCALL_MODE RT_TASK *rt_named_task_init(const char *task_name, void (*thre
 	if ((task = rt_get_adr(name = nam2num(task_name)))) {
 		return task;
 	}
-        if ((task = rt_malloc(sizeof(RT_TASK))) && !rt_task_init(task, thread, data, stack_size, prio, uses_fpu, signal)) {
+        if ((task = rt_named_obj_alloc(IS_TASK, sizeof(RT_TASK))) && !rt_task_init(task, thread, data, stack_size, prio, uses_fpu, signal)) {
 		if (rt_register(name, task, IS_TASK, 0)) {
 			return task;
 		}
 		rt_task_delete(task);
 	}
-	rt_free(task);
+	if (task) {
+		rt_named_obj_free(IS_TASK, task);
+	}
 	return (RT_TASK *)0;
 }
 
@@ -1188,20 +1272,22 @@ RTAI_SYSCALL_MODE RT_TASK *rt_named_task_init_cpuid(const char *task_name, void
 	if ((task = rt_get_adr(name = nam2num(task_name)))) {
 		return task;
 	}
-        if ((task = rt_malloc(sizeof(RT_TASK))) && !rt_task_init_cpuid(task, thread, data, stack_size, prio, uses_fpu, signal, run_on_cpu)) {
+        if ((task = rt_named_obj_alloc(IS_TASK, sizeof(RT_TASK))) && !rt_task_init_cpuid(task, thread, data, stack_size, prio, uses_fpu, signal, run_on_cpu)) {
 		if (rt_register(name, task, IS_TASK, 0)) {
 			return task;
 		}
 		rt_task_delete(task);
 	}
-	rt_free(task);
+	if (task) {
+		rt_named_obj_free(IS_TASK, task);
+	}
 	return (RT_TASK *)0;
 }
 
 RTAI_SYSCALL_MODE int rt_named_task_delete(RT_TASK *task)
 {
 	if (!rt_task_delete(task)) {
-		rt_free(task);
+		rt_named_obj_free(IS_TASK, task);
 	}
 	return rt_drg_on_adr(task);
 }
@@ -1212,19 +1298,61 @@ RTAI_SYSCALL_MODE int rt_named_task_delete(RT_TASK *task)
 
 #ifdef HASHED_REGISTRY
 
+/*
+ * The registry is an open addressing hash table, names and addresses having
+ * their own probe sequences, the name and address slots of an object being
+ * linked to each other by alink/nlink. Deleted slots are marked by NONAME and
+ * NOADR, unless the following one is empty.
+ * Changes are made under list_lock, within an odd reg_seq, so that plain
+ * lookups (rt_get_adr, rt_get_name, rt_get_type) are lock free, they just
+ * probe again if a change overlapped them.
+ * When more than half of the slots are used an srq triggers a Linux work,
+ * which allocates a table about twice as large and rehashes the registry into
+ * it. The rehash is made out of the lock, a few slots at a time, the names
+ * changed meanwhile being logged and then replayed within the lock, along
+ * with the table switch, so that RT callers are delayed just by the replay.
+ * Replaced tables are freed only at module exit, since a lookup, also from a
+ * preemptible Linux context, may still be walking any of them. Tables grow
+ * by doubling, so they cannot take more than twice the memory of the last.
+ */
+
 int max_slots;
-static struct rt_registry_entry *lxrt_list;
+
+struct rt_registry_table {
+	int size;
+	struct rt_registry_table *older;
+	struct rt_registry_entry list[0];  // slots go from 1 to size
+};
+
+static struct rt_registry_table *volatile reg_table;
 static DEFINE_SPINLOCK(list_lock);
+static volatile unsigned long reg_seq;
+static int reg_count, reg_growing, reg_srq = -1;
 
-#define COLLISION_COUNT() do { col++; } while(0)
-static unsigned long long col;
-#ifndef COLLISION_COUNT
-#define COLLISION_COUNT()
-#endif
+#define REG_LOG_SIZE    256
+#define REG_COPY_CHUNK  16
+#define REG_COPY_TRIES  4
+
+/* Names changed while a grown table is being filled, see reg_grow_fun. */
+static struct {
+	int logging, overflow, n;
+	unsigned long name[REG_LOG_SIZE];
+} reg_log;
 
 #define NONAME  (1UL)
 #define NOADR   ((void *)1)
 
+#define REGISTRY_MAX_SLOTS  (1 << 22)
+
+/* Lookups statistics are per CPU, not to share a cache line among readers. */
+static struct {
+	unsigned long lookups, probes, retries, max_probe;
+} ____cacheline_aligned reg_lookup_stats[RTAI_NR_CPUS];
+
+static struct {
+	unsigned long inserts, probes, max_probe, growths, growth_fails;
+} reg_stats;
+
 #define PRIMES_TAB_GRANULARITY  100
 
 static unsigned short primes[ ] = { 1, 103, 211, 307, 401, 503, 601, 701, 809, 907, 1009, 1103, 1201, 1301, 1409, 1511, 1601, 1709, 1801, 1901, 2003, 2111, 2203, 2309, 2411, 2503, 2609, 2707, 2801, 2903, 3001, 3109, 3203, 3301, 3407, 3511,
@@ -1232,249 +1360,417 @@ static unsigned short primes[ ] = { 1, 103, 211, 307, 401, 503, 601, 701, 809, 9
 7603, 7703, 7817, 7901, 8009, 8101, 8209, 8311, 8419, 8501, 8609, 8707, 8803, 8923, 9001, 9103, 9203, 9311, 9403, 9511, 9601, 9719, 9803, 9901, 10007, 10103, 10211, 10301, 10427, 10501, 10601, 10709, 10831, 10903, 11003, 11113, 11213, 11311, 11411, 11503, 11597, 11617, 11701, 11801, 11903, 12007, 12101, 12203, 12301, 12401, 12503, 12601, 12703, 12809, 12907, 13001, 13103, 13217, 13309, 13411, 13513, 13613, 13709, 13807, 13901, 14009, 14107, 14207, 14303, 14401, 14503, 14621,
 14713, 14813, 14923, 15013, 15101, 15217, 15307, 15401, 15511, 15601, 15727, 15803, 15901, 16001, 16103, 16217, 16301, 16411, 16519, 16603, 16703, 16811, 16901, 17011, 17107, 17203, 17317, 17401, 17509, 17609, 17707, 17807, 17903, 18013, 18119, 18211, 18301, 18401, 18503, 18617, 18701, 18803, 18911, 19001, 19121, 19207, 19301, 19403, 19501, 19603, 19709, 19801, 19913, 20011, 20101 };
 
-#define hash_fun(m, n) ((m)%(n) + 1)
+/*
+ * Names and addresses are often sequential, or aligned, the scrambling avoids
+ * them piling up in clusters, which linear probing would make long to skip.
+ */
+static inline unsigned long hash_mix(unsigned long m)
+{
+	m ^= m >> 16;
+	m *= 0x45d9f3bUL;
+	return m ^ (m >> 16);
+}
 
-static inline int hash_ins_adr(void *adr, struct rt_registry_entry *list, int lstlen, int nlink)
+#define hash_fun(m, n) (hash_mix(m)%(n) + 1)
+
+static inline int next_slot(struct rt_registry_table *t, int k)
+{
+	return k < t->size ? k + 1 : 1;
+}
+
+static inline unsigned long reg_write_lock(void)
 {
-	int i, k;
 	unsigned long flags;
+	flags = rt_spin_lock_irqsave(&list_lock);
+	reg_seq++;
+	smp_wmb();
+	return flags;
+}
 
-	i = hash_fun((unsigned long)adr, lstlen);
-	while (1) {
-		k = i;
-		while (list[k].adr > NOADR && list[k].adr != adr) {
-COLLISION_COUNT();
-			if (++k > lstlen) {
-				k = 1;
-			}
-			if (k == i) {
-				return 0;
-			}
-		}
-		flags = rt_spin_lock_irqsave(&list_lock);
-		if (list[k].adr == adr) {
-			rt_spin_unlock_irqrestore(flags, &list_lock);
-			return -k;
-		} else if (list[k].adr <= NOADR) {
-			list[k].adr       = adr;
-			list[k].nlink     = nlink;
-			list[nlink].alink = k;
-			rt_spin_unlock_irqrestore(flags, &list_lock);
-			return k;
+static inline void reg_write_unlock(unsigned long flags)
+{
+	smp_wmb();
+	reg_seq++;
+	rt_spin_unlock_irqrestore(flags, &list_lock);
+}
+
+#define REG_READ_BEGIN(seq) \
+	do { \
+		while (((seq) = reg_seq) & 1) { \
+			cpu_relax(); \
+		} \
+		smp_rmb(); \
+	} while (0)
+
+#define REG_READ_RETRY(seq)  ({ smp_rmb(); (seq) != reg_seq; })
+
+static inline void reg_count_lookup(int probes, int retries)
+{
+	int cpuid = rtai_cpuid();
+	reg_lookup_stats[cpuid].lookups++;
+	reg_lookup_stats[cpuid].probes  += probes;
+	reg_lookup_stats[cpuid].retries += retries;
+	if (probes > reg_lookup_stats[cpuid].max_probe) {
+		reg_lookup_stats[cpuid].max_probe = probes;
+	}
+}
+
+/* From here down to hash_find_name the lock must be held. */
+
+static inline void reg_log_change(unsigned long name)
+{
+	if (reg_log.logging) {
+		if (reg_log.n < REG_LOG_SIZE) {
+			reg_log.name[reg_log.n++] = name;
+		} else {
+			reg_log.overflow = 1;
 		}
-		rt_spin_unlock_irqrestore(flags, &list_lock);
 	}
 }
 
-static int hash_ins_name(unsigned long name, void *adr, int type, struct task_struct *lnxtsk, struct rt_registry_entry *list, int lstlen, int inc)
+static int hash_name_slot(struct rt_registry_table *t, unsigned long name)
 {
 	int i, k;
-	unsigned long flags;
 
-	i = hash_fun(name, lstlen);
-	while (1) {
-		k = i;
-		while (list[k].name > NONAME && list[k].name != name) {
-COLLISION_COUNT();
-			if (++k > lstlen) {
-				k = 1;
-			}
-			if (k == i) {
-				return 0;
-			}
-		}
-		flags = rt_spin_lock_irqsave(&list_lock);
-		if (list[k].name == name) {
-			if (inc) {
-				list[k].count++;
-			}
-			rt_spin_unlock_irqrestore(flags, &list_lock);
-			return -k;
-		} else if (list[k].name <= NONAME) {
-			list[k].name  = name;
-			list[k].type  = type;
-			list[k].tsk   = lnxtsk;
-			list[k].count = 1;
-			list[k].alink = 0;
-			rt_spin_unlock_irqrestore(flags, &list_lock);
-	                if (hash_ins_adr(adr, list, lstlen, k) <= 0) {
-        	                return 0;
-                	}
+	k = i = hash_fun(name, t->size);
+	while (t->list[k].name) {
+		if (t->list[k].name == name) {
 			return k;
 		}
-		rt_spin_unlock_irqrestore(flags, &list_lock);
+		if ((k = next_slot(t, k)) == i) {
+			break;
+		}
 	}
+	return 0;
 }
 
-static void *hash_find_name(unsigned long name, struct rt_registry_entry *list, long lstlen, int inc, int *slot)
+static int hash_adr_slot(struct rt_registry_table *t, void *adr)
 {
 	int i, k;
-	unsigned long flags;
 
-	i = hash_fun(name, lstlen);
-	while (1) {
-		k = i;
-		while (list[k].name && list[k].name != name) {
-COLLISION_COUNT();
-			if (++k > lstlen) {
-				k = 1;
-			}
-			if (k == i) {
-				return NULL;
-			}
+	k = i = hash_fun((unsigned long)adr, t->size);
+	while (t->list[k].adr) {
+		if (t->list[k].adr == adr) {
+			return k;
 		}
-		flags = rt_spin_lock_irqsave(&list_lock);
-		if (list[k].name == name) {
-			if (inc) {
-				list[k].count++;
-			}
-			rt_spin_unlock_irqrestore(flags, &list_lock);
-			if (slot) {
-				*slot = k;
-			}
-			return list[list[k].alink].adr;
-		} else if (list[k].name <= NONAME) {
-			rt_spin_unlock_irqrestore(flags, &list_lock);
-			return NULL;
+		if ((k = next_slot(t, k)) == i) {
+			break;
 		}
-		rt_spin_unlock_irqrestore(flags, &list_lock);
 	}
+	return 0;
 }
 
-static unsigned long hash_find_adr(void *adr, struct rt_registry_entry *list, long lstlen, int inc)
+static int hash_link(struct rt_registry_table *t, unsigned long name, void *adr, int type, struct task_struct *lnxtsk, int count, int *probes)
 {
-	int i, k;
-	unsigned long flags;
+	int i, j, k, n;
 
-	i = hash_fun((unsigned long)adr, lstlen);
-	while (1) {
-		k = i;
-		while (list[k].adr && list[k].adr != adr) {
-COLLISION_COUNT();
-			if (++k > lstlen) {
-				k = 1;
-			}
-			if (k == i) {
-				return 0;
-			}
+	k = i = hash_fun(name, t->size);
+	for (n = 0; t->list[k].name > NONAME; n++) {
+		if ((k = next_slot(t, k)) == i) {
+			return 0;
 		}
-		flags = rt_spin_lock_irqsave(&list_lock);
-		if (list[k].adr == adr) {
-			if (inc) {
-				list[list[k].nlink].count++;
-			}
-			rt_spin_unlock_irqrestore(flags, &list_lock);
-			return list[list[k].nlink].name;
-		} else if (list[k].adr <= NOADR) {
-			rt_spin_unlock_irqrestore(flags, &list_lock);
+	}
+	j = i = hash_fun((unsigned long)adr, t->size);
+	for (*probes = n, n = 0; t->list[j].adr > NOADR; n++) {
+		if ((j = next_slot(t, j)) == i) {
 			return 0;
 		}
-		rt_spin_unlock_irqrestore(flags, &list_lock);
 	}
+	if (n > *probes) {
+		*probes = n;
+	}
+	t->list[k].name  = name;
+	t->list[k].type  = type;
+	t->list[k].tsk   = lnxtsk;
+	t->list[k].count = count;
+	t->list[k].alink = j;
+	t->list[j].adr   = adr;
+	t->list[j].nlink = k;
+	return k;
 }
 
-static int hash_rem_name(unsigned long name, struct rt_registry_entry *list, long lstlen, int dec)
+static void hash_unlink(struct rt_registry_table *t, int k)
 {
-	int i, k;
+	int j;
+
+	t->list[k].name = !t->list[next_slot(t, k)].name ? 0UL : NONAME;
+	j = t->list[k].alink;
+	t->list[j].adr = !t->list[next_slot(t, j)].adr ? NULL : NOADR;
+}
+
+static int hash_ins_name(unsigned long name, void *adr, int type, struct task_struct *lnxtsk)
+{
+	struct rt_registry_table *t;
 	unsigned long flags;
+	int k, probes, grow = 0;
+
+	flags = reg_write_lock();
+	t = reg_table;
+	if ((k = hash_name_slot(t, name))) {
+		reg_log_change(name);
+		t->list[k].count++;
+	} else if (!hash_adr_slot(t, adr) && (k = hash_link(t, name, adr, type, lnxtsk, 1, &probes))) {
+		reg_log_change(name);
+		reg_count++;
+		reg_stats.inserts++;
+		reg_stats.probes += probes;
+		if (probes > reg_stats.max_probe) {
+			reg_stats.max_probe = probes;
+		}
+	}
+	// also when full, a growth may have failed while it was filling up
+	if (2*reg_count > t->size && !reg_growing && reg_srq >= 0) {
+		grow = reg_growing = 1;
+	}
+	reg_write_unlock(flags);
+	if (grow) {
+		rt_pend_linux_srq(reg_srq);
+	}
+	return k;
+}
 
-	k = i = hash_fun(name, lstlen);
-	while (list[k].name && list[k].name != name) {
-COLLISION_COUNT();
-		if (++k > lstlen) {
-			k = 1;
+static void *hash_find_name(unsigned long name, int inc, int *type)
+{
+	struct rt_registry_table *t;
+	unsigned long seq;
+	void *adr;
+	int i, k, probes, retries;
+
+	if (inc) {
+		unsigned long flags;
+		flags = rt_spin_lock_irqsave(&list_lock);
+		t = reg_table;
+		if ((k = hash_name_slot(t, name))) {
+			reg_log_change(name);
+			t->list[k].count++;
+			adr = t->list[t->list[k].alink].adr;
+		} else {
+			adr = NULL;
 		}
-		if (k == i) {
-			return 0;
+		rt_spin_unlock_irqrestore(flags, &list_lock);
+		return adr;
+	}
+	retries = -1;
+	do {
+		REG_READ_BEGIN(seq);
+		retries++;
+		t = reg_table;
+		adr = NULL;
+		k = i = hash_fun(name, t->size);
+		for (probes = 0; t->list[k].name; probes++) {
+			if (t->list[k].name == name) {
+				adr = t->list[t->list[k].alink].adr;
+				if (type) {
+					*type = t->list[k].type;
+				}
+				break;
+			}
+			if ((k = next_slot(t, k)) == i) {
+				break;
+			}
 		}
-	}
-	flags = rt_spin_lock_irqsave(&list_lock);
-	if (list[k].name == name) {
-		if (!dec || (list[k].count && !--list[k].count)) {
-			int j;
-			if ((i = k + 1) > lstlen) {
-				i = 1;
+	} while (REG_READ_RETRY(seq));
+	reg_count_lookup(probes, retries);
+	return adr;
+}
+
+static unsigned long hash_find_adr(void *adr)
+{
+	struct rt_registry_table *t;
+	unsigned long seq, name;
+	int i, k, probes, retries;
+
+	retries = -1;
+	do {
+		REG_READ_BEGIN(seq);
+		retries++;
+		t = reg_table;
+		name = 0;
+		k = i = hash_fun((unsigned long)adr, t->size);
+		for (probes = 0; t->list[k].adr; probes++) {
+			if (t->list[k].adr == adr) {
+				name = t->list[t->list[k].nlink].name;
+				break;
 			}
-			list[k].name = !list[i].name ? 0UL : NONAME;
-			if ((j = list[k].alink)) {
-				if ((i = j + 1) > lstlen) {
-					i = 1;
-				}
-				list[j].adr = !list[i].adr ? NULL : NOADR;
+			if ((k = next_slot(t, k)) == i) {
+				break;
 			}
 		}
+	} while (REG_READ_RETRY(seq));
+	reg_count_lookup(probes, retries);
+	return name;
+}
+
+static int hash_rem_name(unsigned long name, int dec)
+{
+	struct rt_registry_table *t;
+	unsigned long flags;
+	int k;
+
+	flags = reg_write_lock();
+	t = reg_table;
+	if ((k = hash_name_slot(t, name))) {
+		reg_log_change(name);
+		if (!dec || (t->list[k].count && !--t->list[k].count)) {
+			hash_unlink(t, k);
+			reg_count--;
+		}
 		if (dec) {
-			k = list[k].count;
+			k = t->list[k].count;
 		}
-		rt_spin_unlock_irqrestore(flags, &list_lock);
-		return k;
+	} else {
+		k = dec;
 	}
-	rt_spin_unlock_irqrestore(flags, &list_lock);
-	return dec;
+	reg_write_unlock(flags);
+	return k;
 }
 
-static int hash_rem_adr(void *adr, struct rt_registry_entry *list, long lstlen, int dec)
+static int hash_rem_adr(void *adr, int dec)
 {
-	int i, k;
+	struct rt_registry_table *t;
 	unsigned long flags;
-
-	k = i = hash_fun((unsigned long)adr, lstlen);
-	while (list[k].adr && list[k].adr != adr) {
-COLLISION_COUNT();
-		if (++k > lstlen) {
-			k = 1;
-		}
-		if (k == i) {
-			return 0;
+	int j, k;
+
+	flags = reg_write_lock();
+	t = reg_table;
+	if ((j = hash_adr_slot(t, adr))) {
+		k = t->list[j].nlink;
+		reg_log_change(t->list[k].name);
+		if (!dec || (t->list[k].count && !--t->list[k].count)) {
+			hash_unlink(t, k);
+			reg_count--;
 		}
+		k = dec ? t->list[k].count : j;
+	} else {
+		k = dec;
 	}
-	flags = rt_spin_lock_irqsave(&list_lock);
-	if (list[k].adr == adr) {
-		if (!dec || (list[list[k].nlink].count && !--list[list[k].nlink].count)) {
-			int j;
-			if ((i = k + 1) > lstlen) {
-				i = 1;
-			}
-			list[k].adr = !list[i].adr ? NULL : NOADR;
-			j = list[k].nlink;
-			if ((i = j + 1) > lstlen) {
-				i = 1;
+	reg_write_unlock(flags);
+	return k;
+}
+
+/* Copy the slots of old into t, out of the lock, a few at a time. */
+static void reg_copy(struct rt_registry_table *t, struct rt_registry_table *old)
+{
+	struct rt_registry_entry e[REG_COPY_CHUNK];
+	unsigned long seq;
+	int i, k, n, probes;
+
+	for (k = 1; k <= old->size; k += REG_COPY_CHUNK) {
+		do {
+			REG_READ_BEGIN(seq);
+			for (n = 0, i = k; i <= old->size && i < k + REG_COPY_CHUNK; i++) {
+				if (old->list[i].name > NONAME) {
+					e[n] = old->list[i];
+					e[n++].adr = old->list[old->list[i].alink].adr;
+				}
 			}
-			list[j].name = !list[i].name ? 0UL : NONAME;
+		} while (REG_READ_RETRY(seq));
+		for (i = 0; i < n; i++) {
+			hash_link(t, e[i].name, e[i].adr, e[i].type, e[i].tsk, e[i].count, &probes);
 		}
-		if (dec) {
-			k = list[list[k].nlink].count;
+	}
+}
+
+/* Bring the names logged during reg_copy up to date, within the lock. */
+static void reg_replay(struct rt_registry_table *t, struct rt_registry_table *old)
+{
+	int i, k, probes;
+
+	for (i = 0; i < reg_log.n; i++) {
+		if ((k = hash_name_slot(t, reg_log.name[i]))) {
+			hash_unlink(t, k);
+		}
+		if ((k = hash_name_slot(old, reg_log.name[i]))) {
+			hash_link(t, old->list[k].name, old->list[old->list[k].alink].adr, old->list[k].type, old->list[k].tsk, old->list[k].count, &probes);
 		}
+	}
+}
+
+static void reg_grow_fun(struct work_struct *work)
+{
+	struct rt_registry_table *t, *old;
+	unsigned long flags;
+	int size, m, tries;
+
+	old = reg_table;
+	for (size = 2*old->size + 1; ; size += 2) {
+		for (m = 3; m*m <= size && size%m; m += 2);
+		if (m*m > size) {
+			break;
+		}
+	}
+	if (size > REGISTRY_MAX_SLOTS) {
+		// at its limit, leave reg_growing set to stop further requests
+		reg_stats.growth_fails++;
+		return;
+	}
+	if (!(t = vmalloc(sizeof(*t) + (size + 1)*sizeof(struct rt_registry_entry)))) {
+		flags = rt_spin_lock_irqsave(&list_lock);
+		reg_growing = 0;
+		rt_spin_unlock_irqrestore(flags, &list_lock);
+		reg_stats.growth_fails++;
+		return;
+	}
+	for (tries = 0; tries < REG_COPY_TRIES; tries++) {
+		memset(t, 0, sizeof(*t) + (size + 1)*sizeof(struct rt_registry_entry));
+		t->size = size;
+		flags = rt_spin_lock_irqsave(&list_lock);
+		reg_log.logging = 1;
+		reg_log.overflow = reg_log.n = 0;
 		rt_spin_unlock_irqrestore(flags, &list_lock);
-		return k;
+		reg_copy(t, old);
+		flags = reg_write_lock();
+		if (!reg_log.overflow) {
+			reg_replay(t, old);
+			reg_log.logging = 0;
+			t->older = old;
+			reg_table = t;
+			max_slots = size;
+			reg_stats.growths++;
+			reg_growing = 0;
+			reg_write_unlock(flags);
+			return;
+		}
+		reg_write_unlock(flags);
 	}
+	flags = rt_spin_lock_irqsave(&list_lock);
+	reg_log.logging = 0;
+	reg_growing = 0;
 	rt_spin_unlock_irqrestore(flags, &list_lock);
-	return dec;
+	reg_stats.growth_fails++;
+	vfree(t);
+}
+
+static DECLARE_WORK(reg_grow_work, reg_grow_fun);
+
+static void reg_srq_handler(void)
+{
+	schedule_work(&reg_grow_work);
 }
 
 static inline int registr(unsigned long name, void *adr, int type, struct task_struct *lnxtsk)
 {
-	return abs(hash_ins_name(name, adr, type, lnxtsk, lxrt_list, max_slots, 1));
+	return hash_ins_name(name, adr, type, lnxtsk);
 }
 
 static inline int drg_on_name(unsigned long name)
 {
-	return hash_rem_name(name, lxrt_list, max_slots, 0);
+	return hash_rem_name(name, 0);
 } 
 
 static inline int drg_on_name_cnt(unsigned long name)
 {
-	return hash_rem_name(name, lxrt_list, max_slots, -EFAULT);
+	return hash_rem_name(name, -EFAULT);
 } 
 
 static inline int drg_on_adr(void *adr)
 {
-	return hash_rem_adr(adr, lxrt_list, max_slots, 0);
+	return hash_rem_adr(adr, 0);
 } 
 
 static inline int drg_on_adr_cnt(void *adr)
 {
-	return hash_rem_adr(adr, lxrt_list, max_slots, -EFAULT);
+	return hash_rem_adr(adr, -EFAULT);
 } 
 
 static inline unsigned long get_name(void *adr)
@@ -1494,33 +1790,33 @@ static inline unsigned long get_name(void *adr)
 			name = MAX_NAM2NUM + irandu(0xFFFFFFFFUL - MAX_NAM2NUM - 2);
 #endif
 			rt_spin_unlock_irqrestore(flags, &list_lock);
-			if (!hash_find_name(name, lxrt_list, max_slots, 0, NULL)) {
+			if (!hash_find_name(name, 0, NULL)) {
 				return name;
 			}
 		}
 		return 0;
 	} else {
-		return hash_find_adr(adr, lxrt_list, max_slots, 0);
+		return hash_find_adr(adr);
 	}
 	return 0;
 } 
 
 static inline void *get_adr(unsigned long name)
 {
-	return hash_find_name(name, lxrt_list, max_slots, 0, NULL);
+	return hash_find_name(name, 0, NULL);
 } 
 
 static inline void *get_adr_cnt(unsigned long name)
 {
-	return hash_find_name(name, lxrt_list, max_slots, 1, NULL);
+	return hash_find_name(name, 1, NULL);
 } 
 
 static inline int get_type(unsigned long name)
 {
-	int slot;
+	int type;
 
-	if (hash_find_name(name, lxrt_list, max_slots, 0, &slot)) {
-		return lxrt_list[slot].type;
+	if (hash_find_name(name, 0, &type)) {
+		return type;
 	}
         return -EINVAL;
 }
@@ -1528,16 +1824,18 @@ static inline int get_type(unsigned long name)
 unsigned long is_process_registered(struct task_struct *lnxtsk)
 {
 	void *adr = rtai_tskext(lnxtsk, TSKEXT0);
-	return adr ? hash_find_adr(adr, lxrt_list, max_slots, 0) : 0;
+	return adr ? hash_find_adr(adr) : 0;
 }
 
 int rt_get_registry_slot(int slot, struct rt_registry_entry *entry)
 {
+	struct rt_registry_table *t;
 	unsigned long flags;
        	flags = rt_spin_lock_irqsave(&list_lock);
-	if (lxrt_list[slot].name > NONAME) {
-		*entry = lxrt_list[slot];
-		entry->adr = lxrt_list[entry->alink].adr;
+	t = reg_table;
+	if (slot > 0 && slot <= t->size && t->list[slot].name > NONAME) {
+		*entry = t->list[slot];
+		entry->adr = t->list[entry->alink].adr;
 		rt_spin_unlock_irqrestore(flags, &list_lock);
 		return slot;
        	}
@@ -1547,26 +1845,62 @@ int rt_get_registry_slot(int slot, struct rt_registry_entry *entry)
 
 int rt_registry_alloc(void)
 {
+	struct rt_registry_table *t;
+
 	if ((max_slots = (MAX_SLOTS + PRIMES_TAB_GRANULARITY - 1)/(PRIMES_TAB_GRANULARITY)) >= sizeof(primes)/sizeof(primes[0])) {
 		printk("REGISTRY TABLE TOO LARGE FOR AVAILABLE PRIMES\n");
                 return -ENOMEM;
         }
 	max_slots = primes[max_slots];
-	if (!(lxrt_list = vmalloc((max_slots + 1)*sizeof(struct rt_registry_entry)))) {
+	if (!(t = vmalloc(sizeof(*t) + (max_slots + 1)*sizeof(struct rt_registry_entry)))) {
 		printk("NO MEMORY FOR REGISTRY TABLE\n");
                 return -ENOMEM;
 	}
-	memset(lxrt_list, 0, (max_slots + 1)*sizeof(struct rt_registry_entry));
+	memset(t, 0, sizeof(*t) + (max_slots + 1)*sizeof(struct rt_registry_entry));
+	t->size = max_slots;
+	reg_table = t;
+	if ((reg_srq = rt_request_srq(0, reg_srq_handler, 0)) < 0) {
+		printk("NO SRQ FOR REGISTRY GROWTH, THE REGISTRY WILL HAVE %d SLOTS AT MOST\n", max_slots);
+	}
 	return 0;
 }
 
 void rt_registry_free(void)
 {
-	if (lxrt_list) {
-		vfree(lxrt_list);
-		lxrt_list = NULL;
+	struct rt_registry_table *t;
+
+	if (reg_srq >= 0) {
+		rt_free_srq(reg_srq);
+		reg_srq = -1;
+	}
+	cancel_work_sync(&reg_grow_work);
+	while ((t = reg_table)) {
+		reg_table = t->older;
+		vfree(t);
 	}
 }
+
+void rt_registry_stats(struct rt_registry_stats *stats)
+{
+	int cpuid;
+
+	memset(stats, 0, sizeof(*stats));
+	for (cpuid = 0; cpuid < RTAI_NR_CPUS; cpuid++) {
+		stats->lookups += reg_lookup_stats[cpuid].lookups;
+		stats->lookup_probes += reg_lookup_stats[cpuid].probes;
+		stats->lookup_retries += reg_lookup_stats[cpuid].retries;
+		if (reg_lookup_stats[cpuid].max_probe > stats->lookup_max_probe) {
+			stats->lookup_max_probe = reg_lookup_stats[cpuid].max_probe;
+		}
+	}
+	stats->slots = max_slots;
+	stats->used = reg_count;
+	stats->inserts = reg_stats.inserts;
+	stats->insert_probes = reg_stats.probes;
+	stats->insert_max_probe = reg_stats.max_probe;
+	stats->growths = reg_stats.growths;
+	stats->growth_fails = reg_stats.growth_fails;
+}
 #else
 volatile int max_slots;
 static struct rt_registry_entry *lxrt_list;
@@ -1589,6 +1923,12 @@ void rt_registry_free(void)
 	}
 }
 
+void rt_registry_stats(struct rt_registry_stats *stats)
+{
+	memset(stats, 0, sizeof(*stats));
+	stats->slots = max_slots;
+}
+
 static inline int registr(unsigned long name, void *adr, int type, struct task_struct *tsk)
 {
         unsigned long flags;
@@ -2151,13 +2491,17 @@ extern struct proc_dir_entry *rtai_proc_root;
 static int PROC_READ_FUN(rtai_read_lxrt)
 {
 	struct rt_registry_entry entry;
-	char *type_name[] = { "TASK", "SEM", "RWL", "SPL", "MBX", "PRX", "BITS", "TBX", "HPCK" };
+	struct rt_registry_stats stats;
+	char *type_name[] = { "TASK", "SEM", "RWL", "SPL", "MBX", "PRX", "BITS", "TBX", "HPCK", "MQ" };
 	unsigned int i = 1;
 	char name[8];
 	PROC_PRINT_VARS;
 
 	PROC_PRINT("\nRTAI LXRT Information.\n\n");
-	PROC_PRINT("    MAX_SLOTS = %d\n\n", MAX_SLOTS);
+	rt_registry_stats(&stats);
+	PROC_PRINT("    MAX_SLOTS = %d, SLOTS = %d, USED = %d, GROWTHS = %lu (FAILED %lu)\n", MAX_SLOTS, stats.slots, stats.used, stats.growths, stats.growth_fails);
+	PROC_PRINT("    LOOKUPS = %lu, PROBES/LOOKUP = %lu.%02lu, MAX PROBES = %lu, RETRIES = %lu\n", stats.lookups, stats.lookups ? stats.lookup_probes/stats.lookups : 0, stats.lookups ? (100*stats.lookup_probes/stats.lookups)%100 : 0, stats.lookup_max_probe, stats.lookup_retries);
+	PROC_PRINT("    INSERTS = %lu, COLLISIONS/INSERT = %lu.%02lu, MAX COLLISIONS = %lu\n\n", stats.inserts, stats.inserts ? stats.insert_probes/stats.inserts : 0, stats.inserts ? (100*stats.insert_probes/stats.inserts)%100 : 0, stats.insert_max_probe);
 
 //                  1234 123456 0x12345678 ALIEN  0x12345678 0x12345678   1234567      1234567
 
@@ -2231,6 +2575,8 @@ EXPORT_SYMBOL(rt_linux_use_fpu);
 EXPORT_SYMBOL(rt_task_use_fpu);
 EXPORT_SYMBOL(rt_task_signal_handler);
 EXPORT_SYMBOL(rt_gettimeorig);
+EXPORT_SYMBOL(rt_set_time_page);
+EXPORT_SYMBOL(rt_update_time_page);
 EXPORT_SYMBOL(rt_task_make_periodic_relative_ns);
 EXPORT_SYMBOL(rt_task_make_periodic);
 EXPORT_SYMBOL(rt_task_wait_period);
@@ -2255,6 +2601,9 @@ EXPORT_SYMBOL(rt_enqueue_blocked);
 EXPORT_SYMBOL(rt_dequeue_blocked);
 EXPORT_SYMBOL(rt_renq_current);
 EXPORT_SYMBOL(rt_named_task_init);
+EXPORT_SYMBOL(rt_set_named_pool);
+EXPORT_SYMBOL(rt_named_obj_alloc);
+EXPORT_SYMBOL(rt_named_obj_free);
 EXPORT_SYMBOL(rt_named_task_init_cpuid);
 EXPORT_SYMBOL(rt_named_task_delete);
 EXPORT_SYMBOL(is_process_registered);
@@ -2308,12 +2657,19 @@ EXPORT_SYMBOL(nano2count_cpuid);
 EXPORT_SYMBOL(rt_smp_linux_task);
 EXPORT_SYMBOL(rt_smp_current);
 EXPORT_SYMBOL(rt_smp_time_h);
+#ifdef CONFIG_RTAI_BITMAP_READY_LIST
+EXPORT_SYMBOL(rt_smp_ready_map);
+#endif
+#ifdef CONFIG_RTAI_TIMED_LIST_WHEEL
+EXPORT_SYMBOL(rt_smp_twheel);
+#endif
 EXPORT_SYMBOL(wake_up_srq);
 EXPORT_SYMBOL(set_rt_fun_entries);
 EXPORT_SYMBOL(reset_rt_fun_entries);
 EXPORT_SYMBOL(set_rt_fun_ext_index);
 EXPORT_SYMBOL(reset_rt_fun_ext_index);
 EXPORT_SYMBOL(max_slots);
+EXPORT_SYMBOL(rt_registry_stats);
 
 #ifdef CONFIG_SMP
 #endif /* CONFIG_SMP */
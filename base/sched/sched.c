@@ -89,6 +89,14 @@ RT_TASK *rt_smp_current[RTAI_NR_CPUS];
 
 RTIME rt_smp_time_h[RTAI_NR_CPUS];
 
+#ifdef CONFIG_RTAI_BITMAP_READY_LIST
+struct rt_ready_map rt_smp_ready_map[RTAI_NR_CPUS];
+#endif
+
+#ifdef CONFIG_RTAI_TIMED_LIST_WHEEL
+struct rt_twheel rt_smp_twheel[RTAI_NR_CPUS];
+#endif
+
 volatile int rt_sched_timed;
 
 struct klist_t wake_up_hts[RTAI_NR_CPUS];
@@ -251,6 +259,12 @@ int set_rtext(RT_TASK *task, int priority, int uses_fpu, void(*signal)(void), un
 	task->ret_queue.prev = task->ret_queue.next = &(task->ret_queue);
 	task->ret_queue.task = NULL;
 	task->tprev = task->tnext = task->rprev = task->rnext = task;
+#ifdef CONFIG_RTAI_TIMED_LIST_WHEEL
+	rt_twheel_node_init(&task->twn);
+#endif
+#ifdef CONFIG_RTAI_BITMAP_READY_LIST
+	task->rlevel = -1;
+#endif
 	task->blocked_on = NULL;        
 	task->signal = signal;
 	task->unblocked = 0;
@@ -262,6 +276,7 @@ int set_rtext(RT_TASK *task, int priority, int uses_fpu, void(*signal)(void), un
 	task->ExitHook = 0;
 	task->usp_flags = task->usp_flags_mask = task->force_soft = 0;
 	task->msg_buf[0] = 0;
+	task->msg_mm = NULL;
 	task->exectime[0] = task->exectime[1] = 0;
 	task->system_data_ptr = 0;
 	atomic_inc((atomic_t *)(tasks_per_cpu + cpuid));
@@ -382,6 +397,12 @@ int rt_task_init_cpuid(RT_TASK *task, void (*rt_thread)(long), long data, int st
 	task->ret_queue.task = NULL;
 	task->tprev = task->tnext =
 	task->rprev = task->rnext = task;
+#ifdef CONFIG_RTAI_TIMED_LIST_WHEEL
+	rt_twheel_node_init(&task->twn);
+#endif
+#ifdef CONFIG_RTAI_BITMAP_READY_LIST
+	task->rlevel = -1;
+#endif
 	task->blocked_on = NULL;        
 	task->signal = signal;
 	task->unblocked = 0;
@@ -398,6 +419,7 @@ int rt_task_init_cpuid(RT_TASK *task, void (*rt_thread)(long), long data, int st
 
 	task->max_msg_size[0] = (long)rt_thread;
 	task->max_msg_size[1] = data;
+	task->msg_mm = NULL;
 	init_arch_stack();
 	task->schedlat = KernelLatency;
 
@@ -504,17 +526,7 @@ if (CONFIG_RTAI_ALLOW_RR && rt_current->policy > 0) { \
 	if (rt_current->yield_time <= rt_times.tick_time) { \
 		rt_current->rr_remaining = rt_current->rr_quantum; \
 		if (rt_current->state == RT_SCHED_READY) { \
-			RT_TASK *task; \
-			task = rt_current->rnext; \
-			while (rt_current->priority == task->priority) { \
-				task = task->rnext; \
-			} \
-			if (task != rt_current->rnext) { \
-				(rt_current->rprev)->rnext = rt_current->rnext; \
-				(rt_current->rnext)->rprev = rt_current->rprev; \
-				task->rprev = (rt_current->rprev = task->rprev)->rnext = rt_current; \
-				rt_current->rnext = task; \
-			} \
+			yield_ready_task(rt_current); \
 		} \
 	} else { \
 		rt_current->rr_remaining = rt_current->yield_time - rt_times.tick_time; \
@@ -641,8 +653,7 @@ static inline void force_current_soft(RT_TASK *rt_current, int cpuid)
         rt_current->force_soft = 0;
 	rt_current->state &= ~RT_SCHED_READY;;
 	pend_wake_up_hts(lnxtsk = rt_current->lnxtsk, cpuid);
-        (rt_current->rprev)->rnext = rt_current->rnext;
-        (rt_current->rnext)->rprev = rt_current->rprev;
+        rem_ready_list(rt_current);
         rt_schedule();
         rt_current->is_hard = 0;
 	if (rt_current->priority < BASE_SOFT_PRIORITY) {
@@ -754,6 +765,18 @@ do { \
 #endif
 
 
+#ifdef CONFIG_RTAI_TIMED_LIST_WHEEL
+#define SET_NEXT_TWHEEL_SHOT(fire_shot) \
+do { \
+	if (rt_twheel_next(&rt_smp_twheel[cpuid]) < rt_times.intr_time) { \
+		rt_times.intr_time = rt_twheel_next(&rt_smp_twheel[cpuid]); \
+		fire_shot = 1; \
+	} \
+} while (0)
+#else
+#define SET_NEXT_TWHEEL_SHOT(fire_shot)
+#endif
+
 #define SET_NEXT_TIMER_SHOT(fire_shot) \
 do { \
 	fire_shot = 0; \
@@ -772,6 +795,7 @@ do { \
 			break; \
 		} \
 	} \
+	SET_NEXT_TWHEEL_SHOT(fire_shot); \
 } while (0) 
 
 #define IF_GOING_TO_LINUX_CHECK_TIMER_SHOT(fire_shot) \
@@ -1013,11 +1037,13 @@ ksched_exit:
 RTAI_SYSCALL_MODE void rt_spv_RMS(int cpuid)
 {
 	RT_TASK *task;
+	unsigned long flags;
 	int prio;
 	if (cpuid < 0 || cpuid >= num_online_cpus()) {
 		cpuid = rtai_cpuid();
 	}
 	prio = 0;
+	flags = rt_global_save_flags_and_cli();
 	task = &rt_linux_task;
 	while ((task = task->next)) {
 		RT_TASK *task, *htask;
@@ -1031,6 +1057,11 @@ RTAI_SYSCALL_MODE void rt_spv_RMS(int cpuid)
 			}
 		}
 		if (htask) {
+			// off the ready list while its priority is being reassigned
+			if (htask->state == RT_SCHED_READY && htask->is_hard) {
+				rem_ready_list(htask);
+				htask->rprev = htask->rnext = htask;
+			}
 			htask->priority = -1;
 			htask->base_priority = prio++;
 		} else {
@@ -1043,6 +1074,13 @@ ret:	task = &rt_linux_task;
 			task->priority = task->base_priority;
 		}
 	}
+	task = &rt_linux_task;
+	while ((task = task->next)) {
+		if (task->rprev == task && task->state == RT_SCHED_READY && task->is_hard) {
+			enq_ready_task(task);
+		}
+	}
+	rt_global_restore_flags(flags);
 	return;
 }
 
@@ -1560,8 +1598,7 @@ static inline void _rt_schedule_soft_tail(RT_TASK *rt_task, int cpuid)
 {
 	rt_global_cli();
 	rt_task->state &= ~(RT_SCHED_READY | RT_SCHED_SFTRDY);
-	(rt_task->rprev)->rnext = rt_task->rnext;
-	(rt_task->rnext)->rprev = rt_task->rprev;
+	rem_ready_list(rt_task);
 	rt_smp_current[cpuid] = &rt_linux_task;
 	rt_schedule();
 	UNLOCK_LINUX(cpuid);
@@ -1739,8 +1776,7 @@ static RTAI_SYSCALL_MODE void __sthsem_wait(RT_TASK *task, struct sthsem *sem)
 	if (--sem->count < 0) {
 		task->state |= RT_SCHED_SEMAPHORE;
 		NON_RTAI_TASK_SUSPEND(task);
-		(task->rprev)->rnext = task->rnext;
-		(task->rnext)->rprev = task->rprev;
+		rem_ready_list(task);
 		enqueue_blocked(task, &sem->queue, 0);
 		rt_schedule();
 	}
@@ -1830,8 +1866,7 @@ void give_back_to_linux(RT_TASK *rt_task, int keeprio)
 	int rt_priority;
 
 	rt_global_cli();
-	(rt_task->rprev)->rnext = rt_task->rnext;
-	(rt_task->rnext)->rprev = rt_task->rprev;
+	rem_ready_list(rt_task);
 	rt_task->state = 0;
 	pend_wake_up_hts(lnxtsk = rt_task->lnxtsk, rt_task->runnable_on_cpus);
 	active_mm = lnxtsk->active_mm;
@@ -2088,6 +2123,7 @@ static int PROC_READ_FUN(rtai_read_sched)
         int cpuid, i = 1;
 	unsigned long t;
 	RT_TASK *task;
+	struct rtheap_mags_stats mags_stats;
 	PROC_PRINT_VARS;
 
 	PROC_PRINT("\nRTAI LXRT Real Time Task Scheduler.\n\n");
@@ -2101,6 +2137,9 @@ static int PROC_READ_FUN(rtai_read_sched)
 	PROC_PRINT("\n\n");
 
 	PROC_PRINT("Global heap: size = %10d, used = %10lu; <%s>.\n", rtai_global_heap_size, rt_get_heap_mem_used(&rtai_global_heap), RTAI_USES_TLSF ? "TLSF" : "BSD");
+	if (rtheap_mags_stats(&rtai_global_heap, &mags_stats)) {
+		PROC_PRINT("  magazines: cached = %10lu, alloc hits/misses = %lu/%lu, free hits/misses = %lu/%lu.\n", mags_stats.cached, mags_stats.alloc_hits, mags_stats.alloc_misses, mags_stats.free_hits, mags_stats.free_misses);
+	}
 
 	PROC_PRINT("Kstack heap: size = %10d, used = %10lu; <%s>.\n\n", rtai_kstack_heap_size, rt_get_heap_mem_used(&rtai_kstack_heap), RTAI_USES_TLSF ? "TLSF" : "BSD");
 
@@ -2149,6 +2188,9 @@ static int PROC_READ_FUN(rtai_read_sched)
 		while ((task = task->tnext) != &rt_linux_task) {
 			PROC_PRINT("> %p ", task);
 		}
+#ifdef CONFIG_RTAI_TIMED_LIST_WHEEL
+		PROC_PRINT("\nWHEEL: %d parked", rt_smp_twheel[cpuid].count);
+#endif
 		PROC_PRINT("\nREADY\n");
 		task = &rt_linux_task;
 		while ((task = task->rnext) != &rt_linux_task) {
@@ -2597,8 +2639,15 @@ static int __rtai_lxrt_init(void)
                 rt_linux_task.periodic_resume_time = RTAI_TIME_LIMIT;
                 rt_linux_task.tprev = rt_linux_task.tnext =
                 rt_linux_task.rprev = rt_linux_task.rnext = &rt_linux_task;
-#ifdef CONFIG_RTAI_LONG_TIMED_LIST
+#if defined(CONFIG_RTAI_TIMED_LIST_WHEEL)
+		rt_twheel_node_init(&rt_linux_task.twn);
+		rt_twheel_init(&rt_smp_twheel[cpuid], rtai_rdtsc());
+#elif defined(CONFIG_RTAI_LONG_TIMED_LIST)
 		rt_linux_task.rbr.rb_node = NULL;
+#endif
+#ifdef CONFIG_RTAI_BITMAP_READY_LIST
+		rt_linux_task.rlevel = -1;
+		memset(&rt_smp_ready_map[cpuid], 0, sizeof(struct rt_ready_map));
 #endif
 		rt_linux_task.next = 0;
 		rt_linux_task.lnxtsk = current;
@@ -2661,10 +2710,17 @@ static int __rtai_lxrt_init(void)
 #endif
 	printk(".\n");
 	printk(KERN_INFO "RTAI[sched]: hard timer type/freq = %s/%d(Hz); timing: ONESHOT; ", TIMER_NAME, (int)TIMER_FREQ);
-#ifdef CONFIG_RTAI_LONG_TIMED_LIST
-	printk("black/red timed lists.\n");
+#if defined(CONFIG_RTAI_TIMED_LIST_WHEEL)
+	printk("timing wheel timed lists");
+#elif defined(CONFIG_RTAI_LONG_TIMED_LIST)
+	printk("black/red timed lists");
+#else
+	printk("linear timed lists");
+#endif
+#ifdef CONFIG_RTAI_BITMAP_READY_LIST
+	printk(", bitmapped ready lists.\n");
 #else
-	printk("linear timed lists.\n");
+	printk(", linear ready lists.\n");
 #endif
 	printk(KERN_INFO "RTAI[sched]: Linux timer freq = %d (Hz), TimeBase freq = %lu hz.\n", HZ, (unsigned long)tuned.clock_freq);
 	printk(KERN_INFO "RTAI[sched]: timer setup = %d ns, resched latency = %d ns.\n", (int)rtai_imuldiv(tuned.setup_time_TIMER_CPUNIT, 1000000000, tuned.clock_freq), (int)rtai_imuldiv(tuned.sched_latency - tuned.setup_time_TIMER_CPUNIT, 1000000000, tuned.clock_freq));
@@ -63,7 +63,7 @@ static inline void rt_exec_signal(RT_TASK *sigtask, RT_TASK *task)
 	flags = rt_global_save_flags_and_cli();
 	if (sigtask->suspdepth > 0 && !(--sigtask->suspdepth)) {
 		if (task) {
-			sigtask->priority = task->priority; 
+			renq_ready_task(sigtask, task->priority);
  			if (!task->pstate++) {
 				rem_ready_task(task);
 				task->state |= RT_SCHED_SIGSUSP;
@@ -98,7 +98,10 @@ RTAI_SYSCALL_MODE int rt_release_signal(long signal, RT_TASK *task)
 		task = RT_CURRENT;
 	}
 	if (signal >= 0 && RT_SIGNALS && RT_SIGNALS[signal].sigtask) {
-		RT_SIGNALS[signal].sigtask->priority = task->priority;
+		unsigned long flags;
+		flags = rt_global_save_flags_and_cli();
+		renq_ready_task(RT_SIGNALS[signal].sigtask, task->priority);
+		rt_global_restore_flags(flags);
 		RT_SIGNALS[signal].sigtask->rt_signals = NULL;
 		rt_exec_signal(RT_SIGNALS[signal].sigtask, 0);
 		RT_SIGNALS[signal].sigtask = NULL;
@@ -48,6 +48,7 @@ Nov. 2001, Jan Kiszka (Jan.Kiszka@web.de) fix a tiny bug in __task_init.
 #include <rtai_proxies.h>
 #include <rtai_msg.h>
 #include <rtai_schedcore.h>
+#include <rtai_batch.h>
 
 #define MAX_FUN_EXT  16
 struct rt_fun_entry *rt_fun_ext[MAX_FUN_EXT];
@@ -125,25 +126,53 @@ static inline void lxrt_fun_call(RT_TASK *task, void *fun, int narg, long *arg)
 	}
 }
 
+/*
+ * UDC functions can be given the user buffers of their first pair directly,
+ * saving the copies through msg_buf[0], and with them the need of growing it
+ * on the fly. UDC_PEER ones leave those buffers to be copied by the task of
+ * their first argument, in its own context, so they can be passed directly
+ * only if that task shares the caller address space.
+ */
+static inline int lxrt_msg_direct(unsigned long type, long *arg)
+{
+	RT_TASK *peer;
+
+	if (!(type & UDC)) {
+		return 0;
+	}
+	if (!(type & UDC_PEER)) {
+		return 1;
+	}
+	peer = (RT_TASK *)arg[0];
+	return peer && peer->magic == RT_TASK_MAGIC && peer->lnxtsk && peer->lnxtsk->mm == current->mm;
+}
+
 static inline void lxrt_fun_call_wbuf(RT_TASK *rt_task, void *fun, int narg, long *arg, unsigned long type)
 {
-	int rsize, r2size, wsize, w2size, msg_size;
+	int rsize, r2size, wsize, w2size, msg_size, direct;
 	long *wmsg_adr, *w2msg_adr, *fun_args;
 		
 	rsize = r2size = wsize = w2size = 0 ;
 	wmsg_adr = w2msg_adr = NULL;
 	fun_args = arg - 1;
+	if ((direct = lxrt_msg_direct(type, arg))) {
+		rt_task->msg_mm = current->mm;
+	}
 	if (NEED_TO_R(type)) {			
-		rsize = USP_RSZ1(type);
-		rsize = rsize ? fun_args[rsize] : sizeof(long);
+		if (!direct) {
+			rsize = USP_RSZ1(type);
+			rsize = rsize ? fun_args[rsize] : sizeof(long);
+		}
 		if (NEED_TO_R2ND(type)) {
 			r2size = USP_RSZ2(type);
 			r2size = r2size ? fun_args[r2size] : sizeof(long);
 		}
 	}
 	if (NEED_TO_W(type)) {
-		wsize = USP_WSZ1(type);
-		wsize = wsize ? fun_args[wsize] : sizeof(long);
+		if (!direct) {
+			wsize = USP_WSZ1(type);
+			wsize = wsize ? fun_args[wsize] : sizeof(long);
+		}
 		if (NEED_TO_W2ND(type)) {
 			w2size = USP_WSZ2(type);
 			w2size = w2size ? fun_args[w2size] : sizeof(long);
@@ -188,11 +217,12 @@ static inline void lxrt_fun_call_wbuf(RT_TASK *rt_task, void *fun, int narg, lon
        		}
 	}
 	lxrt_fun_call(rt_task, fun, narg, arg);
+	rt_task->msg_mm = NULL;
 	if (wsize) {
 		rt_copy_to_user(wmsg_adr, rt_task->msg_buf[0], wsize);
-		if (w2size) {
-			rt_copy_to_user(w2msg_adr, rt_task->msg_buf[1], w2size);
-		}
+	}
+	if (w2size) {
+		rt_copy_to_user(w2msg_adr, rt_task->msg_buf[1], w2size);
 	}
 }
 
@@ -336,6 +366,89 @@ EXPORT_SYMBOL(rt_make_soft_real_time);
 static long kernel_calibrator_spv(long period, long loops, RT_TASK *task);
 #endif
 
+static inline long long handle_lxrt_fun_request(unsigned int lxsrq, long *arg, RT_TASK *task)
+{
+	unsigned long type;
+	struct rt_fun_entry *funcm;
+	int srq = SRQ(lxsrq);
+/*
+ * The next two lines of code do a lot. It makes possible to extend the use of
+ * USP to any other real time module service in user space, both for soft and
+ * hard real time. Concept contributed and copyrighted by: Giuseppe Renoldi 
+ * (giuseppe@renoldi.org).
+ */
+	if (unlikely(!(funcm = rt_fun_ext[INDX(lxsrq)]))) {
+		rt_printk("BAD: null rt_fun_ext, no module for extension %d?\n", INDX(lxsrq));
+		return -ENOSYS;
+	}
+	if (!(type = funcm[srq].type)) {
+		return ((RTAI_SYSCALL_MODE long long (*)(unsigned long, ...))funcm[srq].fun)(RTAI_FUN_ARGS);
+	}
+	if (unlikely(NEED_TO_RW(type))) {
+		lxrt_fun_call_wbuf(task, funcm[srq].fun, LXRT_NARG(lxsrq), arg, type);
+	} else {
+		lxrt_fun_call(task, funcm[srq].fun, LXRT_NARG(lxsrq), arg);
+	}
+	return task->retval;
+}
+
+/*
+ * Run the requests queued on a batch ring, see rtai_batch.h. The ring is
+ * shared with user space, so its geometry is checked against the size it
+ * was registered with, each entry is copied before being used and nothing
+ * read from it is trusted beyond the ring masks.
+ */
+static long lxrt_batch_submit(unsigned long name, long max, RT_TASK *task)
+{
+	struct rt_batch_ring *ring;
+	struct rt_batch_cqe *cqe;
+	unsigned int entries, sq_head, sq_tail, cq_tail, lxsrq;
+	unsigned long user_data;
+	long arg[RTAI_MAX_FUN_ARGS];
+	long long retval;
+	long done;
+	int size;
+
+	BUILD_BUG_ON(RT_BATCH_ARGS < RTAI_MAX_FUN_ARGS);
+	if (!task || !(ring = rt_get_adr(name)) || (size = rt_get_type(name)) < (int)RT_BATCH_HDR_SIZE) {
+		return -EINVAL;
+	}
+	entries = ring->entries;
+	if (!entries || entries > (unsigned int)size || (entries & (entries - 1)) || RT_BATCH_SIZE((unsigned long)entries) > (unsigned long)size) {
+		return -EINVAL;
+	}
+	sq_head = ring->sq_head;
+	sq_tail = ring->sq_tail;
+	cq_tail = ring->cq_tail;
+	if (sq_tail - sq_head > entries) {
+		return -EINVAL;
+	}
+	rmb();
+	for (done = 0; sq_head != sq_tail && (max <= 0 || done < max) && cq_tail - ring->cq_head < entries; done++) {
+		struct rt_batch_sqe *sqe = RT_BATCH_SQE(ring, sq_head & (entries - 1));
+		lxsrq = sqe->lxsrq;
+		user_data = sqe->user_data;
+		if (SRQ(lxsrq) >= MAX_LXRT_FUN) {
+			retval = -ENOSYS;
+		} else if (LXRT_NARG(lxsrq) > sizeof(arg)) {
+			retval = -EINVAL;
+		} else {
+			memcpy(arg, sqe->args, sizeof(arg));
+			retval = handle_lxrt_fun_request(lxsrq, arg, task);
+		}
+		cqe = RT_BATCH_CQE(ring, entries, cq_tail & (entries - 1));
+		cqe->user_data = user_data;
+		cqe->retval = retval;
+		ring->sq_head = ++sq_head;
+		wmb();
+		ring->cq_tail = ++cq_tail;
+		if (unlikely(task->unblocked || task->force_soft || task->is_hard < 0)) {
+			return done + 1;
+		}
+	}
+	return done;
+}
+
 static inline long long handle_lxrt_request (unsigned int lxsrq, long *uarg, RT_TASK *task)
 {
 #define larg ((struct arg *)arg)
@@ -352,27 +465,7 @@ static inline long long handle_lxrt_request (unsigned int lxsrq, long *uarg, RT_
 #endif
 
 	if (likely((srq = SRQ(lxsrq)) < MAX_LXRT_FUN)) {
-		unsigned long type;
-		struct rt_fun_entry *funcm;
-/*
- * The next two lines of code do a lot. It makes possible to extend the use of
- * USP to any other real time module service in user space, both for soft and
- * hard real time. Concept contributed and copyrighted by: Giuseppe Renoldi 
- * (giuseppe@renoldi.org).
- */
-		if (unlikely(!(funcm = rt_fun_ext[INDX(lxsrq)]))) {
-			rt_printk("BAD: null rt_fun_ext, no module for extension %d?\n", INDX(lxsrq));
-			return -ENOSYS;
-		}
-		if (!(type = funcm[srq].type)) {
-			return ((RTAI_SYSCALL_MODE long long (*)(unsigned long, ...))funcm[srq].fun)(RTAI_FUN_ARGS);
-		}
-		if (unlikely(NEED_TO_RW(type))) {
-			lxrt_fun_call_wbuf(task, funcm[srq].fun, LXRT_NARG(lxsrq), arg, type);
-		} else {
-			lxrt_fun_call(task, funcm[srq].fun, LXRT_NARG(lxsrq), arg);
-	        }
-		return task->retval;
+		return handle_lxrt_fun_request(lxsrq, arg, task);
 	}
 
 	arg0.name = arg[0];
@@ -382,6 +475,12 @@ static inline long long handle_lxrt_request (unsigned int lxsrq, long *uarg, RT_
 			return arg0.ll;
 		}
 
+		case LXRT_BATCH_SUBMIT: {
+			struct arg { unsigned long name; long max; };
+			arg0.ll = lxrt_batch_submit(arg0.name, larg->max, task);
+			return arg0.ll;
+		}
+
 		case LXRT_GET_NAME: {
 			arg0.name = rt_get_name(arg0.p);
 			return arg0.ll;
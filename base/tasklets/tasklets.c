@@ -159,7 +159,7 @@ static struct rt_fun_entry rt_tasklet_fun[] = {
 	
 };
 
-#ifdef CONFIG_RTAI_LONG_TIMED_LIST
+#if defined(CONFIG_RTAI_LONG_TIMED_LIST) && !defined(CONFIG_RTAI_TIMED_LIST_WHEEL)
 
 /* BINARY TREE */
 static inline void enq_timer(struct rt_tasklet_struct *timed_timer)
@@ -172,7 +172,7 @@ static inline void enq_timer(struct rt_tasklet_struct *timed_timer)
 	while (*rbtn) {
 		rbtpn = *rbtn;
 		tmrnxt = rb_entry(rbtpn, struct rt_tasklet_struct, rbn);
-		if (timer->firing_time > tmrnxt->firing_time) {
+		if (timed_timer->firing_time > tmrnxt->firing_time) {
 			rbtn = &(rbtpn)->rb_right;
 		} else {
 			rbtn = &(rbtpn)->rb_left;
@@ -188,10 +188,10 @@ static inline void enq_timer(struct rt_tasklet_struct *timed_timer)
 #define rb_erase_timer(timer) \
 rb_erase(&(timer)->rbn, &timers_list[NUM_CPUS > 1 ? (timer)->cpuid : 0].rbr)
 
-#else /* !CONFIG_RTAI_LONG_TIMED_LIST */
+#else /* !CONFIG_RTAI_LONG_TIMED_LIST || CONFIG_RTAI_TIMED_LIST_WHEEL */
 
 /* LINEAR */
-static inline void enq_timer(struct rt_tasklet_struct *timed_timer)
+static inline void enq_near_timer(struct rt_tasklet_struct *timed_timer)
 {
 	struct rt_tasklet_struct *timer;
 	timer = &timers_list[TIMED_TIMER_CPUID];
@@ -202,7 +202,85 @@ static inline void enq_timer(struct rt_tasklet_struct *timed_timer)
 
 #define rb_erase_timer(timer)
 
-#endif /* CONFIG_RTAI_LONG_TIMED_LIST */
+#ifdef CONFIG_RTAI_TIMED_LIST_WHEEL
+
+/* TIMING WHEEL, in front of the LINEAR list, see rtai_twheel.h */
+static struct rt_twheel timers_wheel[NUM_CPUS];
+
+/* Highest priority parked since the wheel was last found empty. */
+static int timers_wheel_prio[NUM_CPUS];
+
+/* Before anything can test rt_twheel_armed on it. */
+#define init_timer_node(timer)  rt_twheel_node_init(&(timer)->twn)
+
+static inline void note_parked_timer_prio(struct rt_tasklet_struct *timer)
+{
+	if (rt_twheel_armed(&timer->twn) && timer->priority < timers_wheel_prio[TIMER_CPUID]) {
+		timers_wheel_prio[TIMER_CPUID] = timer->priority;
+	}
+}
+
+/*
+ * Parked timers point to their list head, without being linked to it, so
+ * that they are seen as inserted by anybody testing their links.
+ */
+static inline void enq_timer(struct rt_tasklet_struct *timed_timer)
+{
+	if (rt_twheel_near(&timers_wheel[TIMED_TIMER_CPUID], timed_timer->firing_time)) {
+		enq_near_timer(timed_timer);
+	} else {
+		timed_timer->next = timed_timer->prev = &timers_list[TIMED_TIMER_CPUID];
+		rt_twheel_add(&timers_wheel[TIMED_TIMER_CPUID], &timed_timer->twn, timed_timer->firing_time);
+		note_parked_timer_prio(timed_timer);
+	}
+}
+
+static inline void rem_timer(struct rt_tasklet_struct *timer)
+{
+	if (rt_twheel_armed(&timer->twn)) {
+		rt_twheel_del(&timers_wheel[TIMER_CPUID], &timer->twn);
+		if (!timers_wheel[TIMER_CPUID].count) {
+			timers_wheel_prio[TIMER_CPUID] = RT_SCHED_LOWEST_PRIORITY;
+		}
+	} else {
+		(timer->next)->prev = timer->prev;
+		(timer->prev)->next = timer->next;
+	}
+	timer->next = timer->prev = timer;
+}
+
+static inline RTIME first_timer_time(int cpuid)
+{
+	RTIME near_time, far_time;
+	near_time = (timers_list[cpuid].next)->firing_time;
+	far_time  = rt_twheel_next(&timers_wheel[cpuid]);
+	return near_time < far_time ? near_time : far_time;
+}
+
+/* Any timer can anticipate the wheel, so always recheck the first time. */
+#define IS_FIRST_TIMER(timer, cpuid, firing_time)  ((firing_time = first_timer_time(cpuid)), 1)
+
+/* To be called with timers_lock[cpuid] held. */
+static inline void merge_far_timers(int cpuid, RTIME now)
+{
+	struct rt_twheel_node list, *node;
+	list.next = list.prev = &list;
+	if (rt_twheel_expire(&timers_wheel[cpuid], now, &list)) {
+		for (node = list.next; node != &list; node = node->next) {
+			enq_near_timer(container_of(node, struct rt_tasklet_struct, twn));
+		}
+	}
+}
+
+#else /* !CONFIG_RTAI_TIMED_LIST_WHEEL */
+
+#define enq_timer(timed_timer)  enq_near_timer(timed_timer)
+
+#endif /* CONFIG_RTAI_TIMED_LIST_WHEEL */
+
+#endif /* CONFIG_RTAI_LONG_TIMED_LIST && !CONFIG_RTAI_TIMED_LIST_WHEEL */
+
+#ifndef CONFIG_RTAI_TIMED_LIST_WHEEL
 
 static inline void rem_timer(struct rt_tasklet_struct *timer)
 {
@@ -212,6 +290,31 @@ static inline void rem_timer(struct rt_tasklet_struct *timer)
 	rb_erase_timer(timer);
 }
 
+#define first_timer_time(cpuid)  ((timers_list[cpuid].next)->firing_time)
+
+#define IS_FIRST_TIMER(timer, cpuid, firing_time)  (timers_list[cpuid].next == (timer))
+
+#define note_parked_timer_prio(timer)
+
+#define merge_far_timers(cpuid, now)
+
+#define init_timer_node(timer)
+
+#endif /* !CONFIG_RTAI_TIMED_LIST_WHEEL */
+
+/*
+ * Tasks can be on a ready list, indexed by priority, so their priority is
+ * changed through renq_ready_task only.
+ */
+static inline void set_task_prio(RT_TASK *task, int priority)
+{
+	unsigned long flags;
+
+	flags = rt_global_save_flags_and_cli();
+	renq_ready_task(task, priority);
+	rt_global_restore_flags(flags);
+}
+
 /**
  * Insert a tasklet in the list of tasklets to be processed.
  *
@@ -259,7 +362,7 @@ RTAI_SYSCALL_MODE int rt_insert_tasklet(struct rt_tasklet_struct *tasklet, int p
 	if (!pid) {
 		tasklet->task = 0;
 	} else {
-		(tasklet->task)->priority = priority;
+		set_task_prio(tasklet->task, priority);
 		rt_copy_to_user(tasklet->usptasklet, tasklet, sizeof(struct rt_usp_tasklet_struct));
 	}
 // tasklet insertion tasklets_list
@@ -358,7 +461,7 @@ RTAI_SYSCALL_MODE void rt_set_tasklet_priority(struct rt_tasklet_struct *tasklet
 {
 	tasklet->priority = priority;
 	if (tasklet->task) {
-		(tasklet->task)->priority = priority;
+		set_task_prio(tasklet->task, priority);
 	}
 }
 
@@ -400,6 +503,11 @@ static inline void asgn_min_prio(int cpuid)
 	int priority;
 
 	priority = (timer = (timerl = &timers_list[LIST_CPUID])->next)->priority;
+#ifdef CONFIG_RTAI_TIMED_LIST_WHEEL
+	if (timers_wheel_prio[LIST_CPUID] < priority) {
+		priority = timers_wheel_prio[LIST_CPUID];
+	}
+#endif
 	flags = rt_spin_lock_irqsave(lock = &timers_lock[LIST_CPUID]);
 	while ((timer = timer->next) != timerl) {
 		if (timer->priority < priority) {
@@ -411,11 +519,7 @@ static inline void asgn_min_prio(int cpuid)
 	rt_spin_unlock_irqrestore(flags, lock);
 	flags = rt_global_save_flags_and_cli();
 	if ((timer_manager = &timers_manager[LIST_CPUID])->priority > priority) {
-		timer_manager->priority = priority;
-		if (timer_manager->state == RT_SCHED_READY) {
-			rem_ready_task(timer_manager);
-			enq_ready_task(timer_manager);
-		}
+		renq_ready_task(timer_manager, priority);
 	}
 	rt_global_restore_flags(flags);
 }
@@ -479,6 +583,7 @@ RTAI_SYSCALL_MODE int rt_insert_timer(struct rt_tasklet_struct *timer, int prior
 
 // timer initialization
 	timer->uses_fpu    = 0;
+	init_timer_node(timer);
 	
 	if (pid >= 0) {
 		if (!handler) {
@@ -503,20 +608,20 @@ RTAI_SYSCALL_MODE int rt_insert_timer(struct rt_tasklet_struct *timer, int prior
 		timer->cpuid = cpuid = NUM_CPUS > 1 ? rtai_cpuid() : 0;
 	} else {
 		timer->cpuid = cpuid = NUM_CPUS > 1 ? (timer->task)->runnable_on_cpus : 0;
-		(timer->task)->priority = priority;
+		set_task_prio(timer->task, priority);
 		rt_copy_to_user(timer->usptasklet, timer, sizeof(struct rt_usp_tasklet_struct));
 	}
 // timer insertion in timers_list
 	flags = rt_spin_lock_irqsave(lock = &timers_lock[LIST_CPUID]);
 	enq_timer(timer);
 	rt_spin_unlock_irqrestore(flags, lock);
+	flags = rt_global_save_flags_and_cli();
 // timers_manager priority inheritance
 	if (timer->priority < (timer_manager = &timers_manager[LIST_CPUID])->priority) {
-		timer_manager->priority = timer->priority;
+		renq_ready_task(timer_manager, timer->priority);
 	}
 // timers_task deadline inheritance
-	flags = rt_global_save_flags_and_cli();
-	if (timers_list[LIST_CPUID].next == timer && (timer_manager->state & RT_SCHED_DELAYED) && firing_time < timer_manager->resume_time) {
+	if (IS_FIRST_TIMER(timer, LIST_CPUID, firing_time) && (timer_manager->state & RT_SCHED_DELAYED) && firing_time < timer_manager->resume_time) {
 		timer_manager->resume_time = firing_time;
 		rem_timed_task(timer_manager);
 		enq_timed_task(timer_manager);
@@ -568,8 +673,9 @@ RTAI_SYSCALL_MODE void rt_set_timer_priority(struct rt_tasklet_struct *timer, in
 {
 	timer->priority = priority;
 	if (timer->task) {
-		(timer->task)->priority = priority;
+		set_task_prio(timer->task, priority);
 	}
+	note_parked_timer_prio(timer);
 	asgn_min_prio(TIMER_CPUID);
 }
 
@@ -600,7 +706,7 @@ RTAI_SYSCALL_MODE void rt_set_timer_firing_time(struct rt_tasklet_struct *timer,
 
 	set_timer_firing_time(timer, firing_time);
 	flags = rt_global_save_flags_and_cli();
-	if (timers_list[TIMER_CPUID].next == timer && ((timer_manager = &timers_manager[TIMER_CPUID])->state & RT_SCHED_DELAYED) && firing_time < timer_manager->resume_time) {
+	if (IS_FIRST_TIMER(timer, TIMER_CPUID, firing_time) && ((timer_manager = &timers_manager[TIMER_CPUID])->state & RT_SCHED_DELAYED) && firing_time < timer_manager->resume_time) {
 		timer_manager->resume_time = firing_time;
 		rem_timed_task(timer_manager);
 		enq_timed_task(timer_manager);
@@ -686,9 +792,12 @@ static void rt_timers_manager(long cpuid)
 
 	while (1) {
 		int retval;
-		retval = rt_sleep_until((timerl->next)->firing_time);
+		retval = rt_sleep_until(first_timer_time(LIST_CPUID));
 		now = timer_manager->resume_time + timer_tol;
 		now = rt_get_time() + timer_tol;
+		flags = rt_spin_lock_irqsave(lock);
+		merge_far_timers(LIST_CPUID, now);
+		rt_spin_unlock_irqrestore(flags, lock);
 // find all the timers to be fired, in priority order
 		while (1) {
 			used_fpu = 0;
@@ -703,11 +812,11 @@ static void rt_timers_manager(long cpuid)
 			rt_spin_unlock_irqrestore(flags, lock);
 			if (timer == timerl) {
 				if (timer_manager->priority > TimersManagerPrio) {
-					timer_manager->priority = TimersManagerPrio;
+					set_task_prio(timer_manager, TimersManagerPrio);
 				}
 				break;
 			}
-			timer_manager->priority = priority;
+			set_task_prio(timer_manager, priority);
 #if 1
 			flags = rt_spin_lock_irqsave(lock);
 			rem_timer(timer);
@@ -769,6 +878,7 @@ struct rt_tasklet_struct *rt_init_tasklet(void)
 	struct rt_tasklet_struct *tasklet;
 	if ((tasklet = rt_malloc(sizeof(struct rt_tasklet_struct)))) {
 		memset(tasklet, 0, sizeof(struct rt_tasklet_struct));
+		init_timer_node(tasklet);
 	}
 	return tasklet;
 }
@@ -995,6 +1105,10 @@ int __rtai_tasklets_init(void)
 		timers_list[cpuid] = timers_list[0];
 		timers_list[cpuid].cpuid = cpuid;
 		timers_list[cpuid].next = timers_list[cpuid].prev = &timers_list[cpuid];
+#ifdef CONFIG_RTAI_TIMED_LIST_WHEEL
+		rt_twheel_init(&timers_wheel[cpuid], rt_get_time_cpuid(cpuid));
+		timers_wheel_prio[cpuid] = RT_SCHED_LOWEST_PRIORITY;
+#endif
 		rt_task_init_cpuid(&timers_manager[cpuid], rt_timers_manager, cpuid, TaskletsStacksize, TimersManagerPrio, 0, 0, cpuid);
 		rt_task_resume(&timers_manager[cpuid]);
 	}
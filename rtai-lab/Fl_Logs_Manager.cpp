@@ -17,6 +17,7 @@ License along with this library; if not, see <http://www.gnu.org/licenses/>.
 */
 
 #include <Fl_Logs_Manager.h>
+#include <rlg_binlog.h>
 
 extern int Num_Logs;
 extern Target_Logs_T *Logs;
@@ -143,7 +144,7 @@ int Fl_Logs_Manager::n_points_to_save(int n)
 
 void Fl_Logs_Manager::stop_saving(int n)
 {
-	fclose(Save_File_Pointer[n]);
+	if (Save_File_Pointer[n]) fclose(Save_File_Pointer[n]);
 	Save_Type[n]->activate();
 	if (Save_Type[n]->value()) {
 		Save_Points[n]->activate();
@@ -199,7 +200,9 @@ inline void Fl_Logs_Manager::enable_saving_i(Fl_Light_Button *b, void *v)
 {
 	long n = (long)v;
 	if (b->value()) {
-		if ((Save_File_Pointer[n] = fopen(Save_File[n]->value(), "a+")) == NULL) {
+		if (rlg_binlog_name(Save_File[n]->value())) {
+			Save_File_Pointer[n] = NULL;  // opened by the data thread
+		} else if ((Save_File_Pointer[n] = fopen(Save_File[n]->value(), "a+")) == NULL) {
 			fl_alert("Error in opening file %s", Save_File[n]->value());
 			return;
 		}
@@ -291,54 +291,164 @@ void Fl_Scope::add_to_trace(int n, float val)
   }
 
   if ( n == 0 ) { // trigger logic is only evaluated for first channel
-    if ( (Data_Ptr[0] >= 0) && (Data_Ptr[0] < Trace_Len) ) {  // Aquiring
-      Data_Ptr[0]--;
+    check_trigger(val);
+    // record while rolling, acquiring or, unless a oneshot is kept, waiting
+    // for a trigger, without overwriting the last acquisition
+    Record = (Trigger_Mode != tmHold) &&
+             ((Trigger_Mode == tmRoll) ||
+              ((Data_Ptr[0] >= 0) && (Data_Ptr[0] < Trace_Len)) ||
+              (!OneShot_Flag && (Head - Frame_Start + Trace_Len < TRACE_RING_SIZE)));
+    if ( Record ) {
+      if ( Trigger_Mode == tmRoll ) Frame_Mode = false;
+      Head++;
     }
-    else { // Waiting for trigger 
-      switch ( Trigger_Mode) {
-      case tmRoll: 
-	Trigger = 1;
-        break;
-      case tmOverwrite: 
-        Trigger = 1;
-        break;
-      case tmTriggerCh1Pos: 
-        Trigger = (Prev_Val <= 0) && (val > 0 );
-        Prev_Val = val;
-        break;
-      case tmTriggerCh1Neg: 
-        Trigger = (Prev_Val >= 0) && (val < 0 );
-        Prev_Val = val;
-        break;
-      case tmHold:
-        Trigger = 0;
-        break;
-      default:
-        Trigger =  !Pause_Flag;
-        break;
-      } // case
-      if ( (Trigger && !OneShot_Flag) || // Not a oneshot, just start again when triggered
-	   (Trigger && OneShot_Flag && !Pause_Flag) ) // oneshot: continue if manually retriggered
-        Data_Ptr[0] = Trace_Len-1; 
-    } // if
-  } // trigger logic
-
-
-  // Check index and Add data to the trace, if mode == 0 (roll) move all elements in array:
-  if ( Trigger_Mode == tmRoll ) {
-    memmove(Trace[n] + 1, Trace[n], (Trace_Len - 1)*sizeof(float));
-    Trace[n][0] = val;
-  } else {
-    if ((Data_Ptr[0] >= 0) && (Data_Ptr[0] < Trace_Len && Trigger_Mode != tmHold)) Trace[n][Data_Ptr[0]] = val;
+  }
+
+  // Add data to the trace ring, at the position taken by the first channel
+  if ( Record ) {
+    Trace[n][(Head - 1) & TRACE_RING_MASK] = val;
   }
 		  
 } // add_to_trace
 
+/*
+ * Add a block of n_samples samples, the values of the traces of a sample being
+ * consecutive, from data, and a sample being stride doubles after the previous
+ * one.
+ */
+void Fl_Scope::add_to_traces(const double *data, int n_samples, int stride)
+{
+  int s, n;
+
+  for (s = 0; s < n_samples; s++, data += stride) {
+    for (n = 0; n < num_of_traces; n++) {
+      add_to_trace(n, data[n]);
+    }
+  }
+} // add_to_traces
+
+void Fl_Scope::check_trigger(float val)
+{
+  if ( (Data_Ptr[0] >= 0) && (Data_Ptr[0] < Trace_Len) ) {  // Aquiring
+    Data_Ptr[0]--;
+  }
+  else { // Waiting for trigger 
+    switch ( Trigger_Mode) {
+    case tmRoll: 
+	Trigger = 1;
+      break;
+    case tmOverwrite: 
+      Trigger = 1;
+      break;
+    case tmTriggerCh1Pos: 
+      Trigger = (Prev_Val <= 0) && (val > 0 );
+      Prev_Val = val;
+      break;
+    case tmTriggerCh1Neg: 
+      Trigger = (Prev_Val >= 0) && (val < 0 );
+      Prev_Val = val;
+      break;
+    case tmHold:
+      Trigger = 0;
+      break;
+    default:
+      Trigger =  !Pause_Flag;
+      break;
+    } // case
+    if ( (Trigger && !OneShot_Flag) || // Not a oneshot, just start again when triggered
+	   (Trigger && OneShot_Flag && !Pause_Flag) ) { // oneshot: continue if manually retriggered
+      Data_Ptr[0] = Trace_Len-1; 
+      // a new acquisition starts at the current sample
+      Prev_Frame_Start = Frame_Start;
+      Frame_Start = Head;
+      Frame_Mode = Trigger_Mode != tmRoll;
+    }
+  } // if
+} // check_trigger
+
 void Fl_Scope::add_to_trace(int pos, int n, float val)
 {
 	Trace[n][pos] = val;
 }
 
+/*
+ * Bring the pyramids up to date with the samples recorded since the last
+ * call, the block being filled is redone next time.
+ */
+void Fl_Scope::update_pyramid()
+{
+	for (int n = 0; n < num_of_traces; n++) {
+		trace_pyr_update(Trace[n], Trace_Min[n], Trace_Max[n], Pyr_Head, Head);
+	}
+	Pyr_Head = Head;
+}
+
+/*
+ * Min and max of trace n over the recorded positions [from, to), using the
+ * largest whole pyramid blocks and the samples only at the ends.
+ */
+void Fl_Scope::trace_minmax(int n, long long from, long long to, float *min, float *max)
+{
+	trace_pyr_minmax(Trace[n], Trace_Min[n], Trace_Max[n], from, to, min, max);
+}
+
+/*
+ * Recorded position of the j-th sample from the left of the screen, -1 if
+ * there is none. Rolling, the screen ends at the last sample. Triggered, it
+ * starts with the current acquisition, followed by what remains on screen
+ * of the previous one while the current is in progress.
+ */
+long long Fl_Scope::view_pos(int j)
+{
+	long long pos;
+
+	if (!Frame_Mode) {
+		pos = Head - Trace_Len + j;
+	} else if (j < Head - Frame_Start) {
+		pos = Frame_Start + j;
+	} else if (Prev_Frame_Start < Frame_Start) {
+		pos = Prev_Frame_Start + j;
+	} else {
+		return -1;
+	}
+	return (pos >= 0 && pos >= Head - TRACE_RING_SIZE && pos < Head) ? pos : -1;
+}
+
+/*
+ * Draw the samples from the from-th to the to-th on screen, the j-th being
+ * recorded at start + j. With more than two samples per pixel only the min
+ * and max of those falling in each pixel column are drawn.
+ */
+void Fl_Scope::draw_trace(int n, long long start, int from, int to)
+{
+	float ys = ((float)(h()))/(float)(Y_Range_Sup[n]-Y_Range_Inf[n]), yo = Trace_Offset[n];
+	float min, max;
+	long long first, last;
+	int j, j1, c;
+
+	first = Head > TRACE_RING_SIZE ? Head - TRACE_RING_SIZE : 0;
+	if (start + from < first) from = first - start;
+	if (start + to > Head) to = Head - start;
+	if (from >= to) return;
+	glBegin(GL_LINE_STRIP);
+	if (dx >= 0.5) {
+		for (j = from; j < to; j++) {
+			glVertex2f(j*dx, Trace[n][(start + j) & TRACE_RING_MASK]*ys + yo);
+		}
+	} else {
+		for (c = (int)(from*dx), j = from; j < to; c++) {
+			if ((j1 = (int)ceil((c + 1)/dx)) > to) j1 = to;
+			if (j1 > j) {
+				trace_minmax(n, start + j, start + j1, &min, &max);
+				glVertex2f(c, min*ys + yo);
+				glVertex2f(c, max*ys + yo);
+				j = j1;
+			}
+		}
+	}
+	glEnd();
+}
+
 
 void Fl_Scope::initgl()
 {
@@ -423,18 +533,25 @@ void Fl_Scope::drawstats()
   for (int i = j = 0; (i < num_of_traces) && (j < 4); i++) {
 
     if (Trace_Flags[i] & tfStats) {
-      s.sum=0; s.sum2=0; s.min=1E99; s.max=-1E99;
+      s.sum=0; s.sum2=0; s.min=1E99; s.max=-1E99; s.n=0;
       for (int n = Trace_Len - 1; n >= 0; n--) {
-        s.min = (Trace[i][n] < s.min) ? Trace[i][n] : s.min;
-        s.max = (Trace[i][n] > s.max) ? Trace[i][n] : s.max;
-        s.sum += Trace[i][n];
+        long long pos = view_pos(n);
+        if (pos < 0) continue;
+        float v = Trace[i][pos & TRACE_RING_MASK];
+        s.min = (v < s.min) ? v : s.min;
+        s.max = (v > s.max) ? v : s.max;
+        s.sum += v;
+        s.n++;
       }
 
-      s.n = Trace_Len;
+      if (s.n == 0) s.n = 1;
       s.avg = s.sum / s.n;
       s.pkpk = s.max - s.min;
-      for (int n = Trace_Len - 1; n >= 0; n--) 
-        s.sum2 += (Trace[i][n]-s.avg)*(Trace[i][n]-s.avg);
+      for (int n = Trace_Len - 1; n >= 0; n--) {
+        long long pos = view_pos(n);
+        if (pos < 0) continue;
+        s.sum2 += (Trace[i][pos & TRACE_RING_MASK]-s.avg)*(Trace[i][pos & TRACE_RING_MASK]-s.avg);
+      }
       if (s.sum2 != 0.0) s.rms = sqrt(s.sum2/s.n); else s.rms = 0.0;
      
       s.t1 = t*cursors[0].x;  
@@ -519,6 +636,8 @@ void Fl_Scope::draw()
 
 	dx = w()/(Sampling_Frequency*Time_Range);
 	Trace_Len = ceil((w()/dx));
+	if (Trace_Len > MAX_TRACE_LENGTH) Trace_Len = MAX_TRACE_LENGTH;
+	update_pyramid();
 	glClearColor(Bg_rgb[0], Bg_rgb[1], Bg_rgb[2], 0.0);
 	glClear(GL_COLOR_BUFFER_BIT);
 
@@ -533,15 +652,15 @@ void Fl_Scope::draw()
 	        glLineWidth(Trace_Width[nn]);
 		glColor3f(Trace_rgb[nn][0], Trace_rgb[nn][1], Trace_rgb[nn][2]);
 		if (Trace_Visible[nn]) {
-			glBegin(GL_LINE_STRIP);
-			rtPoint p;
-			p.x = p.y = 0;
-			for (int n = Trace_Len - 1; n >= 0; n--) {
-				p.y = Trace[nn][n]*(((float)(h()))/(float)(Y_Range_Sup[nn]-Y_Range_Inf[nn])) + Trace_Offset[nn];
-				glVertex2f(p.x, p.y);
-				p.x += dx;
+			if (!Frame_Mode) {
+				draw_trace(nn, Head - Trace_Len, 0, Trace_Len);
+			} else {
+				int acquired = Head - Frame_Start < Trace_Len ? Head - Frame_Start : Trace_Len;
+				draw_trace(nn, Frame_Start, 0, acquired);
+				if (Prev_Frame_Start < Frame_Start) {
+					draw_trace(nn, Prev_Frame_Start, acquired, Trace_Len);
+				}
 			}
-			glEnd();
 		}
 	}
 
@@ -658,6 +777,8 @@ Fl_Scope::Fl_Scope(int x, int y, int w, int h, int ntr, const char *title):Fl_Gl
 	Trace_Width = new float[num_of_traces];
 
 	Trace = new float*[num_of_traces];
+	Trace_Min = new float**[num_of_traces];
+	Trace_Max = new float**[num_of_traces];
 	Trace_Flags = new int[num_of_traces];
 	Write_Ptr = new int[num_of_traces];
 	Data_Ptr = new int[num_of_traces];
@@ -674,10 +795,20 @@ Fl_Scope::Fl_Scope(int x, int y, int w, int h, int ntr, const char *title):Fl_Gl
 		Trace_Offset[i] = h/2;
 		Trace_Offset_Value[i] = 1.0;
 		Trace_Width[i] = 0.1;
-		Trace[i] = new float[MAX_TRACE_LENGTH];
+		Trace[i] = new float[TRACE_RING_SIZE];
+		Trace_Min[i] = new float*[TRACE_PYR_LEVELS];
+		Trace_Max[i] = new float*[TRACE_PYR_LEVELS];
+		for (int k = 0; k < TRACE_PYR_LEVELS; k++) {
+			Trace_Min[i][k] = new float[TRACE_RING_SIZE >> (TRACE_PYR_SHIFT + k)];
+			Trace_Max[i][k] = new float[TRACE_RING_SIZE >> (TRACE_PYR_SHIFT + k)];
+		}
 		Write_Ptr[i] =0 ;
 		Trace_Flags[i]=tfNone;
 	}
+	Head = Pyr_Head = 0;
+	Frame_Start = Prev_Frame_Start = 0;
+	Frame_Mode = false;
+	Record = false;
 	Pause_Flag = true;
 	OneShot_Flag = false;
 	Scope_Flags = sfDrawGrid;
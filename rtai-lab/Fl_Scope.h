@@ -25,6 +25,7 @@ License along with this library; if not, see <http://www.gnu.org/licenses/>.
 #include <efltk/Fl_Color.h>
 #include <efltk/gl.h>
 #include <GL/glu.h>
+#include <trace_pyr.h>
 
 #define NDIV_GRID_X           10
 #define NDIV_GRID_Y           8
@@ -91,6 +92,7 @@ class Fl_Scope : public Fl_Gl_Window
 		int trace_length();
 		
 		void add_to_trace(int n, float val);
+		void add_to_traces(const double *data, int n_samples, int stride);
 		
 		void pause(int);
 		int pause();
@@ -135,6 +137,10 @@ class Fl_Scope : public Fl_Gl_Window
 		float dx;
 		int Trace_Len, Trace_Ptr;
 		float **Trace;
+		float ***Trace_Min, ***Trace_Max;
+		long long Head, Pyr_Head;
+		long long Frame_Start, Prev_Frame_Start;
+		int Frame_Mode, Record;
 		int *Write_Ptr;
 		int Pause_Flag;
 		int OneShot_Flag;
@@ -170,6 +176,11 @@ class Fl_Scope : public Fl_Gl_Window
 		int increment_trace_pointer();
 		void write_to_trace(int n, float val);
 		void add_to_trace(int pos, int n, float val);
+		void check_trigger(float val);
+		void update_pyramid();
+		void trace_minmax(int n, long long from, long long to, float *min, float *max);
+		long long view_pos(int j);
+		void draw_trace(int n, long long start, int from, int to);
 
 		void initgl();
 		void drawhline(float y, float c[], float w, GLushort p);
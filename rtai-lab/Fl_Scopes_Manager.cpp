@@ -21,6 +21,7 @@ License along with this library; if not, see <http://www.gnu.org/licenses/>.
 */
 
 #include <Fl_Scopes_Manager.h>
+#include <rlg_binlog.h>
 
 extern int Num_Scopes;
 extern Target_Scopes_T *Scopes;
@@ -414,7 +415,7 @@ int Fl_Scopes_Manager::n_points_to_save(int n)
 
 void Fl_Scopes_Manager::stop_saving(int n)
 {
-	fclose(Save_File_Pointer[n]);
+	if (Save_File_Pointer[n]) fclose(Save_File_Pointer[n]);
 	Save_Type[n]->activate();
 	if (Save_Type[n]->value()) {
 		Save_Points[n]->activate();
@@ -576,7 +577,9 @@ inline void Fl_Scopes_Manager::enable_saving_i(Fl_Light_Button *b, void *v)
 {
 	long n = (long)v;
 	if (b->value()) {
-		if ((Save_File_Pointer[n] = fopen(Save_File[n]->value(), "a+")) == NULL) {
+		if (rlg_binlog_name(Save_File[n]->value())) {
+			Save_File_Pointer[n] = NULL;  // opened by the data thread
+		} else if ((Save_File_Pointer[n] = fopen(Save_File[n]->value(), "a+")) == NULL) {
 			fl_alert("Error in opening file %s", Save_File[n]->value());
 			return;
 		}
@@ -0,0 +1,186 @@
+/*
+COPYRIGHT (C) 2026  The RTAI project
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <rlg_binlog.h>
+
+int rlg_binlog_name(const char *file)
+{
+	int len = strlen(file), ext = strlen(RLG_BINLOG_EXT);
+
+	return len > ext && !strcmp(file + len - ext, RLG_BINLOG_EXT);
+}
+
+Rlg_Binlog *rlg_binlog_open(const char *file, const Rlg_Binlog_Info *info)
+{
+	struct rlg_binlog_header *hdr;
+	Rlg_Binlog *log;
+	size_t size;
+	char *names;
+	int n;
+
+	if (info->nvalues <= 0 || (info->value_size != 4 && info->value_size != 8)) {
+		errno = EINVAL;
+		return NULL;
+	}
+	if (!(log = (Rlg_Binlog *)calloc(1, sizeof(Rlg_Binlog)))) {
+		return NULL;
+	}
+	log->sample_size = info->nvalues*info->value_size;
+	log->chunk_size = RLG_BINLOG_CHUNK_SIZE;
+	while (log->chunk_size < sizeof(struct rlg_binlog_chunk) + 16*log->sample_size) {
+		log->chunk_size *= 2;
+	}
+	log->per_chunk = (log->chunk_size - sizeof(struct rlg_binlog_chunk))/log->sample_size;
+	size = sizeof(struct rlg_binlog_header) + info->nvalues*RLG_BINLOG_NAME_SIZE;
+	size = (size + getpagesize() - 1) & ~((size_t)getpagesize() - 1);
+	if (!(hdr = (struct rlg_binlog_header *)calloc(1, size))) {
+		free(log);
+		return NULL;
+	}
+	strcpy(hdr->magic, RLG_BINLOG_MAGIC);
+	hdr->version     = RLG_BINLOG_VERSION;
+	hdr->byte_order  = RLG_BINLOG_BYTE_ORDER;
+	hdr->header_size = size;
+	hdr->chunk_size  = log->chunk_size;
+	hdr->kind        = info->kind;
+	hdr->value_size  = info->value_size;
+	hdr->nvalues     = info->nvalues;
+	hdr->nrow        = info->nrow;
+	hdr->ncol        = info->ncol;
+	hdr->dt          = info->dt;
+	strncpy(hdr->name, info->name, RLG_BINLOG_NAME_SIZE - 1);
+	names = (char *)(hdr + 1);
+	for (n = 0; n < info->nvalues; n++, names += RLG_BINLOG_NAME_SIZE) {
+		if (info->value_names && info->value_names[n]) {
+			strncpy(names, info->value_names[n], RLG_BINLOG_NAME_SIZE - 1);
+		} else if (info->nrow > 1 && info->ncol > 0) {
+			sprintf(names, "%.40s(%d,%d)", info->name, n%info->nrow + 1, n/info->nrow + 1);
+		} else {
+			sprintf(names, "%.40s(%d)", info->name, n + 1);
+		}
+	}
+	if ((log->fd = open(file, O_RDWR | O_CREAT | O_TRUNC, 0666)) < 0) {
+		goto fail;
+	}
+	if (write(log->fd, hdr, size) != (ssize_t)size) {
+		close(log->fd);
+		goto fail;
+	}
+	free(hdr);
+	log->chunk_ofst = size - log->chunk_size;
+	return log;
+fail:
+	n = errno;
+	free(hdr);
+	free(log);
+	errno = n;
+	return NULL;
+}
+
+/*
+ * Space is allocated for a whole chunk before mapping it, so that a full disk
+ * is reported here, rather than by a SIGBUS while copying.
+ */
+static int next_chunk(Rlg_Binlog *log)
+{
+	off_t ofst = log->chunk_ofst + log->chunk_size;
+	void *map;
+	int err;
+
+	if (log->map) {
+		munmap(log->map, log->chunk_size);
+		log->map = NULL;
+	}
+	if ((err = posix_fallocate(log->fd, ofst, log->chunk_size))) {
+		return -err;
+	}
+	if ((map = mmap(NULL, log->chunk_size, PROT_READ | PROT_WRITE, MAP_SHARED, log->fd, ofst)) == MAP_FAILED) {
+		return -errno;
+	}
+	madvise(map, log->chunk_size, MADV_SEQUENTIAL);
+	log->map = (char *)map;
+	log->chunk_ofst = ofst;
+	log->chunk = (struct rlg_binlog_chunk *)map;
+	log->chunk->magic = RLG_BINLOG_CHUNK_MAGIC;
+	log->chunk->nsamples = 0;
+	log->chunk->first = log->nsamples;
+	return 0;
+}
+
+int rlg_binlog_write(Rlg_Binlog *log, const void *samples, int nsamples)
+{
+	const char *p = (const char *)samples;
+	int n, err;
+
+	while (nsamples > 0) {
+		if (!log->map || log->chunk->nsamples == log->per_chunk) {
+			if ((err = next_chunk(log))) {
+				return err;
+			}
+		}
+		if ((n = log->per_chunk - log->chunk->nsamples) > nsamples) {
+			n = nsamples;
+		}
+		memcpy(log->map + sizeof(struct rlg_binlog_chunk) + log->chunk->nsamples*log->sample_size, p, n*log->sample_size);
+		log->chunk->nsamples += n;
+		log->nsamples += n;
+		p += n*log->sample_size;
+		nsamples -= n;
+	}
+	return 0;
+}
+
+int rlg_binlog_close(Rlg_Binlog *log)
+{
+	off_t end;
+	int err = 0;
+
+	if (log->map) {
+		end = log->chunk_ofst + sizeof(struct rlg_binlog_chunk) + log->chunk->nsamples*log->sample_size;
+		munmap(log->map, log->chunk_size);
+		if (ftruncate(log->fd, end)) {
+			err = -errno;
+		}
+	}
+	if (close(log->fd) && !err) {
+		err = -errno;
+	}
+	free(log);
+	return err;
+}
+
+const struct rlg_binlog_header *rlg_binlog_header(const void *map, size_t size)
+{
+	const struct rlg_binlog_header *hdr = (const struct rlg_binlog_header *)map;
+
+	if (size < sizeof(*hdr) || memcmp(hdr->magic, RLG_BINLOG_MAGIC, sizeof(hdr->magic)) || hdr->version != RLG_BINLOG_VERSION ||
+	    hdr->byte_order != RLG_BINLOG_BYTE_ORDER || hdr->header_size > size || !hdr->nvalues ||
+	    (hdr->value_size != 4 && hdr->value_size != 8) ||
+	    hdr->header_size < sizeof(*hdr) + hdr->nvalues*RLG_BINLOG_NAME_SIZE ||
+	    hdr->chunk_size < sizeof(struct rlg_binlog_chunk) + hdr->nvalues*hdr->value_size) {
+		return NULL;
+	}
+	return hdr;
+}
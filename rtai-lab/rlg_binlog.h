@@ -0,0 +1,109 @@
+/*
+COPYRIGHT (C) 2026  The RTAI project
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+ * BINARY LOGS.
+ *
+ * Scope, log and auto log data saved to a file whose name ends with
+ * RLG_BINLOG_EXT are written in binary, exactly as received from the target,
+ * rather than as "%1.5f" text. The file starts with a self describing header:
+ * the kind and name of the block, its sampling time, the size and number of
+ * the values of a sample, the rows and columns of log matrices, whose values
+ * are stored by columns, and a name for each value. It follows a sequence of
+ * chunks, each one made of a chunk header and of whole samples, all the
+ * chunks but the last one being chunk_size bytes long. Chunks are appended
+ * by memory mapping them, so that saving costs just a memcpy, and as the
+ * count of samples of a chunk is updated after they have been copied a file
+ * left by a crash is readable up to its last complete sample.
+ * Integers and values are in the byte order of the host that saved them,
+ * byte_order telling which one it is.
+ */
+
+#ifndef _RLG_BINLOG_H_
+#define _RLG_BINLOG_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#define RLG_BINLOG_EXT         ".rlb"
+#define RLG_BINLOG_MAGIC       "RTAILAB"
+#define RLG_BINLOG_VERSION     1
+#define RLG_BINLOG_BYTE_ORDER  0x01020304
+#define RLG_BINLOG_CHUNK_MAGIC 0x43474c52  // "RLGC"
+#define RLG_BINLOG_CHUNK_SIZE  (8 << 20)
+#define RLG_BINLOG_NAME_SIZE   64
+
+enum {
+	RLG_BINLOG_SCOPE = 1,
+	RLG_BINLOG_LOG   = 2,
+	RLG_BINLOG_ALOG  = 3,
+};
+
+struct rlg_binlog_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t byte_order;
+	uint32_t header_size;  // chunks start here
+	uint32_t chunk_size;
+	uint32_t kind;
+	uint32_t value_size;   // 4: float, 8: double
+	uint32_t nvalues;      // values per sample
+	uint32_t nrow, ncol;
+	uint32_t reserved;
+	double dt;
+	char name[RLG_BINLOG_NAME_SIZE];
+	// followed by nvalues names of RLG_BINLOG_NAME_SIZE bytes
+};
+
+struct rlg_binlog_chunk {
+	uint32_t magic;
+	uint32_t nsamples;
+	uint64_t first;        // index of the first sample of the chunk
+};
+
+typedef struct {
+	int kind;
+	const char *name;
+	double dt;
+	int value_size, nvalues, nrow, ncol;
+	const char *const *value_names;  // may be NULL
+} Rlg_Binlog_Info;
+
+typedef struct {
+	int fd;
+	size_t sample_size, chunk_size, per_chunk;
+	off_t chunk_ofst;
+	char *map;
+	struct rlg_binlog_chunk *chunk;
+	uint64_t nsamples;
+} Rlg_Binlog;
+
+/* Whether file is to be saved in binary, by its name. */
+int rlg_binlog_name(const char *file);
+
+Rlg_Binlog *rlg_binlog_open(const char *file, const Rlg_Binlog_Info *info);
+
+/* Append nsamples whole samples, returns 0 or -errno. */
+int rlg_binlog_write(Rlg_Binlog *log, const void *samples, int nsamples);
+
+int rlg_binlog_close(Rlg_Binlog *log);
+
+/* Validate a mapped binary log, returns its header or NULL. */
+const struct rlg_binlog_header *rlg_binlog_header(const void *map, size_t size);
+
+#endif
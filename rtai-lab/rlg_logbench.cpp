@@ -0,0 +1,140 @@
+/*
+COPYRIGHT (C) 2026  The RTAI project
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+ * Measures the rate at which xrtailab can save scope samples, in binary, see
+ * rlg_binlog.h, and as the "%1.5f " text it uses otherwise, by writing
+ * synthetic samples in batches of the size a scope thread receives.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <rlg_binlog.h>
+
+static double now(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec*1.0E-9;
+}
+
+static void report(const char *what, double bytes, long long samples, double t)
+{
+	printf("%-8s %10.1f MB in %7.3f s: %8.1f MB/s, %10.0f samples/s\n", what, bytes/1.0E6, t, bytes/1.0E6/t, samples/t);
+}
+
+static void usage(void)
+{
+	fprintf(stderr, "Usage: rlg_logbench [-s MB] [-n traces] [-b samples] [-t] [file]\n"
+			"  -s  binary log size, default 1024 MB\n"
+			"  -n  traces per sample, default 8\n"
+			"  -b  samples per batch, default 256\n"
+			"  -t  also save the same samples as text, for comparison\n"
+			"  file defaults to rlg_logbench" RLG_BINLOG_EXT ", it is removed at the end\n");
+	exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+	Rlg_Binlog_Info info;
+	Rlg_Binlog *log;
+	const char *file = "rlg_logbench" RLG_BINLOG_EXT;
+	long long mb = 1024, samples, n;
+	int c, i, j, ntraces = 8, batch = 256, text = 0, err;
+	double *buf, t, dt = 1.0E-4;
+	char txtfile[256];
+	FILE *fp;
+
+	while ((c = getopt(argc, argv, "s:n:b:th")) != -1) {
+		switch (c) {
+			case 's': mb = atoll(optarg); break;
+			case 'n': ntraces = atoi(optarg); break;
+			case 'b': batch = atoi(optarg); break;
+			case 't': text = 1; break;
+			default: usage();
+		}
+	}
+	if (optind < argc) {
+		file = argv[optind];
+	}
+	if (mb <= 0 || ntraces <= 0 || batch <= 0) {
+		usage();
+	}
+	buf = (double *)malloc(batch*(ntraces + 1)*sizeof(double));
+	samples = (mb << 20)/((ntraces + 1)*sizeof(double));
+
+	info.kind = RLG_BINLOG_SCOPE;
+	info.name = "Bench";
+	info.dt = dt;
+	info.value_size = sizeof(double);
+	info.nvalues = ntraces + 1;
+	info.nrow = 1;
+	info.ncol = ntraces + 1;
+	info.value_names = NULL;
+	if (!(log = rlg_binlog_open(file, &info))) {
+		fprintf(stderr, "Cannot open %s: %s\n", file, strerror(errno));
+		return 1;
+	}
+	t = now();
+	for (n = 0; n < samples; n += batch) {
+		for (i = 0; i < batch; i++) {
+			buf[i*(ntraces + 1)] = (n + i)*dt;
+			for (j = 1; j <= ntraces; j++) {
+				buf[i*(ntraces + 1) + j] = j*(n + i);
+			}
+		}
+		if ((err = rlg_binlog_write(log, buf, n + batch > samples ? samples - n : batch))) {
+			fprintf(stderr, "Error in writing %s: %s\n", file, strerror(-err));
+			return 1;
+		}
+	}
+	if ((err = rlg_binlog_close(log))) {
+		fprintf(stderr, "Error in closing %s: %s\n", file, strerror(-err));
+		return 1;
+	}
+	report("binary", (double)samples*(ntraces + 1)*sizeof(double), samples, now() - t);
+	unlink(file);
+
+	if (text) {
+		snprintf(txtfile, sizeof(txtfile), "%s.txt", file);
+		if (!(fp = fopen(txtfile, "w"))) {
+			fprintf(stderr, "Cannot open %s: %s\n", txtfile, strerror(errno));
+			return 1;
+		}
+		t = now();
+		for (n = 0; n < samples; n++) {
+			fprintf(fp, "%1.5f ", n*dt);
+			for (j = 1; j <= ntraces; j++) {
+				fprintf(fp, "%1.5f ", (double)j*n);
+			}
+			fputc('\n', fp);
+		}
+		fclose(fp);
+		report("text", (double)samples*(ntraces + 1)*sizeof(double), samples, now() - t);
+		unlink(txtfile);
+	}
+	free(buf);
+	return 0;
+}
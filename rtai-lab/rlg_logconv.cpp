@@ -0,0 +1,215 @@
+/*
+COPYRIGHT (C) 2026  The RTAI project
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+ * Converts xrtailab binary logs, see rlg_binlog.h, to CSV text, with a first
+ * line of value names, or to a MATLAB level 4 MAT file, holding a matrix of
+ * doubles named after the block, with a row per sample and a column per
+ * value, and a scalar named after the block followed by "_dt".
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <rlg_binlog.h>
+
+static const struct rlg_binlog_header *Hdr;
+static const char *Map;
+static size_t Map_Size;
+static size_t Sample_Size;
+
+/* Count the samples of all the complete chunks, a truncated one ends the log. */
+static uint64_t count_samples(int *nchunks)
+{
+	const struct rlg_binlog_chunk *chunk;
+	size_t ofst, per_chunk;
+	uint64_t n = 0;
+
+	per_chunk = (Hdr->chunk_size - sizeof(struct rlg_binlog_chunk))/Sample_Size;
+	*nchunks = 0;
+	for (ofst = Hdr->header_size; ofst + sizeof(*chunk) <= Map_Size; ofst += Hdr->chunk_size) {
+		chunk = (const struct rlg_binlog_chunk *)(Map + ofst);
+		if (chunk->magic != RLG_BINLOG_CHUNK_MAGIC || chunk->nsamples > per_chunk ||
+		    chunk->first != n || ofst + sizeof(*chunk) + chunk->nsamples*Sample_Size > Map_Size) {
+			break;
+		}
+		n += chunk->nsamples;
+		++*nchunks;
+	}
+	return n;
+}
+
+static inline const char *chunk_data(int k)
+{
+	return Map + Hdr->header_size + (size_t)k*Hdr->chunk_size + sizeof(struct rlg_binlog_chunk);
+}
+
+static inline uint32_t chunk_samples(int k)
+{
+	return ((const struct rlg_binlog_chunk *)(chunk_data(k) - sizeof(struct rlg_binlog_chunk)))->nsamples;
+}
+
+static inline double value(const char *sample, int i)
+{
+	return Hdr->value_size == sizeof(float) ? ((const float *)sample)[i] : ((const double *)sample)[i];
+}
+
+static const char *value_name(int i)
+{
+	return (const char *)(Hdr + 1) + i*RLG_BINLOG_NAME_SIZE;
+}
+
+static int write_csv(FILE *out, int nchunks)
+{
+	const char *fmt = Hdr->value_size == sizeof(float) ? "%.9g" : "%.17g";
+	const char *p;
+	uint32_t i, s;
+	int k;
+
+	for (i = 0; i < Hdr->nvalues; i++) {
+		fprintf(out, i ? ",%.*s" : "%.*s", RLG_BINLOG_NAME_SIZE, value_name(i));
+	}
+	fputc('\n', out);
+	for (k = 0; k < nchunks; k++) {
+		for (p = chunk_data(k), s = 0; s < chunk_samples(k); s++, p += Sample_Size) {
+			for (i = 0; i < Hdr->nvalues; i++) {
+				if (i) fputc(',', out);
+				fprintf(out, fmt, value(p, i));
+			}
+			fputc('\n', out);
+		}
+	}
+	return ferror(out);
+}
+
+static void mat_header(FILE *out, const char *name, uint32_t mrows, uint32_t ncols)
+{
+	int32_t hdr[5];
+
+	// type 0000: little endian, double, full numeric, 1000 if big endian
+	hdr[0] = *(const unsigned char *)&Hdr->byte_order == 0x04 ? 0 : 1000;
+	hdr[1] = mrows;
+	hdr[2] = ncols;
+	hdr[3] = 0;
+	hdr[4] = strlen(name) + 1;
+	fwrite(hdr, sizeof(hdr), 1, out);
+	fwrite(name, hdr[4], 1, out);
+}
+
+static int write_mat(FILE *out, int nchunks, uint64_t nsamples)
+{
+	char name[RLG_BINLOG_NAME_SIZE + 4];
+	const char *p;
+	uint32_t i, s;
+	double v;
+	int k;
+
+	// a valid MATLAB name: a letter, then letters, digits and underscores
+	strncpy(name + 1, Hdr->name, RLG_BINLOG_NAME_SIZE - 1);
+	name[RLG_BINLOG_NAME_SIZE] = 0;
+	name[0] = 'x';
+	for (p = name + 1; *p; p++) {
+		if (!isalnum((unsigned char)*p)) name[p - name] = '_';
+	}
+	p = isalpha((unsigned char)name[1]) ? name + 1 : name;
+	mat_header(out, p, nsamples, Hdr->nvalues);
+	// column major, a pass over the mapped samples per value
+	for (i = 0; i < Hdr->nvalues; i++) {
+		for (k = 0; k < nchunks; k++) {
+			const char *q = chunk_data(k);
+			for (s = 0; s < chunk_samples(k); s++, q += Sample_Size) {
+				v = value(q, i);
+				fwrite(&v, sizeof(v), 1, out);
+			}
+		}
+	}
+	strcat((char *)p, "_dt");
+	mat_header(out, p, 1, 1);
+	fwrite(&Hdr->dt, sizeof(double), 1, out);
+	return ferror(out);
+}
+
+static void usage(void)
+{
+	fprintf(stderr, "Usage: rlg_logconv [-c | -m] [-i] binlog [output]\n"
+			"  -c  CSV output (default), to stdout if no output file is given\n"
+			"  -m  MATLAB level 4 MAT output\n"
+			"  -i  print the log header only\n");
+	exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+	static const char *kinds[] = { "?", "scope", "log", "auto log" };
+	int c, fd, mat = 0, info = 0, nchunks, err;
+	uint64_t nsamples;
+	struct stat st;
+	FILE *out;
+
+	while ((c = getopt(argc, argv, "cmih")) != -1) {
+		switch (c) {
+			case 'c': mat = 0; break;
+			case 'm': mat = 1; break;
+			case 'i': info = 1; break;
+			default: usage();
+		}
+	}
+	if (optind >= argc || argc - optind > 2 || (mat && argc - optind < 2)) {
+		usage();
+	}
+	if ((fd = open(argv[optind], O_RDONLY)) < 0 || fstat(fd, &st)) {
+		fprintf(stderr, "Cannot open %s: %s\n", argv[optind], strerror(errno));
+		return 1;
+	}
+	Map_Size = st.st_size;
+	if (Map_Size < sizeof(*Hdr) || (Map = (const char *)mmap(NULL, Map_Size, PROT_READ, MAP_SHARED, fd, 0)) == MAP_FAILED ||
+	    !(Hdr = rlg_binlog_header(Map, Map_Size))) {
+		fprintf(stderr, "%s is not an xrtailab binary log\n", argv[optind]);
+		return 1;
+	}
+	close(fd);
+	madvise((void *)Map, Map_Size, MADV_SEQUENTIAL);
+	Sample_Size = Hdr->nvalues*Hdr->value_size;
+	nsamples = count_samples(&nchunks);
+	if (info) {
+		printf("%s %.*s: dt %g, %u x %u %s values, %llu samples\n",
+			kinds[Hdr->kind < 4 ? Hdr->kind : 0], RLG_BINLOG_NAME_SIZE, Hdr->name, Hdr->dt,
+			Hdr->nrow, Hdr->ncol, Hdr->value_size == sizeof(float) ? "float" : "double",
+			(unsigned long long)nsamples);
+		return 0;
+	}
+	if (argc - optind < 2) {
+		out = stdout;
+	} else if (!(out = fopen(argv[optind + 1], "w"))) {
+		fprintf(stderr, "Cannot open %s: %s\n", argv[optind + 1], strerror(errno));
+		return 1;
+	}
+	err = mat ? write_mat(out, nchunks, nsamples) : write_csv(out, nchunks);
+	if (fclose(out) || err) {
+		fprintf(stderr, "Error in writing the converted log\n");
+		return 1;
+	}
+	return 0;
+}
@@ -28,6 +28,7 @@ License along with this library; if not, see <http://www.gnu.org/licenses/>.
 
 #define MAX_RTAI_LEDS               1000
 #define MBX_RTAI_LED_SIZE           5000
+#define SCB_RTAI_LED_SIZE           16384
 
 extern char *TargetLedMbxID;
 
@@ -39,25 +40,25 @@ static void init(scicos_block *block)
   char name[7];
   int nch  = GetNin(block);
   int * ipar = GetIparPtrs(block);
-  MBX *mbx;
+  struct rtai_lab_stream *stream;
 
   par_getstr(ledName,ipar,1,ipar[0]);
   rtRegisterLed(ledName,nch);
   get_a_name(TargetLedMbxID,name);
 
-  mbx = (MBX *) RT_typed_named_mbx_init(0,0,name,MBX_RTAI_LED_SIZE/sizeof(unsigned int)*sizeof(unsigned int),FIFO_Q);
-  if(mbx == NULL) {
+  stream = get_a_stream(name,MBX_RTAI_LED_SIZE/sizeof(unsigned int)*sizeof(unsigned int),SCB_RTAI_LED_SIZE);
+  if(stream == NULL) {
     fprintf(stderr, "Cannot init mailbox\n");
     exit_on_error();
   }
 
-  *(block->work) = mbx;
+  *(block->work) = stream;
 
 }
 
 static void inout(scicos_block *block)
 {
-  MBX * mbx = *(block->work);
+  struct rtai_lab_stream *stream = *(block->work);
   int i;
   unsigned int led_mask = 0;
   int nleds  = GetNin(block);
@@ -71,7 +72,7 @@ static void inout(scicos_block *block)
       led_mask += (0 << i);
     }
   }
-  RT_mbx_send_if(0, 0, mbx, &led_mask, sizeof(led_mask));
+  stream_send(stream, &led_mask, sizeof(led_mask));
 
 }
 
@@ -80,8 +81,8 @@ static void end(scicos_block *block)
   int * ipar = GetIparPtrs(block);
 
   char ledName[10];
-  MBX * mbx = *(block->work);
-  RT_named_mbx_delete(0, 0, mbx);
+  struct rtai_lab_stream *stream = *(block->work);
+  free_a_stream(stream);
   par_getstr(ledName,ipar,1,ipar[0]);
   printf("Led %s closed\n",ledName);
 
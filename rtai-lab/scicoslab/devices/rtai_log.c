@@ -29,6 +29,7 @@ License along with this library; if not, see <http://www.gnu.org/licenses/>.
 
 #define MAX_RTAI_LOGS		1000
 #define MBX_RTAI_LOG_SIZE	5000
+#define SCB_RTAI_LOG_SIZE	65536
 
 extern char *TargetLogMbxID;
 
@@ -41,7 +42,7 @@ static void init(scicos_block *block)
   int mu = GetInPortCols(block,1);
   int nu = GetInPortRows(block,1);
   int * ipar = GetIparPtrs(block);
-  MBX *mbx;
+  struct rtai_lab_stream *stream;
 
   int i;
   if (ipar[0]>20)
@@ -50,20 +51,20 @@ static void init(scicos_block *block)
   par_getstr(logName,ipar,1,ipar[0]);
   rtRegisterLogData(logName,nu,mu);
   get_a_name(TargetLogMbxID,name);
-  mbx = (MBX *) RT_typed_named_mbx_init(0,0,name,(MBX_RTAI_LOG_SIZE/(nu*mu*sizeof(float)))*(nu*mu*sizeof(float)),FIFO_Q);
-  if(mbx == NULL) {
+  stream = get_a_stream(name,(MBX_RTAI_LOG_SIZE/(nu*mu*sizeof(float)))*(nu*mu*sizeof(float)),SCB_RTAI_LOG_SIZE);
+  if(stream == NULL) {
     fprintf(stderr, "Cannot init mailbox\n");
     exit_on_error();
   }
 
-  *(block->work) = mbx;
+  *(block->work) = stream;
 }
 
 static void inout(scicos_block *block)
 {
   double *u;
   int i;
-  MBX * mbx = *(block->work);
+  struct rtai_lab_stream *stream = *(block->work);
   int nu = GetInPortRows(block,1);
   int mu = GetInPortCols(block,1);
   int   datasize=nu*mu;
@@ -75,15 +76,15 @@ static void inout(scicos_block *block)
   for (i = 0; i < (nu*mu); i++) {
     data.u[i] = (float)u[i];
   }
-  RT_mbx_send_if(0, 0, mbx, &data, sizeof(data));
+  stream_send(stream, &data, sizeof(data));
 }
 
 static void end(scicos_block *block)
 {
   char logName[20];
   int * ipar = GetIparPtrs(block);
-  MBX * mbx = *(block->work);
-  RT_named_mbx_delete(0, 0, mbx);
+  struct rtai_lab_stream *stream = *(block->work);
+  free_a_stream(stream);
   par_getstr(logName,ipar,1,ipar[0]);
   printf("Log %s closed\n",logName);
 }
@@ -28,6 +28,7 @@ License along with this library; if not, see <http://www.gnu.org/licenses/>.
 
 #define MAX_RTAI_METERS               1000
 #define MBX_RTAI_METER_SIZE           5000
+#define SCB_RTAI_METER_SIZE           16384
 
 extern char *TargetMeterMbxID;
 
@@ -39,37 +40,37 @@ static void init(scicos_block *block)
 
   char meterName[20];
   char name[7];
-  MBX *mbx;
+  struct rtai_lab_stream *stream;
 
   par_getstr(meterName,ipar,1,ipar[0]);
   rtRegisterMeter(meterName,1);
   get_a_name(TargetMeterMbxID,name);
 
-  mbx = (MBX *) RT_typed_named_mbx_init(0,0,name,MBX_RTAI_METER_SIZE/sizeof(float)*sizeof(float),FIFO_Q);
-  if(mbx == NULL) {
+  stream = get_a_stream(name,MBX_RTAI_METER_SIZE/sizeof(float)*sizeof(float),SCB_RTAI_METER_SIZE);
+  if(stream == NULL) {
     fprintf(stderr, "Cannot init mailbox\n");
     exit_on_error();
   }
 
-  *block->work = mbx;
+  *block->work = stream;
 }
 
 static void inout(scicos_block *block)
 {
   double *u = block->inptr[0];
-  MBX * mbx = *(block->work);
+  struct rtai_lab_stream *stream = *(block->work);
   float data;
   data = (float) u[0];
-  RT_mbx_send_if(0, 0, mbx, &data, sizeof(data));
+  stream_send(stream, &data, sizeof(data));
 }
 
 static void end(scicos_block *block)
 {
   char meterName[10];
   int * ipar = GetIparPtrs(block);
-  MBX * mbx = (MBX *) (*block->work);
+  struct rtai_lab_stream *stream = *(block->work);
 
-  RT_named_mbx_delete(0, 0, mbx);
+  free_a_stream(stream);
   par_getstr(meterName,ipar,1,ipar[0]);
   printf("Meter %s closed\n",meterName);
 }
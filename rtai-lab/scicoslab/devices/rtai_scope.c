@@ -29,6 +29,7 @@ License along with this library; if not, see <http://www.gnu.org/licenses/>.
 #include "rtmain.h"
 
 #define MBX_RTAI_SCOPE_SIZE           5000
+#define SCB_RTAI_SCOPE_SIZE           65536
 
 extern char *TargetMbxID;
 
@@ -37,24 +38,24 @@ static void init(scicos_block *block)
   char name[7];
   int nch = GetNin(block);
   int nt = nch+1;
-  MBX *mbx;
+  struct rtai_lab_stream *stream;
 
   rtRegisterScope(Getint8OparPtrs(block,1), (char**)&block->oparptr[1], nch);
   get_a_name(TargetMbxID,name);
 
-  mbx = (MBX *) RT_typed_named_mbx_init(0,0,name,(MBX_RTAI_SCOPE_SIZE/(nt*sizeof(double)))*(nt*sizeof(double)),FIFO_Q);
-  if(mbx == NULL) {
+  stream = get_a_stream(name,(MBX_RTAI_SCOPE_SIZE/(nt*sizeof(double)))*(nt*sizeof(double)),SCB_RTAI_SCOPE_SIZE);
+  if(stream == NULL) {
     fprintf(stderr, "Cannot init mailbox\n");
     exit_on_error();
   }
 
-  *(block->work) = mbx;
+  *(block->work) = stream;
 }
 
 static void inout(scicos_block *block)
 {
   double *u;
-  MBX *mbx = *(block->work);
+  struct rtai_lab_stream *stream = *(block->work);
 
   int ntraces=GetNin(block);
   struct {
@@ -68,13 +69,13 @@ static void inout(scicos_block *block)
     u = block->inptr[i];
     data.u[i] = u[0];
   }
-  RT_mbx_send_if(0, 0, mbx, &data, sizeof(data));
+  stream_send(stream, &data, sizeof(data));
 }
 
 static void end(scicos_block *block)
 {
-  MBX *mbx = *(block->work);
-  RT_named_mbx_delete(0, 0, mbx);
+  struct rtai_lab_stream *stream = *(block->work);
+  free_a_stream(stream);
   printf("Scope %s closed\n", Getint8OparPtrs(block,1));
 }
 
@@ -18,7 +18,17 @@ License along with this library; if not, see <http://www.gnu.org/licenses/>.
 
 */
 
-void *get_a_name(const char *root, char *name);
+struct rtai_lab_stream {
+  void *mbx;
+  void *scb;
+  unsigned long scb_name;
+  unsigned long overruns;  // samples dropped, the ring being full
+};
+
+char *get_a_name(const char *root, char *name);
+struct rtai_lab_stream *get_a_stream(const char *name, int mbx_size, int scb_size);
+int stream_send(struct rtai_lab_stream *stream, void *msg, int msg_size);
+void free_a_stream(struct rtai_lab_stream *stream);
 int rtRegisterScope(char *name, char **traceNames, int n);
 int rtRegisterLed(const char *name, int n);
 int rtRegisterMeter(const char *name, int n);
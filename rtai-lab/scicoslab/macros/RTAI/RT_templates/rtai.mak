@@ -38,6 +38,11 @@ CFLAGS = $(CC_OPTIONS) -O2 -I$(SCIDIR)/routines -I$(SCIDIR)/routines/scicos $(C_
 rtmain44.c: $(RTAIDIR)/share/rtai/scicos/rtmain44.c $(MODEL).c
 	cp $< .
 
+rtmain.h: $(RTAIDIR)/share/rtai/scicos/rtmain.h
+	cp $< .
+
+rtmain44.o: rtmain.h
+
 ../$$MODEL$$: $(OBJSSTAN) $(ULIBRARY)
 	gcc -static -o $@  $(OBJSSTAN) $(SCILIBS) $(ULIBRARY) -lpthread $(COMEDILIB) -lgfortran -lm
 	@echo "### Created executable: $(MODEL) ###"
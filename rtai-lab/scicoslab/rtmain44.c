@@ -23,6 +23,7 @@
 */
 
 #define _XOPEN_SOURCE	600
+#define _DEFAULT_SOURCE  // MAP_LOCKED, for rtai_shm.h
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -43,6 +44,9 @@
 #include <rtai_msg.h>
 #include <rtai_mbx.h>
 #include <rtai_fifos.h>
+#include <rtai_scb.h>
+
+#include "rtmain.h"
 
 #define RTAILAB_VERSION         "3.7.1"
 #define MAX_ADR_SRCH      500
@@ -167,6 +171,64 @@ char *get_a_name(const char *root, char *name)
   return 0;
 }
 
+/*
+ * Blocks sending data to xrtailab stream them into a shared memory ring,
+ * without any system call, while xrtailab runs on this machine and reads it,
+ * falling back to their mailbox, read through netrpc, otherwise. Samples
+ * not fitting in the ring, xrtailab being late, are dropped and counted as
+ * overruns, never mixed into the mailbox.
+ */
+
+struct rtai_lab_stream *get_a_stream(const char *name, int mbx_size, int scb_size)
+{
+  struct rtai_lab_stream *stream;
+  char scb_name[7];
+
+  if (!(stream = (struct rtai_lab_stream *)malloc(sizeof(struct rtai_lab_stream)))) {
+    return 0;
+  }
+  if (!(stream->mbx = RT_typed_named_mbx_init(0, 0, name, mbx_size, FIFO_Q))) {
+    free(stream);
+    return 0;
+  }
+  stream->scb = 0;
+  stream->scb_name = 0;
+  stream->overruns = 0;
+  if (strlen(name) < 6) {
+    sprintf(scb_name, "%sR", name);
+    if ((stream->scb = rt_sscb_init(nam2num(scb_name), scb_size))) {
+      stream->scb_name = nam2num(scb_name);
+    }
+  }
+  return stream;
+}
+
+int stream_send(struct rtai_lab_stream *stream, void *msg, int msg_size)
+{
+  if (stream->scb && RT_SSCB_READERS(stream->scb)) {
+    if (rt_scb_put(stream->scb, msg, msg_size)) {
+      stream->overruns++;
+      return msg_size;
+    }
+    return 0;
+  }
+  return RT_mbx_send_if(0, 0, (MBX *)stream->mbx, msg, msg_size);
+}
+
+void free_a_stream(struct rtai_lab_stream *stream)
+{
+  if (stream->overruns) {
+    char name[7];
+    num2nam(stream->scb_name, name);
+    fprintf(stderr, "Ring %s overruns: %lu samples dropped.\n", name, stream->overruns);
+  }
+  if (stream->scb) {
+    rt_sscb_delete(stream->scb_name);
+  }
+  RT_named_mbx_delete(0, 0, (MBX *)stream->mbx);
+  free(stream);
+}
+
 int rtRegisterScope(char *name, char **traceName, int n)
 {
   int i;
@@ -0,0 +1,108 @@
+/*
+COPYRIGHT (C) 2026  The RTAI project
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public
+License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/*
+ * TRACE RINGS AND MIN/MAX PYRAMIDS.
+ *
+ * Samples are kept on per trace rings, at full resolution, larger than any
+ * trace length so that the history can be browsed while holding. Each ring
+ * has a pyramid of the min/max of its blocks of 2^TRACE_PYR_SHIFT samples,
+ * of their pairs, and so on, so that drawing costs one min/max per pixel
+ * column, whatever the number of samples. Samples are addressed by their
+ * recorded position, counted from the first one, the ring holding those in
+ * [head - TRACE_RING_SIZE, head). Level k of a pyramid is an array of
+ * TRACE_RING_SIZE >> (TRACE_PYR_SHIFT + k) values. Plain C, so that it can
+ * be tested without any display.
+ */
+
+#ifndef _TRACE_PYR_H_
+#define _TRACE_PYR_H_
+
+#define TRACE_RING_BITS       17
+#define TRACE_RING_SIZE       (1 << TRACE_RING_BITS)
+#define TRACE_RING_MASK       (TRACE_RING_SIZE - 1)
+#define TRACE_PYR_SHIFT       4
+#define TRACE_PYR_LEVELS      (TRACE_RING_BITS - TRACE_PYR_SHIFT)
+
+/*
+ * Bring the pyramid of a ring up to date with the samples recorded in
+ * [from, head), the block being filled is redone next time.
+ */
+static inline void trace_pyr_update(float *trace, float **min, float **max, long long from, long long head)
+{
+	long long b, last;
+	int k, i, mask;
+	float *s, lo, hi;
+
+	if (from >= head) return;
+	if (head - from > TRACE_RING_SIZE) from = head - TRACE_RING_SIZE;
+	mask = (TRACE_RING_SIZE >> TRACE_PYR_SHIFT) - 1;
+	last = (head - 1) >> TRACE_PYR_SHIFT;
+	for (b = from >> TRACE_PYR_SHIFT; b <= last; b++) {
+		s = trace + ((b << TRACE_PYR_SHIFT) & TRACE_RING_MASK);
+		lo = hi = s[0];
+		for (i = 1; i < (1 << TRACE_PYR_SHIFT); i++) {
+			if (s[i] < lo) lo = s[i];
+			if (s[i] > hi) hi = s[i];
+		}
+		min[0][b & mask] = lo;
+		max[0][b & mask] = hi;
+	}
+	for (k = 1; k < TRACE_PYR_LEVELS; k++) {
+		mask >>= 1;
+		last = (head - 1) >> (TRACE_PYR_SHIFT + k);
+		for (b = from >> (TRACE_PYR_SHIFT + k); b <= last; b++) {
+			i = (2*b) & (2*mask + 1);
+			min[k][b & mask] = min[k - 1][i] < min[k - 1][i + 1] ? min[k - 1][i] : min[k - 1][i + 1];
+			max[k][b & mask] = max[k - 1][i] > max[k - 1][i + 1] ? max[k - 1][i] : max[k - 1][i + 1];
+		}
+	}
+}
+
+/*
+ * Min and max of a ring over the recorded positions [from, to), using the
+ * largest whole pyramid blocks and the samples only at the ends.
+ */
+static inline void trace_pyr_minmax(const float *trace, float **min, float **max, long long from, long long to, float *vmin, float *vmax)
+{
+	long long size;
+	int k, i;
+	float v;
+
+	*vmin = 1E38;
+	*vmax = -1E38;
+	while (from < to) {
+		size = 1 << TRACE_PYR_SHIFT;
+		if (!(from & (size - 1)) && from + size <= to) {
+			for (k = 0; k + 1 < TRACE_PYR_LEVELS && !(from & (2*size - 1)) && from + 2*size <= to; k++) {
+				size *= 2;
+			}
+			i = (from >> (TRACE_PYR_SHIFT + k)) & ((TRACE_RING_SIZE >> (TRACE_PYR_SHIFT + k)) - 1);
+			if (min[k][i] < *vmin) *vmin = min[k][i];
+			if (max[k][i] > *vmax) *vmax = max[k][i];
+			from += size;
+		} else {
+			v = trace[from & TRACE_RING_MASK];
+			if (v < *vmin) *vmin = v;
+			if (v > *vmax) *vmax = v;
+			from++;
+		}
+	}
+}
+
+#endif /* _TRACE_PYR_H_ */
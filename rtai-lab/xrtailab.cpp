@@ -62,7 +62,9 @@ License along with this library; if not, see <http://www.gnu.org/licenses/>.
 #include <rtai_netrpc.h>
 #include <rtai_msg.h>
 #include <rtai_mbx.h>
+#include <rtai_scb.h>
 
+#include <rlg_binlog.h>
 #include <Fl_Scope.h>
 #include <Fl_Scope_Window.h>
 #include <Fl_Led.h>
@@ -1123,15 +1125,192 @@ void rlg_disconnect_cb(Fl_Widget *, void *)
 	RT_RPC(Target_Interface_Task, DISCONNECT_FROM_TARGET, 0);
 }
 
+/*
+ * The blocks of a target running on this machine stream their data on a
+ * shared memory ring, named as their mailbox plus "R", while it is attached
+ * here, so that neither they nor we need a system call for each message.
+ */
+static void *attach_data_ring(const char *mbx_name)
+{
+	char name[8];
+	void *scb;
+
+	if (Target_Node || strlen(mbx_name) > 5) return NULL;
+	sprintf(name, "%sR", mbx_name);
+	if (!rt_get_adr(nam2num(name)) || !(scb = rt_sscb_init(nam2num(name), 0))) return NULL;
+	rt_sscb_attach(scb);
+	return scb;
+}
+
+static void detach_data_ring(const char *mbx_name, void *scb)
+{
+	char name[8];
+
+	if (scb) {
+		rt_sscb_detach(scb);
+		sprintf(name, "%sR", mbx_name);
+		rt_sscb_delete(nam2num(name));
+	}
+}
+
+/*
+ * The data threads take their samples, unit bytes each and coming every dt
+ * seconds, from the ring of a local target, if any, or from the mailbox.
+ */
+typedef struct {
+	void *scb;
+	long port;
+	MBX *mbx;
+	int unit;
+	double dt;
+} Data_Source_T;
+
+#define REFRESH_NS  ((RTIME)(REFRESH_RATE*1.0E9))
+
+/*
+ * Targets send whole samples, so the rest of a partially received one is
+ * already there, drop it if not.
+ */
+static int complete_sample(Data_Source_T *src, char *msg, int len)
+{
+	int part;
+
+	if ((part = len % src->unit)) {
+		if (RT_mbx_receive_timed(Target_Node, src->port, src->mbx, msg + len, src->unit - part, REFRESH_NS)) {
+			return len - part;
+		}
+		len += src->unit - part;
+	}
+	return len;
+}
+
+/*
+ * Wait, blocking rather than polling, up to a refresh period for the minlen
+ * bytes of a display refresh, then take all the whole samples that are
+ * there, up to maxlen bytes, so that each call gives a batch to be drawn and
+ * saved in one go. Returns the bytes got, a multiple of the sample size.
+ */
+static int get_data(Data_Source_T *src, void *msg, int minlen, int maxlen)
+{
+	int len;
+
+	if (src->scb) {
+		struct timespec nap;
+		RTIME wait, ns;
+		for (wait = 0; (len = rt_scb_avbs(src->scb)) < minlen && wait < REFRESH_NS; wait += ns) {
+			// a ring has no wake up, sleep till the missing samples are due
+			ns = (RTIME)(((minlen - len)/src->unit + 1)*src->dt*1.0E9);
+			if (ns > REFRESH_NS - wait) ns = REFRESH_NS - wait;
+			nap.tv_sec = ns/1000000000;
+			nap.tv_nsec = ns%1000000000;
+			nanosleep(&nap, NULL);
+		}
+		if ((len = ((len < maxlen ? len : maxlen)/src->unit)*src->unit)) {
+			rt_scb_get(src->scb, msg, len);
+		}
+		return len;
+	}
+	len = minlen - RT_mbx_receive_timed(Target_Node, src->port, src->mbx, msg, minlen, REFRESH_NS);
+	if ((len = complete_sample(src, (char *)msg, len)) == minlen && maxlen > minlen) {
+		len += (maxlen - minlen) - RT_mbx_receive_wp(Target_Node, src->port, src->mbx, (char *)msg + minlen, maxlen - minlen);
+		len = complete_sample(src, (char *)msg, len);
+	}
+	return len;
+}
+
+/*
+ * Saved values are formatted as "%1.5f " in a local buffer, written with one
+ * fwrite per batch, as a fprintf per value, with its stream locking, costs
+ * more than all the rest at high sample rates.
+ */
+#define SAVE_BUF_SIZE  (64*1024)
+#define SAVE_VAL_SIZE  512  // room for any double as "%1.5f "
+
+typedef struct {
+	FILE *file;
+	Rlg_Binlog *bin;
+	int len;
+	char buf[SAVE_BUF_SIZE];
+} Save_Buf_T;
+
+static void save_flush(Save_Buf_T *sb)
+{
+	if (sb->len) {
+		fwrite(sb->buf, 1, sb->len, sb->file);
+		sb->len = 0;
+	}
+}
+
+static void save_value(Save_Buf_T *sb, double val)
+{
+	if (sb->len > SAVE_BUF_SIZE - SAVE_VAL_SIZE) save_flush(sb);
+	sb->len += snprintf(sb->buf + sb->len, SAVE_VAL_SIZE, "%1.5f ", val);
+}
+
+static inline void save_newline(Save_Buf_T *sb)
+{
+	sb->buf[sb->len++] = '\n';
+}
+
+/*
+ * Binary saving, see rlg_binlog.h, chosen by the name of the file. Managers
+ * do not open such files, the data threads do it when the first samples to be
+ * saved arrive, so that the header can describe them.
+ */
+static Rlg_Binlog *save_binlog_open(const char *file, const Rlg_Binlog_Info *info)
+{
+	Rlg_Binlog *log;
+
+	if (!(log = rlg_binlog_open(file, info))) {
+		printf("Error in opening file %s: %s\n", file, strerror(errno));
+	}
+	free((void *)file);
+	return log;
+}
+
+static void save_binlog_close(Save_Buf_T *sb)
+{
+	if (sb->bin) {
+		rlg_binlog_close(sb->bin);
+		sb->bin = NULL;
+	}
+}
+
+/*
+ * Save n samples, up to max in all, any if max is 0, returns true, having
+ * closed the log, when done or on failure.
+ */
+static int save_binlog_write(Save_Buf_T *sb, const void *samples, int n, int *cnt, int max)
+{
+	int err;
+
+	if (!sb->bin) {
+		return true;
+	}
+	if (max > 0 && n > max - *cnt) {
+		n = max - *cnt;
+	}
+	if ((err = rlg_binlog_write(sb->bin, samples, n))) {
+		printf("Error in saving binary log: %s\n", strerror(-err));
+	}
+	*cnt += n;
+	if (err || *cnt == max) {
+		save_binlog_close(sb);
+		*cnt = 0;
+		return true;
+	}
+	return false;
+}
+
 static void *rt_get_synch_data(void *arg)
 {
 	RT_TASK *GetSynchronoscopeDataTask;
 	MBX *GetSynchronoscopeDataMbx;
 	char GetSynchronoscopeDataMbxName[7];
 	long GetSynchronoscopeDataPort;
+	Data_Source_T Src;
 	int MsgData = 0, MsgLen, MaxMsgLen, DataBytes;
 	float MsgBuf[MAX_MSG_LEN/sizeof(float)];
-	int n;
 	int index = ((Args_T *)arg)->index;
 	char *mbx_id = strdup(((Args_T *)arg)->mbx_id);
 	int x = ((Args_T *)arg)->x;
@@ -1157,7 +1336,11 @@ static void *rt_get_synch_data(void *arg)
 	MsgLen = (((int)(DataBytes*REFRESH_RATE*(1./Synchs[index].dt)))/DataBytes)*DataBytes;
 	if (MsgLen < DataBytes) MsgLen = DataBytes;
 	if (MsgLen > MaxMsgLen) MsgLen = MaxMsgLen;
-	MsgData = MsgLen/DataBytes;
+	Src.scb = NULL;
+	Src.port = GetSynchronoscopeDataPort;
+	Src.mbx = GetSynchronoscopeDataMbx;
+	Src.unit = DataBytes;
+	Src.dt = Synchs[index].dt;
 
 	Fl_Synch_Window *Synch_Win = new Fl_Synch_Window(x, y, w, h, RLG_Main_Workspace->viewport(), Synchs[index].name);
 	Synchs_Manager->Synch_Windows[index] = Synch_Win;
@@ -1167,32 +1350,23 @@ static void *rt_get_synch_data(void *arg)
 
 	while (true) {
 		if (End_App || !Is_Target_Connected) break;
-		while (RT_mbx_receive_if(Target_Node, GetSynchronoscopeDataPort, GetSynchronoscopeDataMbx, &MsgBuf, MsgLen)) {
-			if (End_App || !Is_Target_Connected) goto end;
-			if (!Synchs_Manager->visible()) {
-				Fl::lock();
-				RLG_Synchs_Mgr_Button->activate();
-				Fl::unlock();
-			}
-			if (Synchs[index].visible) {
-				Fl::lock();
-				Synch_Win->show();
-				Fl::unlock();
-			} else {
-				Fl::lock();
-				Synch_Win->hide();
-				Fl::unlock();
-			}
-			msleep(10);
-		}
+		MsgData = get_data(&Src, MsgBuf, MsgLen, MaxMsgLen)/DataBytes;
+		if (End_App || !Is_Target_Connected) break;
 		Fl::lock();
-		for (n = 0; n < MsgData; n++) {
-			Synch_Win->Synch->value(MsgBuf[n]);
+		if (!Synchs_Manager->visible()) {
+			RLG_Synchs_Mgr_Button->activate();
+		}
+		if (Synchs[index].visible) {
+			Synch_Win->show();
+		} else {
+			Synch_Win->hide();
+		}
+		if (MsgData) {
+			Synch_Win->Synch->value(MsgBuf[MsgData - 1]);
 			Synch_Win->Synch->redraw();
 		}
 		Fl::unlock();
 	}
-end:
 	if (Verbose) {
 		printf("Deleting synch thread number...%d\n", index);
 	}
@@ -1207,11 +1381,12 @@ static void *rt_get_meter_data(void *arg)
 {
 	RT_TASK *GetMeterDataTask;
 	MBX *GetMeterDataMbx;
+	void *GetMeterDataScb;
 	char GetMeterDataMbxName[7];
 	long GetMeterDataPort;
+	Data_Source_T Src;
 	int MsgData = 0, MsgLen, MaxMsgLen, DataBytes;
 	float MsgBuf[MAX_MSG_LEN/sizeof(float)];
-	int n;
 	int index = ((Args_T *)arg)->index;
 	char *mbx_id = strdup(((Args_T *)arg)->mbx_id);
 	int x = ((Args_T *)arg)->x;
@@ -1232,12 +1407,17 @@ static void *rt_get_meter_data(void *arg)
 		printf("Error in getting %s mailbox address\n", GetMeterDataMbxName);
 		exit(1);
 	}
+	GetMeterDataScb = attach_data_ring(GetMeterDataMbxName);
 	DataBytes = sizeof(float);
 	MaxMsgLen = (MAX_MSG_LEN/DataBytes)*DataBytes;
 	MsgLen = (((int)(DataBytes*REFRESH_RATE*(1./Meters[index].dt)))/DataBytes)*DataBytes;
 	if (MsgLen < DataBytes) MsgLen = DataBytes;
 	if (MsgLen > MaxMsgLen) MsgLen = MaxMsgLen;
-	MsgData = MsgLen/DataBytes;
+	Src.scb = GetMeterDataScb;
+	Src.port = GetMeterDataPort;
+	Src.mbx = GetMeterDataMbx;
+	Src.unit = DataBytes;
+	Src.dt = Meters[index].dt;
 
 	Fl_Meter_Window *Meter_Win = new Fl_Meter_Window(x, y, w, h, RLG_Main_Workspace->viewport(), Meters[index].name);
 	Meters_Manager->Meter_Windows[index] = Meter_Win;
@@ -1247,36 +1427,28 @@ static void *rt_get_meter_data(void *arg)
 
 	while (true) {
 		if (End_App || !Is_Target_Connected) break;
-		while (RT_mbx_receive_if(Target_Node, GetMeterDataPort, GetMeterDataMbx, &MsgBuf, MsgLen)) {
-			if (End_App || !Is_Target_Connected) goto end;
-			if (!Meters_Manager->visible()) {
-				Fl::lock();
-				RLG_Meters_Mgr_Button->activate();
-				Fl::unlock();
-			}
-			if (Meters[index].visible) {
-				Fl::lock();
-				Meter_Win->show();
-				Fl::unlock();
-			} else {
-				Fl::lock();
-				Meter_Win->hide();
-				Fl::unlock();
-			}
-			msleep(10);
-		}
+		MsgData = get_data(&Src, MsgBuf, MsgLen, MaxMsgLen)/DataBytes;
+		if (End_App || !Is_Target_Connected) break;
 		Fl::lock();
-		for (n = 0; n < MsgData; n++) {
-			Meter_Win->Meter->value(MsgBuf[n]);
+		if (!Meters_Manager->visible()) {
+			RLG_Meters_Mgr_Button->activate();
+		}
+		if (Meters[index].visible) {
+			Meter_Win->show();
+		} else {
+			Meter_Win->hide();
+		}
+		if (MsgData) {
+			Meter_Win->Meter->value(MsgBuf[MsgData - 1]);
 			Meter_Win->Meter->redraw();
 		}
 		Fl::unlock();
 	}
-end:
 	if (Verbose) {
 		printf("Deleting meter thread number...%d\n", index);
 	}
 	Meter_Win->hide();
+	detach_data_ring(GetMeterDataMbxName, GetMeterDataScb);
 	rt_release_port(Target_Node, GetMeterDataPort);
 	rt_task_delete(GetMeterDataTask);
 
@@ -1287,11 +1459,12 @@ static void *rt_get_led_data(void *arg)
 {
 	RT_TASK *GetLedDataTask;
 	MBX *GetLedDataMbx;
+	void *GetLedDataScb;
 	char GetLedDataMbxName[7];
 	long GetLedDataPort;
+	Data_Source_T Src;
 	int MsgData = 0, MsgLen, MaxMsgLen, DataBytes;
 	unsigned int MsgBuf[MAX_MSG_LEN/sizeof(unsigned int)];
-	int n;
 	int index = ((Args_T *)arg)->index;
 	char *mbx_id = strdup(((Args_T *)arg)->mbx_id);
 	int x = ((Args_T *)arg)->x;
@@ -1312,12 +1485,17 @@ static void *rt_get_led_data(void *arg)
 		printf("Error in getting %s mailbox address\n", GetLedDataMbxName);
 		exit(1);
 	}
+	GetLedDataScb = attach_data_ring(GetLedDataMbxName);
 	DataBytes = sizeof(unsigned int);
 	MaxMsgLen = (MAX_MSG_LEN/DataBytes)*DataBytes;
 	MsgLen = (((int)(DataBytes*REFRESH_RATE*(1./Leds[index].dt)))/DataBytes)*DataBytes;
 	if (MsgLen < DataBytes) MsgLen = DataBytes;
 	if (MsgLen > MaxMsgLen) MsgLen = MaxMsgLen;
-	MsgData = MsgLen/DataBytes;
+	Src.scb = GetLedDataScb;
+	Src.port = GetLedDataPort;
+	Src.mbx = GetLedDataMbx;
+	Src.unit = DataBytes;
+	Src.dt = Leds[index].dt;
 
 	Fl_Led_Window *Led_Win = new Fl_Led_Window(x, y, w, h, RLG_Main_Workspace->viewport(), Leds[index].name, Leds[index].n_leds);
 	Leds_Manager->Led_Windows[index] = Led_Win;
@@ -1327,38 +1505,30 @@ static void *rt_get_led_data(void *arg)
 
 	while (true) {
 		if (End_App || !Is_Target_Connected) break;
-		while (RT_mbx_receive_if(Target_Node, GetLedDataPort, GetLedDataMbx, &MsgBuf, MsgLen)) {
-			if (End_App || !Is_Target_Connected) goto end;
-			if (!Leds_Manager->visible()) {
-				Fl::lock();
-				RLG_Leds_Mgr_Button->activate();
-				Fl::unlock();
-			}
-			if (Leds[index].visible) {
-				Fl::lock();
-				Led_Win->show();
-				Fl::unlock();
-			} else {
-				Fl::lock();
-				Led_Win->hide();
-				Fl::unlock();
-			}
-			msleep(10);
-		}
+		MsgData = get_data(&Src, MsgBuf, MsgLen, MaxMsgLen)/DataBytes;
+		if (End_App || !Is_Target_Connected) break;
 		Fl::lock();
-		for (n = 0; n < MsgData; n++) {
-			Led_Mask = MsgBuf[n];
+		if (!Leds_Manager->visible()) {
+			RLG_Leds_Mgr_Button->activate();
+		}
+		if (Leds[index].visible) {
+			Led_Win->show();
+		} else {
+			Led_Win->hide();
+		}
+		if (MsgData) {
+			Led_Mask = MsgBuf[MsgData - 1];
 			Led_Win->led_mask(Led_Mask);
 			Led_Win->led_on_off();
 			Led_Win->update();
 		}
 		Fl::unlock();
 	}
-end:
 	if (Verbose) {
 		printf("Deleting led thread number...%d\n", index);
 	}
 	Led_Win->hide();
+	detach_data_ring(GetLedDataMbxName, GetLedDataScb);
 	rt_release_port(Target_Node, GetLedDataPort);
 	rt_task_delete(GetLedDataTask);
 
@@ -1369,8 +1539,12 @@ static void *rt_get_log_data(void *arg)
 {
 	RT_TASK *GetLogDataTask;
 	MBX *GetLogDataMbx;
+	void *GetLogDataScb;
 	char GetLogDataMbxName[7];
 	long GetLogDataPort;
+	Data_Source_T Src;
+	Save_Buf_T *Save;
+	Rlg_Binlog_Info Info;
 	int MsgData = 0, MsgLen, MaxMsgLen, DataBytes;
 	float MsgBuf[MAX_MSG_LEN/sizeof(float)];
 	int n, i, j, k, DataCnt = 0;
@@ -1389,51 +1563,75 @@ static void *rt_get_log_data(void *arg)
 		printf("Error in getting %s mailbox address\n", GetLogDataMbxName);
 		exit(1);
 	}
+	GetLogDataScb = attach_data_ring(GetLogDataMbxName);
 	DataBytes = (Logs[index].nrow*Logs[index].ncol)*sizeof(float);
 	MaxMsgLen = (MAX_MSG_LEN/DataBytes)*DataBytes;
 	MsgLen = (((int)(DataBytes*REFRESH_RATE*(1./Logs[index].dt)))/DataBytes)*DataBytes;
 	if (MsgLen < DataBytes) MsgLen = DataBytes;
 	if (MsgLen > MaxMsgLen) MsgLen = MaxMsgLen;
-	MsgData = MsgLen/DataBytes;
+	Src.scb = GetLogDataScb;
+	Src.port = GetLogDataPort;
+	Src.mbx = GetLogDataMbx;
+	Src.unit = DataBytes;
+	Src.dt = Logs[index].dt;
+	Save = new Save_Buf_T;
+	Save->bin = NULL;
+	Save->len = 0;
+	Info.kind = RLG_BINLOG_LOG;
+	Info.name = Logs[index].name;
+	Info.dt = Logs[index].dt;
+	Info.value_size = sizeof(float);
+	Info.nvalues = Logs[index].nrow*Logs[index].ncol;
+	Info.nrow = Logs[index].nrow;
+	Info.ncol = Logs[index].ncol;
+	Info.value_names = NULL;
 
 	rt_send(Target_Interface_Task, 0);
 	mlockall(MCL_CURRENT | MCL_FUTURE);
 
 	while (true) {
 		if (End_App || !Is_Target_Connected) break;
-		while (RT_mbx_receive_if(Target_Node, GetLogDataPort, GetLogDataMbx, &MsgBuf, MsgLen)) {
-			if (End_App || !Is_Target_Connected) goto end;
-			if (!Logs_Manager->visible()) {
-				Fl::lock();
-				RLG_Logs_Mgr_Button->activate();
-				Fl::unlock();
-			}
-			msleep(10);
+		MsgData = get_data(&Src, MsgBuf, MsgLen, MaxMsgLen)/DataBytes;
+		if (End_App || !Is_Target_Connected) break;
+		if (!Logs_Manager->visible()) {
+			Fl::lock();
+			RLG_Logs_Mgr_Button->activate();
+			Fl::unlock();
 		}
-		if (Logs_Manager->start_saving(index)) {
+		if (MsgData && Logs_Manager->start_saving(index) && !(Save->file = Logs_Manager->save_file(index))) {
+			if (!Save->bin) {
+				Save->bin = save_binlog_open(Logs_Manager->file_name(index), &Info);
+			}
+			if (save_binlog_write(Save, MsgBuf, MsgData, &DataCnt, Logs_Manager->n_points_to_save(index))) {
+				Logs_Manager->stop_saving(index);
+			}
+		} else if (MsgData && Logs_Manager->start_saving(index)) {
 			for (n = 0; n < MsgData; n++) {
 				++DataCnt;
-//				fprintf(Logs_Manager->save_file(index), "Data # %d\n", ++DataCnt);
 				for (i = 0; i < Logs[index].nrow; i++) {
 					j = n*Logs[index].nrow*Logs[index].ncol + i;
 					for (k = 0; k < Logs[index].ncol; k++) {
-						fprintf(Logs_Manager->save_file(index), "%1.5f ", MsgBuf[j]);
+						save_value(Save, MsgBuf[j]);
 						j += Logs[index].nrow;
 					}
-					fprintf(Logs_Manager->save_file(index), "\n");
+					save_newline(Save);
 				}
 				if (DataCnt == Logs_Manager->n_points_to_save(index)) {
+					save_flush(Save);
 					Logs_Manager->stop_saving(index);
 					DataCnt = 0;
 					break;
 				}
 			}
+			save_flush(Save);
 		}
 	}
-end:
+	save_binlog_close(Save);
+	delete Save;
 	if (Verbose) {
 		printf("Deleting log thread number...%d\n", index);
 	}
+	detach_data_ring(GetLogDataMbxName, GetLogDataScb);
 	rt_release_port(Target_Node, GetLogDataPort);
 	rt_task_delete(GetLogDataTask);
 
@@ -1445,18 +1643,21 @@ static void *rt_get_alog_data(void *arg)
 	MBX *GetALogDataMbx;
 	char GetALogDataMbxName[7];
 	long GetALogDataPort;
+	Data_Source_T Src;
+	Save_Buf_T *Save;
 	int MsgData = 0, MsgLen, MaxMsgLen, DataBytes;
 	float MsgBuf[MAX_MSG_LEN/sizeof(float)];
 	int n, i, j, k;
 	int index = ((Alog_T *)arg)->index;
 	char *mbx_id = strdup(((Alog_T *)arg)->mbx_id);
 	char *alog_file_name = strdup(((Alog_T *)arg)->alog_name);   //read alog block name and set it to file name
-	FILE *saving;
+	FILE *saving = NULL;
+	Rlg_Binlog_Info Info;
 	long size_counter = 0;
 	long logging = 0;
 	
 	
-	if((saving = fopen(alog_file_name, "a+")) == NULL){
+	if (!rlg_binlog_name(alog_file_name) && (saving = fopen(alog_file_name, "a+")) == NULL){
 		printf("Error opening auto log file %s\n", alog_file_name);
 		}
 	
@@ -1480,7 +1681,26 @@ static void *rt_get_alog_data(void *arg)
 	MsgLen = (((int)(DataBytes*REFRESH_RATE*(1./ALogs[index].dt)))/DataBytes)*DataBytes;
 	if (MsgLen < DataBytes) MsgLen = DataBytes;
 	if (MsgLen > MaxMsgLen) MsgLen = MaxMsgLen;
-	MsgData = MsgLen/DataBytes;
+	Src.scb = NULL;
+	Src.port = GetALogDataPort;
+	Src.mbx = GetALogDataMbx;
+	Src.unit = DataBytes;
+	Src.dt = ALogs[index].dt;
+	Save = new Save_Buf_T;
+	Save->file = saving;
+	Save->bin = NULL;
+	Save->len = 0;
+	if (!saving) {
+		Info.kind = RLG_BINLOG_ALOG;
+		Info.name = ALogs[index].name;
+		Info.dt = ALogs[index].dt;
+		Info.value_size = sizeof(float);
+		Info.nvalues = ALogs[index].nrow*ALogs[index].ncol;
+		Info.nrow = ALogs[index].nrow;
+		Info.ncol = ALogs[index].ncol;
+		Info.value_names = NULL;
+		Save->bin = save_binlog_open(strdup(alog_file_name), &Info);
+	}
 	
 	//printf("MsgData %d MsgLen %d MaxMsgLen %d DataBytes %d DimBuf= %d\n", MsgData, MsgLen, MaxMsgLen, DataBytes,MAX_MSG_LEN/sizeof(float));
 	
@@ -1489,27 +1709,36 @@ static void *rt_get_alog_data(void *arg)
 	
 	while (true) {
 		if (End_App || !Is_Target_Connected) break;
-		while (RT_mbx_receive_if(Target_Node, GetALogDataPort, GetALogDataMbx, &MsgBuf, MsgLen)) {
-			if (End_App || !Is_Target_Connected) goto end;
-			if (!ALogs_Manager->visible()) {
-				Fl::lock();
-				RLG_ALogs_Mgr_Button->activate();
-				Fl::unlock();
+		MsgData = get_data(&Src, MsgBuf, MsgLen, MaxMsgLen)/DataBytes;
+		if (End_App || !Is_Target_Connected) break;
+		if (!ALogs_Manager->visible()) {
+			Fl::lock();
+			RLG_ALogs_Mgr_Button->activate();
+			Fl::unlock();
+		}
+		if (Save->bin) {
+			// flagged samples only, without their flag
+			for (n = 0; n < MsgData; n++) {
+				if ((int)MsgBuf[(n + 1)*(Info.nvalues + 1) - 1] &&
+				Save->bin->nsamples*Save->bin->sample_size <= 1000000) {
+					rlg_binlog_write(Save->bin, MsgBuf + n*(Info.nvalues + 1), 1);
+				}
 			}
-			msleep(10);
+			continue;
 		}
+		if (!saving) continue;
 			for (n = 0; n < MsgData; n++) {
-				size_counter=ftell(saving);    			//get file dimension in bytes
+				size_counter=ftell(saving) + Save->len;    	//get file dimension in bytes
 				//printf("Size counter: %d\n", size_counter);
 				if(((int)MsgBuf[(((n+1)*ALogs[index].nrow*ALogs[index].ncol + (n+1))-1)]) &&
 				size_counter<=1000000){
 					for (i = 0; i < ALogs[index].nrow; i++) {
 						j = n*ALogs[index].nrow*ALogs[index].ncol + i;
 						for (k = 0; k < ALogs[index].ncol; k++) {
-							fprintf(saving,"%1.5f ",MsgBuf[j]); 
+							save_value(Save, MsgBuf[j]);
 							j += ALogs[index].nrow;
 						}
-						fprintf(saving, "\n");
+						save_newline(Save);
 						j++;
 					}
 				}
@@ -1521,13 +1750,14 @@ static void *rt_get_alog_data(void *arg)
 						}
 				}*/		
 			}
-			
+			save_flush(Save);
 	}
-end:
 	if (Verbose) {
 		printf("Deleting auto log thread number...%d\n", index);
 	}
-	fclose(saving);
+	save_binlog_close(Save);
+	delete Save;
+	if (saving) fclose(saving);
 	rt_release_port(Target_Node, GetALogDataPort);
 	rt_task_delete(GetALogDataTask);
 
@@ -1537,11 +1767,16 @@ static void *rt_get_scope_data(void *arg)
 {
 	RT_TASK *GetScopeDataTask;
 	MBX *GetScopeDataMbx;
+	void *GetScopeDataScb;
 	char GetScopeDataMbxName[7];
 	long GetScopeDataPort;
+	Data_Source_T Src;
+	Save_Buf_T *Save;
+	Rlg_Binlog_Info Info;
+	const char **Names;
 	int MsgData = 0, MsgLen, MaxMsgLen, TracesBytes;
 	double MsgBuf[MAX_MSG_LEN/sizeof(double)];
-	int n, nn, js, jl;
+	int n, nn, jl;
 	int index = ((Args_T *)arg)->index;
 	char *mbx_id = strdup(((Args_T *)arg)->mbx_id);
 	int x = ((Args_T *)arg)->x;
@@ -1563,12 +1798,33 @@ static void *rt_get_scope_data(void *arg)
 		printf("Error in getting %s mailbox address\n", GetScopeDataMbxName);
 		return (void *)1;
 	}
+	GetScopeDataScb = attach_data_ring(GetScopeDataMbxName);
 	TracesBytes = (Scopes[index].ntraces + 1)*sizeof(double);
 	MaxMsgLen = (MAX_MSG_LEN/TracesBytes)*TracesBytes;
 	MsgLen = (((int)(TracesBytes*REFRESH_RATE*(1./Scopes[index].dt)))/TracesBytes)*TracesBytes;
 	if (MsgLen < TracesBytes) MsgLen = TracesBytes;
 	if (MsgLen > MaxMsgLen) MsgLen = MaxMsgLen;
-	MsgData = MsgLen/TracesBytes;
+	Src.scb = GetScopeDataScb;
+	Src.port = GetScopeDataPort;
+	Src.mbx = GetScopeDataMbx;
+	Src.unit = TracesBytes;
+	Src.dt = Scopes[index].dt;
+	Save = new Save_Buf_T;
+	Save->bin = NULL;
+	Save->len = 0;
+	Names = new const char*[Scopes[index].ntraces + 1];
+	Names[0] = "time";
+	for (n = 0; n < Scopes[index].ntraces; n++) {
+		Names[n + 1] = Scopes[index].traceName[n];
+	}
+	Info.kind = RLG_BINLOG_SCOPE;
+	Info.name = Scopes[index].name;
+	Info.dt = Scopes[index].dt;
+	Info.value_size = sizeof(double);
+	Info.nvalues = Scopes[index].ntraces + 1;
+	Info.nrow = 1;
+	Info.ncol = Scopes[index].ntraces + 1;
+	Info.value_names = Names;
 
 	Fl_Scope_Window *Scope_Win = new Fl_Scope_Window(x, y, w, h, RLG_Main_Workspace->viewport(), Scopes[index].name, Scopes[index].ntraces, Scopes[index].dt);
 	Scopes_Manager->Scope_Windows[index] = Scope_Win;
@@ -1578,58 +1834,61 @@ static void *rt_get_scope_data(void *arg)
 
 	while (true) {
 		if (End_App || !Is_Target_Connected) break;
-		while (RT_mbx_receive_if(Target_Node, GetScopeDataPort, GetScopeDataMbx, &MsgBuf, MsgLen)) {
-			if (End_App || !Is_Target_Connected) goto end;
-			if (!Scopes_Manager->visible()) {
-				Fl::lock();
-				RLG_Scopes_Mgr_Button->activate();
-				Fl::unlock();
-			}
-			if (Scopes[index].visible) {
-				Fl::lock();
-				Scope_Win->show();
-				Fl::unlock();
-			} else {
-				Fl::lock();
-				Scope_Win->hide();
-				Fl::unlock();
-			}
-			msleep(10);
-		}
+		MsgData = get_data(&Src, MsgBuf, MsgLen, MaxMsgLen)/TracesBytes;
+		if (End_App || !Is_Target_Connected) break;
 		Fl::lock();
-		js = 1; // Drop sampletime
-		for (n = 0; n < MsgData; n++) {
-			for (nn = 0; nn < Scopes[index].ntraces; nn++) {
-				Scope_Win->Plot->add_to_trace(nn, MsgBuf[js++]);
-			}
-			js++;
+		if (!Scopes_Manager->visible()) {
+			RLG_Scopes_Mgr_Button->activate();
+		}
+		if (Scopes[index].visible) {
+			Scope_Win->show();
+		} else {
+			Scope_Win->hide();
+		}
+		if (!MsgData) {
+			Fl::unlock();
+			continue;
 		}
+		// Drop sampletime
+		Scope_Win->Plot->add_to_traces(MsgBuf + 1, MsgData, Scopes[index].ntraces + 1);
 		if (Scope_Win->is_visible() && (!stop_draw)) {
 			Scope_Win->Plot->redraw();
 		}
-		if (Scopes_Manager->start_saving(index)) {
+		if (Scopes_Manager->start_saving(index) && !(Save->file = Scopes_Manager->save_file(index))) {
+			if (!Save->bin) {
+				Save->bin = save_binlog_open(Scopes_Manager->file_name(index), &Info);
+			}
+			if (save_binlog_write(Save, MsgBuf, MsgData, &save_idx, Scopes_Manager->n_points_to_save(index))) {
+				Scopes_Manager->stop_saving(index);
+			}
+		} else if (Scopes_Manager->start_saving(index)) {
 			jl = 0;
 			for (n = 0; n < MsgData; n++) {
 				for (nn = 0; nn < Scopes[index].ntraces + 1; nn++) {
-					fprintf(Scopes_Manager->save_file(index), "%1.5f ", MsgBuf[jl++]);
+					save_value(Save, MsgBuf[jl++]);
 				}
-				fprintf(Scopes_Manager->save_file(index), "\n");
+				save_newline(Save);
 				save_idx++;
 				if (save_idx == Scopes_Manager->n_points_to_save(index)) {
+					save_flush(Save);
 					Scopes_Manager->stop_saving(index);
 					save_idx = 0;
 					break;
 				}
 			}
+			save_flush(Save);
 		}
 		Fl::unlock();
 	}
+	save_binlog_close(Save);
+	delete Save;
+	delete[] Names;
 
-end:
 	if (Verbose) {
 		printf("Deleting scope thread number...%d\n", index);
 	}
 	Scope_Win->hide();
+	detach_data_ring(GetScopeDataMbxName, GetScopeDataScb);
 	rt_release_port(Target_Node, GetScopeDataPort);
 	rt_task_delete(GetScopeDataTask);
 
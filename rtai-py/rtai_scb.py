@@ -43,3 +43,43 @@ rt_scb_put = rtai.rt_scb_put
 
 rtai.rt_scb_ovrwr.argtypes = [c_void_p, c_void_p, c_int]
 rt_scb_ovrwr = rtai.rt_scb_ovrwr
+
+
+# multiple producers non blocking shared memory circular buffers
+
+
+rtai.rt_mpscb_init.argtypes = [c_ulong, c_int, c_ulong]
+rtai.rt_mpscb_init.restype = c_void_p
+rt_mpscb_init = rtai.rt_mpscb_init
+
+rtai.rt_mpscb_reset.argtypes = [c_void_p]
+rt_mpscb_reset = rtai.rt_mpscb_reset
+
+rtai.rt_mpscb_delete.argtypes = [c_ulong]
+rt_mpscb_delete = rtai.rt_mpscb_delete
+
+rtai.rt_mpscb_avbs.argtypes = [c_void_p]
+rt_mpscb_avbs = rtai.rt_mpscb_avbs
+
+rtai.rt_mpscb_frbs.argtypes = [c_void_p]
+rt_mpscb_frbs = rtai.rt_mpscb_frbs
+
+rtai.rt_mpscb_reserve.argtypes = [c_void_p, c_int]
+rtai.rt_mpscb_reserve.restype = c_void_p
+rt_mpscb_reserve = rtai.rt_mpscb_reserve
+
+rtai.rt_mpscb_commit.argtypes = [c_void_p, c_void_p]
+rt_mpscb_commit = rtai.rt_mpscb_commit
+
+rtai.rt_mpscb_peek.argtypes = [c_void_p, POINTER(c_int)]
+rtai.rt_mpscb_peek.restype = c_void_p
+rt_mpscb_peek = rtai.rt_mpscb_peek
+
+rtai.rt_mpscb_release.argtypes = [c_void_p]
+rt_mpscb_release = rtai.rt_mpscb_release
+
+rtai.rt_mpscb_put.argtypes = [c_void_p, c_void_p, c_int]
+rt_mpscb_put = rtai.rt_mpscb_put
+
+rtai.rt_mpscb_get.argtypes = [c_void_p, c_void_p, c_int]
+rt_mpscb_get = rtai.rt_mpscb_get
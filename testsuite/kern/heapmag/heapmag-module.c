@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2026 The RTAI project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/init.h>
+#include <rtai_sched.h>
+#include <rtai_sem.h>
+#include <rtai_malloc.h>
+
+MODULE_DESCRIPTION("Measures rt_malloc/rt_free costs concurrently on all CPUs");
+MODULE_AUTHOR("The RTAI project");
+MODULE_LICENSE("GPL");
+
+/*
+ * Command line parameters
+ */
+int loops = 100000;
+RTAI_MODULE_PARM(loops, int);
+MODULE_PARM_DESC(loops, "Number of allocations per CPU (default: 100000)");
+
+int nblocks = 32;
+RTAI_MODULE_PARM(nblocks, int);
+MODULE_PARM_DESC(nblocks, "Number of blocks held at once by each CPU (default: 32)");
+
+int maxsize = 512;
+RTAI_MODULE_PARM(maxsize, int);
+MODULE_PARM_DESC(maxsize, "Max size of the allocated blocks (default: 512)");
+
+int stack_size = 4096;
+RTAI_MODULE_PARM(stack_size, int);
+MODULE_PARM_DESC(stack_size, "Task stack size in bytes (default: 4096)");
+
+#define MAXBLOCKS  256
+
+static RT_TASK task[RTAI_NR_CPUS];
+
+static SEM start, done;
+
+static struct {
+	RTIME alloc_max, free_max, alloc_sum, free_sum;
+	int failed;
+} result[RTAI_NR_CPUS];
+
+/*
+ * Each task keeps nblocks blocks, replacing a pseudo randomly chosen one with
+ * a new block of pseudo random size at each loop, all the CPUs starting at
+ * once, so that they contend for the heap as much as possible.
+ */
+
+static void heap_task(long cpuid)
+{
+	void *block[MAXBLOCKS];
+	unsigned int seed;
+	RTIME dt;
+	int i, k;
+
+	seed = cpuid + 1;
+	for (k = 0; k < nblocks; k++) {
+		block[k] = NULL;
+	}
+	rt_sem_wait_barrier(&start);
+	for (i = 0; i < loops; i++) {
+		seed = seed*1103515245 + 12345;
+		k = (seed >> 16)%nblocks;
+		dt = rtai_rdtsc();
+		rt_free(block[k]);
+		dt = rtai_rdtsc() - dt;
+		result[cpuid].free_sum += dt;
+		if (dt > result[cpuid].free_max) {
+			result[cpuid].free_max = dt;
+		}
+		seed = seed*1103515245 + 12345;
+		dt = rtai_rdtsc();
+		block[k] = rt_malloc(1 + (seed >> 16)%maxsize);
+		dt = rtai_rdtsc() - dt;
+		result[cpuid].alloc_sum += dt;
+		if (dt > result[cpuid].alloc_max) {
+			result[cpuid].alloc_max = dt;
+		}
+		if (!block[k]) {
+			result[cpuid].failed++;
+		}
+	}
+	for (k = 0; k < nblocks; k++) {
+		rt_free(block[k]);
+	}
+	rt_sem_signal(&done);
+}
+
+#define NS(t)  ((int)rtai_llimd(t, 1000000000, RTAI_CLOCK_FREQ))
+
+static void report_task(long ncpus)
+{
+	struct rtheap_mags_stats stats;
+	int cpuid;
+
+	for (cpuid = 0; cpuid < ncpus; cpuid++) {
+		rt_sem_wait(&done);
+	}
+	rt_printk("\n\nCONCURRENT RT_MALLOC/RT_FREE (ns)%s\n", rtheap_mags_stats(&rtai_global_heap, &stats) ? " - PER CPU MAGAZINES" : "");
+	rt_printk("    CPU ALC_AVG ALC_MAX FRE_AVG FRE_MAX  FAILED\n");
+	for (cpuid = 0; cpuid < ncpus; cpuid++) {
+		rt_printk("%7d %7d %7d %7d %7d %7d\n", cpuid,
+			NS(rtai_llimd(result[cpuid].alloc_sum, 1, loops)), NS(result[cpuid].alloc_max),
+			NS(rtai_llimd(result[cpuid].free_sum, 1, loops)), NS(result[cpuid].free_max),
+			result[cpuid].failed);
+	}
+	if (stats.alloc_hits + stats.alloc_misses) {
+		rt_printk("MAGAZINES: ALLOC HITS %lu MISSES %lu, FREE HITS %lu MISSES %lu\n", stats.alloc_hits, stats.alloc_misses, stats.free_hits, stats.free_misses);
+	}
+	rt_printk("\n");
+}
+
+static RT_TASK report;
+
+static int __heapmag_init(void)
+{
+	int cpuid, ncpus, e;
+
+	printk("\nWait for it ...\n");
+	if (nblocks <= 0 || nblocks > MAXBLOCKS) {
+		nblocks = MAXBLOCKS;
+	}
+	if (maxsize <= 0) {
+		maxsize = 1;
+	}
+	ncpus = num_online_cpus() < RTAI_NR_CPUS ? num_online_cpus() : RTAI_NR_CPUS;
+	rt_sem_init(&start, ncpus);
+	rt_sem_init(&done, 0);
+	for (cpuid = 0; cpuid < ncpus; cpuid++) {
+		if ((e = rt_task_init_cpuid(&task[cpuid], heap_task, cpuid, stack_size + MAXBLOCKS*sizeof(void *), 0, 0, 0, cpuid)) < 0) {
+		task_init_has_failed:
+			rt_printk("heapmag: failed to initialize task %d, error=%d\n", cpuid, e);
+			while (--cpuid >= 0) {
+				rt_task_delete(&task[cpuid]);
+			}
+			rt_sem_delete(&start);
+			rt_sem_delete(&done);
+			return -1;
+		}
+	}
+	if ((e = rt_task_init_cpuid(&report, report_task, ncpus, stack_size, 1, 0, 0, 0)) < 0) {
+		goto task_init_has_failed;
+	}
+	rt_task_resume(&report);
+	for (cpuid = 0; cpuid < ncpus; cpuid++) {
+		rt_task_resume(&task[cpuid]);
+	}
+
+	return 0;
+}
+
+
+static void __heapmag_exit(void)
+{
+	int cpuid;
+	rt_task_delete(&report);
+	for (cpuid = 0; cpuid < RTAI_NR_CPUS; cpuid++) {
+		rt_task_delete(&task[cpuid]);
+	}
+	rt_sem_delete(&start);
+	rt_sem_delete(&done);
+}
+
+module_init(__heapmag_init);
+module_exit(__heapmag_exit);
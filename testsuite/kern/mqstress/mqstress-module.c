@@ -0,0 +1,197 @@
+/*
+ * Copyright (C) 2026 The RTAI project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/init.h>
+#include <rtai_sched.h>
+#include <rtai_tbx.h>
+#include <rtai_mq.h>
+
+MODULE_DESCRIPTION("Measures priority queues send/receive cost against their backlog");
+MODULE_AUTHOR("The RTAI project");
+MODULE_LICENSE("GPL");
+
+/*
+ * Command line parameters
+ */
+int depth_max = 10000;
+RTAI_MODULE_PARM(depth_max, int);
+MODULE_PARM_DESC(depth_max, "Max number of queued messages (default: 10000)");
+
+int step = 1000;
+RTAI_MODULE_PARM(step, int);
+MODULE_PARM_DESC(step, "Backlog increment between measures (default: 1000)");
+
+int nprios = 16;
+RTAI_MODULE_PARM(nprios, int);
+MODULE_PARM_DESC(nprios, "Number of priorities messages are spread over (default: 16)");
+
+int loops = 1000;
+RTAI_MODULE_PARM(loops, int);
+MODULE_PARM_DESC(loops, "Number of send/receive pairs per measure (default: 1000)");
+
+int stack_size = 4096;
+RTAI_MODULE_PARM(stack_size, int);
+MODULE_PARM_DESC(stack_size, "Task stack size in bytes (default: 4096)");
+
+#define MQ_NAME  "mqstress"
+
+static RT_TASK task;
+
+static RT_MSGQ tbx;
+
+struct stats { RTIME min, max, sum; };
+
+static inline void stats_init(struct stats *s)
+{
+	s->min = RTAI_TIME_LIMIT;
+	s->max = s->sum = 0;
+}
+
+static inline void stats_add(struct stats *s, RTIME dt)
+{
+	if (dt < s->min) {
+		s->min = dt;
+	}
+	if (dt > s->max) {
+		s->max = dt;
+	}
+	s->sum += dt;
+}
+
+#define NS(t)  ((int)rtai_llimd(t, 1000000000, RTAI_CLOCK_FREQ))
+
+static void print_stats(int depth, struct stats *snd, struct stats *rcv)
+{
+	rt_printk("%7d %7d %7d %7d %7d %7d %7d\n", depth,
+		NS(snd->min), NS(rtai_llimd(snd->sum, 1, loops)), NS(snd->max),
+		NS(rcv->min), NS(rtai_llimd(rcv->sum, 1, loops)), NS(rcv->max));
+}
+
+/*
+ * Messages priorities are cycled over nprios values, so that a linear
+ * insertion must scan a good part of the queue, while the more urgent ones
+ * are taken out. The queue is refilled at each depth to limit the drift of
+ * the priorities of the backlog toward the less urgent ones.
+ */
+
+static void tbx_stress(void)
+{
+	int i, depth, msg, prio;
+	struct stats snd, rcv;
+	RTIME dt;
+
+	rt_printk("\n\nTBX BACKLOG VS SEND/RECEIVE (ns)\n");
+	rt_printk("BACKLOG SND_MIN SND_AVG SND_MAX RCV_MIN RCV_AVG RCV_MAX\n");
+	for (depth = 0; depth <= depth_max; depth += step) {
+		while (!rt_msg_receive_if(&tbx, &msg, sizeof(msg), &prio));
+		for (i = 0; i < depth; i++) {
+			rt_msg_send_if(&tbx, &i, sizeof(i), i%nprios);
+		}
+		stats_init(&snd);
+		stats_init(&rcv);
+		for (i = 0; i < loops; i++) {
+			dt = rtai_rdtsc();
+			rt_msg_send_if(&tbx, &i, sizeof(i), i%nprios);
+			stats_add(&snd, rtai_rdtsc() - dt);
+			dt = rtai_rdtsc();
+			rt_msg_receive_if(&tbx, &msg, sizeof(msg), &prio);
+			stats_add(&rcv, rtai_rdtsc() - dt);
+		}
+		print_stats(depth, &snd, &rcv);
+	}
+}
+
+static void mq_stress(void)
+{
+	int i, depth, msg;
+	unsigned int prio;
+	struct stats snd, rcv;
+	struct mq_attr attr = { depth_max + 1, sizeof(int), MQ_NONBLOCK, 0 };
+	mqd_t mq;
+	RTIME dt;
+
+	rt_printk("\n\nPOSIX MQ BACKLOG VS SEND/RECEIVE (ns)\n");
+	if ((mq = mq_open(MQ_NAME, O_CREAT | O_RDWR | O_NONBLOCK, 0666, &attr)) <= 0) {
+		rt_printk("mqstress: failed to open the queue, error=%d\n", mq);
+		return;
+	}
+	rt_printk("BACKLOG SND_MIN SND_AVG SND_MAX RCV_MIN RCV_AVG RCV_MAX\n");
+	for (depth = 0; depth <= depth_max; depth += step) {
+		while ((int)mq_receive(mq, (char *)&msg, sizeof(msg), &prio) > 0);
+		for (i = 0; i < depth; i++) {
+			mq_send(mq, (char *)&i, sizeof(i), i%nprios);
+		}
+		stats_init(&snd);
+		stats_init(&rcv);
+		for (i = 0; i < loops; i++) {
+			dt = rtai_rdtsc();
+			mq_send(mq, (char *)&i, sizeof(i), i%nprios);
+			stats_add(&snd, rtai_rdtsc() - dt);
+			dt = rtai_rdtsc();
+			mq_receive(mq, (char *)&msg, sizeof(msg), &prio);
+			stats_add(&rcv, rtai_rdtsc() - dt);
+		}
+		print_stats(depth, &snd, &rcv);
+	}
+	mq_close(mq);
+	mq_unlink(MQ_NAME);
+}
+
+static void stress_task(long t)
+{
+	tbx_stress();
+	mq_stress();
+	rt_printk("\n");
+}
+
+static int __mqstress_init(void)
+{
+	int e;
+
+	printk("\nWait for it ...\n");
+	if (step <= 0) {
+		step = depth_max > 0 ? depth_max : 1;
+	}
+	if (nprios <= 0 || nprios > MQ_PRIO_MAX) {
+		nprios = MQ_PRIO_MAX;
+	}
+	if ((e = rt_msgq_init(&tbx, depth_max + 1, sizeof(int)))) {
+		rt_printk("mqstress: failed to initialize the typed mailbox, error=%d\n", e);
+		return e;
+	}
+	if ((e = rt_task_init_cpuid(&task, stress_task, 0, stack_size, 0, 0, 0, rtai_cpuid())) < 0) {
+		rt_printk("mqstress: failed to initialize task, error=%d\n", e);
+		rt_msgq_delete(&tbx);
+		return -1;
+	}
+	rt_task_resume(&task);
+
+	return 0;
+}
+
+
+static void __mqstress_exit(void)
+{
+	rt_task_delete(&task);
+	rt_msgq_delete(&tbx);
+}
+
+module_init(__mqstress_init);
+module_exit(__mqstress_exit);
@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2026 The RTAI project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/init.h>
+#include <linux/slab.h>
+#include <rtai_sched.h>
+
+MODULE_DESCRIPTION("Measures rt_schedule() cost against the ready list depth");
+MODULE_AUTHOR("The RTAI project");
+MODULE_LICENSE("GPL");
+
+/*
+ * Command line parameters
+ */
+int ntasks = 500;
+RTAI_MODULE_PARM(ntasks, int);
+MODULE_PARM_DESC(ntasks, "Max number of ready tasks (default: 500)");
+
+int step = 50;
+RTAI_MODULE_PARM(step, int);
+MODULE_PARM_DESC(step, "Ready list depth increment between measures (default: 50)");
+
+int nprio = 100;
+RTAI_MODULE_PARM(nprio, int);
+MODULE_PARM_DESC(nprio, "Number of distinct priorities of the ready tasks (default: 100)");
+
+int loops = 20000;
+RTAI_MODULE_PARM(loops, int);
+MODULE_PARM_DESC(loops, "Number of resume/suspend pairs per measure (default: 20000)");
+
+int stack_size = 4096;
+RTAI_MODULE_PARM(stack_size, int);
+MODULE_PARM_DESC(stack_size, "Task stack size in bytes (default: 4096)");
+
+#define BASE_PRIO  10
+#define CHK_PRIO   2
+
+static RT_TASK *thread, probe, task, chk[4];
+
+static void pend_task(long t)
+{
+	while(1) {
+		rt_task_suspend(rt_whoami());
+	}
+}
+
+/*
+ * The measuring task has the highest priority, so nothing it makes ready can
+ * preempt it and each resume/suspend costs just a ready list insertion and 
+ * removal, plus a call to rt_schedule() finding nothing to switch to. The
+ * probe has the lowest priority, so that it must be put behind all the tasks 
+ * already made ready, i.e. the worst case for a linear ready list.
+ */
+
+static int ready_list_ordered(void)
+{
+	RT_TASK *t;
+	unsigned long flags;
+	int ordered = 1;
+
+	flags = rt_global_save_flags_and_cli();
+	for (t = rt_whoami(); (t->rnext)->priority != RT_SCHED_LINUX_PRIORITY; t = t->rnext) {
+		if ((t->rnext)->priority < t->priority) {
+			ordered = 0;
+			break;
+		}
+	}
+	rt_global_restore_flags(flags);
+	return ordered;
+}
+
+/*
+ * A ready task whose new priority still fits between its neighbours stays 
+ * where it is, the tasks made ready afterwards must be queued anyhow by 
+ * their priority, i.e. 2, 4, 3, 5 must not happen below.
+ */
+
+static void prio_check(void)
+{
+	int i, ordered;
+
+	for (i = 0; i < 3; i++) {
+		rt_task_resume(chk + i);
+	}
+	rt_change_prio(chk + 1, CHK_PRIO + 2);
+	rt_task_resume(chk + 3);
+	ordered = ready_list_ordered();
+	rt_task_suspend(chk + 1);
+	rt_task_resume(chk + 1);
+	ordered &= ready_list_ordered();
+	for (i = 0; i < 4; i++) {
+		rt_task_suspend(chk + i);
+	}
+	rt_printk("\n\nPRIORITY CHANGED IN PLACE: READY LIST %s\n", ordered ? "ORDERED" : "OUT OF ORDER (ERROR)");
+}
+
+static void sched_task(long t)
+{
+	int i, k, depth;
+	RTIME min, max, dt;
+
+	prio_check();
+	rt_printk("\n\nREADY LIST DEPTH VS RESUME/SUSPEND (ns)%s\n", 
+#ifdef CONFIG_RTAI_BITMAP_READY_LIST
+	" - BITMAPPED READY LIST");
+#else
+	" - LINEAR READY LIST");
+#endif
+	rt_printk("  DEPTH     MIN     AVG     MAX\n");
+	for (depth = k = 0; depth <= ntasks; depth += step) {
+		for (; k < depth; k++) {
+			rt_task_resume(thread + k);
+		}
+		min = RTAI_TIME_LIMIT;
+		max = 0;
+		t = rtai_rdtsc();
+		for (i = 0; i < loops; i++) {
+			dt = rtai_rdtsc();
+			rt_task_resume(&probe);
+			rt_task_suspend(&probe);
+			dt = rtai_rdtsc() - dt;
+			if (dt < min) {
+				min = dt;
+			}
+			if (dt > max) {
+				max = dt;
+			}
+		}
+		t = rtai_rdtsc() - t;
+		rt_printk("%7d %7d %7d %7d\n", depth, 
+			(int)rtai_llimd(min, 1000000000, RTAI_CLOCK_FREQ),
+			(int)rtai_llimd(rtai_llimd(t, 1000000000, RTAI_CLOCK_FREQ), 1, loops),
+			(int)rtai_llimd(max, 1000000000, RTAI_CLOCK_FREQ));
+	}
+	rt_printk("\n");
+}
+
+static int __readyq_init(void)
+{
+	int i, k, e;
+
+	printk("\nWait for it ...\n");
+	if (step <= 0) {
+		step = ntasks > 0 ? ntasks : 1;
+	}
+	if (nprio <= 0) {
+		nprio = 1;
+	}
+        thread = (RT_TASK *)kmalloc(ntasks*sizeof(RT_TASK), GFP_KERNEL);
+	if (!thread) {
+		return -ENOMEM;
+	}
+	for (i = 0; i < ntasks; i++) {
+		if ((e = rt_task_init_cpuid(thread + i, pend_task, i, stack_size, BASE_PRIO + i%nprio, 0, 0, rtai_cpuid())) < 0) {
+		task_init_has_failed:
+		    rt_printk("readyq: failed to initialize task %d, error=%d\n", i, e);
+		    while (--i >= 0)
+			rt_task_delete(thread + i);
+		    kfree(thread);
+		    return -1;
+		}
+	}
+	if ((e = rt_task_init_cpuid(&probe, pend_task, i, stack_size, BASE_PRIO + nprio, 0, 0, rtai_cpuid())) < 0) {
+		goto task_init_has_failed;
+	}
+	for (k = 0; k < 4; k++) {
+		// priorities 2, 3, 5 and then 3 again
+		if ((e = rt_task_init_cpuid(chk + k, pend_task, k, stack_size, CHK_PRIO + k%3 + k/2, 0, 0, rtai_cpuid())) < 0) {
+			while (--k >= 0) {
+				rt_task_delete(chk + k);
+			}
+			rt_task_delete(&probe);
+			goto task_init_has_failed;
+		}
+	}
+	if ((e = rt_task_init_cpuid(&task, sched_task, i, stack_size, 1, 0, 0, rtai_cpuid())) < 0) {
+		for (k = 0; k < 4; k++) {
+			rt_task_delete(chk + k);
+		}
+		rt_task_delete(&probe);
+		goto task_init_has_failed;
+	}
+	rt_task_resume(&task);
+
+	return 0;
+}
+
+
+static void __readyq_exit(void)
+{
+	int i;
+	rt_task_delete(&task);
+	rt_task_delete(&probe);
+	for (i = 0; i < 4; i++) {
+		rt_task_delete(chk + i);
+	}
+	for (i = 0; i < ntasks; i++) {
+		rt_task_delete(thread + i);
+	}
+        kfree(thread);
+}
+
+module_init(__readyq_init);
+module_exit(__readyq_exit);
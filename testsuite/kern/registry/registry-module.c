@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2026 The RTAI project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/init.h>
+#include <linux/vmalloc.h>
+#include <rtai_sched.h>
+#include <rtai_registry.h>
+
+MODULE_DESCRIPTION("Measures registry lookups against the number of registered objects");
+MODULE_AUTHOR("The RTAI project");
+MODULE_LICENSE("GPL");
+
+/*
+ * Command line parameters
+ */
+int nobjs = 50000;
+RTAI_MODULE_PARM(nobjs, int);
+MODULE_PARM_DESC(nobjs, "Max number of registered objects (default: 50000)");
+
+int step = 5000;
+RTAI_MODULE_PARM(step, int);
+MODULE_PARM_DESC(step, "Registered objects increment between measures (default: 5000)");
+
+int loops = 20000;
+RTAI_MODULE_PARM(loops, int);
+MODULE_PARM_DESC(loops, "Number of lookups per measure (default: 20000)");
+
+int stack_size = 4096;
+RTAI_MODULE_PARM(stack_size, int);
+MODULE_PARM_DESC(stack_size, "Task stack size in bytes (default: 4096)");
+
+/* Not a known type, so that nobody takes the dummy objects for real ones. */
+#define IS_DUMMY    0x7F
+#define DUMMY_NAME  0x10000000UL
+
+static RT_TASK task;
+
+static char *objs;
+
+static int nregs;
+
+static void registry_task(long t)
+{
+	struct rt_registry_stats stats;
+	unsigned long probes;
+	int i, k, depth, errs;
+	RTIME min, max, dt;
+
+	rt_printk("\n\nREGISTRY LOOKUPS (ns)\n");
+	rt_printk("  OBJS   SLOTS     MIN     AVG     MAX  PROBES ERRS\n");
+	for (depth = step; depth <= nobjs; depth += step) {
+		for (; nregs < depth; nregs++) {
+			if (!rt_register(DUMMY_NAME + nregs, objs + nregs, IS_DUMMY, NULL)) {
+				rt_printk("registry: failed to register object %d\n", nregs);
+				return;
+			}
+		}
+/* let the Linux work grow the table, if it must */
+		rt_sleep(nano2count(100000000));
+		rt_registry_stats(&stats);
+		probes = stats.lookup_probes;
+		min = RTAI_TIME_LIMIT;
+		max = 0;
+		t = rtai_rdtsc();
+		for (errs = i = 0; i < loops; i++) {
+			k = (i*7919) % depth;
+			dt = rtai_rdtsc();
+			if (rt_get_adr(DUMMY_NAME + k) != objs + k) {
+				errs++;
+			}
+			dt = rtai_rdtsc() - dt;
+			if (dt < min) {
+				min = dt;
+			}
+			if (dt > max) {
+				max = dt;
+			}
+		}
+		t = rtai_rdtsc() - t;
+		rt_registry_stats(&stats);
+		probes = stats.lookup_probes - probes;
+		rt_printk("%6d %7d %7d %7d %7d %3lu.%02lu %4d\n", depth, stats.slots,
+			(int)rtai_llimd(min, 1000000000, RTAI_CLOCK_FREQ),
+			(int)rtai_llimd(rtai_llimd(t, 1000000000, RTAI_CLOCK_FREQ), 1, loops),
+			(int)rtai_llimd(max, 1000000000, RTAI_CLOCK_FREQ),
+			probes/loops, (100*probes/loops)%100, errs);
+	}
+	rt_printk("%lu growths, more in /proc/rtai/names\n\n", stats.growths);
+}
+
+static int __registry_init(void)
+{
+	int e;
+
+	printk("\nWait for it ...\n");
+	if (step <= 0) {
+		step = nobjs > 0 ? nobjs : 1;
+	}
+	if (!(objs = vmalloc(nobjs))) {
+		return -ENOMEM;
+	}
+	if ((e = rt_task_init_cpuid(&task, registry_task, 0, stack_size, 0, 0, 0, rtai_cpuid())) < 0) {
+		rt_printk("registry: failed to initialize task, error=%d\n", e);
+		vfree(objs);
+		return -1;
+	}
+	rt_task_resume(&task);
+
+	return 0;
+}
+
+
+static void __registry_exit(void)
+{
+	rt_task_delete(&task);
+	while (--nregs >= 0) {
+		rt_drg_on_adr(objs + nregs);
+	}
+	vfree(objs);
+}
+
+module_init(__registry_init);
+module_exit(__registry_exit);
@@ -0,0 +1,175 @@
+/*
+ * Copyright (C) 2026 The RTAI project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/init.h>
+#include <linux/slab.h>
+#include <rtai_sched.h>
+#include <rtai_sem.h>
+
+MODULE_DESCRIPTION("Measures timed waits cost against the timed list length");
+MODULE_AUTHOR("The RTAI project");
+MODULE_LICENSE("GPL");
+
+/*
+ * Command line parameters
+ */
+int ntasks = 1000;
+RTAI_MODULE_PARM(ntasks, int);
+MODULE_PARM_DESC(ntasks, "Max number of tasks blocked with a timeout (default: 1000)");
+
+int step = 100;
+RTAI_MODULE_PARM(step, int);
+MODULE_PARM_DESC(step, "Timed list length increment between measures (default: 100)");
+
+int timeout = 100;
+RTAI_MODULE_PARM(timeout, int);
+MODULE_PARM_DESC(timeout, "Timeout of the blocked tasks, in seconds (default: 100)");
+
+int loops = 20000;
+RTAI_MODULE_PARM(loops, int);
+MODULE_PARM_DESC(loops, "Number of signal/rearm pairs per measure (default: 20000)");
+
+int stack_size = 4096;
+RTAI_MODULE_PARM(stack_size, int);
+MODULE_PARM_DESC(stack_size, "Task stack size in bytes (default: 4096)");
+
+static RT_TASK *thread, probe, task;
+
+static SEM block_sem, probe_sem;
+
+static RTIME block_delay;
+
+static void block_task(long i)
+{
+	while(1) {
+		rt_sem_wait_timed(&block_sem, block_delay + i);
+	}
+}
+
+/*
+ * The probe has a higher priority than the measuring task, so signalling it
+ * cancels its timeout and switches to it, it rearms a timeout farther than
+ * those of all the blocked tasks and switches back.
+ */
+
+static void probe_task(long t)
+{
+	while(1) {
+		rt_sem_wait_timed(&probe_sem, 2*block_delay);
+	}
+}
+
+static void timed_task(long t)
+{
+	int i, k, depth;
+	RTIME min, max, dt;
+
+	rt_printk("\n\nTIMED LIST LENGTH VS SIGNAL/REARM (ns)%s\n",
+#if defined(CONFIG_RTAI_TIMED_LIST_WHEEL)
+	" - TIMING WHEEL TIMED LIST");
+#elif defined(CONFIG_RTAI_LONG_TIMED_LIST)
+	" - BLACK/RED TIMED LIST");
+#else
+	" - LINEAR TIMED LIST");
+#endif
+	rt_printk(" LENGTH     MIN     AVG     MAX\n");
+	rt_task_resume(&probe);
+	for (depth = k = 0; depth <= ntasks; depth += step) {
+		for (; k < depth; k++) {
+			rt_task_resume(thread + k);
+		}
+		min = RTAI_TIME_LIMIT;
+		max = 0;
+		t = rtai_rdtsc();
+		for (i = 0; i < loops; i++) {
+			dt = rtai_rdtsc();
+			rt_sem_signal(&probe_sem);
+			dt = rtai_rdtsc() - dt;
+			if (dt < min) {
+				min = dt;
+			}
+			if (dt > max) {
+				max = dt;
+			}
+		}
+		t = rtai_rdtsc() - t;
+		rt_printk("%7d %7d %7d %7d\n", depth,
+			(int)rtai_llimd(min, 1000000000, RTAI_CLOCK_FREQ),
+			(int)rtai_llimd(rtai_llimd(t, 1000000000, RTAI_CLOCK_FREQ), 1, loops),
+			(int)rtai_llimd(max, 1000000000, RTAI_CLOCK_FREQ));
+	}
+	rt_printk("\n");
+}
+
+static int __timedq_init(void)
+{
+	int i, e;
+
+	printk("\nWait for it ...\n");
+	if (step <= 0) {
+		step = ntasks > 0 ? ntasks : 1;
+	}
+	block_delay = nano2count(timeout*1000000000LL);
+	rt_sem_init(&block_sem, 0);
+	rt_sem_init(&probe_sem, 0);
+        thread = (RT_TASK *)kmalloc(ntasks*sizeof(RT_TASK), GFP_KERNEL);
+	if (!thread) {
+		return -ENOMEM;
+	}
+	for (i = 0; i < ntasks; i++) {
+		if ((e = rt_task_init_cpuid(thread + i, block_task, i, stack_size, 1, 0, 0, rtai_cpuid())) < 0) {
+		task_init_has_failed:
+		    rt_printk("timedq: failed to initialize task %d, error=%d\n", i, e);
+		    while (--i >= 0)
+			rt_task_delete(thread + i);
+		    kfree(thread);
+		    rt_sem_delete(&probe_sem);
+		    rt_sem_delete(&block_sem);
+		    return -1;
+		}
+	}
+	if ((e = rt_task_init_cpuid(&probe, probe_task, i, stack_size, 1, 0, 0, rtai_cpuid())) < 0) {
+		goto task_init_has_failed;
+	}
+	if ((e = rt_task_init_cpuid(&task, timed_task, i, stack_size, 2, 0, 0, rtai_cpuid())) < 0) {
+		rt_task_delete(&probe);
+		goto task_init_has_failed;
+	}
+	rt_task_resume(&task);
+
+	return 0;
+}
+
+
+static void __timedq_exit(void)
+{
+	int i;
+	rt_task_delete(&task);
+	rt_task_delete(&probe);
+	for (i = 0; i < ntasks; i++) {
+		rt_task_delete(thread + i);
+	}
+        kfree(thread);
+	rt_sem_delete(&probe_sem);
+	rt_sem_delete(&block_sem);
+}
+
+module_init(__timedq_init);
+module_exit(__timedq_exit);
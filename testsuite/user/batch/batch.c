@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2026 The RTAI project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+
+#include <rtai_lxrt.h>
+#include <rtai_sem.h>
+#include <rtai_mbx.h>
+#include <rtai_batch.h>
+
+#define LOOPS   100000
+#define GROUPS  5
+#define NCALLS  (4*GROUPS)
+
+static SEM *sem;
+
+static MBX *mbx;
+
+static long long retval[NCALLS];
+
+/*
+ * A cycle is made of GROUPS of 4 non blocking calls: signal and take back a
+ * semaphore, send and receive back a message.
+ */
+
+static void percall_cycle(void)
+{
+	long msg = 0x5a5a5a5a;
+	int i;
+
+	for (i = 0; i < NCALLS; i += 4) {
+		retval[i]     = rt_sem_signal(sem);
+		retval[i + 1] = rt_sem_wait_if(sem);
+		retval[i + 2] = rt_mbx_send_if(mbx, &msg, sizeof(msg));
+		retval[i + 3] = rt_mbx_receive_if(mbx, &msg, sizeof(msg));
+	}
+}
+
+static int batch_cycle(struct rt_batch_ring *ring)
+{
+	struct { SEM *sem; } sarg = { sem };
+	struct { MBX *mbx; char *msg; long msg_size; long space; } marg;
+	struct rt_batch_cqe cqe;
+	long msg = 0x5a5a5a5a;
+	int i, err = 0;
+
+	marg.mbx = mbx;
+	marg.msg = (char *)&msg;
+	marg.msg_size = sizeof(msg);
+	marg.space = 0;
+	for (i = 0; i < NCALLS; i += 4) {
+		RT_BATCH_QUEUE(ring, BIDX, SEM_SIGNAL, sarg, i);
+		RT_BATCH_QUEUE(ring, BIDX, SEM_WAIT_IF, sarg, i + 1);
+		RT_BATCH_QUEUE(ring, BIDX, MBX_SEND_IF, marg, i + 2);
+		RT_BATCH_QUEUE(ring, BIDX, MBX_RECEIVE_IF, marg, i + 3);
+	}
+	if (rt_batch_submit(ring) != NCALLS) {
+		return -1;
+	}
+	for (i = 0; rt_batch_reap(ring, &cqe); i++) {
+		if (cqe.user_data != (unsigned long)i || cqe.retval != retval[i]) {
+			err = -1;
+		}
+	}
+	return i == NCALLS ? err : -1;
+}
+
+int main(void)
+{
+	RT_TASK *task;
+	struct rt_batch_ring *ring;
+	RTIME tns;
+	int i, errs = 0;
+
+	if (!(task = rt_thread_init(nam2num("BATCHM"), 0, 0, SCHED_FIFO, 0x1))) {
+		printf("CANNOT INIT MAIN TASK\n");
+		exit(1);
+	}
+	mlockall(MCL_CURRENT | MCL_FUTURE);
+	if (!(sem = rt_typed_sem_init(nam2num("BATCHS"), 0, CNT_SEM))) {
+		printf("CANNOT CREATE THE SEMAPHORE\n");
+		exit(1);
+	}
+	if (!(mbx = rt_mbx_init(nam2num("BATCHX"), 4*sizeof(long)))) {
+		printf("CANNOT CREATE THE MAILBOX\n");
+		exit(1);
+	}
+	if (!(ring = rt_batch_init(nam2num("BATCHR"), NCALLS))) {
+		printf("CANNOT CREATE THE BATCH RING\n");
+		exit(1);
+	}
+	rt_set_oneshot_mode();
+	start_rt_timer(0);
+	rt_make_hard_real_time();
+
+	printf("\n%d CYCLES OF %d NON BLOCKING CALLS\n", LOOPS, NCALLS);
+	tns = rt_get_cpu_time_ns();
+	for (i = 0; i < LOOPS; i++) {
+		percall_cycle();
+	}
+	tns = rt_get_cpu_time_ns() - tns;
+	printf("A TRAP PER CALL:    %lld NS PER CALL.\n", tns/(LOOPS*NCALLS));
+	tns = rt_get_cpu_time_ns();
+	for (i = 0; i < LOOPS; i++) {
+		if (batch_cycle(ring)) {
+			errs++;
+		}
+	}
+	tns = rt_get_cpu_time_ns() - tns;
+	printf("A TRAP PER CYCLE:   %lld NS PER CALL.\n", tns/(LOOPS*NCALLS));
+	printf("CYCLES WITH WRONG COMPLETIONS %d (MUST BE 0).\n", errs);
+
+	rt_make_soft_real_time();
+	stop_rt_timer();
+	rt_batch_delete(ring);
+	rt_mbx_delete(mbx);
+	rt_sem_delete(sem);
+	rt_task_delete(task);
+	return 0;
+}
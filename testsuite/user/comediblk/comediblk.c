@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2026 The RTAI project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Acquires all the channels of the analog input subdevice 0 of /dev/comedi0
+ * with an async command, in blocks of scans, each one read with its
+ * sequence number and the time it was found complete. It checks that no
+ * block is missed and reports the spacing of the blocks stamps, along with
+ * how late the reader has been. It can be run without any hardware by
+ * configuring the comedi_test driver on /dev/comedi0.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include <rtai_lxrt.h>
+#include <rtai_comedi.h>
+
+#define DEVICE     "/dev/comedi0"
+#define SUBDEV     0
+#define MAXCHANS   16
+#define SCAN_NS    100000
+#define BLOCK      100     // scans per block
+#define NBLOCKS    500
+
+static unsigned int chanlist[MAXCHANS];
+
+static lsampl_t data[MAXCHANS*BLOCK];
+
+int main(void)
+{
+	RT_TASK *task;
+	void *dev;
+	comedi_cmd cmd;
+	RT_COMEDI_BLOCK blk;
+	RTIME prev = 0, dt, mindt = 0, maxdt = 0;
+	long n, nblocks = 0, late = 0;
+	unsigned int cbmask = 0;
+	int nchans, i, errs = 0;
+
+	if (!(task = rt_task_init_schmod(nam2num("CMDBLK"), 0, 0, 0, SCHED_FIFO, 0x1))) {
+		printf("CANNOT INIT MAIN TASK\n");
+		exit(1);
+	}
+	if (!(dev = comedi_open(DEVICE))) {
+		printf("CANNOT OPEN %s, TRY: modprobe comedi_test; comedi_config %s comedi_test\n", DEVICE, DEVICE);
+		rt_task_delete(task);
+		exit(1);
+	}
+	mlockall(MCL_CURRENT | MCL_FUTURE);
+	rt_set_oneshot_mode();
+	start_rt_timer(0);
+
+	if ((nchans = comedi_get_n_channels(dev, SUBDEV)) > MAXCHANS) {
+		nchans = MAXCHANS;
+	}
+	for (i = 0; i < nchans; i++) {
+		chanlist[i] = CR_PACK(i, 0, AREF_GROUND);
+	}
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.subdev         = SUBDEV;
+	cmd.start_src      = TRIG_NOW;
+	cmd.scan_begin_src = TRIG_TIMER;
+	cmd.scan_begin_arg = SCAN_NS;
+	cmd.convert_src    = TRIG_TIMER;
+	cmd.convert_arg    = SCAN_NS/nchans/2;
+	cmd.scan_end_src   = TRIG_COUNT;
+	cmd.scan_end_arg   = nchans;
+	cmd.stop_src       = TRIG_COUNT;
+	cmd.stop_arg       = BLOCK*NBLOCKS;
+	cmd.chanlist       = chanlist;
+	cmd.chanlist_len   = nchans;
+	comedi_command_test(dev, &cmd);
+	if (comedi_command_test(dev, &cmd)) {
+		printf("COMMAND NOT SUPPORTED BY %s\n", DEVICE);
+		goto out;
+	}
+	rt_comedi_register_callback(dev, SUBDEV, COMEDI_CB_EOS | COMEDI_CB_BLOCK | COMEDI_CB_EOA | COMEDI_CB_ERROR | COMEDI_CB_OVERFLOW, NULL, task);
+	if (rt_comedi_block_config(dev, SUBDEV, nchans, BLOCK) != nchans*BLOCK) {
+		printf("CANNOT CONFIGURE BLOCKS OF %d SCANS\n", BLOCK);
+		goto out;
+	}
+	if (comedi_command(dev, &cmd)) {
+		printf("CANNOT START THE COMMAND\n");
+		goto out;
+	}
+
+	rt_make_hard_real_time();
+	while (nblocks < NBLOCKS) {
+		if ((n = rt_comedi_block_wread_timed(dev, SUBDEV, &blk, data, nano2count(1000000000))) >= RTE_BASE) {
+			errs++;
+			break;
+		}
+		cbmask |= blk.cbmask;
+		if (!n) {
+			if (blk.cbmask & (COMEDI_CB_EOA | COMEDI_CB_ERROR | COMEDI_CB_OVERFLOW)) {
+				break;
+			}
+			continue;
+		}
+		if (n != nchans*BLOCK || blk.seq != nblocks) {
+			errs++;
+		}
+		if (blk.stamp && prev) {
+			dt = blk.stamp - prev;
+			if (!mindt || dt < mindt) mindt = dt;
+			if (dt > maxdt) maxdt = dt;
+		}
+		prev = blk.stamp;
+		if (blk.overrun > late) {
+			late = blk.overrun;
+		}
+		nblocks++;
+	}
+	rt_make_soft_real_time();
+
+	printf("\n%ld BLOCKS OF %d SCANS OF %d CHANNELS, STAMPS SPACING MIN/MAX %lld/%lld NS (%d NS EXPECTED),\n", nblocks, BLOCK, nchans, count2nano(mindt), count2nano(maxdt), BLOCK*SCAN_NS);
+	printf("AT MOST %ld BLOCKS BEHIND, CALLBACKS 0x%x, %d ERRORS (MUST BE 0).\n", late, cbmask, errs);
+	comedi_cancel(dev, SUBDEV);
+out:
+	comedi_close(dev);
+	stop_rt_timer();
+	rt_task_delete(task);
+	return 0;
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2026 The RTAI project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Acquires all the channels of the analog input subdevice 0 of /dev/comedi0
+ * with an async command, reading the samples in place from the mapped
+ * COMEDI buffer, a block of scans at a time. It can be run without any
+ * hardware by configuring the comedi_test driver on /dev/comedi0.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include <rtai_lxrt.h>
+#include <rtai_comedi.h>
+
+#define DEVICE     "/dev/comedi0"
+#define SUBDEV     0
+#define MAXCHANS   16
+#define SCAN_NS    100000
+#define BLOCK      100     // scans per wait
+#define NBLOCKS    500
+
+static unsigned int chanlist[MAXCHANS];
+
+int main(void)
+{
+	RT_TASK *task;
+	void *dev;
+	comedi_cmd cmd;
+	char *buf;
+	long size, ofst, span, scanlen, sampsize, nbytes = 0, nwaits = 0, nsamples, nscans;
+	unsigned int flags;
+	int nchans, i, errs = 0;
+	double sum = 0;
+
+	if (!(task = rt_task_init_schmod(nam2num("CMDMAP"), 0, 0, 0, SCHED_FIFO, 0x1))) {
+		printf("CANNOT INIT MAIN TASK\n");
+		exit(1);
+	}
+	if (!(dev = comedi_open(DEVICE))) {
+		printf("CANNOT OPEN %s, TRY: modprobe comedi_test; comedi_config %s comedi_test\n", DEVICE, DEVICE);
+		rt_task_delete(task);
+		exit(1);
+	}
+	mlockall(MCL_CURRENT | MCL_FUTURE);
+	rt_set_oneshot_mode();
+	start_rt_timer(0);
+
+	if ((nchans = comedi_get_n_channels(dev, SUBDEV)) > MAXCHANS) {
+		nchans = MAXCHANS;
+	}
+	flags = comedi_get_subdevice_flags(dev, SUBDEV);
+	sampsize = flags & SDF_LSAMPL ? sizeof(lsampl_t) : sizeof(sampl_t);
+	scanlen = nchans*sampsize;
+	for (i = 0; i < nchans; i++) {
+		chanlist[i] = CR_PACK(i, 0, AREF_GROUND);
+	}
+	memset(&cmd, 0, sizeof(cmd));
+	cmd.subdev         = SUBDEV;
+	cmd.start_src      = TRIG_NOW;
+	cmd.scan_begin_src = TRIG_TIMER;
+	cmd.scan_begin_arg = SCAN_NS;
+	cmd.convert_src    = TRIG_TIMER;
+	cmd.convert_arg    = SCAN_NS/nchans/2;
+	cmd.scan_end_src   = TRIG_COUNT;
+	cmd.scan_end_arg   = nchans;
+	cmd.stop_src       = TRIG_COUNT;
+	cmd.stop_arg       = BLOCK*NBLOCKS;
+	cmd.chanlist       = chanlist;
+	cmd.chanlist_len   = nchans;
+	comedi_command_test(dev, &cmd);
+	if (comedi_command_test(dev, &cmd)) {
+		printf("COMMAND NOT SUPPORTED BY %s\n", DEVICE);
+		goto out;
+	}
+	rt_comedi_register_callback(dev, SUBDEV, COMEDI_CB_EOS | COMEDI_CB_BLOCK | COMEDI_CB_EOA | COMEDI_CB_ERROR | COMEDI_CB_OVERFLOW, NULL, task);
+	if (comedi_command(dev, &cmd)) {
+		printf("CANNOT START THE COMMAND\n");
+		goto out;
+	}
+	if (!(buf = rt_comedi_mmap(DEVICE, dev, SUBDEV, &size))) {
+		printf("CANNOT MAP THE BUFFER OF %s\n", DEVICE);
+		comedi_cancel(dev, SUBDEV);
+		goto out;
+	}
+
+	rt_make_hard_real_time();
+	while (nbytes < BLOCK*NBLOCKS*scanlen) {
+		if ((span = rt_comedi_wait_scans_timed(dev, SUBDEV, BLOCK, scanlen, &ofst, nano2count(1000000000))) >= RTE_BASE) {
+			errs++;
+			break;
+		}
+		nwaits++;
+		// a scan split at the end of the buffer is completed by the next span
+		nsamples = span/sampsize;
+		for (i = 0; i < nsamples; i++) {
+			sum += sampsize == sizeof(lsampl_t) ? ((lsampl_t *)(buf + ofst))[i] : ((sampl_t *)(buf + ofst))[i];
+		}
+		rt_comedi_buffer_mark_read(dev, SUBDEV, nsamples*sampsize);
+		nbytes += nsamples*sampsize;
+	}
+	rt_make_soft_real_time();
+
+	nscans = nbytes/scanlen;
+	printf("\n%ld SCANS OF %d CHANNELS IN %ld WAITS (%d SCANS PER BLOCK), MEAN SAMPLE %g, %d ERRORS (MUST BE 0).\n", nscans, nchans, nwaits, BLOCK, nscans ? sum/(nscans*nchans) : 0.0, errs);
+	comedi_cancel(dev, SUBDEV);
+	rt_comedi_munmap(buf, size);
+out:
+	comedi_close(dev);
+	stop_rt_timer();
+	rt_task_delete(task);
+	return 0;
+}
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2026 The RTAI project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <pthread.h>
+
+#include <rtai_lxrt.h>
+#include <rtai_sem.h>
+#include <rtai_fmutex.h>
+
+#define LOOPS       1000000
+#define NR_THREADS  4
+#define CNT_LOOPS   200000
+
+static SEM *sem;
+
+static struct rt_fmutex *fm;
+
+static volatile long counter;
+
+/*
+ * Threads with different priorities, spread over the CPUs, increment a
+ * shared counter without atomic operations, within the fast mutex, so that
+ * any failure of the mutual exclusion shows up in the final count.
+ */
+
+static void *thread_fun(void *arg)
+{
+	RT_TASK *task;
+	int id, i, ncpus;
+
+	id = (long)arg;
+	ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if (!(task = rt_thread_init(nam2num("FMTXT0") + id, 1 + id, 0, SCHED_FIFO, 1 << (id % ncpus)))) {
+		printf("CANNOT INIT THREAD %d\n", id);
+		exit(1);
+	}
+	rt_make_hard_real_time();
+	for (i = 0; i < CNT_LOOPS; i++) {
+		rt_fmutex_lock(fm);
+		counter++;
+		rt_fmutex_unlock(fm);
+	}
+	rt_make_soft_real_time();
+	rt_task_delete(task);
+	return NULL;
+}
+
+int main(void)
+{
+	RT_TASK *task;
+	pthread_t thread[NR_THREADS];
+	RTIME t, tns;
+	int i;
+
+	if (!(task = rt_thread_init(nam2num("FMTXM"), 0, 0, SCHED_FIFO, 0x1))) {
+		printf("CANNOT INIT MAIN TASK\n");
+		exit(1);
+	}
+	mlockall(MCL_CURRENT | MCL_FUTURE);
+	if (!(sem = rt_typed_sem_init(nam2num("FMTXS"), RESEM_BINSEM, RES_SEM))) {
+		printf("CANNOT CREATE THE SEMAPHORE\n");
+		exit(1);
+	}
+	if (!(fm = rt_fmutex_open(nam2num("FMTX"), RESEM_BINSEM))) {
+		printf("CANNOT CREATE THE FAST MUTEX\n");
+		exit(1);
+	}
+	rt_set_oneshot_mode();
+	start_rt_timer(0);
+	rt_make_hard_real_time();
+
+	printf("\nUNCONTENDED LOCK/UNLOCK PAIRS, %d LOOPS (COUNTS ARE TSC CYCLES IN ONESHOT MODE)\n", LOOPS);
+	tns = rt_get_cpu_time_ns();
+	t = rt_get_time();
+	for (i = 0; i < LOOPS; i++) {
+		rt_sem_wait(sem);
+		rt_sem_signal(sem);
+	}
+	t = rt_get_time() - t;
+	tns = rt_get_cpu_time_ns() - tns;
+	printf("RESOURCE SEMAPHORE: %lld COUNTS, %lld NS.\n", t/LOOPS, tns/LOOPS);
+	tns = rt_get_cpu_time_ns();
+	t = rt_get_time();
+	for (i = 0; i < LOOPS; i++) {
+		rt_fmutex_lock(fm);
+		rt_fmutex_unlock(fm);
+	}
+	t = rt_get_time() - t;
+	tns = rt_get_cpu_time_ns() - tns;
+	printf("FAST MUTEX:         %lld COUNTS, %lld NS.\n", t/LOOPS, tns/LOOPS);
+
+	rt_make_soft_real_time();
+	for (i = 0; i < NR_THREADS; i++) {
+		pthread_create(&thread[i], NULL, thread_fun, (void *)(long)i);
+	}
+	for (i = 0; i < NR_THREADS; i++) {
+		pthread_join(thread[i], NULL);
+	}
+	printf("\nCONTENDED COUNT %ld (MUST BE %d), MUTEX WORD %lx (MUST BE 0).\n", counter, NR_THREADS*CNT_LOOPS, fm->owner);
+
+	// a word not naming an RTAI task must be refused, not followed
+	fm->owner = (unsigned long)&counter;
+	i = rt_fmutex_lock(fm);
+	fm->owner = 0;
+	printf("FORGED OWNER LOCK RETURNED %d (MUST BE %d).\n", i, RTE_OBJINV);
+
+	stop_rt_timer();
+	rt_fmutex_close(fm);
+	rt_sem_delete(sem);
+	rt_task_delete(task);
+	return 0;
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2026 The RTAI project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include <rtai_lxrt.h>
+
+#define LOOPS  1000000
+#define NCONV  10000
+
+struct gettime_res { RTIME time, time_ns, count2nano; };
+
+static RTIME conv[NCONV], c2n[NCONV], n2c[NCONV];
+
+static void measure(struct gettime_res *res)
+{
+	RTIME t;
+	int i;
+
+	t = rt_get_cpu_time_ns();
+	for (i = 0; i < LOOPS; i++) {
+		rt_get_time();
+	}
+	res->time = rt_get_cpu_time_ns() - t;
+	t = rt_get_cpu_time_ns();
+	for (i = 0; i < LOOPS; i++) {
+		rt_get_time_ns();
+	}
+	res->time_ns = rt_get_cpu_time_ns() - t;
+	t = rt_get_cpu_time_ns();
+	for (i = 0; i < LOOPS; i++) {
+		count2nano(i);
+	}
+	res->count2nano = rt_get_cpu_time_ns() - t;
+}
+
+int main(void)
+{
+	RT_TASK *task;
+	struct gettime_res page, trap;
+	struct { unsigned long dummy; } arg;
+	RTIME t, dt, maxdt;
+	int i, behind, convdiff;
+
+	if (!(task = rt_thread_init(nam2num("GETTIM"), 0, 0, SCHED_FIFO, 0x1))) {
+		printf("CANNOT INIT GETTIME TASK\n");
+		exit(1);
+	}
+	mlockall(MCL_CURRENT | MCL_FUTURE);
+	if (!rt_usp_time_page) {
+		printf("\nTIME PAGE NOT AVAILABLE, ONLY LXRT CALLS WILL BE MEASURED.\n");
+	}
+
+	rt_make_hard_real_time();
+	measure(&page);
+	for (maxdt = behind = i = 0; rt_usp_time_page && i < LOOPS; i++) {
+		t  = rtai_lxrt(BIDX, SIZARG, GET_TIME_NS, &arg).rt;
+		dt = rt_get_time_ns() - t;
+		if (dt < 0) {
+			behind++;
+			continue;
+		}
+		if (dt > maxdt) {
+			maxdt = dt;
+		}
+	}
+	rt_make_soft_real_time();
+
+	// conversions must be those of the kernel rtai_llimd, rounding included
+	srandom(1);
+	for (i = 0; i < NCONV; i++) {
+		conv[i] = ((((RTIME)random() << 31) | random()) >> (22 + i%40))*(i & 1 ? -1 : 1);
+		c2n[i] = count2nano(conv[i]);
+		n2c[i] = nano2count(conv[i]);
+	}
+
+	rt_time_page_close();
+	rt_make_hard_real_time();
+	measure(&trap);
+	rt_make_soft_real_time();
+	for (convdiff = i = 0; i < NCONV; i++) {
+		if (c2n[i] != count2nano(conv[i]) || n2c[i] != nano2count(conv[i])) {
+			convdiff++;
+		}
+	}
+
+	printf("\nAVERAGE COST OF %d CALLS (ns): TIME PAGE, LXRT CALL.\n", LOOPS);
+	printf("rt_get_time:    %5lld %5lld\n", page.time/LOOPS, trap.time/LOOPS);
+	printf("rt_get_time_ns: %5lld %5lld\n", page.time_ns/LOOPS, trap.time_ns/LOOPS);
+	printf("count2nano:     %5lld %5lld\n", page.count2nano/LOOPS, trap.count2nano/LOOPS);
+	printf("\nTIME PAGE CONVERSIONS DIFFERENT FROM THE LXRT ONES: %d (MUST BE 0).\n", convdiff);
+	if (behind) {
+		printf("\nTIME PAGE BEHIND THE KERNEL TIME %d TIMES, CHECK TSC OFFSETS.\n", behind);
+	}
+	if (maxdt) {
+		printf("\nMAX TIME PAGE LEAD ON THE PRECEDING LXRT CALL: %lld ns.\n", maxdt);
+	}
+
+	rt_task_delete(task);
+	return 0;
+}
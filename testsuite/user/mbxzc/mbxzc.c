@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2026 The RTAI project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <pthread.h>
+
+#include <rtai_mbx.h>
+#include <rtai_shm.h>
+
+#define FRAME_SIZE  (64*1024)
+#define MBX_SIZE    (4*FRAME_SIZE + 1000)
+#define FRAMES      2000
+
+static MBX *mbx;
+
+static char frame[FRAME_SIZE];
+
+static volatile int zero_copy, errors;
+
+static void fill_frame(struct rt_mbx_span *span, int seq)
+{
+	if (span) {
+		memset(span[0].adr, seq, span[0].size);
+		memset(span[1].adr, seq, span[1].size);
+	} else {
+		memset(frame, seq, FRAME_SIZE);
+	}
+}
+
+static void check_frame(struct rt_mbx_span *span, char *buf, int seq)
+{
+	char *first, *last;
+	if (span) {
+		first = span[0].adr;
+		last  = span[1].size ? (char *)span[1].adr + span[1].size - 1 : (char *)span[0].adr + span[0].size - 1;
+	} else {
+		first = buf;
+		last  = buf + FRAME_SIZE - 1;
+	}
+	if (*first != (char)seq || *last != (char)seq) {
+		errors++;
+	}
+}
+
+static void *producer_fun(void *arg)
+{
+	RT_TASK *task;
+	struct rt_mbx_span span[2];
+	int seq;
+
+	if (!(task = rt_thread_init(nam2num("MBXZCP"), 1, 0, SCHED_FIFO, 0xF))) {
+		printf("CANNOT INIT PRODUCER TASK\n");
+		exit(1);
+	}
+	rt_make_hard_real_time();
+	for (seq = 0; seq < FRAMES; seq++) {
+		if (zero_copy) {
+			if (rt_mbx_reserve(mbx, FRAME_SIZE, span)) {
+				errors++;
+				break;
+			}
+			fill_frame(span, seq);
+			rt_mbx_commit(mbx, FRAME_SIZE);
+		} else {
+			fill_frame(NULL, seq);
+			rt_mbx_send(mbx, frame, FRAME_SIZE);
+		}
+	}
+	rt_make_soft_real_time();
+	rt_task_delete(task);
+	return NULL;
+}
+
+static RTIME run(void)
+{
+	static char rframe[FRAME_SIZE];
+	pthread_t thread;
+	struct rt_mbx_span span[2];
+	RTIME t;
+	int seq;
+
+	pthread_create(&thread, NULL, producer_fun, NULL);
+	rt_make_hard_real_time();
+	t = rt_get_cpu_time_ns();
+	for (seq = 0; seq < FRAMES; seq++) {
+		if (zero_copy) {
+			if (rt_mbx_peek(mbx, FRAME_SIZE, span)) {
+				errors++;
+				break;
+			}
+			check_frame(span, NULL, seq);
+			rt_mbx_consume(mbx, FRAME_SIZE);
+		} else {
+			rt_mbx_receive(mbx, rframe, FRAME_SIZE);
+			check_frame(NULL, rframe, seq);
+		}
+	}
+	t = rt_get_cpu_time_ns() - t;
+	rt_make_soft_real_time();
+	pthread_join(thread, NULL);
+	return t;
+}
+
+int main(void)
+{
+	RT_TASK *task;
+	RTIME copy, inplace;
+
+	if (!(task = rt_thread_init(nam2num("MBXZCC"), 0, 0, SCHED_FIFO, 0xF))) {
+		printf("CANNOT INIT CONSUMER TASK\n");
+		exit(1);
+	}
+	mlockall(MCL_CURRENT | MCL_FUTURE);
+	if (!rt_global_heap_open()) {
+		printf("CANNOT MAP THE GLOBAL HEAP (RTAI MALLOC MUST USE VMALLOC)\n");
+		exit(1);
+	}
+	if (!(mbx = rt_mbx_init(nam2num("MBXZC"), MBX_SIZE))) {
+		printf("CANNOT CREATE MAILBOX\n");
+		exit(1);
+	}
+	start_rt_timer(0);
+
+	zero_copy = 0;
+	copy = run();
+	zero_copy = 1;
+	inplace = run();
+
+	printf("\n%d FRAMES OF %d BYTES, AVERAGE TIME PER FRAME (ns):\n", FRAMES, FRAME_SIZE);
+	printf("SEND/RECEIVE:                %lld\n", copy/FRAMES);
+	printf("RESERVE/COMMIT/PEEK/CONSUME: %lld\n", inplace/FRAMES);
+	printf("ERRORS: %d (MUST BE 0)\n", errors);
+
+	stop_rt_timer();
+	rt_mbx_delete(mbx);
+	rt_global_heap_close();
+	rt_task_delete(task);
+	return 0;
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2026 The RTAI project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <pthread.h>
+
+#include <rtai_lxrt.h>
+#include <rtai_scb.h>
+
+#define NR_PRODUCERS  8
+#define LOOPS         100000
+#define PERIOD        20000
+#define SCB_SIZE      16384
+
+struct mpscb_msg { int producer, seq; RTIME time; };
+
+static void *scb;
+
+static volatile int end;
+
+static struct { volatile int done, drops; RTIME cost; } producer[NR_PRODUCERS];
+
+static void *producer_fun(void *arg)
+{
+	RT_TASK *task;
+	struct mpscb_msg *msg;
+	int id, seq, ncpus;
+	RTIME t;
+
+	id = (long)arg;
+	ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if (!(task = rt_thread_init(nam2num("MPSCP0") + id, 1, 0, SCHED_FIFO, 1 << (id % ncpus)))) {
+		printf("CANNOT INIT PRODUCER %d\n", id);
+		exit(1);
+	}
+	rt_make_hard_real_time();
+	for (seq = 0; seq < LOOPS; seq++) {
+		t = rt_get_cpu_time_ns();
+		if ((msg = rt_mpscb_reserve(scb, sizeof(struct mpscb_msg)))) {
+			msg->producer = id;
+			msg->seq      = seq;
+			msg->time     = t;
+			rt_mpscb_commit(scb, msg);
+		} else {
+			producer[id].drops++;
+		}
+		producer[id].cost += rt_get_cpu_time_ns() - t;
+		rt_sleep(nano2count(PERIOD));
+	}
+	producer[id].done = 1;
+	rt_make_soft_real_time();
+	rt_task_delete(task);
+	return NULL;
+}
+
+int main(void)
+{
+	RT_TASK *task;
+	pthread_t thread[NR_PRODUCERS];
+	struct mpscb_msg *msg;
+	int i, size, done, next[NR_PRODUCERS], msgs, lost, errors;
+
+	if (!(task = rt_thread_init(nam2num("MPSCBC"), 0, 0, SCHED_FIFO, 0x1))) {
+		printf("CANNOT INIT CONSUMER TASK\n");
+		exit(1);
+	}
+	mlockall(MCL_CURRENT | MCL_FUTURE);
+	if (!(scb = rt_mpscb_init(nam2num("MPSCB"), SCB_SIZE, USE_VMALLOC))) {
+		printf("CANNOT ALLOCATE THE SCB\n");
+		exit(1);
+	}
+	start_rt_timer(0);
+	for (i = 0; i < NR_PRODUCERS; i++) {
+		next[i] = 0;
+		pthread_create(&thread[i], NULL, producer_fun, (void *)(long)i);
+	}
+
+	rt_make_hard_real_time();
+	msgs = lost = errors = 0;
+	do {
+		for (done = i = 0; i < NR_PRODUCERS; i++) {
+			done += producer[i].done;
+		}
+		while ((msg = rt_mpscb_peek(scb, &size))) {
+			if (size != sizeof(struct mpscb_msg) || msg->producer < 0 || msg->producer >= NR_PRODUCERS || msg->seq < next[msg->producer]) {
+				errors++;
+			} else {
+				lost += msg->seq - next[msg->producer];
+				next[msg->producer] = msg->seq + 1;
+			}
+			msgs++;
+			rt_mpscb_release(scb);
+		}
+		rt_sleep(nano2count(10*PERIOD));
+	} while (done < NR_PRODUCERS);
+	rt_make_soft_real_time();
+
+	for (i = 0; i < NR_PRODUCERS; i++) {
+		pthread_join(thread[i], NULL);
+		lost -= producer[i].drops;
+		printf("PRODUCER %d: RESERVE/COMMIT %lld ns, DROPS %d.\n", i, producer[i].cost/LOOPS, producer[i].drops);
+	}
+	printf("\nMESSAGES %d, LOST %d, ERRORS %d (BOTH MUST BE 0).\n", msgs, lost, errors);
+
+	stop_rt_timer();
+	rt_mpscb_delete(nam2num("MPSCB"));
+	rt_task_delete(task);
+	return 0;
+}
@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2026 The RTAI project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <pthread.h>
+
+#include <rtai_lxrt.h>
+#include <rtai_msg.h>
+
+#define LOOPS    20000
+#define MAXSIZE  (64*1024)
+
+static RT_TASK *srvtask;
+
+static volatile int end, ifmode;
+
+static long sbuf[MAXSIZE/sizeof(long)], rbuf[MAXSIZE/sizeof(long)], srvbuf[MAXSIZE/sizeof(long)];
+
+/*
+ * The server returns each message with its words complemented, so that both
+ * directions are checked. In ifmode it gets rt_sendx_if messages instead,
+ * and sends back their first word.
+ */
+
+static void *server_fun(void *arg)
+{
+	RT_TASK *task;
+	long len;
+	int i;
+
+	if (!(srvtask = rt_thread_init(nam2num("MSGXS"), 1, 0, SCHED_FIFO, 0x1))) {
+		printf("CANNOT INIT SERVER TASK\n");
+		exit(1);
+	}
+	rt_make_hard_real_time();
+	while (!end) {
+		if ((task = rt_receivex(NULL, srvbuf, sizeof(srvbuf), &len)) && len > 0) {
+			if (ifmode) {
+				rt_send(task, srvbuf[0]);
+				continue;
+			}
+			for (i = 0; i < len/(int)sizeof(long); i++) {
+				srvbuf[i] = ~srvbuf[i];
+			}
+			rt_returnx(task, srvbuf, len);
+		}
+	}
+	rt_make_soft_real_time();
+	rt_task_delete(srvtask);
+	return NULL;
+}
+
+int main(void)
+{
+	RT_TASK *task;
+	pthread_t thread;
+	unsigned long msg;
+	RTIME tns;
+	int size, i, k, errs;
+
+	if (!(task = rt_thread_init(nam2num("MSGXM"), 0, 0, SCHED_FIFO, 0x1))) {
+		printf("CANNOT INIT MAIN TASK\n");
+		exit(1);
+	}
+	mlockall(MCL_CURRENT | MCL_FUTURE);
+	rt_set_oneshot_mode();
+	start_rt_timer(0);
+	pthread_create(&thread, NULL, server_fun, NULL);
+	while (!srvtask) {
+		rt_sleep(nano2count(1000000));
+	}
+	rt_make_hard_real_time();
+
+	printf("\nEXTENDED RPCS WITHIN A PROCESS, %d LOOPS PER SIZE\n", LOOPS);
+	for (size = 64; size <= MAXSIZE; size *= 4) {
+		errs = 0;
+		tns = rt_get_cpu_time_ns();
+		for (k = 0; k < LOOPS; k++) {
+			sbuf[k % (size/sizeof(long))] = k;
+			if (rt_rpcx(srvtask, sbuf, rbuf, size, size) != srvtask) {
+				errs++;
+			} else if (rbuf[k % (size/sizeof(long))] != ~(long)k) {
+				errs++;
+			}
+		}
+		tns = rt_get_cpu_time_ns() - tns;
+		for (i = 0; i < size/(int)sizeof(long); i++) {
+			if (rbuf[i] != ~sbuf[i]) {
+				errs++;
+				break;
+			}
+		}
+		printf("SIZE %6d: %8lld NS PER RPC, %d ERRORS (MUST BE 0).\n", size, tns/LOOPS, errs);
+	}
+
+	/*
+	 * The server has a lower priority, so it copies an rt_sendx_if message
+	 * after the sender has returned and reused its buffer, which must not
+	 * matter.
+	 */
+	ifmode = 1;
+	errs = 0;
+	for (k = 0; k < LOOPS; k++) {
+		sbuf[0] = k;
+		while (rt_sendx_if(srvtask, sbuf, sizeof(long)) != srvtask) {
+			rt_sleep(nano2count(10000));
+		}
+		sbuf[0] = -1;
+		if (rt_receive(srvtask, &msg) != srvtask || msg != (unsigned long)k) {
+			errs++;
+		}
+	}
+	printf("SENDX_IF WITH THE BUFFER REUSED AT ONCE: %d ERRORS (MUST BE 0).\n", errs);
+	ifmode = 0;
+
+	end = 1;
+	rt_sendx(srvtask, sbuf, 0);
+	rt_make_soft_real_time();
+	pthread_join(thread, NULL);
+	stop_rt_timer();
+	rt_task_delete(task);
+	return 0;
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2026 The RTAI project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include <rtai_sem.h>
+#include <rtai_mbx.h>
+#include <rtai_netrpc.h>
+
+#define BYTES   (16*1024*1024)
+#define CHUNK   1024
+#define SIZES   4
+#define MBXSIZ  (1024*1024)
+
+static int sizes[SIZES] = { 4096, 16384, 65536, 262144 };
+
+static MBX *mbx;
+
+static SEM *go, *done;
+
+static volatile int msg_size, msgs;
+
+static char rbuf[MBXSIZ];
+
+/*
+ * Drain the mailbox, a message at a time, whatever the size of the
+ * netrpc calls carrying it, signalling the end of each batch.
+ */
+
+static void *receiver(void *arg)
+{
+	RT_TASK *task;
+	int i;
+
+	if (!(task = rt_thread_init(nam2num("FRGRCV"), 0, 0, SCHED_FIFO, 0xF))) {
+		printf("CANNOT INIT RECEIVER TASK\n");
+		exit(1);
+	}
+	mlockall(MCL_CURRENT | MCL_FUTURE);
+	while (1) {
+		rt_sem_wait(go);
+		if (!msg_size) {
+			break;
+		}
+		for (i = 0; i < msgs; i++) {
+			rt_mbx_receive(mbx, rbuf, msg_size);
+		}
+		rt_sem_signal(done);
+	}
+	rt_task_delete(task);
+	return NULL;
+}
+
+/*
+ * Send msgs messages of size bytes with a remote mailbox send each, so
+ * fragmented by netrpc, or by hand, in CHUNK bytes calls.
+ */
+
+static int send_msgs(unsigned long node, int port, MBX *rmbx, char *buf, int size, int bychunk)
+{
+	int i, ofst, len;
+
+	for (i = 0; i < msgs; i++) {
+		if (bychunk) {
+			for (ofst = 0; ofst < size; ofst += len) {
+				len = size - ofst < CHUNK ? size - ofst : CHUNK;
+				if (RT_mbx_send(node, port, rmbx, buf + ofst, len)) {
+					return -1;
+				}
+			}
+		} else if (RT_mbx_send(node, port, rmbx, buf, size)) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	RT_TASK *task;
+	MBX *rmbx;
+	pthread_t thread;
+	unsigned long node;
+	int port, i, bychunk, mbs[2];
+	char *buf;
+	RTIME t;
+
+	if (!(task = rt_task_init_schmod(nam2num("NETFRG"), 1, 0, 0, SCHED_FIFO, 0xF))) {
+		printf("CANNOT INIT NETFRAG TASK\n");
+		exit(1);
+	}
+	mlockall(MCL_CURRENT | MCL_FUTURE);
+	buf  = malloc(sizes[SIZES - 1]);
+	go   = rt_sem_init(nam2num("FRGGO"), 0);
+	done = rt_sem_init(nam2num("FRGDON"), 0);
+	mbx  = rt_mbx_init(nam2num("FRGMBX"), MBXSIZ);
+	pthread_create(&thread, NULL, receiver, NULL);
+	node = ddn2nl(argc > 1 ? argv[1] : "127.0.0.1");
+	if ((port = rt_request_port(node)) <= 0) {
+		printf("CANNOT GET A PORT ON THE NETRPC NODE, ERROR %d\n", port);
+		goto out;
+	}
+	rmbx = RT_get_adr(node, port, "FRGMBX");
+
+	printf("\n\nREMOTE MAILBOX SENDS, %d MB PER SIZE\n", BYTES >> 20);
+	printf("   SIZE  FRAGMENTED MB/s  BY %d BYTES MB/s\n", CHUNK);
+	for (i = 0; i < SIZES; i++) {
+		msg_size = sizes[i];
+		msgs = BYTES/sizes[i];
+		for (bychunk = 0; bychunk < 2; bychunk++) {
+			rt_sem_signal(go);
+			t = rt_get_cpu_time_ns();
+			if (send_msgs(node, port, rmbx, buf, sizes[i], bychunk)) {
+				printf("REMOTE SEND OF %d BYTES FAILED\n", sizes[i]);
+				goto release;
+			}
+			rt_sem_wait(done);
+			t = rt_get_cpu_time_ns() - t;
+			mbs[bychunk] = (int)(BYTES*1000LL/t);
+		}
+		printf("%7d %16d %16d\n", sizes[i], mbs[0], mbs[1]);
+	}
+	printf("\n");
+
+release:
+	rt_release_port(node, port);
+out:
+	msg_size = 0;
+	rt_sem_signal(go);
+	pthread_join(thread, NULL);
+	rt_mbx_delete(mbx);
+	rt_sem_delete(done);
+	rt_sem_delete(go);
+	rt_task_delete(task);
+	free(buf);
+	return 0;
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2026 The RTAI project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include <rtai_sem.h>
+#include <rtai_mbx.h>
+#include <rtai_netrpc.h>
+
+#define CALLS    10000
+#define WINDOWS  4
+
+static int windows[WINDOWS] = { 1, 4, 16, NETRPC_MAX_WINDOW };
+
+/*
+ * Keep up to window async semaphore signals outstanding on the port, taking
+ * their returns from the port mailbox. With a window of 1 each call waits
+ * for the previous return, as on non pipelined ports.
+ */
+
+static int pipe_calls(unsigned long node, int port, MBX *mbx, SEM *sem, int window, int *errors)
+{
+	unsigned long long retval;
+	unsigned long reqid;
+	int sent, done, len1, len2;
+
+	for (sent = done = 0; done < CALLS; ) {
+		if (sent < CALLS && sent - done < window) {
+			if (window > 1) {
+				if (!RT_sem_signal(node, -port, sem)) {
+					(*errors)++;
+				}
+			} else {
+				RT_sem_signal(node, -port, sem);
+			}
+			sent++;
+			continue;
+		}
+		len1 = len2 = 0;
+		if (rt_get_net_rpc_ret_id(mbx, &reqid, &retval, NULL, &len1, NULL, &len2, nano2count(1000000000), MBX_RECEIVE_TIMED)) {
+			return -1;
+		}
+		if (window > 1 && !reqid) {
+			(*errors)++;
+		}
+		done++;
+	}
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	RT_TASK *task;
+	SEM *sem, *rsem;
+	MBX *mbx;
+	unsigned long node;
+	int port, i, errors;
+	RTIME t;
+
+	if (!(task = rt_task_init_schmod(nam2num("NETPIP"), 1, 0, 0, SCHED_FIFO, 0xF))) {
+		printf("CANNOT INIT NETPIPE TASK\n");
+		exit(1);
+	}
+	mlockall(MCL_CURRENT | MCL_FUTURE);
+	sem  = rt_sem_init(nam2num("PIPSEM"), 0);
+	mbx  = rt_mbx_init(nam2num("PIPMBX"), 1000*WINDOWS*NETRPC_MAX_WINDOW);
+	node = ddn2nl(argc > 1 ? argv[1] : "127.0.0.1");
+	if ((port = rt_request_port_mbx(node, mbx)) <= 0) {
+		printf("CANNOT GET A PORT ON THE NETRPC NODE, ERROR %d\n", port);
+		goto out;
+	}
+	rsem = RT_get_adr(node, port, "PIPSEM");
+
+	printf("\n\nPIPELINED NETRPC PORT, %d ASYNC CALLS\n", CALLS);
+	printf(" WINDOW  CALLS/s   us/CALL  ERRORS\n");
+	for (i = 0; i < WINDOWS; i++) {
+		if (rt_set_netrpc_window(port, windows[i])) {
+			printf("CANNOT SET A WINDOW OF %d\n", windows[i]);
+			break;
+		}
+		errors = 0;
+		t = rt_get_cpu_time_ns();
+		if (pipe_calls(node, port, mbx, rsem, windows[i], &errors)) {
+			printf("RETURNS LOST WITH A WINDOW OF %d\n", windows[i]);
+			break;
+		}
+		if (rt_sync_net_rpc(node, -port) <= 0 || rt_waiting_return(node, port)) {
+			errors++;
+		}
+		t = rt_get_cpu_time_ns() - t;
+		printf("%7d %8d %9d %7d\n", windows[i], (int)(CALLS*1000000000LL/t), (int)(t/(1000LL*CALLS)), errors);
+	}
+	printf("\n");
+
+	rt_set_netrpc_window(port, 1);
+	rt_release_port(node, port);
+out:
+	rt_mbx_delete(mbx);
+	rt_sem_delete(sem);
+	rt_task_delete(task);
+	return 0;
+}
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2026 The RTAI project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include <rtai_sem.h>
+#include <rtai_netrpc.h>
+
+#define CALLS     5000
+#define CYCLES    50
+#define MAXCPUS   8
+
+static unsigned long node;
+static volatile int errors[MAXCPUS];
+
+/*
+ * Each thread runs on its own CPU, with its own port and semaphore, so that
+ * the calls of the different threads are received by different per CPU soft
+ * receivers at the same time. Any signal lost, or delivered to a semaphore
+ * of another thread, shows up in the count taken back. Ports are requested
+ * and released again at each cycle, so that on the local node the rings of
+ * the local ports are set up and freed while the other threads use theirs.
+ */
+
+static void *shard_fun(void *arg)
+{
+	long cpu = (long)arg;
+	char name[7];
+	RT_TASK *task;
+	SEM *sem, *rsem;
+	int port, cycle, i, taken;
+
+	sprintf(name, "SHRT%ld", cpu);
+	if (!(task = rt_thread_init(nam2num(name), 1, 0, SCHED_FIFO, 1 << cpu))) {
+		printf("CANNOT INIT THE TASK ON CPU %ld\n", cpu);
+		errors[cpu] = -1;
+		return NULL;
+	}
+	sprintf(name, "SHRS%ld", cpu);
+	sem = rt_sem_init(nam2num(name), 0);
+	for (cycle = 0; cycle < CYCLES && !errors[cpu]; cycle++) {
+		if ((port = rt_request_port(node)) <= 0) {
+			printf("CANNOT GET A PORT ON CPU %ld, ERROR %d\n", cpu, port);
+			errors[cpu] = -1;
+			break;
+		}
+		if (!(rsem = RT_get_adr(node, port, name))) {
+			errors[cpu] = -1;
+		} else {
+			for (i = 0; i < CALLS/CYCLES; i++) {
+				if (RT_sem_signal(node, port, rsem) >= RTE_BASE) {
+					errors[cpu]++;
+				}
+			}
+			for (taken = 0; RT_sem_wait_if(node, port, rsem) > 0; taken++);
+			if (taken != CALLS/CYCLES) {
+				errors[cpu] += abs(CALLS/CYCLES - taken);
+			}
+		}
+		rt_release_port(node, port);
+	}
+	rt_sem_delete(sem);
+	rt_thread_delete(task);
+	return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+	RT_TASK *task;
+	long thread[MAXCPUS];
+	int cpus, cpu, fails;
+
+	if (!(task = rt_task_init_schmod(nam2num("NETSHR"), 0, 0, 0, SCHED_FIFO, 0xF))) {
+		printf("CANNOT INIT NETSHARD TASK\n");
+		exit(1);
+	}
+	mlockall(MCL_CURRENT | MCL_FUTURE);
+	node = ddn2nl(argc > 1 ? argv[1] : "127.0.0.1");
+	if ((cpus = sysconf(_SC_NPROCESSORS_ONLN)) > MAXCPUS) {
+		cpus = MAXCPUS;
+	}
+
+	printf("\n\nNETRPC CALLS FROM %d CPUS AT ONCE, %d EACH ON %d PORTS\n", cpus, CALLS, CYCLES);
+	for (cpu = 0; cpu < cpus; cpu++) {
+		thread[cpu] = rt_thread_create(shard_fun, (void *)(long)cpu, 0);
+	}
+	for (fails = cpu = 0; cpu < cpus; cpu++) {
+		rt_thread_join(thread[cpu]);
+		printf("CPU %d: %d ERRORS\n", cpu, errors[cpu]);
+		fails += errors[cpu] != 0;
+	}
+	printf("CPUS WITH ERRORS: %d (MUST BE 0)\n\n", fails);
+
+	rt_task_delete(task);
+	return 0;
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2026 The RTAI project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <pthread.h>
+
+#include <rtai_lxrt.h>
+#include <rtai_pool.h>
+
+#define NR_THREADS  8
+#define LOOPS       1000000
+#define NOBJS       (4*NR_THREADS)
+#define HELD        4
+
+struct pool_obj { long link; volatile long owner; char payload[40]; };
+
+static void *pool;
+
+static struct { volatile int errors, empty; RTIME cost; } thread_res[NR_THREADS];
+
+/*
+ * Each thread keeps a few objects, marking them as its own, and checks the
+ * mark is still there when it frees them, so that any object given to two
+ * threads at once is detected. The first long of the objects is left alone,
+ * as the pool uses it to link them while free.
+ */
+
+static void *thread_fun(void *arg)
+{
+	RT_TASK *task;
+	struct pool_obj *obj[HELD];
+	int id, i, k, ncpus;
+	RTIME t;
+
+	id = (long)arg;
+	ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if (!(task = rt_thread_init(nam2num("POOLT0") + id, 1, 0, SCHED_FIFO, 1 << (id % ncpus)))) {
+		printf("CANNOT INIT THREAD %d\n", id);
+		exit(1);
+	}
+	rt_make_hard_real_time();
+	for (k = 0; k < HELD; k++) {
+		obj[k] = NULL;
+	}
+	t = rt_get_cpu_time_ns();
+	for (i = 0; i < LOOPS; i++) {
+		k = i % HELD;
+		if (obj[k]) {
+			if (obj[k]->owner != id + 1) {
+				thread_res[id].errors++;
+			}
+			obj[k]->owner = 0;
+			rt_pool_free(pool, obj[k]);
+		}
+		if ((obj[k] = rt_pool_alloc(pool))) {
+			if (obj[k]->owner) {
+				thread_res[id].errors++;
+			}
+			obj[k]->owner = id + 1;
+		} else {
+			thread_res[id].empty++;
+		}
+	}
+	thread_res[id].cost = rt_get_cpu_time_ns() - t;
+	for (k = 0; k < HELD; k++) {
+		if (obj[k]) {
+			obj[k]->owner = 0;
+			rt_pool_free(pool, obj[k]);
+		}
+	}
+	rt_make_soft_real_time();
+	rt_task_delete(task);
+	return NULL;
+}
+
+int main(void)
+{
+	RT_TASK *task;
+	pthread_t thread[NR_THREADS];
+	int i, errors, nobjs;
+
+	if (!(task = rt_thread_init(nam2num("POOLM"), 0, 0, SCHED_FIFO, 0x1))) {
+		printf("CANNOT INIT MAIN TASK\n");
+		exit(1);
+	}
+	mlockall(MCL_CURRENT | MCL_FUTURE);
+	if (!(pool = rt_pool_create(nam2num("POOL"), sizeof(struct pool_obj), NOBJS, RT_POOL_CACHE_BYTES))) {
+		printf("CANNOT CREATE THE POOL\n");
+		exit(1);
+	}
+	start_rt_timer(0);
+	for (i = 0; i < NR_THREADS; i++) {
+		pthread_create(&thread[i], NULL, thread_fun, (void *)(long)i);
+	}
+	errors = 0;
+	for (i = 0; i < NR_THREADS; i++) {
+		pthread_join(thread[i], NULL);
+		errors += thread_res[i].errors;
+		printf("THREAD %d: ALLOC/FREE %lld ns, EMPTY %d.\n", i, thread_res[i].cost/LOOPS, thread_res[i].empty);
+	}
+	for (nobjs = 0; rt_pool_alloc(pool); nobjs++);
+	printf("\nERRORS %d (MUST BE 0), OBJECTS BACK IN THE POOL %d (MUST BE %d).\n", errors, nobjs, NOBJS);
+
+	stop_rt_timer();
+	rt_pool_delete(nam2num("POOL"));
+	rt_task_delete(task);
+	return 0;
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2026 The RTAI project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Sends bursts of bytes over a looped back rtser device of the 16550A
+ * driver, by default a software loopback one, see 16550A_soft.h, and reads
+ * them back, checking that they arrive all, in order and without line
+ * errors. Burst sizes are chosen around the receive FIFO trigger level and
+ * the transmit FIFO chunk, so that both the burst reads of the FIFO and the
+ * byte by byte polling of what remains are exercised, in all FIFO modes.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include <rtai_lxrt.h>
+#include <rtdm/rtserial.h>
+
+#define DEV       "rtser0"
+#define REPEATS   100
+#define TIMEOUT   100000000
+
+static int bursts[] = { 1, 3, 4, 7, 8, 13, 14, 15, 16, 17, 63, 64, 65, 200, 1000, 4000 };
+static int fifos[] = { RTSER_FIFO_DEPTH_1, RTSER_FIFO_DEPTH_4, RTSER_FIFO_DEPTH_8, RTSER_FIFO_DEPTH_14 };
+
+static char out[4000], in[4000];
+
+static int burst(int fd, int size, int seq)
+{
+	int k, n, got;
+
+	for (k = 0; k < size; k++) {
+		out[k] = seq + 7*k;
+	}
+	if ((n = rt_dev_write(fd, out, size)) != size) {
+		printf("WRITE OF %d BYTES RETURNED %d\n", size, n);
+		return 1;
+	}
+	for (got = 0; got < size; got += n) {
+		if ((n = rt_dev_read(fd, in + got, size - got)) <= 0) {
+			printf("READ AFTER %d OF %d BYTES RETURNED %d\n", got, size, n);
+			return 1;
+		}
+	}
+	return memcmp(in, out, size) != 0;
+}
+
+int main(int argc, char *argv[])
+{
+	struct rtser_config config = {
+		.config_mask = RTSER_SET_BAUD | RTSER_SET_FIFO_DEPTH | RTSER_SET_TIMEOUT_RX | RTSER_SET_TIMEOUT_TX,
+		.baud_rate   = 115200,
+		.rx_timeout  = TIMEOUT,
+		.tx_timeout  = TIMEOUT,
+	};
+	struct rtser_status status;
+	const char *dev = argc > 1 ? argv[1] : DEV;
+	RT_TASK *task;
+	RTIME t;
+	long long bytes;
+	int fd, f, b, i, errs, lsr, total;
+
+	if (!(task = rt_task_init_schmod(nam2num("SER550"), 0, 0, 0, SCHED_FIFO, 0x1))) {
+		printf("CANNOT INIT MAIN TASK\n");
+		exit(1);
+	}
+	mlockall(MCL_CURRENT | MCL_FUTURE);
+	if ((fd = rt_dev_open(dev, 0)) < 0) {
+		printf("CANNOT OPEN %s (%d)\n", dev, fd);
+		rt_task_delete(task);
+		exit(1);
+	}
+	rt_make_hard_real_time();
+
+	total = 0;
+	for (f = 0; f < sizeof(fifos)/sizeof(fifos[0]); f++) {
+		config.fifo_depth = fifos[f];
+		if ((errs = rt_dev_ioctl(fd, RTSER_RTIOC_SET_CONFIG, &config))) {
+			printf("CANNOT CONFIGURE %s (%d)\n", dev, errs);
+			total++;
+			break;
+		}
+		errs = lsr = 0;
+		bytes = 0;
+		t = rt_get_cpu_time_ns();
+		for (b = 0; b < sizeof(bursts)/sizeof(bursts[0]); b++) {
+			for (i = 0; i < REPEATS; i++) {
+				errs += burst(fd, bursts[b], i);
+				bytes += bursts[b];
+			}
+		}
+		t = rt_get_cpu_time_ns() - t;
+		if (!rt_dev_ioctl(fd, RTSER_RTIOC_GET_STATUS, &status)) {
+			lsr = status.line_status & (RTSER_LSR_OVERRUN_ERR | RTSER_LSR_PARITY_ERR | RTSER_LSR_FRAMING_ERR | RTSER_LSR_BREAK_IND);
+		}
+		printf("FIFO TRIGGER 0x%02x: %lld BYTES, %lld BYTES/s, %d ERRORS, LINE STATUS ERRORS 0x%x\n", fifos[f], bytes, t ? bytes*1000000000LL/t : 0, errs, lsr);
+		total += errs + (lsr != 0);
+	}
+
+	rt_make_soft_real_time();
+	rt_dev_close(fd);
+	printf("\n%s, %d ERRORS (MUST BE 0).\n", dev, total);
+	rt_task_delete(task);
+	return 0;
+}
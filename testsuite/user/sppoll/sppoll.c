@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2026 The RTAI project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+/*
+ * Compares the interrupt and the polled (RT_SP_POLLED) modes of the RTAI
+ * serial driver on a looped back port, by default a software UART, see
+ * uart_soft.h. For each mode it sends messages, timing how long it takes
+ * to receive each of them back, and reports the CPU time used by this task
+ * and by the polling task of the port group, both while idle and while
+ * streaming. CPU times are available only if RTAI has been configured with
+ * CONFIG_RTAI_MONITOR_EXECTIME.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include <rtai_lxrt.h>
+#include <rtai_serial.h>
+
+#define TTY       0
+#define MSGSIZE   16
+#define NMSGS     2000
+#define IDLE_NS   1000000000
+#define TIMEOUT   100000000
+
+static RTIME exectime(RT_TASK *task)
+{
+	RTIME t[3] = { 0, 0, 0 };
+
+	if (task) {
+		rt_get_exectime(task, t);
+	}
+	return t[0];
+}
+
+static void report(const char *what, RT_TASK *task, RT_TASK *poll, RTIME t0, RTIME p0, RTIME dt)
+{
+	RTIME t = exectime(task) - t0, p = exectime(poll) - p0;
+
+	if (t || p) {
+		printf("  %-6s %7lld NS, CPU: THIS TASK %9lld NS (%5.2f%%), POLLING TASK %9lld NS (%5.2f%%)\n", what, count2nano(dt), count2nano(t), 100.0*t/dt, count2nano(p), 100.0*p/dt);
+	} else {
+		printf("  %-6s %7lld NS, CPU: NOT AVAILABLE\n", what, count2nano(dt));
+	}
+}
+
+static int bench(RT_TASK *task, RT_TASK *poll, int tty, int polled)
+{
+	char out[MSGSIZE], in[MSGSIZE];
+	RTIME t0, p0, start, t, lat, minlat = 0, maxlat = 0, sumlat = 0;
+	int i, k, errs = 0;
+
+	if ((i = rt_spopen(tty, 115200, 8, 1, RT_SP_PARITY_NONE, RT_SP_NO_HAND_SHAKE | (polled ? RT_SP_POLLED : 0), RT_SP_FIFO_SIZE_DEFAULT))) {
+		printf("CANNOT OPEN TTY %d (%d)\n", tty, i);
+		return 1;
+	}
+	printf("\n%s MODE:\n", polled ? "POLLED" : "INTERRUPT");
+
+	t0 = exectime(task);
+	p0 = exectime(poll);
+	start = rt_get_time();
+	rt_sleep(nano2count(IDLE_NS));
+	report("IDLE", task, poll, t0, p0, rt_get_time() - start);
+
+	t0 = exectime(task);
+	p0 = exectime(poll);
+	start = rt_get_time();
+	for (i = 0; i < NMSGS; i++) {
+		for (k = 0; k < MSGSIZE; k++) {
+			out[k] = i + k;
+		}
+		t = rt_get_time();
+		if (rt_spwrite_timed(tty, out, MSGSIZE, DELAY_FOREVER) || rt_spread_timed(tty, in, MSGSIZE, nano2count(TIMEOUT))) {
+			errs++;
+			break;
+		}
+		lat = rt_get_time() - t;
+		if (memcmp(in, out, MSGSIZE)) {
+			errs++;
+		}
+		if (!minlat || lat < minlat) minlat = lat;
+		if (lat > maxlat) maxlat = lat;
+		sumlat += lat;
+	}
+	report("STREAM", task, poll, t0, p0, rt_get_time() - start);
+	if (i) {
+		printf("  %d MESSAGES OF %d BYTES, ROUND TRIP MIN/AVG/MAX %lld/%lld/%lld NS\n", i, MSGSIZE, count2nano(minlat), count2nano(sumlat/i), count2nano(maxlat));
+	}
+	printf("  %d ERRORS (MUST BE 0), UART ERRORS 0x%x\n", errs, rt_spget_err(tty));
+	rt_spclose(tty);
+	return errs;
+}
+
+int main(int argc, char *argv[])
+{
+	RT_TASK *task, *poll = NULL;
+	char name[8];
+	int tty = argc > 1 ? atoi(argv[1]) : TTY, k, errs;
+
+	if (!(task = rt_task_init_schmod(nam2num("SPPOLL"), 0, 0, 0, SCHED_FIFO, 0x1))) {
+		printf("CANNOT INIT MAIN TASK\n");
+		exit(1);
+	}
+	// the polling task of a group is named after its first port
+	for (k = tty; k >= 0 && !poll; k--) {
+		sprintf(name, "SPPL%02d", k);
+		poll = rt_get_adr(nam2num(name));
+	}
+	mlockall(MCL_CURRENT | MCL_FUTURE);
+	rt_set_oneshot_mode();
+	start_rt_timer(0);
+
+	rt_make_hard_real_time();
+	errs = bench(task, poll, tty, 0);
+	errs += bench(task, poll, tty, 1);
+	rt_make_soft_real_time();
+
+	printf("\nTTY %d, POLLING TASK %s, %d ERRORS (MUST BE 0).\n", tty, poll ? name : "NOT FOUND", errs);
+	stop_rt_timer();
+	rt_task_delete(task);
+	return 0;
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2026 The RTAI project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <trace_pyr.h>
+
+#define BURSTS   2000
+#define SPANS    50
+
+static float trace[TRACE_RING_SIZE];
+static float *min[TRACE_PYR_LEVELS], *max[TRACE_PYR_LEVELS];
+
+/* What the pyramid must give, from the samples alone. */
+static void scan_minmax(long long from, long long to, float *vmin, float *vmax)
+{
+	float v;
+
+	*vmin = 1E38;
+	*vmax = -1E38;
+	for (; from < to; from++) {
+		v = trace[from & TRACE_RING_MASK];
+		if (v < *vmin) *vmin = v;
+		if (v > *vmax) *vmax = v;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	long long head, pyr_head, from, to;
+	float pmin, pmax, smin, smax;
+	int k, i, n, errors, spans;
+
+	for (k = 0; k < TRACE_PYR_LEVELS; k++) {
+		min[k] = malloc((TRACE_RING_SIZE >> (TRACE_PYR_SHIFT + k))*sizeof(float));
+		max[k] = malloc((TRACE_RING_SIZE >> (TRACE_PYR_SHIFT + k))*sizeof(float));
+	}
+	srand(1);
+
+	head = pyr_head = 0;
+	errors = spans = 0;
+	for (i = 0; i < BURSTS; i++) {
+		// from a few samples to more than the whole ring at once
+		n = i % 100 ? rand() % (4 << TRACE_PYR_SHIFT) : rand() % (2*TRACE_RING_SIZE);
+		while (n--) {
+			trace[head++ & TRACE_RING_MASK] = (float)(rand() - RAND_MAX/2);
+		}
+		trace_pyr_update(trace, min, max, pyr_head, head);
+		pyr_head = head;
+		for (k = 0; k < SPANS; k++) {
+			from = head > TRACE_RING_SIZE ? head - TRACE_RING_SIZE : 0;
+			from += rand() % (head - from + 1);
+			to = from + (k & 1 ? rand() % 64 : rand() % (head - from + 1));
+			if (to > head) {
+				to = head;
+			}
+			trace_pyr_minmax(trace, min, max, from, to, &pmin, &pmax);
+			scan_minmax(from, to, &smin, &smax);
+			if (pmin != smin || pmax != smax) {
+				errors++;
+			}
+			spans++;
+		}
+	}
+
+	printf("\n\nTRACE PYRAMIDS, %lld SAMPLES RECORDED\n", head);
+	printf("SPANS WITH A WRONG MIN/MAX: %d OF %d (MUST BE 0)\n\n", errors, spans);
+	return 0;
+}
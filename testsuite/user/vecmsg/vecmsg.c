@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2026 The RTAI project
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <pthread.h>
+
+#include <rtai_mbx.h>
+#include <rtai_tbx.h>
+
+#define MSG_SIZE  64
+#define MSGS      100000
+#define VEC       16
+#define MBX_SIZE  (4*VEC*MSG_SIZE)
+#define TBX_MSGS  (4*VEC)
+
+static MBX *mbx;
+static RT_MSGQ *tbx;
+
+static volatile int vectored, typed, errors;
+
+static void fill_msg(int *msg, int seq)
+{
+	msg[0] = msg[MSG_SIZE/sizeof(int) - 1] = seq;
+}
+
+static void check_msg(int *msg, int seq)
+{
+	if (msg[0] != seq || msg[MSG_SIZE/sizeof(int) - 1] != seq) {
+		errors++;
+	}
+}
+
+static void *sender_fun(void *arg)
+{
+	static int msg[VEC][MSG_SIZE/sizeof(int)];
+	struct rt_msg_iov iov[VEC];
+	RT_TASK *task;
+	int seq, i;
+
+	if (!(task = rt_thread_init(nam2num("VECSND"), 1, 0, SCHED_FIFO, 0xF))) {
+		printf("CANNOT INIT SENDER TASK\n");
+		exit(1);
+	}
+	rt_make_hard_real_time();
+	for (seq = 0; seq < MSGS; seq += VEC) {
+		for (i = 0; i < VEC; i++) {
+			fill_msg(msg[i], seq + i);
+			iov[i].msg  = msg[i];
+			iov[i].size = MSG_SIZE;
+			iov[i].prio = 0;
+		}
+		if (vectored) {
+			if ((typed ? rt_msg_send_vec(tbx, iov, VEC) : rt_mbx_send_vec(mbx, iov, VEC)) != VEC) {
+				errors++;
+			}
+		} else {
+			for (i = 0; i < VEC; i++) {
+				if (typed ? rt_msg_send(tbx, msg[i], MSG_SIZE, 0) : rt_mbx_send(mbx, msg[i], MSG_SIZE)) {
+					errors++;
+				}
+			}
+		}
+	}
+	rt_make_soft_real_time();
+	rt_task_delete(task);
+	return NULL;
+}
+
+/*
+ * Typed mailboxes have no vectored receive, so only their sends are
+ * vectored and compared.
+ */
+static RTIME run(void)
+{
+	static int msg[VEC][MSG_SIZE/sizeof(int)];
+	struct rt_msg_iov iov[VEC];
+	pthread_t thread;
+	RTIME t;
+	int seq, i;
+
+	pthread_create(&thread, NULL, sender_fun, NULL);
+	rt_make_hard_real_time();
+	t = rt_get_cpu_time_ns();
+	for (seq = 0; seq < MSGS; seq += VEC) {
+		if (vectored && !typed) {
+			for (i = 0; i < VEC; i++) {
+				iov[i].msg  = msg[i];
+				iov[i].size = MSG_SIZE;
+			}
+			if (rt_mbx_receive_vec(mbx, iov, VEC) != VEC) {
+				errors++;
+			}
+		} else {
+			for (i = 0; i < VEC; i++) {
+				if (typed ? rt_msg_receive(tbx, msg[i], MSG_SIZE, NULL) : rt_mbx_receive(mbx, msg[i], MSG_SIZE)) {
+					errors++;
+				}
+			}
+		}
+		for (i = 0; i < VEC; i++) {
+			check_msg(msg[i], seq + i);
+		}
+	}
+	t = rt_get_cpu_time_ns() - t;
+	rt_make_soft_real_time();
+	pthread_join(thread, NULL);
+	return t;
+}
+
+int main(void)
+{
+	RT_TASK *task;
+	RTIME mbx_single, mbx_vec, tbx_single, tbx_vec;
+
+	if (!(task = rt_thread_init(nam2num("VECRCV"), 0, 0, SCHED_FIFO, 0xF))) {
+		printf("CANNOT INIT RECEIVER TASK\n");
+		exit(1);
+	}
+	mlockall(MCL_CURRENT | MCL_FUTURE);
+	if (!(mbx = rt_mbx_init(nam2num("VECMBX"), MBX_SIZE))) {
+		printf("CANNOT CREATE MAILBOX\n");
+		exit(1);
+	}
+	if (!(tbx = rt_msgq_init(nam2num("VECTBX"), TBX_MSGS, MSG_SIZE))) {
+		printf("CANNOT CREATE TYPED MAILBOX\n");
+		exit(1);
+	}
+	start_rt_timer(0);
+
+	typed = 0;
+	vectored = 0;
+	mbx_single = run();
+	vectored = 1;
+	mbx_vec = run();
+	typed = 1;
+	vectored = 0;
+	tbx_single = run();
+	vectored = 1;
+	tbx_vec = run();
+
+	printf("\n%d MESSAGES OF %d BYTES, VECTORS OF %d, AVERAGE TIME PER MESSAGE (ns):\n", MSGS, MSG_SIZE, VEC);
+	printf("MBX SEND/RECEIVE:          %lld\n", mbx_single/MSGS);
+	printf("MBX SEND_VEC/RECEIVE_VEC:  %lld\n", mbx_vec/MSGS);
+	printf("TBX SEND/RECEIVE:          %lld\n", tbx_single/MSGS);
+	printf("TBX SEND_VEC/RECEIVE:      %lld\n", tbx_vec/MSGS);
+	printf("ERRORS: %d (MUST BE 0)\n", errors);
+
+	stop_rt_timer();
+	rt_msgq_delete(tbx);
+	rt_mbx_delete(mbx);
+	rt_task_delete(task);
+	return 0;
+}